@@ -0,0 +1,82 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LoopbackServer.hpp"
+
+/**
+ * Measures the time until every response of a batch is parsed, on the request
+ * threads (tryGET from each thread) and on decode pools of growing size
+ * (Session::tryBatch). Parsing scans the payload and copies the body out with
+ * its JSON escapes; unescaping it (ResponseData::decodeBody) is not measured.
+ *
+ * Usage: batch-benchmark [requests] [body size] [request threads]
+ *
+ * Run it from its build directory, where the library is copied to dependencies/.
+ */
+
+static double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t requests = argc > 1 ? std::stoul(argv[1]) : 100;
+    size_t bodySize = argc > 2 ? std::stoul(argv[2]) : 1024 * 1024;
+    size_t threads = argc > 3 ? std::stoul(argv[3]) : 16;
+
+    LoopbackServer server;
+    RequestData requestData;
+    requestData.url = server.url("/bytes/" + std::to_string(bodySize));
+    requestData.insecureSkipVerify = true;
+    std::vector<RequestData> batch(requests, requestData);
+    std::printf("%zu requests of %zu bytes, %zu request threads\n", requests, bodySize, threads);
+
+    SessionData sessionData;
+    sessionData.sessionId = "batch-benchmark";
+    Session session(sessionData);
+    if (auto response = session.tryGET(requestData); !response) {
+        std::printf("skipped: %s\n", response.error().message.c_str());
+        return 0;
+    }
+
+    ThreadPool requestExecutor(threads);
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::future<Expected<ResponseData>>> responses;
+        for (const RequestData& request : batch) {
+            responses.push_back(requestExecutor.submit([&session, &request]() { return session.tryGET(request); }));
+        }
+        for (auto& response : responses) {
+            response.get();
+        }
+    }
+    std::printf("%-32s %8.3f s\n", "parsed on request threads", seconds(start));
+
+    std::vector<size_t> decodeThreads{1, 2, 4, std::thread::hardware_concurrency()};
+    std::sort(decodeThreads.begin(), decodeThreads.end());
+    decodeThreads.erase(std::unique(decodeThreads.begin(), decodeThreads.end()), decodeThreads.end());
+
+    for (size_t size : decodeThreads) {
+        ThreadPool decodeExecutor(size);
+        start = std::chrono::steady_clock::now();
+        std::vector<Expected<ResponseData>> responses = session.tryBatch(batch, "GET", requestExecutor,
+            decodeExecutor);
+        double elapsed = seconds(start);
+
+        size_t failures = std::count_if(responses.begin(), responses.end(),
+            [](const Expected<ResponseData>& response) { return !response; });
+        std::string name = "tryBatch, " + std::to_string(size) + " decode threads";
+        std::printf("%-32s %8.3f s%s\n", name.c_str(), elapsed, failures ? " (with failures)" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "../include/tls_client.hpp"
+
+/**
+ * Compares JsonHelper::appendEscaped, which finds the bytes to escape in
+ * blocks of 16 or 32 bytes, with a scalar escaper checking one byte at a time,
+ * on ASCII text, UTF-8 heavy text and text dense in characters to escape.
+ *
+ * Usage: json-escape-benchmark [input size] [rounds]
+ *
+ * Build with -DCMAKE_CXX_FLAGS=-mavx2 (or -march=native) to use AVX2.
+ */
+
+static double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * The escaper before vectorization, checking every byte in turn.
+ */
+static void appendEscapedScalar(std::string& out, std::string_view value) {
+    static constexpr char HEX[] = "0123456789abcdef";
+    out.reserve(out.size() + value.size());
+
+    const auto* bytes = reinterpret_cast<const unsigned char*>(value.data());
+    size_t length = value.size();
+    size_t start = 0;
+
+    for (size_t i = 0; i < length;) {
+        unsigned char ch = bytes[i];
+        if (ch >= 0x20 && ch < 0x80 && ch != '"' && ch != '\\' && ch != '<' && ch != '>' && ch != '&') {
+            ++i;
+            continue;
+        }
+
+        if (ch < 0x80) {
+            out.append(value.data() + start, i - start);
+            switch (ch) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    out += "\\u00";
+                    out += HEX[ch >> 4];
+                    out += HEX[ch & 0xF];
+                    break;
+            }
+            start = ++i;
+            continue;
+        }
+
+        size_t size = ch >= 0xF0 ? 4 : ch >= 0xE0 ? 3 : ch >= 0xC2 ? 2 : 0;
+        bool valid = size != 0 && ch <= 0xF4 && i + size <= length;
+        for (size_t j = 1; valid && j < size; ++j) {
+            valid = (bytes[i + j] & 0xC0) == 0x80;
+        }
+        if (valid && size == 3) {
+            valid = !(ch == 0xE0 && bytes[i + 1] < 0xA0) && !(ch == 0xED && bytes[i + 1] >= 0xA0);
+        }
+        if (valid && size == 4) {
+            valid = !(ch == 0xF0 && bytes[i + 1] < 0x90) && !(ch == 0xF4 && bytes[i + 1] >= 0x90);
+        }
+
+        if (!valid) {
+            out.append(value.data() + start, i - start);
+            out += "\\ufffd";
+            start = ++i;
+        } else if (size == 3 && ch == 0xE2 && bytes[i + 1] == 0x80 && (bytes[i + 2] == 0xA8 || bytes[i + 2] == 0xA9)) {
+            out.append(value.data() + start, i - start);
+            out += bytes[i + 2] == 0xA8 ? "\\u2028" : "\\u2029";
+            start = i += 3;
+        } else {
+            i += size;
+        }
+    }
+    out.append(value.data() + start, length - start);
+}
+
+/**
+ * Builds an input of about size bytes from random pieces.
+ */
+static std::string makeInput(std::initializer_list<const char*> pieces, size_t size) {
+    std::vector<const char*> choices(pieces);
+    std::mt19937 random(42);
+    std::string input;
+    while (input.size() < size) {
+        input += choices[random() % choices.size()];
+    }
+    return input;
+}
+
+template <typename Escape>
+static double measure(Escape escape, const std::string& input, size_t rounds, std::string& out) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        out.clear();
+        escape(out, input);
+    }
+    return seconds(start);
+}
+
+int main(int argc, char** argv) {
+    size_t size = argc > 1 ? std::stoul(argv[1]) : 4 * 1024 * 1024;
+    size_t rounds = argc > 2 ? std::stoul(argv[2]) : 50;
+
+#if defined(TLS_CLIENT_HAS_AVX2)
+    const char* instructions = "AVX2";
+#elif defined(TLS_CLIENT_HAS_SSE2)
+    const char* instructions = "SSE2";
+#elif defined(TLS_CLIENT_HAS_NEON)
+    const char* instructions = "NEON";
+#else
+    const char* instructions = "none";
+#endif
+    std::printf("%zu byte inputs, %zu rounds, vector instructions: %s\n", size, rounds, instructions);
+
+    struct Input {
+        const char* name;
+        std::string text;
+    };
+    Input inputs[] = {
+        {"ascii", makeInput({"The quick brown fox jumps over the lazy dog. ", "user_id=12345&page=2 ",
+            "Lorem ipsum dolor sit amet, consectetur adipiscing elit. "}, size)},
+        {"utf-8 heavy", makeInput({"Съешь же ещё этих мягких французских булок. ", "東京都渋谷区 ",
+            "café crème brûlée 😀 ", "plain text "}, size)},
+        {"escape dense", makeInput({"{\"key\": \"value\"}\n", "<a href=\"/x?a=1&b=2\">", "C:\\path\\to\\file\t",
+            "line\r\n"}, size)},
+    };
+
+    std::string scalar;
+    std::string vectorized;
+    for (const Input& input : inputs) {
+        double scalarTime = measure(appendEscapedScalar, input.text, rounds, scalar);
+        double vectorizedTime = measure(JsonHelper::appendEscaped, input.text, rounds, vectorized);
+        if (scalar != vectorized) {
+            std::printf("%s: outputs differ\n", input.name);
+            return 1;
+        }
+
+        double megabytes = static_cast<double>(input.text.size()) * rounds / (1024 * 1024);
+        std::printf("%-14s scalar %8.0f MB/s   vectorized %8.0f MB/s   %5.2fx\n", input.name,
+            megabytes / scalarTime, megabytes / vectorizedTime, scalarTime / vectorizedTime);
+    }
+    return 0;
+}
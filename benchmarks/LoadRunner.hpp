@@ -0,0 +1,76 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/tls_client.hpp"
+
+// Load generation shared by the benchmarks: every thread sends GET requests
+// to one URL through a shared session, one at a time.
+
+struct Result {
+    size_t requests = 0;
+    size_t failures = 0;
+    double seconds = 0;
+    std::vector<double> latencies; // In microseconds
+};
+
+inline Result run(Session& session, const std::string& url, size_t requests, size_t threads) {
+    std::vector<std::vector<double>> latencies(threads);
+    std::vector<size_t> failures(threads);
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t thread = 0; thread < threads; ++thread) {
+        workers.emplace_back([&, thread] {
+            RequestData requestData;
+            requestData.url = url;
+            requestData.insecureSkipVerify = true;
+
+            for (size_t i = 0; i < requests; ++i) {
+                auto requestStart = std::chrono::steady_clock::now();
+                auto response = session.tryGET(requestData);
+                std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - requestStart;
+
+                latencies[thread].push_back(elapsed.count());
+                if (!response || response->statusCode != 200) {
+                    if (++failures[thread] == 1 && !response) {
+                        std::fprintf(stderr, "  first error: %s\n", response.error().message.c_str());
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    Result result;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (size_t thread = 0; thread < threads; ++thread) {
+        result.latencies.insert(result.latencies.end(), latencies[thread].begin(), latencies[thread].end());
+        result.failures += failures[thread];
+    }
+    result.requests = result.latencies.size();
+    std::sort(result.latencies.begin(), result.latencies.end());
+    return result;
+}
+
+inline void report(const char* name, const Result& result) {
+    auto percentile = [&](double p) {
+        return result.latencies.empty() ? 0.0 : result.latencies[static_cast<size_t>(p * (result.latencies.size() - 1))];
+    };
+    std::printf("%-32s %8zu requests %6zu failed %10.0f req/s   p50 %8.1f us   p99 %8.1f us\n", name,
+        result.requests, result.failures, result.requests / result.seconds, percentile(0.5), percentile(0.99));
+}
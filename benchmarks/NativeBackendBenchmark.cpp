@@ -0,0 +1,61 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "../include/tls_client_native.hpp"
+#include "LoadRunner.hpp"
+#include "LoopbackServer.hpp"
+
+/**
+ * Compares the library path with the native backend on a loopback HTTPS server.
+ *
+ * Usage: native-backend-benchmark [requests per thread] [body size] [threads] [path]
+ *
+ * The path defaults to /bytes/<body size>; see LoopbackServer for the other
+ * endpoints and their delay, status and chunked parameters.
+ *
+ * Run it from its build directory, where the library is copied to dependencies/.
+ */
+
+int main(int argc, char** argv) {
+    size_t requests = argc > 1 ? std::stoul(argv[1]) : 2000;
+    size_t bodySize = argc > 2 ? std::stoul(argv[2]) : 1024;
+    size_t threads = argc > 3 ? std::stoul(argv[3]) : 1;
+    std::string path = argc > 4 ? argv[4] : "/bytes/" + std::to_string(bodySize);
+
+    LoopbackServer server;
+    std::string url = server.url(path);
+    std::printf("%zu threads x %zu requests, %zu byte bodies\n", threads, requests, bodySize);
+
+    auto backend = NativeBackend::create();
+    if (!backend) {
+        std::fprintf(stderr, "Failed to create the native backend: %s\n", backend.error().message.c_str());
+        return 1;
+    }
+
+    SessionData nativeConfig;
+    nativeConfig.backend = *backend;
+    Session native(nativeConfig);
+    run(native, url, std::min<size_t>(requests, 100), threads); // Warm up
+    report("native", run(native, url, requests, threads));
+
+    Session library{SessionData()};
+    RequestData probe;
+    probe.url = url;
+    probe.insecureSkipVerify = true;
+    if (auto response = library.tryGET(probe); !response && response.error().code == ErrorCode::Library) {
+        std::printf("library skipped: %s\n", response.error().message.c_str());
+        return 0;
+    }
+
+    run(library, url, std::min<size_t>(requests, 100), threads);
+    report("library", run(library, url, requests, threads));
+    return 0;
+}
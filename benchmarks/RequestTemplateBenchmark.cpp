@@ -0,0 +1,102 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "LoopbackServer.hpp"
+
+/**
+ * Compares requests built from scratch, as a RequestData serialized for each
+ * request, with requests sent from a RequestTemplate, which serializes the
+ * static parts once. It times the serialization alone and then whole requests
+ * on a loopback server.
+ *
+ * Usage: request-template-benchmark [serializations] [requests] [body size]
+ *
+ * Run it from its build directory, where the library is copied to dependencies/.
+ */
+
+static double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void report(const char* name, size_t count, double elapsed) {
+    std::printf("%-40s %10.0f /s %10.2f us each\n", name, count / elapsed, elapsed * 1e6 / count);
+}
+
+int main(int argc, char** argv) {
+    size_t serializations = argc > 1 ? std::stoul(argv[1]) : 200000;
+    size_t requests = argc > 2 ? std::stoul(argv[2]) : 2000;
+    size_t bodySize = argc > 3 ? std::stoul(argv[3]) : 256;
+
+    LoopbackServer server;
+    std::string baseUrl = server.url("/anything?id=");
+    std::string body(bodySize, 'x');
+
+    // A typical API request: headers, cookies, a timeout and a fingerprint
+    auto buildRequest = [&](size_t id) {
+        RequestData requestData;
+        requestData.url = baseUrl + std::to_string(id);
+        requestData.insecureSkipVerify = true;
+        requestData.timeoutSeconds = 30;
+        requestData.headers = R"({"accept": "application/json", "authorization": "Bearer 0123456789abcdef",)"
+            R"json( "user-agent": "Mozilla/5.0 (Windows NT 10.0; Win64; x64)"})json";
+        requestData.cookies = R"({"session": "abcdef0123456789"})";
+        requestData.data = body;
+        return requestData;
+    };
+
+    SessionData sessionData;
+    sessionData.sessionId = "request-template-benchmark";
+    sessionData.headerOrder = R"(["accept", "authorization", "user-agent"])";
+    Session session(sessionData);
+    std::printf("%zu serializations, %zu requests, %zu byte bodies\n", serializations, requests, bodySize);
+
+    // Serialization alone; prepare builds the envelope the way every request from scratch does
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < serializations; ++i) {
+        bytes += session.prepare(buildRequest(i), "POST").envelope().size();
+    }
+    report("serialize from scratch", serializations, seconds(start));
+
+    RequestTemplate requestTemplate = session.prepare(buildRequest(0), "POST");
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < serializations; ++i) {
+        requestTemplate.setUrlSuffix(std::to_string(i));
+        requestTemplate.setBody(body);
+        bytes += requestTemplate.envelope().size();
+    }
+    report("serialize from template", serializations, seconds(start));
+
+    if (auto response = session.tryPOST(buildRequest(0)); !response) {
+        std::printf("skipped requests: %s\n", response.error().message.c_str());
+        return bytes == 0;
+    }
+
+    size_t failures = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < requests; ++i) {
+        failures += !session.tryPOST(buildRequest(i));
+    }
+    report("requests from scratch", requests, seconds(start));
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < requests; ++i) {
+        requestTemplate.setUrlSuffix(std::to_string(i));
+        requestTemplate.setBody(body);
+        failures += !session.tryPerform(requestTemplate);
+    }
+    report("requests from template", requests, seconds(start));
+
+    if (failures > 0) {
+        std::printf("%zu requests failed\n", failures);
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "LoadRunner.hpp"
+#include "LoopbackServer.hpp"
+
+/**
+ * Sweeps the transport options of the library on a loopback HTTPS server and
+ * recommends the fastest pool settings for a concurrency.
+ *
+ * Usage: transport-benchmark [concurrency] [requests per thread] [server latency ms] [body size]
+ *
+ * Run it from its build directory, where the library is copied to dependencies/.
+ */
+
+struct Candidate {
+    std::string name;
+    bool forceHttp1 = true;
+    TransportOptions options;
+    double throughput = 0;
+};
+
+static std::string describe(const Candidate& candidate) {
+    if (!candidate.forceHttp1) {
+        return "HTTP/2";
+    }
+    if (candidate.options.disableKeepAlives) {
+        return "HTTP/1.1 no keep-alive";
+    }
+    return "HTTP/1.1 idle " + std::to_string(*candidate.options.maxIdleConnsPerHost) + " max " +
+        (*candidate.options.maxConnsPerHost ? std::to_string(*candidate.options.maxConnsPerHost) : "-");
+}
+
+int main(int argc, char** argv) {
+    int concurrency = argc > 1 ? std::stoi(argv[1]) : 16;
+    size_t requests = argc > 2 ? std::stoul(argv[2]) : 200;
+    size_t latency = argc > 3 ? std::stoul(argv[3]) : 5;
+    size_t bodySize = argc > 4 ? std::stoul(argv[4]) : 1024;
+
+    LoopbackServer server;
+    std::string url = server.url("/bytes/" + std::to_string(bodySize) + "?delay=" + std::to_string(latency));
+    std::printf("%d threads x %zu requests, %zu ms latency, %zu byte bodies\n", concurrency, requests, latency,
+        bodySize);
+
+    Session probeSession{SessionData()};
+    RequestData probe;
+    probe.url = url;
+    probe.insecureSkipVerify = true;
+    if (auto response = probeSession.tryGET(probe); !response && response.error().code == ErrorCode::Library) {
+        std::printf("skipped: %s\n", response.error().message.c_str());
+        return 0;
+    }
+
+    // Idle pools below the concurrency close and reopen connections under load,
+    // and a connection limit below it makes requests queue for a connection
+    std::vector<int> idleSizes{2, std::max(concurrency / 2, 1), concurrency, concurrency * 2};
+    std::sort(idleSizes.begin(), idleSizes.end());
+    idleSizes.erase(std::unique(idleSizes.begin(), idleSizes.end()), idleSizes.end());
+
+    std::vector<Candidate> candidates;
+    for (int idle : idleSizes) {
+        for (int limit : {0, std::max(concurrency / 2, 1)}) {
+            Candidate candidate;
+            candidate.options.maxIdleConns = 0;
+            candidate.options.maxIdleConnsPerHost = idle;
+            candidate.options.maxConnsPerHost = limit;
+            candidates.push_back(candidate);
+        }
+    }
+    Candidate noKeepAlive;
+    noKeepAlive.options.disableKeepAlives = true;
+    candidates.push_back(noKeepAlive);
+    Candidate http2;
+    http2.forceHttp1 = false;
+    candidates.push_back(http2);
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        Candidate& candidate = candidates[i];
+        candidate.name = describe(candidate);
+
+        SessionData sessionData;
+        sessionData.forceHttp1 = candidate.forceHttp1;
+        sessionData.sessionId = "transport-benchmark-" + std::to_string(i);
+        sessionData.transportOptions = candidate.options;
+        Session session(sessionData);
+
+        run(session, url, std::min<size_t>(requests, 20), concurrency); // Warm up the pool
+        Result result = run(session, url, requests, concurrency);
+        report(candidate.name.c_str(), result);
+        candidate.throughput = result.failures == 0 ? result.requests / result.seconds : 0;
+    }
+
+    // Among the HTTP/1.1 pools within 5% of the best one, the smallest holds the fewest sockets
+    double best = 0;
+    for (const Candidate& candidate : candidates) {
+        if (candidate.forceHttp1 && !candidate.options.disableKeepAlives) {
+            best = std::max(best, candidate.throughput);
+        }
+    }
+    const Candidate* recommended = nullptr;
+    for (const Candidate& candidate : candidates) {
+        if (candidate.forceHttp1 && !candidate.options.disableKeepAlives && candidate.throughput >= best * 0.95 &&
+            (!recommended || *candidate.options.maxIdleConnsPerHost < *recommended->options.maxIdleConnsPerHost)) {
+            recommended = &candidate;
+        }
+    }
+    if (!recommended || best == 0) {
+        std::printf("\nNo configuration completed without failures\n");
+        return 1;
+    }
+
+    std::printf("\nRecommended for %d concurrent HTTP/1.1 requests per host (%.0f req/s):\n", concurrency,
+        recommended->throughput);
+    std::printf("  sessionData.sessionId = \"...\";\n");
+    std::printf("  sessionData.transportOptions = TransportOptions();\n");
+    std::printf("  sessionData.transportOptions->maxIdleConnsPerHost = %d;\n",
+        *recommended->options.maxIdleConnsPerHost);
+    if (*recommended->options.maxConnsPerHost) {
+        std::printf("  sessionData.transportOptions->maxConnsPerHost = %d;\n", *recommended->options.maxConnsPerHost);
+    }
+    std::printf("HTTP/2 multiplexes the requests on one connection, where the pool limits barely matter.\n");
+    return 0;
+}
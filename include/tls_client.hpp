@@ -48,45 +48,114 @@
     #error "Unsupported C++ standard (use 17 or higher)"
 #endif
 
+//
+// Include optional third-party JSON backends. These macros are set by the
+// TLS_CLIENT_JSON_BACKEND CMake option when the library is found on the build
+// machine, but can also be defined manually
+//
+#if defined(TLS_CLIENT_HAS_YYJSON)
+#include <yyjson.h>
+#endif
+
+#if defined(TLS_CLIENT_HAS_SIMDJSON)
+#include <simdjson.h>
+#endif
+
+//
+// Check if exceptions are enabled. When building with -fno-exceptions, the
+// errors that would be thrown abort the process instead; use the try* API
+// of Session to handle errors without exceptions
+//
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define TLS_CLIENT_EXCEPTIONS
+#endif
+
+//
+// Select the vector instructions used to scan strings. AVX2 is used when the
+// build targets it (e.g. -mavx2 or -march=native), SSE2 and NEON are baseline
+// on x86-64 and arm64. Define TLS_CLIENT_NO_SIMD to scan byte by byte
+//
+#if !defined(TLS_CLIENT_NO_SIMD)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TLS_CLIENT_HAS_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TLS_CLIENT_HAS_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TLS_CLIENT_HAS_NEON
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+/**
+ * @brief TLS_CLIENT_THROW macro
+ *
+ * This macro throws the given exception, or prints its message and aborts
+ * when exceptions are disabled.
+ *
+ * @param exception The exception to be thrown.
+ */
+#if defined(TLS_CLIENT_EXCEPTIONS)
+#define TLS_CLIENT_THROW(exception) throw exception
+#else
+#define TLS_CLIENT_THROW(exception)                                                                                    \
+    do {                                                                                                               \
+        std::cerr << (exception).what() << std::endl;                                                                  \
+        std::abort();                                                                                                  \
+    } while (false)
+#endif
+
  /**
   * @brief LOAD_LIBRARY macro
   *
   * This macro is used to load a shared library
   * (DLL on Windows or .so on Linux/macOS) and retrieve function
-  * pointers for specific functions (`request` and `freeMemory`).
+  * pointers for specific functions (`request`, `freeMemory` and `destroySession`).
   *
   * @param hLib A smart pointer to hold the handle to the loaded library.
   * @param lib_path The file path of the library to be loaded.
-  *
-  * @throws std::runtime_error if the library fails to load.
+  * @param error A string receiving the error message if the library fails to load.
   *
   * Usage example:
   * @code
   * std::shared_ptr<void> hLib;
-  * LOAD_LIBRARY(hLib, "path/to/library");
+  * std::string error;
+  * LOAD_LIBRARY(hLib, "path/to/library", error);
   * @endcode
   */
 #if defined(OS_WIN)
 #include <Windows.h>
 
-#define LOAD_LIBRARY(hLib, lib_path)                                                                                   \
+#define LOAD_LIBRARY(hLib, lib_path, error)                                                                            \
     hLib = std::shared_ptr<void>(LoadLibrary(lib_path.c_str()), &FreeLibrary);                                         \
     if (!hLib) {                                                                                                       \
-        throw std::runtime_error("Failed to load library: " + lib_path);                                               \
+        error = "Failed to load library: " + lib_path;                                                                 \
     }                                                                                                                  \
-    request = reinterpret_cast<RequestFunc>(GetProcAddress(static_cast<HMODULE>(hLib.get()), "request"));              \
-    freeMemory = reinterpret_cast<FreeMemoryFunc>(GetProcAddress(static_cast<HMODULE>(hLib.get()), "freeMemory"));
+    else {                                                                                                             \
+        request = reinterpret_cast<RequestFunc>(GetProcAddress(static_cast<HMODULE>(hLib.get()), "request"));          \
+        freeMemory = reinterpret_cast<FreeMemoryFunc>(GetProcAddress(static_cast<HMODULE>(hLib.get()), "freeMemory")); \
+        destroySession = reinterpret_cast<DestroySessionFunc>(                                                         \
+            GetProcAddress(static_cast<HMODULE>(hLib.get()), "destroySession"));                                       \
+    }
 
 #elif defined(OS_LINUX) || defined(OS_APPLE)
 #include <dlfcn.h>
 
-#define LOAD_LIBRARY(hLib, lib_path)                                                                                   \
+#define LOAD_LIBRARY(hLib, lib_path, error)                                                                            \
     hLib = std::shared_ptr<void>(dlopen(lib_path.c_str(), RTLD_LAZY), &dlclose);                                       \
     if (!hLib) {                                                                                                       \
-        throw std::runtime_error("Failed to load library: " + lib_path + " " + dlerror());                             \
+        error = "Failed to load library: " + lib_path + " " + dlerror();                                               \
     }                                                                                                                  \
-    request = reinterpret_cast<RequestFunc>(dlsym(hLib.get(), "request"));                                             \
-    freeMemory = reinterpret_cast<FreeMemoryFunc>(dlsym(hLib.get(), "freeMemory"));
+    else {                                                                                                             \
+        request = reinterpret_cast<RequestFunc>(dlsym(hLib.get(), "request"));                                         \
+        freeMemory = reinterpret_cast<FreeMemoryFunc>(dlsym(hLib.get(), "freeMemory"));                                \
+        destroySession = reinterpret_cast<DestroySessionFunc>(dlsym(hLib.get(), "destroySession"));                    \
+    }
 #endif
 
 /**
@@ -100,7 +169,7 @@
  */
 #define CHECK_INITIALIZED(variable)                                                                                    \
     if (!(variable)) {                                                                                                 \
-        throw std::logic_error("Variable " #variable " is not initialized.");                                          \
+        TLS_CLIENT_THROW(std::logic_error("Variable " #variable " is not initialized."));                              \
     }
 
 /**
@@ -114,13 +183,27 @@
  */
 #define JSON_VALUE(value) JsonHelper::jsonValue(value)
 
+#include <algorithm>
 #include <any>
+#include <array>
+#include <atomic>
 #include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
 #include <random>
 #include <regex>
@@ -128,17 +211,27 @@
 #include <stdexcept>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <variant>
 #include <vector>
 
+#if defined(OS_LINUX) || defined(OS_APPLE)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 /**
  * @brief clientIdentifiers vector
  *
  * This vector contains identifiers for various client applications.
  * These identifiers are used to uniquely identify different clients.
  */
-std::vector<std::string> clientIdentifiers = {
+inline std::vector<std::string> clientIdentifiers = {
     // Chrome
     "chrome_103",
     "chrome_104",
@@ -201,6 +294,153 @@ std::vector<std::string> clientIdentifiers = {
     "confirmed_android_2"
 };
 
+struct RequestData;
+struct ResponseData;
+class RequestBackend;
+class HostResolver;
+class FailureCache;
+
+/**
+ * @brief JsonDecoder struct reading JSON documents into a type, defined in tls_client_json_bind.hpp.
+ */
+template <typename T>
+struct JsonDecoder;
+
+/**
+ * @brief ResponseSink class receiving the responses of a session.
+ *
+ * Sinks are registered in SessionData::sinks and called, in order, with every
+ * response that completed (status code other than 0). They are called from the
+ * thread that performed the request, so implementations must be thread-safe.
+ */
+class ResponseSink {
+public:
+    virtual ~ResponseSink() = default;
+
+    /**
+     * @brief Receives a completed response.
+     *
+     * Sinks may annotate the response, e.g. set ResponseData::bodyHash.
+     *
+     * @param requestData The request data of the request.
+     * @param method The HTTP method of the request.
+     * @param responseData The response of the request.
+     */
+    virtual void consume(const RequestData& requestData, const std::string& method, ResponseData& responseData) = 0;
+};
+
+/**
+ * @brief ContentHash class computing content hashes of response bodies.
+ *
+ * The hash is XXH3 64-bit with the default secret and seed 0, so it matches
+ * `XXH3_64bits` of the xxHash library and can be recomputed by any tool
+ * supporting it. Long inputs are processed in 64 byte stripes of eight
+ * independent lanes, which compilers vectorize.
+ */
+class ContentHash {
+public:
+    /**
+     * @brief Computes the hash of the given data.
+     *
+     * @param data The data to hash.
+     * @return uint64_t The XXH3 64-bit hash of the data.
+     */
+    [[nodiscard]] static inline uint64_t compute(std::string_view data) noexcept;
+
+private:
+    static constexpr uint64_t PRIME32_1 = 0x9E3779B1U;
+    static constexpr uint64_t PRIME32_2 = 0x85EBCA77U;
+    static constexpr uint64_t PRIME32_3 = 0xC2B2AE3DU;
+    static constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+    static constexpr uint64_t PRIME_MX1 = 0x165667919E3779F9ULL;
+    static constexpr uint64_t PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+    static constexpr size_t STRIPE_LENGTH = 64; /**< Bytes consumed by one accumulation round. */
+    static constexpr size_t SECRET_SIZE = 192;  /**< Size of the default secret. */
+
+    static constexpr uint8_t SECRET[SECRET_SIZE] = {
+        0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+        0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+        0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+        0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+        0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+        0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+        0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+        0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+        0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+        0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+        0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+        0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+    };
+
+    static inline uint64_t read64(const uint8_t* data) noexcept;
+    static inline uint32_t read32(const uint8_t* data) noexcept;
+    static inline uint64_t multiplyFold(uint64_t lhs, uint64_t rhs) noexcept;
+    static inline uint64_t avalanche(uint64_t hash) noexcept;
+    static inline uint64_t avalanche64(uint64_t hash) noexcept;
+    static inline uint64_t mix16(const uint8_t* data, const uint8_t* secret) noexcept;
+    static inline uint64_t hashShort(const uint8_t* data, size_t length) noexcept;
+    static inline uint64_t hashMedium(const uint8_t* data, size_t length) noexcept;
+    static inline uint64_t hashLong(const uint8_t* data, size_t length) noexcept;
+    static inline void accumulate(uint64_t* accumulators, const uint8_t* data, const uint8_t* secret) noexcept;
+};
+
+/**
+ * @brief UrlView struct splitting an absolute URL into its parts without copying.
+ */
+struct UrlView {
+    std::string_view scheme; /**< The scheme, e.g. "https", empty if missing. */
+    std::string_view host;   /**< The host, without user info and port; IPv6 hosts keep their brackets. */
+    std::string_view port;   /**< The port, empty if missing. */
+    std::string_view target; /**< The path and query without the fragment, as written (possibly empty). */
+
+    /**
+     * @brief Splits a URL.
+     *
+     * @param url The URL, which must outlive the view.
+     * @return UrlView The parts of the URL.
+     */
+    [[nodiscard]] static inline UrlView parse(std::string_view url) noexcept;
+
+    /**
+     * @brief Returns the host and port, lowercased and without the default port of the scheme.
+     *
+     * @return std::string The authority, e.g. "example.com" or "example.com:8443".
+     */
+    [[nodiscard]] inline std::string authority() const;
+
+    /**
+     * @brief Returns the target of an HTTP request line, which always starts with a slash.
+     *
+     * @return std::string The path and query, e.g. "/" or "/?q=1".
+     */
+    [[nodiscard]] std::string requestTarget() const {
+        return target.empty() || target.front() != '/' ? "/" + std::string(target) : std::string(target);
+    }
+};
+
+/**
+ * @brief TransportOptions struct containing the connection pool options of the library.
+ *
+ * The options are passed to the HTTP transport of the library (see
+ * SessionData::transportOptions). Unset limits keep the defaults of the library.
+ * The pool only outlives a request when the session has a sessionId.
+ */
+struct TransportOptions {
+    std::optional<int> maxIdleConns;        /**< Maximum idle connections over all hosts, 0 for no limit. */
+    std::optional<int> maxIdleConnsPerHost; /**< Maximum idle connections kept per host. */
+    std::optional<int> maxConnsPerHost;     /**< Maximum connections per host, 0 for no limit. */
+    std::optional<std::chrono::milliseconds> idleConnTimeout; /**< How long idle connections are kept. */
+    std::optional<int> readBufferSize;      /**< Size of the read buffer of a connection, in bytes. */
+    std::optional<int> writeBufferSize;     /**< Size of the write buffer of a connection, in bytes. */
+    bool disableKeepAlives = false;         /**< Whether to open a new connection for every request. */
+    bool disableCompression = false;        /**< Whether to stop requesting gzip compressed responses. */
+};
+
 /**
  * @brief SessionData struct containing tls session information
  *
@@ -509,6 +749,140 @@ struct SessionData {
      * Note: The actual content or type of headers can vary depending on the specific protocol or message format.
      */
     std::optional<std::string> headerOrder;
+
+    /**
+     * @brief profile field
+     *
+     * This field holds the fingerprint of a compile-time profile, as the JSON
+     * members written into every request envelope. When it is set, the
+     * fingerprint fields above (ja3String to headerOrder, connectionFlow
+     * included) are ignored. It points to static data and is set by
+     * ProfileSession (see tls_client_profile.hpp). It is fixed when a session
+     * is constructed: setSessionData keeps the profile of the session.
+     */
+    std::string_view profile;
+
+    /**
+     * @brief sessionId field
+     *
+     * This optional field identifies the client kept by the library between requests.
+     * Without it, the library creates a client, and so opens new connections, for
+     * every request. Sessions with the same id share their client and connections,
+     * which are released once no BasicSession holds the id any more: when the last
+     * one is destroyed or switches to another id with setSessionData.
+     *
+     * The client is created with the options of the first request of the id:
+     * a later setSessionData with other transportOptions (or client settings) has
+     * no effect on an id already in use. Use a new id to apply them.
+     *
+     * Example: "crawler-1"
+     */
+    std::optional<std::string> sessionId;
+
+    /**
+     * @brief localAddress field
+     *
+     * This optional field specifies the local address the connections of the library
+     * are bound to, as "ip:port"; port 0 picks an ephemeral port. Binding to one of
+     * several local addresses spreads the connections to a host over more source
+     * ports (see SessionPool).
+     *
+     * Example: "10.0.0.2:0"
+     */
+    std::optional<std::string> localAddress;
+
+    /**
+     * @brief transportOptions field
+     *
+     * This optional field specifies the connection pool options of the library
+     * (see @ref TransportOptions). The pool limits only matter together with a sessionId,
+     * and are fixed by the first request of the id (see @ref sessionId).
+     */
+    std::optional<TransportOptions> transportOptions;
+
+    /**
+     * @brief maxResponseSize field
+     *
+     * This optional field specifies the maximum size in bytes of a response, as returned
+     * by the library (the body together with its headers and cookies). Larger responses
+     * are discarded without being copied and fail with ErrorCode::ResponseTooLarge.
+     * The library still reads the whole response; the limit is not forwarded to it.
+     *
+     * It applies to every request of the session, unless the request sets its own limit.
+     *
+     * Example: 16777216 (16 MiB)
+     */
+    std::optional<size_t> maxResponseSize;
+
+    /**
+     * @brief spillThreshold field
+     *
+     * This optional field specifies the body size in bytes above which response bodies
+     * are moved out of the heap into an anonymous memory-mapped file (see
+     * ResponseData::mappedBody). Bodies returned by the library are written into the
+     * file straight from the library response, without a heap copy. Only supported on
+     * Linux and macOS.
+     *
+     * Example: 8388608 (8 MiB)
+     */
+    std::optional<size_t> spillThreshold;
+
+    /**
+     * @brief spillDirectory field
+     *
+     * This optional field specifies the directory where spilled bodies are stored as
+     * unnamed files. When unset, spilled bodies are kept in in-memory files (memfd),
+     * which can only be reclaimed by swapping. Pointing it to a disk-backed directory
+     * lets the kernel write the pages back and drop them.
+     *
+     * Example: "/var/tmp"
+     */
+    std::optional<std::string> spillDirectory;
+
+    /**
+     * @brief sinks field
+     *
+     * This field specifies the sinks receiving every completed response of the
+     * session, in order (see @ref ResponseSink). Sinks run after the body is spilled.
+     */
+    std::vector<std::shared_ptr<ResponseSink>> sinks;
+
+    /**
+     * @brief backend field
+     *
+     * This optional field specifies a backend performing the requests of the
+     * session instead of the tls-client library (see @ref RequestBackend).
+     */
+    std::shared_ptr<RequestBackend> backend;
+
+    /**
+     * @brief backendHosts field
+     *
+     * This field restricts the backend to the given hosts. An entry matches
+     * the host exactly or, if it starts with "*.", any subdomain. When empty,
+     * the backend performs every request it supports.
+     *
+     * Example: {"api.internal", "*.partner.example"}
+     */
+    std::vector<std::string> backendHosts;
+
+    /**
+     * @brief resolver field
+     *
+     * This optional field specifies a resolver for the host names of the requests
+     * sent through the library (see @ref HostResolver and DnsCache). Requests
+     * through a proxy, to IP addresses or with a serverNameOverwrite are sent unchanged.
+     */
+    std::shared_ptr<HostResolver> resolver;
+
+    /**
+     * @brief failureCache field
+     *
+     * This optional field specifies a cache failing requests at once, without
+     * calling the library or the backend, while matching requests keep failing
+     * (see @ref FailureCache and NegativeCache).
+     */
+    std::shared_ptr<FailureCache> failureCache;
 };
 
 /**
@@ -597,6 +971,193 @@ struct RequestData {
      * Example: {"key": "value"}
      */
     std::optional<std::string> data;
+
+    /**
+     * @brief maxResponseSize field
+     *
+     * This optional field specifies the maximum size in bytes of the response to this
+     * request, overriding SessionData::maxResponseSize.
+     *
+     * Example: 1048576 (1 MiB)
+     */
+    std::optional<size_t> maxResponseSize;
+
+    /**
+     * @brief serverNameOverwrite field
+     *
+     * This optional field specifies the server name sent in the TLS handshake (SNI)
+     * instead of the host of the URL, e.g. when the URL holds an IP address.
+     *
+     * Example: "example.com"
+     */
+    std::optional<std::string> serverNameOverwrite;
+
+    /**
+     * @brief requestHostOverride field
+     *
+     * This optional field specifies the Host header (:authority in HTTP/2) of the
+     * request instead of the host of the URL.
+     *
+     * Example: "example.com"
+     */
+    std::optional<std::string> requestHostOverride;
+};
+
+/**
+ * @brief MappedBody class holding a response body in an anonymous memory-mapped file.
+ *
+ * The file is created with `O_TMPFILE` in a given directory or with `memfd_create`
+ * (falling back to an unlinked `mkstemp` file), so it has no name and disappears
+ * with the last reference. Its pages can be reclaimed by the kernel under memory
+ * pressure, unlike heap memory. Not supported on Windows.
+ */
+class MappedBody {
+public:
+    /**
+     * @brief Copies data into a new anonymous memory-mapped file.
+     *
+     * @param data The data to store.
+     * @param directory The directory to create the file in, or nothing to use an in-memory file.
+     * @return std::shared_ptr<const MappedBody> The mapped data, or nullptr on failure.
+     */
+    [[nodiscard]] static inline std::shared_ptr<const MappedBody> create(std::string_view data,
+        const std::optional<std::string>& directory = std::nullopt);
+
+    MappedBody(const MappedBody&) = delete;
+    MappedBody& operator=(const MappedBody&) = delete;
+
+    /**
+     * @brief Destructor unmapping and closing the file.
+     */
+    inline ~MappedBody();
+
+    /**
+     * @brief Returns the mapped data.
+     *
+     * @return std::string_view The mapped data.
+     */
+    [[nodiscard]] std::string_view view() const noexcept { return {static_cast<const char*>(address), size}; }
+
+    /**
+     * @brief Returns the file descriptor of the file.
+     *
+     * @return int The file descriptor, valid as long as this object.
+     */
+    [[nodiscard]] int fd() const noexcept { return file; }
+
+private:
+    int file;      /**< The file descriptor of the file. */
+    void* address; /**< The address the file is mapped at. */
+    size_t size;   /**< The size of the mapped data. */
+
+    MappedBody(int file, void* address, size_t size) : file(file), address(address), size(size) {}
+
+    /**
+     * @brief Opens a new anonymous file.
+     *
+     * @param directory The directory to create the file in, or nothing to use an in-memory file.
+     * @return int The file descriptor, or -1 on failure.
+     */
+    static inline int openAnonymousFile(const std::optional<std::string>& directory);
+};
+
+/**
+ * @brief MemoryScope class routing the temporary allocations of the requests of a thread to a memory resource.
+ *
+ * While a scope is alive, the requests made on its thread take their
+ * temporaries from the resource: the library response, the parse state of
+ * the codecs and of JsonSax and JsonDecoder. RequestData, ResponseData and the
+ * other values handed back keep using the global heap, so they can outlive the
+ * resource. A request/response cycle can then run in a monotonic arena that is
+ * released in one step:
+ *
+ * @code
+ * std::array<std::byte, 1 << 16> buffer;
+ * std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+ * {
+ *     MemoryScope scope(&arena);
+ *     response = session.tryGET(requestData);
+ * }
+ * @endcode
+ *
+ * Scopes nest, and only affect their own thread: requests run by tryBatch or
+ * a Pipeline use the scopes of their executor threads.
+ */
+class MemoryScope {
+public:
+    /**
+     * @brief Routes the temporary allocations of this thread to a resource until destroyed.
+     *
+     * @param resource The memory resource, which must outlive the scope.
+     */
+    explicit MemoryScope(std::pmr::memory_resource* resource) noexcept : previous(current()) {
+        current() = resource;
+    }
+
+    /**
+     * @brief Destructor restoring the resource of the enclosing scope.
+     */
+    ~MemoryScope() { current() = previous; }
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+    /**
+     * @brief Returns the resource of the innermost scope of this thread.
+     *
+     * @return std::pmr::memory_resource* The resource, or the default resource outside any scope.
+     */
+    [[nodiscard]] static std::pmr::memory_resource* resource() noexcept {
+        std::pmr::memory_resource* resource = current();
+        return resource ? resource : std::pmr::get_default_resource();
+    }
+
+private:
+    std::pmr::memory_resource* previous; /**< The resource of the enclosing scope. */
+
+    [[nodiscard]] static std::pmr::memory_resource*& current() noexcept {
+        static thread_local std::pmr::memory_resource* resource = nullptr;
+        return resource;
+    }
+};
+
+/**
+ * @brief HugePageResource class allocating memory straight from the kernel, in huge pages when possible.
+ *
+ * Meant as the upstream of a std::pmr::monotonic_buffer_resource, whose blocks
+ * it maps in multiples of 2 MiB: with MAP_HUGETLB when huge pages are
+ * reserved, and otherwise as normal pages advised to become transparent huge
+ * pages. Other systems than Linux, and alignments above the page size, use the
+ * default resource.
+ *
+ * @code
+ * HugePageResource hugePages;
+ * std::pmr::monotonic_buffer_resource arena(HugePageResource::HUGE_PAGE_SIZE, &hugePages);
+ * @endcode
+ */
+class HugePageResource : public std::pmr::memory_resource {
+public:
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024; /**< The size blocks are rounded up to. */
+
+protected:
+    inline void* do_allocate(size_t bytes, size_t alignment) override;
+    inline void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    /**
+     * @brief Checks whether an allocation is mapped, rather than taken from the default resource.
+     */
+    [[nodiscard]] static bool mapped([[maybe_unused]] size_t alignment) noexcept {
+#if defined(OS_LINUX)
+        return alignment <= 4096;
+#else
+        return false;
+#endif
+    }
 };
 
 /**
@@ -614,7 +1175,7 @@ struct ResponseData {
      *
      * Example: 200 (OK)
      */
-    int statusCode;
+    int statusCode = 0;
 
     /**
      * @brief body field
@@ -670,498 +1231,3928 @@ struct ResponseData {
      * Example: "HTTP/1.1"
      */
     std::string usedProtocol;
-};
 
-/**
- * @brief TlsClient class for performing TLS requests.
- */
-class TlsClient {
-public:
     /**
-     * @brief Performs a TLS request with the provided input.
+     * @brief mappedBody field
      *
-     * @param input The input data for the request.
-     * @return std::string The response from the TLS request.
+     * When the body is larger than SessionData::spillThreshold, it is moved into an
+     * anonymous memory-mapped file held by this field, and @ref body is left empty.
+     * Use @ref bodyView to read the body wherever it is stored.
      */
-    static std::string performRequest(const std::string& input);
+    std::shared_ptr<const MappedBody> mappedBody;
 
     /**
-     * @brief Destructor for the TlsClient class.
+     * @brief bodyEscaped field
      *
-     * This destructor is private to prevent direct instantiation and to manage
-     * the lifecycle of the TLS client within the defined class structure.
+     * This field tells whether @ref body keeps the JSON escape sequences of the library
+     * response. It is only false for backends returning the raw body (see
+     * NativeBackendOptions::escapeBody).
      */
-     ~TlsClient();
-private:
-    using RequestFunc = char* (*)(const char*);   /**< Type definition for request function pointer. */
-    using FreeMemoryFunc = void (*)(char*);       /**< Type definition for free memory function pointer. */
-
-    static inline RequestFunc request;            /**< Pointer to the request function. */
-    static inline FreeMemoryFunc freeMemory;      /**< Pointer to the free memory function. */
-    static inline std::shared_ptr<void> hLib;     /**< Handle to the loaded library. */
+    bool bodyEscaped = true;
 
     /**
-     * @brief Ensures the TLS client is initialized.
+     * @brief bodyHash field
      *
-     * This function ensures that the necessary components of the TLS client
-     * are initialized before performing any request.
+     * This optional field contains the content hash of the decoded body (see @ref ContentHash
+     * and @ref decodeBody), set by sinks that hash bodies such as BodyStore. Equal hashes
+     * mean equal bodies, so downstream stages can skip unchanged content.
      */
-    static inline void ensureInitialized();
-};
+    std::optional<uint64_t> bodyHash;
 
-/**
- * @brief JsonHelper class provides utilities for JSON parsing and generation.
- */
-class JsonHelper {
-public:
     /**
-     * @brief Parses JSON response into ResponseData structure.
+     * @brief Returns the body of the response, whether it is held in memory or mapped.
      *
-     * @param json The JSON string to parse.
-     * @return ResponseData The parsed response data.
+     * @return std::string_view The body, valid as long as this response.
      */
-    [[nodiscard]] static inline ResponseData parseResponse(const std::string& json);
+    [[nodiscard]] std::string_view bodyView() const noexcept {
+        return mappedBody ? mappedBody->view() : std::string_view(body);
+    }
 
     /**
-     * @brief Builds JSON string from given data.
+     * @brief Returns the body as the server sent it, with its JSON escape sequences decoded.
      *
-     * @tparam Args Variadic template parameter pack for data types.
-     * @param data The unordered map containing key-value pairs.
-     * @return std::string The JSON string representation of the data.
+     * @return std::string The decoded body.
      */
-    template <typename... Args>
-    [[nodiscard]] static inline std::string buildJson(const std::unordered_map<std::string, std::any>& data);
+    [[nodiscard]] inline std::string decodeBody() const;
+
+    /**
+     * @brief Returns the first value of a response header.
+     *
+     * @param name The name of the header, matched case-insensitively.
+     * @return std::optional<std::string> The unescaped value, or nothing if the header is missing or empty.
+     */
+    [[nodiscard]] std::optional<std::string> header(std::string_view name) const { return findHeader(headers, name); }
+
+    /**
+     * @brief Returns the first value of a header in a JSON object of headers.
+     *
+     * @param headers The headers, as in @ref headers.
+     * @param name The name of the header, matched case-insensitively.
+     * @return std::optional<std::string> The unescaped value, or nothing if the header is missing or empty.
+     */
+    [[nodiscard]] static inline std::optional<std::string> findHeader(std::string_view headers, std::string_view name);
+};
+
+/**
+ * @brief SharedResponse class holding an immutable response in a single reference-counted buffer.
+ *
+ * Every field is a view into one buffer: the response string returned by the
+ * library, released with its freeMemory when the last reference goes away, or
+ * one heap copy for responses that did not come straight from the library.
+ * Stages that all consume a response (cache, archive, parser, metrics) can
+ * share the std::shared_ptr across threads, for an atomic increment instead of
+ * a copy of the body each:
+ *
+ * @code
+ * Expected<std::shared_ptr<const SharedResponse>> response = session.tryShare(requestData, "GET");
+ * cache.push(*response);
+ * archive.push(*response);
+ * @endcode
+ *
+ * The fields follow the rules of ResponseData: the body keeps its escape
+ * sequences, and the headers and cookies are JSON objects.
+ */
+class SharedResponse {
+public:
+    /**
+     * @brief Copies a response into a new shared buffer.
+     *
+     * A mapped body is shared rather than copied.
+     *
+     * @param responseData The response to copy.
+     * @return std::shared_ptr<const SharedResponse> The shared response.
+     */
+    [[nodiscard]] static inline std::shared_ptr<const SharedResponse> copy(const ResponseData& responseData);
+
+    SharedResponse(const SharedResponse&) = delete;
+    SharedResponse& operator=(const SharedResponse&) = delete;
+
+    /**
+     * @brief Returns the HTTP status code of the response.
+     */
+    [[nodiscard]] int statusCode() const noexcept { return status; }
+
+    /**
+     * @brief Returns the body of the response, whether it is held in the buffer or mapped.
+     */
+    [[nodiscard]] std::string_view body() const noexcept { return mappedBody ? mappedBody->view() : bodyText; }
+
+    /**
+     * @brief Returns the headers of the response, as a JSON object.
+     */
+    [[nodiscard]] std::string_view headers() const noexcept { return headersText; }
+
+    /**
+     * @brief Returns the cookies of the response, as a JSON object.
+     */
+    [[nodiscard]] std::string_view cookies() const noexcept { return cookiesText; }
+
+    /**
+     * @brief Returns the final URL of the response, after any redirects.
+     */
+    [[nodiscard]] std::string_view target() const noexcept { return targetText; }
+
+    /**
+     * @brief Returns the protocol used for the response.
+     */
+    [[nodiscard]] std::string_view usedProtocol() const noexcept { return protocolText; }
+
+    /**
+     * @brief Returns the content hash of the body, if a sink computed it.
+     */
+    [[nodiscard]] std::optional<uint64_t> bodyHash() const noexcept { return hash; }
+
+    /**
+     * @brief Returns the size of the buffer holding the response.
+     */
+    [[nodiscard]] size_t size() const noexcept { return length; }
+
+    /**
+     * @brief Returns the first value of a response header.
+     *
+     * @param name The name of the header, matched case-insensitively.
+     * @return std::optional<std::string> The unescaped value, or nothing if the header is missing or empty.
+     */
+    [[nodiscard]] std::optional<std::string> header(std::string_view name) const {
+        return ResponseData::findHeader(headersText, name);
+    }
+
+    /**
+     * @brief Copies the response into a ResponseData.
+     *
+     * @return ResponseData The response, sharing the mapped body if any.
+     */
+    [[nodiscard]] inline ResponseData toResponseData() const;
 
 private:
+    friend class TlsClient;
+
+    std::unique_ptr<char, void (*)(char*)> data; /**< The buffer, with the function releasing it. */
+    size_t length = 0;                           /**< The size of the buffer. */
+    int status = 0;                              /**< The HTTP status code. */
+    std::string_view bodyText;                   /**< The body, in the buffer. */
+    std::string_view headersText;                /**< The headers, in the buffer. */
+    std::string_view cookiesText;                /**< The cookies, in the buffer. */
+    std::string_view targetText;                 /**< The target, in the buffer. */
+    std::string_view protocolText;               /**< The protocol, in the buffer. */
+    std::shared_ptr<const MappedBody> mappedBody; /**< The mapped body, if the body was spilled. */
+    std::optional<uint64_t> hash;                /**< The content hash of the body. */
+    bool escaped = true;                         /**< Whether the body keeps its JSON escape sequences. */
+
+    SharedResponse(char* data, size_t length, void (*release)(char*)) : data(data, release), length(length) {}
+
     /**
-     * @brief Converts a value to its JSON string representation.
+     * @brief Takes ownership of a library response and points the fields into it.
      *
-     * @tparam T Type of the value.
-     * @param value The value to convert.
-     * @return std::string The JSON string representation of the value.
+     * @param data The library response.
+     * @param length The size of the library response.
+     * @param release The function releasing the library response.
+     * @return std::shared_ptr<const SharedResponse> The shared response, or nullptr if it is
+     * malformed, in which case the library response is left to the caller.
      */
-    template <typename T>
-    [[nodiscard]] static inline std::string jsonValue(const T& value);
+    [[nodiscard]] static inline std::shared_ptr<const SharedResponse> adopt(char* data, size_t length,
+        void (*release)(char*));
+};
+
+/**
+ * @brief ErrorCode enum describing why a request failed.
+ */
+enum class ErrorCode {
+    Timeout,     /**< The request did not complete within its timeout. */
+    Proxy,       /**< The proxy could not be reached or refused the request. */
+    Tls,         /**< The TLS handshake or certificate verification failed. */
+    Dns,         /**< The host name could not be resolved. */
+    Connection,  /**< The connection was refused, reset or closed early. */
+    Request,     /**< Any other failure reported by the library. */
+    Parse,       /**< The library response could not be parsed. */
+    Library,     /**< The shared library could not be loaded. */
+    ResponseTooLarge, /**< The response exceeded the configured maximum size. */
+    Io           /**< A file could not be opened, read or written. */
+};
 
+/**
+ * @brief Error struct containing a structured request error.
+ */
+struct Error {
     /**
-     * @brief Appends a key-value pair to the JSON string stream.
+     * @brief code field
      *
-     * @param oss The output string stream to append to.
-     * @param key The key for the JSON object.
-     * @param value The value associated with the key.
+     * This field specifies the class of the error, so retry logic
+     * can branch on it without parsing the message.
      */
-    static inline void appendValue(std::ostringstream& oss, [[maybe_unused]] const std::string& key, const std::any& value);
+    ErrorCode code;
 
     /**
-     * @brief Tokenizes a JSON string into individual tokens.
+     * @brief message field
+     *
+     * This field contains the human readable error message, usually
+     * the one reported by the library.
      *
-     * @param json The JSON string to tokenize.
-     * @return std::vector<std::string> Vector of tokens extracted from the JSON string.
+     * Example: "failed to do request: ... context deadline exceeded"
      */
-    [[nodiscard]] static inline std::vector<std::string> tokenize(const std::string& json);
+    std::string message;
+};
+
+/**
+ * @brief Unexpected struct wrapping an error to construct an Expected from.
+ *
+ * @tparam E Type of the error.
+ */
+template <typename E>
+struct Unexpected {
+    E error; /**< The wrapped error. */
+};
 
+/**
+ * @brief Expected class holding either a value or an error.
+ *
+ * A minimal C++17 stand-in for `std::expected`, used by the non-throwing
+ * API. Accessing the value of an Expected holding an error throws
+ * `std::logic_error` (or aborts when exceptions are disabled).
+ *
+ * @tparam T Type of the value.
+ * @tparam E Type of the error.
+ */
+template <typename T, typename E = Error>
+class Expected {
+public:
     /**
-     * @brief Appends a key-value pair to the JSON string stream.
+     * @brief Constructs an Expected holding a value.
      *
-     * This function is used for basic data types.
+     * @param value The value to hold.
+     */
+    Expected(T value) : storage(std::in_place_index<0>, std::move(value)) {}
+
+    /**
+     * @brief Constructs an Expected holding an error.
      *
-     * @tparam T Type of the value.
-     * @param oss The output string stream to append to.
-     * @param key The key for the JSON object.
-     * @param value The value associated with the key.
+     * @param unexpected The error to hold.
      */
-    template <typename T>
-    static inline void appendKeyValue(std::ostringstream& oss, const std::string& key, const T& value);
+    Expected(Unexpected<E> unexpected) : storage(std::in_place_index<1>, std::move(unexpected.error)) {}
 
     /**
-     * @brief Helper struct for always_false type trait.
+     * @brief Checks whether the Expected holds a value.
      *
-     * Provides a type trait that is always false.
+     * @return bool True if a value is held, false if an error is held.
      */
-    template <typename T>
-    struct always_false : std::false_type {};
+    [[nodiscard]] bool hasValue() const noexcept { return storage.index() == 0; }
+
+    /**
+     * @brief Checks whether the Expected holds a value.
+     */
+    explicit operator bool() const noexcept { return hasValue(); }
+
+    /**
+     * @brief Returns the held value.
+     *
+     * @return T& The held value.
+     * @throws std::logic_error if an error is held.
+     */
+    [[nodiscard]] T& value() & { checkValue(); return *std::get_if<0>(&storage); }
+    [[nodiscard]] const T& value() const& { checkValue(); return *std::get_if<0>(&storage); }
+    [[nodiscard]] T&& value() && { checkValue(); return std::move(*std::get_if<0>(&storage)); }
+
+    /**
+     * @brief Returns the held value or a fallback if an error is held.
+     *
+     * @param fallback The value to return if an error is held.
+     * @return T The held value or the fallback.
+     */
+    [[nodiscard]] T valueOr(T fallback) const& { return hasValue() ? *std::get_if<0>(&storage) : std::move(fallback); }
+    [[nodiscard]] T valueOr(T fallback) && { return hasValue() ? std::move(*std::get_if<0>(&storage)) : std::move(fallback); }
+
+    /**
+     * @brief Returns the held error. Must only be called if no value is held.
+     *
+     * @return E& The held error.
+     */
+    [[nodiscard]] E& error() & noexcept { return *std::get_if<1>(&storage); }
+    [[nodiscard]] const E& error() const& noexcept { return *std::get_if<1>(&storage); }
+
+    T& operator*() & noexcept { return *std::get_if<0>(&storage); }
+    const T& operator*() const& noexcept { return *std::get_if<0>(&storage); }
+    T* operator->() noexcept { return std::get_if<0>(&storage); }
+    const T* operator->() const noexcept { return std::get_if<0>(&storage); }
+
+private:
+    std::variant<T, E> storage; /**< The held value or error. */
+
+    /**
+     * @brief Throws if no value is held.
+     */
+    void checkValue() const {
+        if (!hasValue()) {
+            TLS_CLIENT_THROW(std::logic_error("Expected does not hold a value"));
+        }
+    }
 };
 
+/**
+ * @brief RequestBackend class performing requests without the tls-client library.
+ *
+ * A backend set in SessionData::backend performs the requests it supports
+ * (and, with SessionData::backendHosts, only for the listed hosts); the
+ * other requests still go through the library. Backends return the same
+ * ResponseData as the library, so sinks and callers see no difference.
+ * Implementations must be thread-safe.
+ */
+class RequestBackend {
+public:
+    virtual ~RequestBackend() = default;
+
+    /**
+     * @brief Checks whether the backend can perform a request, e.g. its scheme and proxy.
+     *
+     * @param requestData The request data of the request.
+     * @return bool Whether the backend can perform the request.
+     */
+    [[nodiscard]] virtual bool supports(const RequestData& requestData) const = 0;
+
+    /**
+     * @brief Performs a request.
+     *
+     * @param requestData The request data of the request.
+     * @param method The HTTP method of the request.
+     * @param maxResponseSize The maximum size of the response body.
+     * @return Expected<ResponseData> The response, or the error that prevented it.
+     */
+    [[nodiscard]] virtual Expected<ResponseData> perform(const RequestData& requestData, const std::string& method,
+        size_t maxResponseSize) = 0;
+};
 
 /**
- * @brief Session class for managing HTTP session operations.
+ * @brief HostResolver class resolving the host names of the requests of a session.
+ *
+ * A resolver set in SessionData::resolver makes the library connect to the
+ * returned address, while the TLS server name and the Host header keep the
+ * host name. Implementations must be thread-safe (see DnsCache).
  */
-class Session {
+class HostResolver {
 public:
+    virtual ~HostResolver() = default;
+
     /**
-     * @brief Constructor to initialize the session with provided session data.
+     * @brief Resolves a host name.
      *
-     * @param sessionData The session data to initialize the session with.
+     * @param host The host name, lowercase.
+     * @return Expected<std::string> The IP address to connect to, or the error
+     * (usually ErrorCode::Dns) failing the request.
      */
-    Session(SessionData sessionData) : sessionData(sessionData) {};
+    [[nodiscard]] virtual Expected<std::string> resolve(const std::string& host) = 0;
+};
+
+/**
+ * @brief FailureCache class remembering failed requests, so that matching ones fail at once.
+ *
+ * A cache set in SessionData::failureCache is asked before every request and
+ * told the outcome of every request it did not fail. Implementations decide
+ * which requests match and for how long (see NegativeCache), and must be thread-safe.
+ */
+class FailureCache {
+public:
+    virtual ~FailureCache() = default;
 
     /**
-     * @brief Sends a GET request using the session.
+     * @brief Returns the cached error of a request, if a matching request failed recently.
      *
-     * @param requestData The request data for the GET request.
-     * @return ResponseData The response from the GET request.
+     * @param requestData The request data of the request.
+     * @return std::optional<Error> The error to fail the request with.
      */
-    ResponseData GET(RequestData requestData);
+    [[nodiscard]] virtual std::optional<Error> lookup(const RequestData& requestData) = 0;
+
+    /**
+     * @brief Records the error of a failed request.
+     *
+     * @param requestData The request data of the request.
+     * @param error The error of the request.
+     */
+    virtual void recordFailure(const RequestData& requestData, const Error& error) = 0;
+
+    /**
+     * @brief Records a request that completed, with any status code.
+     *
+     * @param requestData The request data of the request.
+     */
+    virtual void recordSuccess(const RequestData& requestData) = 0;
+};
+
+/**
+ * @brief TlsClient class for performing TLS requests.
+ */
+class TlsClient {
+public:
+    /**
+     * @brief Performs a TLS request with the provided input.
+     *
+     * @param input The input data for the request.
+     * @param maxResponseSize The maximum size of the response.
+     * @return std::string The response from the TLS request.
+     * @throws std::length_error if the response is larger than maxResponseSize.
+     */
+    static std::string performRequest(const std::string& input, size_t maxResponseSize = SIZE_MAX);
+
+    /**
+     * @brief Performs a TLS request with the provided input without throwing.
+     *
+     * @param input The input data for the request.
+     * @param maxResponseSize The maximum size of the response.
+     * @return Expected<std::string> The response from the TLS request, an
+     * ErrorCode::Library error if the library could not be loaded, or an
+     * ErrorCode::ResponseTooLarge error if the response is larger than maxResponseSize.
+     */
+    [[nodiscard]] static inline Expected<std::string> tryPerformRequest(const std::string& input,
+        size_t maxResponseSize = SIZE_MAX);
+
+    /**
+     * @brief Performs a TLS request without throwing, copying the response into a memory resource.
+     *
+     * @param input The input data for the request.
+     * @param maxResponseSize The maximum size of the response.
+     * @param resource The memory resource the response is allocated from.
+     * @return Expected<std::pmr::string> The response from the TLS request, or
+     * the same errors as the other overload.
+     */
+    [[nodiscard]] static inline Expected<std::pmr::string> tryPerformRequest(const std::string& input,
+        size_t maxResponseSize, std::pmr::memory_resource* resource);
+
+    /**
+     * @brief Performs a TLS request without throwing, keeping the response in the buffer of the library.
+     *
+     * @param input The input data for the request.
+     * @param maxResponseSize The maximum size of the response.
+     * @return Expected<std::shared_ptr<const SharedResponse>> The response, released with
+     * freeMemory once no longer referenced, the same errors as tryPerformRequest, or an
+     * ErrorCode::Parse error if the response is malformed.
+     */
+    [[nodiscard]] static inline Expected<std::shared_ptr<const SharedResponse>> tryPerformShared(
+        const std::string& input, size_t maxResponseSize = SIZE_MAX);
+
+    /**
+     * @brief Maps an error message reported by the library to an error code.
+     *
+     * Messages of failed requests name the request as `<Method> "<url>": <cause>`; only
+     * the cause is matched, so the URL cannot change the class.
+     *
+     * @param message The unescaped error message.
+     * @return ErrorCode The class of the error.
+     */
+    [[nodiscard]] static inline ErrorCode classifyError(std::string_view message);
+
+    /**
+     * @brief Builds the error of a failed request from the body of a response with status 0.
+     *
+     * @param body The body, with its JSON escape sequences.
+     * @return Error The classified error with the unescaped message.
+     */
+    [[nodiscard]] static inline Error libraryError(std::string_view body);
+
+    /**
+     * @brief Registers one more holder of a session id, see releaseSession.
+     *
+     * @param sessionId The session id.
+     */
+    static inline void retainSession(const std::string& sessionId);
+
+    /**
+     * @brief Releases a holder of a session id, and the client the library keeps
+     * for it, closing its connections, once no holder is left.
+     *
+     * An id that was never retained is released at once. Does nothing more if
+     * the library was never loaded or does not export destroySession; the
+     * library is not loaded by this call.
+     *
+     * @param sessionId The session id.
+     */
+    static inline void releaseSession(const std::string& sessionId);
+
+    /**
+     * @brief Destructor for the TlsClient class.
+     *
+     * This destructor is private to prevent direct instantiation and to manage
+     * the lifecycle of the TLS client within the defined class structure.
+     */
+     ~TlsClient();
+private:
+    using RequestFunc = char* (*)(const char*);   /**< Type definition for request function pointer. */
+    using FreeMemoryFunc = void (*)(char*);       /**< Type definition for free memory function pointer. */
+    using DestroySessionFunc = char* (*)(const char*); /**< Type definition for destroy session function pointer. */
+
+    static inline RequestFunc request;            /**< Pointer to the request function. */
+    static inline FreeMemoryFunc freeMemory;      /**< Pointer to the free memory function. */
+    static inline DestroySessionFunc destroySession; /**< Pointer to the destroy session function. */
+    static inline std::atomic<bool> loaded{false};   /**< Whether the library was loaded. */
+    static inline std::mutex sessionMutex;           /**< Guards the session holders. */
+    static inline std::unordered_map<std::string, size_t> sessionHolders; /**< The holders of each session id. */
+    static inline std::shared_ptr<void> hLib;     /**< Handle to the loaded library. */
+
+    /**
+     * @brief Ensures the TLS client is initialized.
+     *
+     * This function ensures that the necessary components of the TLS client
+     * are initialized before performing any request.
+     */
+    static inline void ensureInitialized();
+
+    /**
+     * @brief Loads the library once.
+     *
+     * @return const std::optional<Error>& The error if the library failed to load.
+     */
+    static inline const std::optional<Error>& initialize();
+
+    /**
+     * @brief Copies a response returned by the library and releases it.
+     *
+     * The response is only copied if it is not larger than maxResponseSize,
+     * which is checked without reading past the limit.
+     *
+     * @tparam String The string type of the copy.
+     * @param result The response returned by the library.
+     * @param maxResponseSize The maximum size of the response.
+     * @param allocator The allocator of the copy.
+     * @return std::optional<String> The response, or nothing if it is too large.
+     */
+    template <typename String>
+    static inline std::optional<String> takeResponse(char* result, size_t maxResponseSize,
+        const typename String::allocator_type& allocator = {});
+
+    /**
+     * @brief Sends a request to the library.
+     *
+     * @param input The input data for the request.
+     * @return Expected<char*> The response, to release with freeMemory, or the
+     * error that prevented the library from answering.
+     */
+    [[nodiscard]] static inline Expected<char*> send(const std::string& input);
+
+    /**
+     * @brief Finds the end of a response, without reading more than one byte past the maximum size.
+     *
+     * @param result The response returned by the library.
+     * @param maxResponseSize The maximum size of the response.
+     * @return const char* The terminating null byte, or nullptr if the response is too large.
+     */
+    [[nodiscard]] static inline const char* findEnd(const char* result, size_t maxResponseSize) noexcept;
+
+    /**
+     * @brief Sends a request to the library, copying the response into a String.
+     */
+    template <typename String>
+    static inline Expected<String> tryPerform(const std::string& input, size_t maxResponseSize,
+        const typename String::allocator_type& allocator);
+};
+
+/**
+ * @brief JsonHelper class provides utilities for JSON parsing and generation.
+ *
+ * JsonHelper is also the built-in JSON codec used by @ref BasicSession. A codec is
+ * any type providing the static functions below:
+ *
+ * @code
+ * struct MyCodec {
+ *     static std::string buildJson(const std::unordered_map<std::string, std::any>& data);
+ *     static ResponseData parseResponse(std::string_view json);
+ *     static Expected<ResponseData> tryParseResponse(std::string_view json);
+ * };
+ * @endcode
+ *
+ * @note String values of the request fields holding an object or array, such
+ * as headers or h2Settings (see isRawField), are embedded as-is when they look
+ * like one; every other string, requestBody and requestUrl included, is
+ * escaped. ResponseData::body keeps the escape sequences of the library
+ * response. Every codec follows the same rules, so they can be swapped freely.
+ */
+class JsonHelper {
+public:
+    /**
+     * @brief Parses JSON response into ResponseData structure.
+     *
+     * @param json The JSON string to parse.
+     * @return ResponseData The parsed response data.
+     */
+    [[nodiscard]] static inline ResponseData parseResponse(std::string_view json);
+
+    /**
+     * @brief Parses JSON response into ResponseData structure without throwing.
+     *
+     * @param json The JSON string to parse.
+     * @return Expected<ResponseData> The parsed response data, or an
+     * ErrorCode::Parse error if the response is malformed.
+     */
+    [[nodiscard]] static inline Expected<ResponseData> tryParseResponse(std::string_view json);
+
+    /**
+     * @brief Builds JSON string from given data.
+     *
+     * @tparam Args Variadic template parameter pack for data types.
+     * @param data The unordered map containing key-value pairs.
+     * @return std::string The JSON string representation of the data.
+     */
+    template <typename... Args>
+    [[nodiscard]] static inline std::string buildJson(const std::unordered_map<std::string, std::any>& data);
+
+    /**
+     * @brief Visits the string fields of a flat JSON object, such as a headers object.
+     *
+     * Fields holding an array of strings are visited once per element, and
+     * other values are skipped.
+     *
+     * @tparam F Type of the visitor, called as `bool(std::string_view name, std::string value)`
+     * with the unescaped value; it returns false to stop.
+     * @param json The JSON object.
+     * @param visit The visitor.
+     */
+    template <typename F>
+    static inline void forEachField(std::string_view json, F&& visit);
+
+    /**
+     * @brief Visits the fields of a JSON object with their values as they are written.
+     *
+     * Strings keep their quotes and escape sequences, and objects and arrays
+     * are passed whole, so nothing is copied or unescaped.
+     *
+     * @tparam F Type of the visitor, called as `bool(std::string_view name, std::string_view value)`;
+     * it returns false to stop.
+     * @param json The JSON object.
+     * @param visit The visitor.
+     * @return bool False if the object is malformed before the visitor stopped.
+     */
+    template <typename F>
+    static inline bool forEachRawField(std::string_view json, F&& visit);
+
+    /**
+     * @brief Appends a string escaped the way the library escapes it, without the quotes.
+     *
+     * Escaping follows Go's encoding/json: quotes, backslashes and control
+     * characters are escaped, so are <, >, & and U+2028/U+2029, and invalid
+     * UTF-8 is replaced with U+FFFD.
+     *
+     * @param out The string to append to.
+     * @param value The string to escape.
+     */
+    static inline void appendEscaped(std::string& out, std::string_view value);
+
+    /**
+     * @brief Appends the content of a JSON string with its escape sequences decoded.
+     *
+     * \\uXXXX sequences are appended as UTF-8, surrogate pairs included, and
+     * unpaired surrogates as U+FFFD. Malformed escape sequences are copied as they are.
+     *
+     * @param out The string to append to.
+     * @param escaped The content of the JSON string, without the quotes.
+     */
+    static inline void appendUnescaped(std::string& out, std::string_view escaped);
+
+    /**
+     * @brief Checks whether a string value of a request field is embedded as-is rather than escaped.
+     *
+     * Only the fields the library reads as an object or array (headers,
+     * requestCookies, transportOptions and the fingerprint fields) are
+     * embedded, and only if the value starts and ends like one.
+     *
+     * @param key The name of the field.
+     * @param value The value of the field.
+     * @return bool True if the value is written as JSON.
+     */
+    [[nodiscard]] static constexpr bool isRawField(std::string_view key, std::string_view value) noexcept;
+
+private:
+    friend class JsonSax;
+
+    /**
+     * @brief Reads the four hex digits of a \\u escape sequence, and of a low surrogate following
+     * it, and appends the code point as UTF-8. Unpaired surrogates become U+FFFD.
+     *
+     * @param text The input.
+     * @param position The offset of the first hex digit, moved past the sequence.
+     * @param out The string to append to.
+     * @return bool Whether the sequence was well-formed.
+     */
+    static inline bool readUnicode(std::string_view text, size_t& position, std::string& out);
+
+    /**
+     * @brief Reads four hex digits.
+     */
+    [[nodiscard]] static inline int readHex(std::string_view text, size_t position) noexcept;
+
+    /**
+     * @brief Appends a code point as UTF-8.
+     */
+    template <typename String>
+    static void appendUtf8(String& out, uint32_t codePoint);
+
+    /**
+     * @brief Finds the first byte that appendEscaped cannot copy as it is.
+     *
+     * Those are control characters, quotes, backslashes, <, >, & and every
+     * byte of a multibyte UTF-8 sequence. Blocks of 32 (AVX2) or 16 (SSE2,
+     * NEON) bytes are checked at once, and the tail byte by byte.
+     *
+     * @param bytes The string to scan.
+     * @param position The offset to scan from.
+     * @param length The length of the string.
+     * @return size_t The offset of the byte, or length if there is none.
+     */
+    [[nodiscard]] static inline size_t findEscape(const unsigned char* bytes, size_t position, size_t length) noexcept;
+
+    /**
+     * @brief Checks whether appendEscaped cannot copy a byte as it is.
+     */
+    [[nodiscard]] static constexpr bool needsEscape(unsigned char ch) noexcept {
+        return ch < 0x20 || ch >= 0x80 || ch == '"' || ch == '\\' || ch == '<' || ch == '>' || ch == '&';
+    }
+
+    /**
+     * @brief Returns the number of trailing zero bits of a non-zero value.
+     */
+    [[nodiscard]] static unsigned countTrailingZeros(uint64_t bits) noexcept {
+#if defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanForward(&index, static_cast<unsigned long>(bits))) {
+            return index;
+        }
+        _BitScanForward(&index, static_cast<unsigned long>(bits >> 32));
+        return index + 32;
+#else
+        return static_cast<unsigned>(__builtin_ctzll(bits));
+#endif
+    }
+
+    /**
+     * @brief Converts a value to its JSON string representation.
+     *
+     * @tparam T Type of the value.
+     * @param value The value to convert.
+     * @return std::string The JSON string representation of the value.
+     */
+    template <typename T>
+    [[nodiscard]] static inline std::string jsonValue(const T& value);
+
+    /**
+     * @brief Appends a key-value pair to the JSON string stream.
+     *
+     * @param oss The output string stream to append to.
+     * @param key The key for the JSON object.
+     * @param value The value associated with the key.
+     */
+    static inline void appendValue(std::ostringstream& oss, [[maybe_unused]] const std::string& key, const std::any& value);
+
+    /**
+     * @brief Copies a JSON value without the whitespace outside of its strings.
+     *
+     * @param value The JSON value.
+     * @return std::string The compact value.
+     */
+    [[nodiscard]] static inline std::string compact(std::string_view value);
+
+    /**
+     * @brief Appends a key-value pair to the JSON string stream.
+     *
+     * This function is used for basic data types.
+     *
+     * @tparam T Type of the value.
+     * @param oss The output string stream to append to.
+     * @param key The key for the JSON object.
+     * @param value The value associated with the key.
+     */
+    template <typename T>
+    static inline void appendKeyValue(std::ostringstream& oss, const std::string& key, const T& value);
+
+    /**
+     * @brief Helper struct for always_false type trait.
+     *
+     * Provides a type trait that is always false.
+     */
+    template <typename T>
+    struct always_false : std::false_type {};
+};
+
+#if defined(TLS_CLIENT_HAS_YYJSON)
+/**
+ * @brief YyjsonCodec class is a JSON codec backed by the yyjson library.
+ *
+ * Both the request envelope and the library response are handled by yyjson.
+ */
+class YyjsonCodec {
+public:
+    /**
+     * @brief Parses JSON response into ResponseData structure.
+     *
+     * @param json The JSON string to parse.
+     * @return ResponseData The parsed response data.
+     */
+    [[nodiscard]] static inline ResponseData parseResponse(std::string_view json);
+
+    /**
+     * @brief Parses JSON response into ResponseData structure without throwing.
+     *
+     * @param json The JSON string to parse.
+     * @return Expected<ResponseData> The parsed response data, or an
+     * ErrorCode::Parse error if the response is malformed.
+     */
+    [[nodiscard]] static inline Expected<ResponseData> tryParseResponse(std::string_view json);
+
+    /**
+     * @brief Builds JSON string from given data.
+     *
+     * @param data The unordered map containing key-value pairs.
+     * @return std::string The JSON string representation of the data.
+     */
+    [[nodiscard]] static inline std::string buildJson(const std::unordered_map<std::string, std::any>& data);
+
+private:
+    /**
+     * @brief Serializes a value back to its JSON text.
+     *
+     * @param value The value to serialize.
+     * @return std::string The JSON text of the value.
+     */
+    [[nodiscard]] static inline std::string writeValue(yyjson_val* value);
+
+    /**
+     * @brief Slices the raw content of a string value, escape sequences included, from the input.
+     *
+     * @param json The input.
+     * @param buffer The padded copy of the input the document was read in place from.
+     * @param value The string value.
+     * @return std::string_view The content of the string, without the quotes.
+     */
+    [[nodiscard]] static inline std::string_view rawString(std::string_view json, const std::string& buffer,
+        yyjson_val* value) noexcept;
+};
+#endif
+
+#if defined(TLS_CLIENT_HAS_SIMDJSON)
+/**
+ * @brief SimdjsonCodec class is a JSON codec backed by the simdjson library.
+ *
+ * simdjson is a parser only, so the request envelope is built by @ref JsonHelper.
+ */
+class SimdjsonCodec {
+public:
+    /**
+     * @brief Parses JSON response into ResponseData structure.
+     *
+     * @param json The JSON string to parse.
+     * @return ResponseData The parsed response data.
+     */
+    [[nodiscard]] static inline ResponseData parseResponse(std::string_view json);
+
+    /**
+     * @brief Parses JSON response into ResponseData structure without throwing.
+     *
+     * @param json The JSON string to parse.
+     * @return Expected<ResponseData> The parsed response data, or an
+     * ErrorCode::Parse error if the response is malformed.
+     */
+    [[nodiscard]] static inline Expected<ResponseData> tryParseResponse(std::string_view json);
+
+    /**
+     * @brief Builds JSON string from given data.
+     *
+     * @param data The unordered map containing key-value pairs.
+     * @return std::string The JSON string representation of the data.
+     */
+    [[nodiscard]] static inline std::string buildJson(const std::unordered_map<std::string, std::any>& data);
+
+private:
+    /**
+     * @brief Returns the raw JSON text of a value.
+     *
+     * @param value The value to read.
+     * @param[out] out The raw JSON text, without surrounding whitespace.
+     * @return bool True if the value could be read.
+     */
+    [[nodiscard]] static inline bool rawJson(simdjson::ondemand::value value, std::string_view& out);
+};
+#endif
+
+/**
+ * @brief TLS_CLIENT_JSON_CODEC macro
+ *
+ * The JSON codec used by the @ref Session alias. Defaults to the built-in
+ * @ref JsonHelper; the TLS_CLIENT_JSON_BACKEND CMake option overrides it with
+ * the fastest codec found on the build machine.
+ */
+#if !defined(TLS_CLIENT_JSON_CODEC)
+#define TLS_CLIENT_JSON_CODEC JsonHelper
+#endif
+
+/**
+ * @brief Sharded class spreading a value over cache-line aligned shards.
+ *
+ * Each thread is assigned its own shard on first use, so state updated from
+ * many threads (counters, caches with their own lock per shard) does not
+ * contend on a single cache line or mutex.
+ *
+ * @tparam T Type of the value held by each shard.
+ * @tparam N Number of shards.
+ */
+template <typename T, size_t N = 64>
+class Sharded {
+public:
+    /**
+     * @brief Returns the shard assigned to the calling thread.
+     *
+     * @return T& The shard of the calling thread.
+     */
+    T& local() noexcept { return shards[threadIndex() % N].value; }
+
+    /**
+     * @brief Returns the shard owning the given hash.
+     *
+     * @param hash The hash of the key.
+     * @return T& The shard owning the key.
+     */
+    T& forHash(size_t hash) noexcept { return shards[hash % N].value; }
+
+    /**
+     * @brief Calls the given function for every shard.
+     *
+     * @tparam F Type of the function.
+     * @param function The function to call with each shard.
+     */
+    template <typename F>
+    void forEach(F&& function) const {
+        for (const Shard& shard : shards) {
+            function(shard.value);
+        }
+    }
+
+    template <typename F>
+    void forEach(F&& function) {
+        for (Shard& shard : shards) {
+            function(shard.value);
+        }
+    }
+
+private:
+    struct alignas(64) Shard {
+        T value{}; /**< The value held by the shard. */
+    };
+
+    std::array<Shard, N> shards; /**< The shards. */
+
+    /**
+     * @brief Returns a small index unique to the calling thread.
+     *
+     * @return size_t The index of the calling thread.
+     */
+    static size_t threadIndex() noexcept {
+        static std::atomic<size_t> next{0};
+        thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+};
+
+/**
+ * @brief AtomicSharedPtr class holding a shared pointer that can be swapped atomically.
+ *
+ * Readers take a snapshot with load() and keep using it while writers
+ * publish a new value with store(), RCU style.
+ *
+ * The pointer is copied into a few shards with a lock each: a load only locks
+ * the shard of the calling thread, which other threads rarely share, and a
+ * store updates every shard. Unlike std::atomic_load under C++17, loads thus
+ * do not go through a global pool of locks, and no thread keeps a value alive
+ * after it was replaced or the pointer destroyed.
+ *
+ * @tparam T Type of the pointed value.
+ */
+template <typename T>
+class AtomicSharedPtr {
+public:
+    /**
+     * @brief Constructs the pointer with an initial value.
+     *
+     * @param value The initial value.
+     */
+    explicit AtomicSharedPtr(std::shared_ptr<T> value = nullptr) {
+        slots.forEach([&value](Slot& slot) { slot.pointer = value; });
+    }
+
+    AtomicSharedPtr(const AtomicSharedPtr&) = delete;
+    AtomicSharedPtr& operator=(const AtomicSharedPtr&) = delete;
+
+    /**
+     * @brief Returns a snapshot of the current value.
+     *
+     * @return std::shared_ptr<T> The current value.
+     */
+    [[nodiscard]] std::shared_ptr<T> load() const {
+        Slot& slot = slots.local();
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        return slot.pointer;
+    }
+
+    /**
+     * @brief Publishes a new value.
+     *
+     * @param value The new value.
+     */
+    void store(std::shared_ptr<T> value) { (void)exchange(std::move(value)); }
+
+    /**
+     * @brief Publishes a new value and returns the previous one.
+     *
+     * @param value The new value.
+     * @return std::shared_ptr<T> The value replaced.
+     */
+    [[nodiscard]] std::shared_ptr<T> exchange(std::shared_ptr<T> value) {
+        // Stores are serialized, so that every shard ends up with the last value
+        std::lock_guard<std::mutex> lock(storeMutex);
+        std::shared_ptr<T> previous;
+        slots.forEach([&value, &previous](Slot& slot) {
+            std::shared_ptr<T> replaced = value;
+            {
+                std::lock_guard<std::mutex> slotLock(slot.mutex);
+                slot.pointer.swap(replaced);
+            }
+            previous = std::move(replaced);
+        });
+        return previous;
+    }
+
+private:
+    /**
+     * @brief Slot struct holding one copy of the pointer.
+     */
+    struct Slot {
+        std::mutex mutex;           /**< Guards the pointer. */
+        std::shared_ptr<T> pointer; /**< The held pointer. */
+    };
+
+    mutable Sharded<Slot, 8> slots; /**< The copies of the pointer. */
+    std::mutex storeMutex;          /**< Serializes stores. */
+};
+
+/**
+ * @brief ThreadPool class running tasks on a fixed set of worker threads.
+ *
+ * This is the executor used for asynchronous work (polling, batches and
+ * background writers). Tasks run in submission order; the destructor finishes
+ * every queued task before joining the workers.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Starts the worker threads.
+     *
+     * @param threads Number of worker threads, at least one.
+     */
+    explicit inline ThreadPool(size_t threads = std::thread::hardware_concurrency());
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Destructor running the queued tasks and joining the workers.
+     */
+    inline ~ThreadPool();
+
+    /**
+     * @brief Queues a task without waiting for its result.
+     *
+     * @param task The task to run.
+     */
+    inline void post(std::function<void()> task);
+
+    /**
+     * @brief Queues a function and returns a future for its result.
+     *
+     * @tparam F Type of the function.
+     * @param function The function to run.
+     * @return std::future The result of the function.
+     */
+    template <typename F>
+    auto submit(F&& function) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+        std::future<Result> result = task->get_future();
+        post([task]() { (*task)(); });
+        return result;
+    }
+
+    /**
+     * @brief Returns the number of worker threads.
+     *
+     * @return size_t The number of workers.
+     */
+    [[nodiscard]] size_t size() const noexcept { return workers.size(); }
+
+    /**
+     * @brief Returns the number of tasks waiting for a worker.
+     *
+     * @return size_t The number of queued tasks.
+     */
+    [[nodiscard]] inline size_t pending() const;
+
+private:
+    std::vector<std::thread> workers;         /**< The worker threads. */
+    std::deque<std::function<void()>> tasks;  /**< The queued tasks. */
+    mutable std::mutex mutex;                 /**< Guards tasks and stopping. */
+    std::condition_variable available;        /**< Signaled when a task is queued or the pool stops. */
+    bool stopping = false;                    /**< Whether the destructor was called. */
+
+    /**
+     * @brief Runs queued tasks until the pool stops.
+     */
+    inline void work();
+};
+
+ThreadPool::ThreadPool(size_t threads) {
+    threads = std::max<size_t>(threads, 1);
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([this]() { work(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    available.notify_one();
+}
+
+size_t ThreadPool::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.size();
+}
+
+void ThreadPool::work() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+/**
+ * @brief RequestTemplate class holding a request serialized ahead of time, with a variable URL suffix and body.
+ *
+ * Most of a library request envelope (method, URL, headers, cookies, proxy,
+ * timeout and the session fingerprint) is the same for every request of a
+ * kind. BasicSession::prepare serializes it once, and each request then
+ * copies that prefix and escapes only the variable parts after it:
+ *
+ * @code
+ * requestData.url = "https://api.example/items?id=";
+ * RequestTemplate item = session.prepare(requestData, "GET");
+ *
+ * item.setUrlSuffix("42");
+ * Expected<ResponseData> response = session.tryPerform(item);
+ * @endcode
+ *
+ * A template belongs to the session that prepared it. The setters are not
+ * thread-safe, so every thread keeps its own copy.
+ */
+class RequestTemplate {
+public:
+    /**
+     * @brief Sets the text appended to the URL of the template, such as a path or a query value.
+     *
+     * @param suffix The suffix, sent as it is.
+     */
+    void setUrlSuffix(std::string_view suffix) { urlSuffix.assign(suffix.data(), suffix.size()); }
+
+    /**
+     * @brief Sets the request body.
+     *
+     * @param body The body.
+     */
+    void setBody(std::string_view body) { this->body.emplace(body); }
+
+    /**
+     * @brief Removes the request body.
+     */
+    void clearBody() noexcept { body.reset(); }
+
+    /**
+     * @brief Returns the HTTP method of the template.
+     */
+    [[nodiscard]] const std::string& getMethod() const noexcept { return method; }
+
+    /**
+     * @brief Returns the request data of the current request.
+     *
+     * @return RequestData The request data the template was prepared from, with the suffix and body set.
+     */
+    [[nodiscard]] inline RequestData toRequestData() const;
+
+    /**
+     * @brief Returns the library request envelope of the current request.
+     *
+     * @return std::string The prefix followed by the escaped URL suffix and body.
+     */
+    [[nodiscard]] inline std::string envelope() const;
+
+private:
+    template <typename Codec>
+    friend class BasicSession;
+
+    std::shared_ptr<const SessionData> config; /**< The session data the template was prepared with. */
+    RequestData requestData;                   /**< The request the template was prepared from. */
+    std::string method;
+    std::string prefix;       /**< The envelope up to the escaped URL of the template, unterminated. */
+    size_t maxResponseSize = 0;
+    bool direct = false;      /**< Whether the envelope is sent as it is, without a backend or a resolver. */
+    std::string urlSuffix;
+    std::optional<std::string> body;
+};
+
+/**
+ * @brief SessionStats struct containing request statistics of a session.
+ */
+struct SessionStats {
+    uint64_t requests = 0;      /**< Number of requests sent. */
+    uint64_t failures = 0;      /**< Number of requests that failed (status code 0 or error). */
+    uint64_t bytesSent = 0;     /**< Size of the request envelopes passed to the library. */
+    uint64_t bytesReceived = 0; /**< Size of the responses returned by the library. */
+};
+
+
+/**
+ * @brief BasicSession class for managing HTTP session operations.
+ *
+ * A session is thread-safe: all public member functions may be called
+ * concurrently from any number of threads. The session data is swapped
+ * atomically (every request uses the snapshot taken when it started) and
+ * statistics are kept in per-thread shards, so threads sharing a session
+ * never serialize on a common lock.
+ *
+ * @tparam Codec The JSON codec used to build requests and parse responses
+ * (see @ref JsonHelper for the requirements).
+ */
+template <typename Codec>
+class BasicSession {
+public:
+    /**
+     * @brief Constructor to initialize the session with provided session data.
+     *
+     * @param sessionData The session data to initialize the session with.
+     */
+    BasicSession(SessionData sessionData)
+        : BasicSession(Shared(), std::make_shared<const SessionData>(std::move(sessionData))) {}
+
+    /**
+     * @brief Copy constructor. The copy shares the session data (and session id) of
+     * the other session, and starts with empty statistics.
+     *
+     * @param other The session to copy.
+     */
+    BasicSession(const BasicSession& other) : BasicSession(Shared(), other.sessionData.load()) {}
+
+    /**
+     * @brief Move constructor, which copies: the other session stays usable.
+     *
+     * @param other The session to move from.
+     */
+    BasicSession(BasicSession&& other) : BasicSession(Shared(), other.sessionData.load()) {}
+
+    /**
+     * @brief Copy assignment. The session takes the session data of the other session,
+     * and its statistics start over.
+     *
+     * @param other The session to copy.
+     * @return BasicSession& This session.
+     */
+    BasicSession& operator=(const BasicSession& other) {
+        if (this != &other) {
+            replaceSessionData(other.sessionData.load());
+            stats = std::make_unique<Sharded<StatsShard>>();
+        }
+        return *this;
+    }
+
+    BasicSession& operator=(BasicSession&& other) { return *this = static_cast<const BasicSession&>(other); }
+
+    /**
+     * @brief Destructor releasing the session id, if any: the library client of the
+     * id is released with its last holder (see SessionData::sessionId).
+     */
+    ~BasicSession() {
+        if (std::shared_ptr<const SessionData> config = sessionData.load(); config && config->sessionId) {
+            TlsClient::releaseSession(*config->sessionId);
+        }
+    }
+
+    /**
+     * @brief Returns a snapshot of the session data.
+     *
+     * @return std::shared_ptr<const SessionData> The current session data.
+     */
+    [[nodiscard]] std::shared_ptr<const SessionData> getSessionData() const;
+
+    /**
+     * @brief Replaces the session data.
+     *
+     * Requests already in flight keep using the previous session data. The
+     * profile of the session (see SessionData::profile) is kept, whatever the
+     * new session data holds.
+     *
+     * @param sessionData The new session data.
+     */
+    void setSessionData(SessionData sessionData);
+
+    /**
+     * @brief Returns the statistics of the session.
+     *
+     * @return SessionStats The statistics summed over all threads.
+     */
+    [[nodiscard]] SessionStats getStats() const;
+
+    /**
+     * @brief Sends a GET request using the session.
+     *
+     * @param requestData The request data for the GET request.
+     * @return ResponseData The response from the GET request.
+     */
+    ResponseData GET(RequestData requestData);
+
+    /**
+     * @brief Sends a POST request using the session.
+     *
+     * @param requestData The request data for the POST request.
+     * @return ResponseData The response from the POST request.
+     */
+    ResponseData POST(RequestData requestData);
+
+    /**
+     * @brief Sends a PUT request using the session.
+     *
+     * @param requestData The request data for the PUT request.
+     * @return ResponseData The response from the PUT request.
+     */
+    ResponseData PUT(RequestData requestData);
+
+    /**
+     * @brief Sends a DELETE request using the session.
+     *
+     * @param requestData The request data for the DELETE request.
+     * @return ResponseData The response from the DELETE request.
+     */
+    ResponseData _DELETE(RequestData requestData);
+
+    /**
+     * @brief Sends a PATCH request using the session.
+     *
+     * @param requestData The request data for the PATCH request.
+     * @return ResponseData The response from the PATCH request
+     */
+    ResponseData PATCH(RequestData requestData);
+
+    /**
+     * @brief Sends a HEAD request using the session.
+     *
+     * @param requestData The request data for the HEAD request.
+     * @return ResponseData The response from the HEAD request.
+     */
+    ResponseData HEAD(RequestData requestData);
+
+    /**
+     * @brief Sends an OPTIONS request using the session.
+     *
+     * @param requestData The request data for the OPTIONS request.
+     * @return ResponseData The response from the OPTIONS request.
+     */
+    ResponseData OPTIONS(RequestData requestData);
+
+    /**
+     * @brief Sends a GET request using the session without throwing.
+     *
+     * @param requestData The request data for the GET request.
+     * @return Expected<ResponseData> The response from the GET request, or the
+     * error that prevented it from completing.
+     */
+    [[nodiscard]] Expected<ResponseData> tryGET(const RequestData& requestData);
+
+    /**
+     * @brief Sends a POST request using the session without throwing.
+     *
+     * @param requestData The request data for the POST request.
+     * @return Expected<ResponseData> The response from the POST request, or the
+     * error that prevented it from completing.
+     */
+    [[nodiscard]] Expected<ResponseData> tryPOST(const RequestData& requestData);
+
+    /**
+     * @brief Sends a PUT request using the session without throwing.
+     *
+     * @param requestData The request data for the PUT request.
+     * @return Expected<ResponseData> The response from the PUT request, or the
+     * error that prevented it from completing.
+     */
+    [[nodiscard]] Expected<ResponseData> tryPUT(const RequestData& requestData);
+
+    /**
+     * @brief Sends a DELETE request using the session without throwing.
+     *
+     * @param requestData The request data for the DELETE request.
+     * @return Expected<ResponseData> The response from the DELETE request, or the
+     * error that prevented it from completing.
+     */
+    [[nodiscard]] Expected<ResponseData> tryDELETE(const RequestData& requestData);
+
+    /**
+     * @brief Sends a PATCH request using the session without throwing.
+     *
+     * @param requestData The request data for the PATCH request.
+     * @return Expected<ResponseData> The response from the PATCH request, or the
+     * error that prevented it from completing.
+     */
+    [[nodiscard]] Expected<ResponseData> tryPATCH(const RequestData& requestData);
+
+    /**
+     * @brief Sends a HEAD request using the session without throwing.
+     *
+     * @param requestData The request data for the HEAD request.
+     * @return Expected<ResponseData> The response from the HEAD request, or the
+     * error that prevented it from completing.
+     */
+    [[nodiscard]] Expected<ResponseData> tryHEAD(const RequestData& requestData);
+
+    /**
+     * @brief Sends an OPTIONS request using the session without throwing.
+     *
+     * @param requestData The request data for the OPTIONS request.
+     * @return Expected<ResponseData> The response from the OPTIONS request, or the
+     * error that prevented it from completing.
+     */
+    [[nodiscard]] Expected<ResponseData> tryOPTIONS(const RequestData& requestData);
+
+    /**
+     * @brief Sends a batch of requests and parses the responses in parallel without throwing.
+     *
+     * The requests are sent on requestExecutor, whose threads wait on the
+     * library, and each response is parsed on decodeExecutor as soon as it
+     * arrives, so that scanning large payloads and copying their bodies out
+     * uses every core while the other requests are still in flight. Bodies
+     * keep their JSON escapes, as for the other request functions; call
+     * ResponseData::decodeBody to unescape one. The two executors may be the
+     * same pool. Must not be called from a thread of either executor.
+     *
+     * The library responses are allocated from the default memory resource, as
+     * they are freed on another thread; parsing uses the MemoryScope of the
+     * decode thread. A request whose sending or parsing throws (e.g. in a sink)
+     * fails with ErrorCode::Request.
+     *
+     * @param requests The request data of the requests.
+     * @param method The HTTP method of the requests.
+     * @param requestExecutor The executor sending the requests.
+     * @param decodeExecutor The executor parsing the responses.
+     * @return std::vector<Expected<ResponseData>> The result of each request, in order.
+     */
+    [[nodiscard]] inline std::vector<Expected<ResponseData>> tryBatch(const std::vector<RequestData>& requests,
+        const std::string& method, ThreadPool& requestExecutor, ThreadPool& decodeExecutor);
+
+    /**
+     * @brief Serializes the static parts of a request once, for requests differing only in URL suffix and body.
+     *
+     * The template keeps the session data it was prepared with. If the
+     * session data is replaced, or the request goes through a backend or a
+     * resolver, tryPerform builds the request from scratch instead.
+     *
+     * @param requestData The request data of the requests, with the URL they share.
+     * @param method The HTTP method of the requests.
+     * @return RequestTemplate The template, with the URL suffix empty and the body of requestData.
+     */
+    [[nodiscard]] inline RequestTemplate prepare(const RequestData& requestData, const std::string& method) const;
+
+    /**
+     * @brief Sends the current request of a template without throwing.
+     *
+     * @param requestTemplate A template prepared by this session.
+     * @return Expected<ResponseData> The response, or the error that prevented it from completing.
+     */
+    [[nodiscard]] inline Expected<ResponseData> tryPerform(const RequestTemplate& requestTemplate);
+
+    /**
+     * @brief Sends a GET request and reads its JSON body into a value without throwing.
+     *
+     * The body is read straight out of the library response into the value,
+     * without a ResponseData or an unescaped copy of the body. Sessions with
+     * sinks, and requests sent by a backend, still build the ResponseData.
+     * T is described with TLS_CLIENT_JSON_FIELDS, and tls_client_json_bind.hpp
+     * must be included to call this function.
+     *
+     * @tparam T Type of the value.
+     * @param requestData The request data for the GET request.
+     * @return Expected<T> The value, an ErrorCode::Request error if the status
+     * code is 400 or above, an ErrorCode::Parse error if the body does not
+     * match T, or the error that prevented the request from completing.
+     */
+    template <typename T>
+    [[nodiscard]] Expected<T> getJson(const RequestData& requestData);
+
+    /**
+     * @brief Performs an HTTP request without throwing, returning a response to share between consumers.
+     *
+     * The response stays in the buffer the library returned, without being
+     * copied into a ResponseData. Sessions with sinks or a resolver, spilled
+     * bodies and requests sent by a backend still build the ResponseData, and
+     * copy it into the shared buffer once.
+     *
+     * @param requestData The request data for the HTTP request.
+     * @param method The HTTP method to use.
+     * @return Expected<std::shared_ptr<const SharedResponse>> The response, or the
+     * error that prevented it from completing.
+     */
+    [[nodiscard]] inline Expected<std::shared_ptr<const SharedResponse>> tryShare(const RequestData& requestData,
+        const std::string& method);
+
+private:
+    /**
+     * @brief StatsShard struct holding the statistics counters of one shard.
+     */
+    struct StatsShard {
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> bytesSent{0};
+        std::atomic<uint64_t> bytesReceived{0};
+    };
+
+    AtomicSharedPtr<const SessionData> sessionData; /**< The session data associated with this session. */
+    std::unique_ptr<Sharded<StatsShard>> stats;     /**< The per-thread statistics of this session. */
+
+    /**
+     * @brief Tag of the constructor taking a session data snapshot.
+     */
+    struct Shared {};
+
+    /**
+     * @brief Constructs the session with a session data snapshot, retaining its session id.
+     */
+    BasicSession(Shared, std::shared_ptr<const SessionData> config)
+        : sessionData(std::move(config)), stats(std::make_unique<Sharded<StatsShard>>()) {
+        if (std::shared_ptr<const SessionData> current = sessionData.load(); current && current->sessionId) {
+            TlsClient::retainSession(*current->sessionId);
+        }
+    }
+
+    /**
+     * @brief Publishes new session data, retaining its session id and releasing the previous one.
+     */
+    inline void replaceSessionData(std::shared_ptr<const SessionData> config);
+
+    /**
+     * @brief Returns the maximum response size of a request.
+     *
+     * @param config The session data snapshot used for the request.
+     * @param requestData The request data for the HTTP request.
+     * @return size_t The limit of the request, or of the session if the request has none.
+     */
+    [[nodiscard]] static inline size_t maxResponseSize(const SessionData& config, const RequestData& requestData);
+
+    /**
+     * @brief Moves the body of a response into a mapped file if it is above the spill threshold.
+     *
+     * Used for responses already built in memory, by a backend or from a shared response;
+     * library responses are spilled by parsePayload. The body is kept in memory if the
+     * file cannot be created.
+     *
+     * @param config The session data snapshot used for the request.
+     * @param responseData The response to update.
+     */
+    static inline void spillBody(const SessionData& config, ResponseData& responseData);
+
+    /**
+     * @brief Builds the transportOptions object of a request envelope.
+     *
+     * @param config The session data snapshot used for the request.
+     * @return std::optional<std::string> The JSON object, or nothing if the library defaults apply.
+     */
+    [[nodiscard]] static inline std::optional<std::string> buildTransportOptions(const SessionData& config);
+
+    /**
+     * @brief Returns the backend performing a request, or nullptr to use the library.
+     *
+     * @param config The session data snapshot used for the request.
+     * @param requestData The request data of the request.
+     * @return RequestBackend* The backend of the request, if any.
+     */
+    [[nodiscard]] static inline RequestBackend* selectBackend(const SessionData& config,
+        const RequestData& requestData);
+
+    /**
+     * @brief Points a request at the address of its host, if the session has a resolver.
+     *
+     * The URL gets the address, while serverNameOverwrite and requestHostOverride keep the host.
+     *
+     * @param config The session data snapshot used for the request.
+     * @param requestData The request data of the request.
+     * @return Expected<std::optional<RequestData>> The request to send if it differs,
+     * or the error of the resolver.
+     */
+    [[nodiscard]] static inline Expected<std::optional<RequestData>> resolveHost(const SessionData& config,
+        const RequestData& requestData);
+
+    /**
+     * @brief Replaces the address in the target of a response with the host it was resolved from.
+     *
+     * @param originalUrl The URL of the request before resolveHost.
+     * @param resolvedUrl The URL of the request after resolveHost.
+     * @param responseData The response to update.
+     */
+    static inline void restoreTarget(const std::string& originalUrl, const std::string& resolvedUrl,
+        ResponseData& responseData);
+
+    /**
+     * @brief Reports the outcome of a request to the failure cache of the session, if any.
+     *
+     * @param config The session data snapshot used for the request.
+     * @param requestData The request data of the request.
+     * @param error The error of the request, or nullptr if it completed.
+     */
+    static inline void recordOutcome(const SessionData& config, const RequestData& requestData,
+        const Error* error);
+
+    /**
+     * @brief Passes a completed response to the sinks of the session.
+     *
+     * @param config The session data snapshot used for the request.
+     * @param requestData The request data of the request.
+     * @param method The HTTP method of the request.
+     * @param responseData The response to pass.
+     */
+    static inline void dispatchSinks(const SessionData& config, const RequestData& requestData,
+        const std::string& method, ResponseData& responseData);
+
+    /**
+     * @brief Records a completed request in the statistics of the calling thread.
+     *
+     * @param bytesSent Size of the request envelope.
+     * @param bytesReceived Size of the library response.
+     * @param failed Whether the request failed.
+     */
+    inline void recordRequest(size_t bytesSent, size_t bytesReceived, bool failed);
+
+    /**
+     * @brief Performs an HTTP request with the specified method.
+     *
+     * @param requestData The request data for the HTTP request.
+     * @param method The HTTP method to use (e.g., "POST", "GET", etc.).
+     * @return ResponseData The response from the HTTP request.
+     */
+    [[nodiscard]] inline ResponseData performRequest(RequestData requestData, const std::string& method);
+
+    /**
+     * @brief Performs an HTTP request with the specified method without throwing.
+     *
+     * @param requestData The request data for the HTTP request.
+     * @param method The HTTP method to use (e.g., "POST", "GET", etc.).
+     * @return Expected<ResponseData> The response from the HTTP request, or
+     * the error that prevented it from completing.
+     */
+    [[nodiscard]] inline Expected<ResponseData> tryPerformRequest(const RequestData& requestData,
+        const std::string& method);
+
+    /**
+     * @brief PendingResponse struct holding the response of a request that is not parsed yet.
+     */
+    struct PendingResponse {
+        std::shared_ptr<const SessionData> config; /**< The session data snapshot used for the request. */
+        std::optional<RequestData> resolved;       /**< The request sent, if resolveHost changed it. */
+        size_t bytesSent = 0;                      /**< Size of the request envelope. */
+        std::pmr::string payload{MemoryScope::resource()}; /**< The library response, in the memory scope. */
+        std::optional<ResponseData> completed;     /**< The response of a backend, which needs no parsing. */
+        std::shared_ptr<const SharedResponse> shared; /**< The library response, if it was kept in place. */
+    };
+
+    /**
+     * @brief Sends a request without parsing the library response.
+     *
+     * @param requestData The request data for the HTTP request.
+     * @param method The HTTP method to use.
+     * @param share Whether to keep the library response in place, in PendingResponse::shared.
+     * @return Expected<PendingResponse> The response to pass to tryDecode, or the
+     * error that prevented the request from completing.
+     */
+    [[nodiscard]] inline Expected<PendingResponse> trySend(const RequestData& requestData, const std::string& method,
+        bool share = false);
+
+    /**
+     * @brief Parses the response of trySend and passes it to the sinks.
+     *
+     * @param requestData The request data for the HTTP request.
+     * @param method The HTTP method of the request.
+     * @param pending The response returned by trySend.
+     * @return Expected<ResponseData> The response, or the error reported by the library.
+     */
+    [[nodiscard]] inline Expected<ResponseData> tryDecode(const RequestData& requestData, const std::string& method,
+        PendingResponse pending);
+
+    /**
+     * @brief Parses a library response with the codec, in place if the codec accepts a std::string_view.
+     *
+     * A body above the spill threshold is written from the payload straight into a mapped
+     * file, and the codec parses the response without it.
+     *
+     * @param config The session data snapshot used for the request.
+     * @param payload The library response.
+     * @return Expected<ResponseData> The parsed response, or the error of the codec.
+     */
+    [[nodiscard]] static inline Expected<ResponseData> parsePayload(const SessionData& config,
+        std::string_view payload);
+
+    /**
+     * @brief Adds a key-value pair to the request body if the value is present.
+     *
+     * @tparam T Type of the value to add.
+     * @param body The map representing the request body.
+     * @param key The key to add to the body.
+     * @param value The value to add to the body.
+     */
+    template <typename T>
+    static inline void addToBodyIfPresent(std::unordered_map<std::string, std::any>& body, const std::string& key,
+        const T& value);
+
+    /**
+     * @brief Collects the fields of the request envelope for the HTTP request.
+     *
+     * @param config The session data snapshot used for the request.
+     * @param requestData The request data for the HTTP request.
+     * @param method The HTTP method being used.
+     * @return std::unordered_map<std::string, std::any> The fields, to pass to Codec::buildJson.
+     */
+    [[nodiscard]] static inline std::unordered_map<std::string, std::any> buildRequestFields(
+        const SessionData& config, const RequestData& requestData, const std::string& method);
+
+    /**
+     * @brief Builds the request body for the HTTP request.
+     *
+     * @param config The session data snapshot used for the request.
+     * @param requestData The request data for the HTTP request.
+     * @param method The HTTP method being used.
+     * @return std::string The constructed request body.
+     */
+    [[nodiscard]] static inline std::string buildRequestBody(const SessionData& config,
+        const RequestData& requestData, const std::string& method);
+
+    /**
+     * @brief Appends the members of the profile of the session data, if any, to an unterminated JSON object.
+     *
+     * @param config The session data snapshot used for the request.
+     * @param json The JSON object, without its closing brace.
+     */
+    static inline void appendProfile(const SessionData& config, std::string& json);
+};
+
+/**
+ * @brief Session class using the default JSON codec.
+ */
+using Session = BasicSession<TLS_CLIENT_JSON_CODEC>;
+
+inline std::string TlsClient::performRequest(const std::string& input, size_t maxResponseSize) {
+    ensureInitialized();
+
+    char* result = request(input.c_str());
+    std::optional<std::string> response = takeResponse<std::string>(result, maxResponseSize);
+    if (!response) {
+        TLS_CLIENT_THROW(std::length_error("Response exceeds " + std::to_string(maxResponseSize) + " bytes"));
+    }
+    return std::move(*response);
+}
+
+template <typename String>
+std::optional<String> TlsClient::takeResponse(char* result, size_t maxResponseSize,
+    const typename String::allocator_type& allocator) {
+    const char* end = findEnd(result, maxResponseSize);
+    std::optional<String> response;
+    if (end) {
+        response.emplace(result, end - result, allocator);
+    }
+    freeMemory(result);
+    return response;
+}
+
+Expected<std::string> TlsClient::tryPerformRequest(const std::string& input, size_t maxResponseSize) {
+    return tryPerform<std::string>(input, maxResponseSize, {});
+}
+
+Expected<std::pmr::string> TlsClient::tryPerformRequest(const std::string& input, size_t maxResponseSize,
+    std::pmr::memory_resource* resource) {
+    return tryPerform<std::pmr::string>(input, maxResponseSize, resource);
+}
+
+template <typename String>
+Expected<String> TlsClient::tryPerform(const std::string& input, size_t maxResponseSize,
+    const typename String::allocator_type& allocator) {
+    Expected<char*> result = send(input);
+    if (!result) {
+        return Unexpected<Error>{std::move(result.error())};
+    }
+
+    std::optional<String> response = takeResponse<String>(*result, maxResponseSize, allocator);
+    if (!response) {
+        return Unexpected<Error>{{ErrorCode::ResponseTooLarge,
+            "Response exceeds " + std::to_string(maxResponseSize) + " bytes"}};
+    }
+    return std::move(*response);
+}
+
+Expected<std::shared_ptr<const SharedResponse>> TlsClient::tryPerformShared(const std::string& input,
+    size_t maxResponseSize) {
+    Expected<char*> result = send(input);
+    if (!result) {
+        return Unexpected<Error>{std::move(result.error())};
+    }
+
+    const char* end = findEnd(*result, maxResponseSize);
+    if (!end) {
+        freeMemory(*result);
+        return Unexpected<Error>{{ErrorCode::ResponseTooLarge,
+            "Response exceeds " + std::to_string(maxResponseSize) + " bytes"}};
+    }
+
+    size_t length = end - *result;
+    std::shared_ptr<const SharedResponse> shared = SharedResponse::adopt(*result, length, freeMemory);
+    if (!shared) {
+        Error error{ErrorCode::Parse, "Malformed library response: " + std::string(*result, length)};
+        freeMemory(*result);
+        return Unexpected<Error>{std::move(error)};
+    }
+    return shared;
+}
+
+Expected<char*> TlsClient::send(const std::string& input) {
+    if (const std::optional<Error>& error = initialize()) {
+        return Unexpected<Error>{*error};
+    }
+    if (!request || !freeMemory) {
+        return Unexpected<Error>{{ErrorCode::Library, "The library does not export request and freeMemory"}};
+    }
+
+    char* result = request(input.c_str());
+    if (!result) {
+        return Unexpected<Error>{{ErrorCode::Library, "The library returned no response"}};
+    }
+    return result;
+}
+
+const char* TlsClient::findEnd(const char* result, size_t maxResponseSize) noexcept {
+    // Never look further than one byte past the limit, so an oversized
+    // response is rejected without being read or copied
+    return maxResponseSize == SIZE_MAX
+        ? result + strlen(result)
+        : static_cast<const char*>(memchr(result, '\0', maxResponseSize + 1));
+}
+
+ErrorCode TlsClient::classifyError(std::string_view message) {
+    // Skip past `<Method> "<url>": ` so keywords inside the URL are not matched
+    size_t quote = message.find('"');
+    if (quote != std::string_view::npos && quote >= 2 && message[quote - 1] == ' ' &&
+        isalpha(static_cast<unsigned char>(message[quote - 2]))) {
+        size_t end = message.find("\": ", quote + 1);
+        if (end != std::string_view::npos) {
+            message.remove_prefix(end + 3);
+        }
+    }
+
+    auto contains = [message](std::string_view needle) {
+        return message.find(needle) != std::string_view::npos;
+    };
+
+    if (contains("proxy")) {
+        return ErrorCode::Proxy;
+    }
+    if (contains("Timeout") || contains("timeout") || contains("deadline exceeded")) {
+        return ErrorCode::Timeout;
+    }
+    if (contains("tls:") || contains("x509:") || contains("certificate")) {
+        return ErrorCode::Tls;
+    }
+    if (contains("no such host") || contains("lookup ")) {
+        return ErrorCode::Dns;
+    }
+    if (contains("connection refused") || contains("connection reset") || contains("EOF")) {
+        return ErrorCode::Connection;
+    }
+    return ErrorCode::Request;
+}
+
+Error TlsClient::libraryError(std::string_view body) {
+    std::string message;
+    JsonHelper::appendUnescaped(message, body);
+    ErrorCode code = classifyError(message);
+    return Error{code, std::move(message)};
+}
+
+void TlsClient::retainSession(const std::string& sessionId) {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    ++sessionHolders[sessionId];
+}
+
+void TlsClient::releaseSession(const std::string& sessionId) {
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        auto it = sessionHolders.find(sessionId);
+        if (it != sessionHolders.end() && --it->second > 0) {
+            return;
+        }
+        if (it != sessionHolders.end()) {
+            sessionHolders.erase(it);
+        }
+    }
+
+    if (!loaded.load(std::memory_order_acquire) || !destroySession || !freeMemory) {
+        return;
+    }
+
+    std::string input = R"({"sessionId": ")";
+    JsonHelper::appendEscaped(input, sessionId);
+    input += "\"}";
+    if (char* result = destroySession(input.c_str())) {
+        freeMemory(result);
+    }
+}
+
+inline void TlsClient::ensureInitialized() {
+    if (const std::optional<Error>& error = initialize()) {
+        TLS_CLIENT_THROW(std::runtime_error(error->message));
+    }
+
+    CHECK_INITIALIZED(request);
+    CHECK_INITIALIZED(freeMemory);
+}
+
+const std::optional<Error>& TlsClient::initialize() {
+    static const std::optional<Error> error = []() -> std::optional<Error> {
+        std::error_code ec;
+        std::string root_dir = std::filesystem::current_path(ec).string();
+        std::string lib_path = root_dir + "/dependencies/" + DLL_NAME;
+
+        std::string message;
+        LOAD_LIBRARY(hLib, lib_path, message);
+
+        if (!message.empty()) {
+            return Error{ErrorCode::Library, message};
+        }
+        loaded.store(true, std::memory_order_release);
+        return std::nullopt;
+    }();
+
+    return error;
+}
+
+inline TlsClient::~TlsClient() { hLib.reset(); }
+
+std::shared_ptr<const MappedBody> MappedBody::create(std::string_view data,
+    const std::optional<std::string>& directory) {
+#if defined(OS_LINUX) || defined(OS_APPLE)
+    if (data.empty()) {
+        return nullptr;
+    }
+
+    int file = openAnonymousFile(directory);
+    if (file < 0) {
+        return nullptr;
+    }
+
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t result = write(file, data.data() + written, data.size() - written);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            close(file);
+            return nullptr;
+        }
+        written += static_cast<size_t>(result);
+    }
+
+    void* address = mmap(nullptr, data.size(), PROT_READ, MAP_SHARED, file, 0);
+    if (address == MAP_FAILED) {
+        close(file);
+        return nullptr;
+    }
+
+    return std::shared_ptr<const MappedBody>(new MappedBody(file, address, data.size()));
+#else
+    (void)data;
+    (void)directory;
+    return nullptr;
+#endif
+}
+
+MappedBody::~MappedBody() {
+#if defined(OS_LINUX) || defined(OS_APPLE)
+    munmap(address, size);
+    close(file);
+#endif
+}
+
+int MappedBody::openAnonymousFile(const std::optional<std::string>& directory) {
+#if defined(OS_LINUX) || defined(OS_APPLE)
+#if defined(OS_LINUX) && defined(O_TMPFILE)
+    if (directory) {
+        int file = open(directory->c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+        if (file >= 0) {
+            return file;
+        }
+    }
+#endif
+#if defined(OS_LINUX) && defined(MFD_CLOEXEC)
+    if (!directory) {
+        int file = memfd_create("tls-client-body", MFD_CLOEXEC);
+        if (file >= 0) {
+            return file;
+        }
+    }
+#endif
+    const char* tmpdir = getenv("TMPDIR");
+    std::string path = directory.value_or(tmpdir ? tmpdir : "/tmp") + "/tls-client-body-XXXXXX";
+
+    int file = mkstemp(path.data());
+    if (file >= 0) {
+        unlink(path.c_str());
+    }
+    return file;
+#else
+    (void)directory;
+    return -1;
+#endif
+}
+
+void* HugePageResource::do_allocate(size_t bytes, size_t alignment) {
+    if (!mapped(alignment)) {
+        return std::pmr::get_default_resource()->allocate(bytes, alignment);
+    }
+#if defined(OS_LINUX)
+    size_t size = (std::max<size_t>(bytes, 1) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void* address = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (address == MAP_FAILED) {
+        // No huge pages are reserved; transparent huge pages may still back the mapping
+        address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED) {
+            TLS_CLIENT_THROW(std::bad_alloc());
+        }
+#if defined(MADV_HUGEPAGE)
+        madvise(address, size, MADV_HUGEPAGE);
+#endif
+    }
+    return address;
+#else
+    return nullptr;
+#endif
+}
+
+void HugePageResource::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    if (!mapped(alignment)) {
+        std::pmr::get_default_resource()->deallocate(pointer, bytes, alignment);
+        return;
+    }
+#if defined(OS_LINUX)
+    munmap(pointer, (std::max<size_t>(bytes, 1) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+#endif
+}
+
+UrlView UrlView::parse(std::string_view url) noexcept {
+    UrlView view;
+
+    size_t start = url.find("://");
+    if (start != std::string_view::npos) {
+        view.scheme = url.substr(0, start);
+        start += 3;
+    } else {
+        start = 0;
+    }
+
+    size_t end = url.find_first_of("/?#", start);
+    std::string_view authority = url.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+    if (size_t userInfo = authority.rfind('@'); userInfo != std::string_view::npos) {
+        authority.remove_prefix(userInfo + 1);
+    }
+
+    // The port follows the last colon, unless it is part of an IPv6 address
+    size_t colon = authority.rfind(':');
+    if (colon != std::string_view::npos && authority.find(']', colon) == std::string_view::npos) {
+        view.host = authority.substr(0, colon);
+        view.port = authority.substr(colon + 1);
+    } else {
+        view.host = authority;
+    }
+
+    std::string_view target = end == std::string_view::npos ? std::string_view() : url.substr(end);
+    view.target = target.substr(0, target.find('#'));
+    return view;
+}
+
+std::string UrlView::authority() const {
+    std::string result(host);
+    bool defaultPort = port.empty() || (scheme == "http" && port == "80") || (scheme == "https" && port == "443");
+    if (!defaultPort) {
+        result += ':';
+        result += port;
+    }
+
+    std::transform(result.begin(), result.end(), result.begin(),
+        [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    return result;
+}
+
+template <typename F>
+void JsonHelper::forEachField(std::string_view json, F&& visit) {
+    // Reads the JSON string starting at the opening quote at position, leaving position after it
+    auto readString = [json](size_t& position) {
+        size_t start = ++position;
+        for (position = json.find_first_of("\"\\", position); position != std::string_view::npos;
+            position = json.find_first_of("\"\\", position + 2)) {
+            if (json[position] == '"') {
+                break;
+            }
+        }
+        position = std::min(position, json.size());
+
+        std::string value;
+        appendUnescaped(value, json.substr(start, position - start));
+        ++position;
+        return value;
+    };
+
+    size_t position = json.find('"');
+    while (position != std::string_view::npos) {
+        std::string name = readString(position);
+
+        position = json.find_first_not_of(" \t\r\n:", position);
+        if (position == std::string_view::npos) {
+            return;
+        }
+
+        if (json[position] == '"') {
+            if (!visit(std::string_view(name), readString(position))) {
+                return;
+            }
+        } else if (json[position] == '[') {
+            for (++position; position < json.size() && json[position] != ']';) {
+                if (json[position] != '"') {
+                    ++position;
+                    continue;
+                }
+                if (!visit(std::string_view(name), readString(position))) {
+                    return;
+                }
+            }
+        }
+
+        // Move to the next name, skipping over non-string values
+        position = json.find_first_of(",}", position);
+        position = position == std::string_view::npos ? position : json.find('"', position);
+    }
+}
+
+template <typename F>
+bool JsonHelper::forEachRawField(std::string_view json, F&& visit) {
+    auto skipSpace = [json](size_t position) {
+        position = json.find_first_not_of(" \t\r\n", position);
+        return position == std::string_view::npos ? json.size() : position;
+    };
+
+    // Returns the offset after the string starting at the opening quote at position
+    auto skipString = [json](size_t position) {
+        for (position = json.find_first_of("\"\\", position + 1); position != std::string_view::npos;
+            position = json.find_first_of("\"\\", position + 2)) {
+            if (json[position] == '"') {
+                return position + 1;
+            }
+        }
+        return std::string_view::npos;
+    };
+
+    // Returns the offset after the value starting at position
+    auto skipValue = [&](size_t position) {
+        if (json[position] == '"') {
+            return skipString(position);
+        }
+        if (json[position] != '{' && json[position] != '[') {
+            return std::min(json.find_first_of(",}] \t\r\n", position), json.size());
+        }
+
+        size_t depth = 0;
+        for (; position != std::string_view::npos; position = json.find_first_of("\"{}[]", position)) {
+            char ch = json[position];
+            if (ch == '"') {
+                position = skipString(position);
+                continue;
+            }
+            ++position;
+            if (ch == '{' || ch == '[') {
+                ++depth;
+            } else if (--depth == 0) {
+                return position;
+            }
+        }
+        return std::string_view::npos;
+    };
+
+    size_t position = skipSpace(0);
+    if (position == json.size() || json[position] != '{') {
+        return false;
+    }
+    position = skipSpace(position + 1);
+    if (position < json.size() && json[position] == '}') {
+        return true;
+    }
+
+    while (position < json.size() && json[position] == '"') {
+        size_t nameEnd = skipString(position);
+        if (nameEnd == std::string_view::npos) {
+            return false;
+        }
+        std::string_view name = json.substr(position + 1, nameEnd - position - 2);
+
+        position = skipSpace(nameEnd);
+        if (position == json.size() || json[position] != ':') {
+            return false;
+        }
+        position = skipSpace(position + 1);
+        if (position == json.size()) {
+            return false;
+        }
+
+        size_t valueEnd = skipValue(position);
+        if (valueEnd == std::string_view::npos || valueEnd == position) {
+            return false;
+        }
+        if (!visit(name, json.substr(position, valueEnd - position))) {
+            return true;
+        }
+
+        position = skipSpace(valueEnd);
+        if (position < json.size() && json[position] == '}') {
+            return true;
+        }
+        if (position == json.size() || json[position] != ',') {
+            return false;
+        }
+        position = skipSpace(position + 1);
+    }
+    return false;
+}
+
+void JsonHelper::appendEscaped(std::string& out, std::string_view value) {
+    static constexpr char HEX[] = "0123456789abcdef";
+    out.reserve(out.size() + value.size());
+
+    const auto* bytes = reinterpret_cast<const unsigned char*>(value.data());
+    size_t length = value.size();
+    size_t start = 0;
+
+    // Runs of bytes that need no escaping are found in blocks and copied at once. Escapes and
+    // multibyte sequences tend to come in runs, so short runs are stepped over byte by byte
+    for (size_t i = findEscape(bytes, 0, length); i < length;) {
+        if (!needsEscape(bytes[i])) {
+            i = i + 1 < length && !needsEscape(bytes[i + 1]) ? findEscape(bytes, i + 2, length) : i + 1;
+            continue;
+        }
+
+        unsigned char ch = bytes[i];
+        if (ch < 0x80) {
+            out.append(value.data() + start, i - start);
+            switch (ch) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    out += "\\u00";
+                    out += HEX[ch >> 4];
+                    out += HEX[ch & 0xF];
+                    break;
+            }
+            start = ++i;
+            continue;
+        }
+
+        // Validate the UTF-8 sequence, rejecting overlong forms, surrogates and code points past U+10FFFF
+        size_t size = ch >= 0xF0 ? 4 : ch >= 0xE0 ? 3 : ch >= 0xC2 ? 2 : 0;
+        bool valid = size != 0 && ch <= 0xF4 && i + size <= length;
+        for (size_t j = 1; valid && j < size; ++j) {
+            valid = (bytes[i + j] & 0xC0) == 0x80;
+        }
+        if (valid && size == 3) {
+            valid = !(ch == 0xE0 && bytes[i + 1] < 0xA0) && !(ch == 0xED && bytes[i + 1] >= 0xA0);
+        }
+        if (valid && size == 4) {
+            valid = !(ch == 0xF0 && bytes[i + 1] < 0x90) && !(ch == 0xF4 && bytes[i + 1] >= 0x90);
+        }
+
+        if (!valid) {
+            out.append(value.data() + start, i - start);
+            out += "\\ufffd";
+            start = ++i;
+        } else if (size == 3 && ch == 0xE2 && bytes[i + 1] == 0x80 && (bytes[i + 2] == 0xA8 || bytes[i + 2] == 0xA9)) {
+            out.append(value.data() + start, i - start);
+            out += bytes[i + 2] == 0xA8 ? "\\u2028" : "\\u2029";
+            start = i += 3;
+        } else {
+            i += size;
+        }
+    }
+    out.append(value.data() + start, length - start);
+}
+
+void JsonHelper::appendUnescaped(std::string& out, std::string_view escaped) {
+    out.reserve(out.size() + escaped.size());
+
+    size_t start = 0;
+    for (size_t i = escaped.find('\\'); i != std::string_view::npos && i + 1 < escaped.size();
+        i = escaped.find('\\', start)) {
+        out.append(escaped.data() + start, i - start);
+
+        char ch = escaped[i + 1];
+        start = i + 2;
+        switch (ch) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u':
+                if (!readUnicode(escaped, start, out)) {
+                    out.append(escaped.data() + i, 2);
+                }
+                break;
+            default:
+                out.append(escaped.data() + i, 2);
+                break;
+        }
+    }
+    out.append(escaped.data() + start, escaped.size() - start);
+}
+
+bool JsonHelper::readUnicode(std::string_view text, size_t& position, std::string& out) {
+    int high = readHex(text, position);
+    if (high < 0) {
+        return false;
+    }
+    position += 4;
+
+    uint32_t codePoint = static_cast<uint32_t>(high);
+    if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+        int low = position + 6 <= text.size() && text[position] == '\\' && text[position + 1] == 'u'
+            ? readHex(text, position + 2) : -1;
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (static_cast<uint32_t>(low) - 0xDC00);
+            position += 6;
+        } else {
+            codePoint = 0xFFFD;
+        }
+    } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+        codePoint = 0xFFFD;
+    }
+
+    appendUtf8(out, codePoint);
+    return true;
+}
+
+int JsonHelper::readHex(std::string_view text, size_t position) noexcept {
+    if (position + 4 > text.size()) {
+        return -1;
+    }
+
+    int value = 0;
+    for (size_t i = position; i < position + 4; ++i) {
+        char ch = text[i];
+        int digit = ch >= '0' && ch <= '9' ? ch - '0'
+            : ch >= 'a' && ch <= 'f' ? ch - 'a' + 10
+            : ch >= 'A' && ch <= 'F' ? ch - 'A' + 10 : -1;
+        if (digit < 0) {
+            return -1;
+        }
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+template <typename String>
+void JsonHelper::appendUtf8(String& out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+size_t JsonHelper::findEscape(const unsigned char* bytes, size_t position, size_t length) noexcept {
+#if defined(TLS_CLIENT_HAS_AVX2)
+    // Compared as signed bytes, non-ASCII bytes are negative and so below the space too
+    const __m256i space32 = _mm256_set1_epi8(0x20);
+    const __m256i quote32 = _mm256_set1_epi8('"');
+    const __m256i backslash32 = _mm256_set1_epi8('\\');
+    const __m256i less32 = _mm256_set1_epi8('<');
+    const __m256i greater32 = _mm256_set1_epi8('>');
+    const __m256i ampersand32 = _mm256_set1_epi8('&');
+    for (; position + 32 <= length; position += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + position));
+        __m256i special = _mm256_or_si256(_mm256_cmpgt_epi8(space32, block),
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, quote32), _mm256_cmpeq_epi8(block, backslash32)),
+                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, less32), _mm256_cmpeq_epi8(block, greater32)),
+                    _mm256_cmpeq_epi8(block, ampersand32))));
+        if (uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special))) {
+            return position + countTrailingZeros(mask);
+        }
+    }
+#endif
+
+#if defined(TLS_CLIENT_HAS_SSE2)
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i less = _mm_set1_epi8('<');
+    const __m128i greater = _mm_set1_epi8('>');
+    const __m128i ampersand = _mm_set1_epi8('&');
+    for (; position + 16 <= length; position += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + position));
+        __m128i special = _mm_or_si128(_mm_cmplt_epi8(block, space),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, less), _mm_cmpeq_epi8(block, greater)),
+                    _mm_cmpeq_epi8(block, ampersand))));
+        if (uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special))) {
+            return position + countTrailingZeros(mask);
+        }
+    }
+#elif defined(TLS_CLIENT_HAS_NEON)
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    const uint8x16_t high = vdupq_n_u8(0x80);
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t less = vdupq_n_u8('<');
+    const uint8x16_t greater = vdupq_n_u8('>');
+    const uint8x16_t ampersand = vdupq_n_u8('&');
+    for (; position + 16 <= length; position += 16) {
+        uint8x16_t block = vld1q_u8(bytes + position);
+        uint8x16_t special = vorrq_u8(vorrq_u8(vcltq_u8(block, space), vcgeq_u8(block, high)),
+            vorrq_u8(vorrq_u8(vceqq_u8(block, quote), vceqq_u8(block, backslash)),
+                vorrq_u8(vorrq_u8(vceqq_u8(block, less), vceqq_u8(block, greater)), vceqq_u8(block, ampersand))));
+
+        // Narrow each byte of the mask to 4 bits, as NEON has no movemask
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(special), 4)), 0);
+        if (mask != 0) {
+            return position + countTrailingZeros(mask) / 4;
+        }
+    }
+#endif
+
+    for (; position < length; ++position) {
+        if (needsEscape(bytes[position])) {
+            return position;
+        }
+    }
+    return length;
+}
+
+std::optional<std::string> ResponseData::findHeader(std::string_view headers, std::string_view name) {
+    auto equalsIgnoreCase = [](std::string_view lhs, std::string_view rhs) {
+        return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        });
+    };
+
+    std::optional<std::string> result;
+    JsonHelper::forEachField(headers, [&](std::string_view field, std::string value) {
+        if (!equalsIgnoreCase(field, name)) {
+            return true;
+        }
+        result = std::move(value);
+        return false;
+    });
+    return result;
+}
+
+std::string ResponseData::decodeBody() const {
+    if (!bodyEscaped) {
+        return std::string(bodyView());
+    }
+
+    std::string decoded;
+    JsonHelper::appendUnescaped(decoded, bodyView());
+    return decoded;
+}
+
+std::shared_ptr<const SharedResponse> SharedResponse::copy(const ResponseData& responseData) {
+    std::string_view body = responseData.mappedBody ? std::string_view() : std::string_view(responseData.body);
+    size_t length = body.size() + responseData.headers.size() + responseData.cookies.size() +
+        responseData.target.size() + responseData.usedProtocol.size();
+
+    std::shared_ptr<SharedResponse> shared(new SharedResponse(new char[length], length,
+        [](char* data) { delete[] data; }));
+    char* out = shared->data.get();
+    auto place = [&out](std::string_view field) {
+        std::string_view view(out, field.size());
+        out = std::copy(field.begin(), field.end(), out);
+        return view;
+    };
+
+    shared->status = responseData.statusCode;
+    shared->bodyText = place(body);
+    shared->headersText = place(responseData.headers);
+    shared->cookiesText = place(responseData.cookies);
+    shared->targetText = place(responseData.target);
+    shared->protocolText = place(responseData.usedProtocol);
+    shared->mappedBody = responseData.mappedBody;
+    shared->hash = responseData.bodyHash;
+    shared->escaped = responseData.bodyEscaped;
+    return shared;
+}
+
+std::shared_ptr<const SharedResponse> SharedResponse::adopt(char* data, size_t length, void (*release)(char*)) {
+    std::shared_ptr<SharedResponse> shared(new SharedResponse(data, length, release));
+
+    // The fields are left where the library wrote them, string values without their quotes
+    bool hasStatus = false;
+    bool wellFormed = JsonHelper::forEachRawField(std::string_view(data, length),
+        [&](std::string_view name, std::string_view value) {
+            bool quoted = value.size() >= 2 && value.front() == '"';
+            std::string_view text = quoted ? value.substr(1, value.size() - 2) : std::string_view();
+
+            if (name == "status") {
+                auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), shared->status);
+                hasStatus = ec == std::errc() && end == value.data() + value.size();
+            } else if (name == "body") {
+                shared->bodyText = text;
+            } else if (name == "target") {
+                shared->targetText = text;
+            } else if (name == "usedProtocol") {
+                shared->protocolText = text;
+            } else if (name == "headers") {
+                shared->headersText = value;
+            } else if (name == "cookies") {
+                shared->cookiesText = value;
+            }
+            return true;
+        });
+
+    if (!wellFormed || !hasStatus) {
+        shared->data.release();
+        return nullptr;
+    }
+    return shared;
+}
+
+ResponseData SharedResponse::toResponseData() const {
+    ResponseData responseData;
+    responseData.statusCode = status;
+    responseData.body = bodyText;
+    responseData.headers = headersText;
+    responseData.cookies = cookiesText;
+    responseData.target = targetText;
+    responseData.usedProtocol = protocolText;
+    responseData.mappedBody = mappedBody;
+    responseData.bodyHash = hash;
+    responseData.bodyEscaped = escaped;
+    return responseData;
+}
+
+uint64_t ContentHash::compute(std::string_view data) noexcept {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+    size_t length = data.size();
+
+    if (length <= 16) {
+        return hashShort(bytes, length);
+    }
+    if (length <= 240) {
+        return hashMedium(bytes, length);
+    }
+    return hashLong(bytes, length);
+}
+
+uint64_t ContentHash::read64(const uint8_t* data) noexcept {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+uint32_t ContentHash::read32(const uint8_t* data) noexcept {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+        (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+uint64_t ContentHash::multiplyFold(uint64_t lhs, uint64_t rhs) noexcept {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = static_cast<__uint128_t>(lhs) * rhs;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+    uint64_t lowLow = (lhs & 0xFFFFFFFF) * (rhs & 0xFFFFFFFF);
+    uint64_t highLow = (lhs >> 32) * (rhs & 0xFFFFFFFF);
+    uint64_t lowHigh = (lhs & 0xFFFFFFFF) * (rhs >> 32);
+    uint64_t highHigh = (lhs >> 32) * (rhs >> 32);
+    uint64_t cross = (lowLow >> 32) + (highLow & 0xFFFFFFFF) + lowHigh;
+    uint64_t upper = (highLow >> 32) + (cross >> 32) + highHigh;
+    uint64_t lower = (cross << 32) | (lowLow & 0xFFFFFFFF);
+    return lower ^ upper;
+#endif
+}
+
+uint64_t ContentHash::avalanche(uint64_t hash) noexcept {
+    hash ^= hash >> 37;
+    hash *= PRIME_MX1;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t ContentHash::avalanche64(uint64_t hash) noexcept {
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t ContentHash::mix16(const uint8_t* data, const uint8_t* secret) noexcept {
+    return multiplyFold(read64(data) ^ read64(secret), read64(data + 8) ^ read64(secret + 8));
+}
+
+uint64_t ContentHash::hashShort(const uint8_t* data, size_t length) noexcept {
+    if (length > 8) {
+        uint64_t low = read64(data) ^ (read64(SECRET + 24) ^ read64(SECRET + 32));
+        uint64_t high = read64(data + length - 8) ^ (read64(SECRET + 40) ^ read64(SECRET + 48));
+
+        uint64_t swapped = 0;
+        for (int i = 0; i < 8; ++i) {
+            swapped = (swapped << 8) | ((low >> (8 * i)) & 0xFF);
+        }
+        return avalanche(length + swapped + high + multiplyFold(low, high));
+    }
+
+    if (length >= 4) {
+        uint64_t input = read32(data + length - 4) + (static_cast<uint64_t>(read32(data)) << 32);
+        uint64_t hash = input ^ (read64(SECRET + 8) ^ read64(SECRET + 16));
+
+        hash ^= ((hash << 49) | (hash >> 15)) ^ ((hash << 24) | (hash >> 40));
+        hash *= PRIME_MX2;
+        hash ^= (hash >> 35) + length;
+        hash *= PRIME_MX2;
+        return hash ^ (hash >> 28);
+    }
+
+    if (length > 0) {
+        uint32_t combined = (static_cast<uint32_t>(data[0]) << 16) | (static_cast<uint32_t>(data[length >> 1]) << 24) |
+            static_cast<uint32_t>(data[length - 1]) | (static_cast<uint32_t>(length) << 8);
+        return avalanche64(combined ^ static_cast<uint64_t>(read32(SECRET) ^ read32(SECRET + 4)));
+    }
+
+    return avalanche64(read64(SECRET + 56) ^ read64(SECRET + 64));
+}
+
+uint64_t ContentHash::hashMedium(const uint8_t* data, size_t length) noexcept {
+    uint64_t hash = length * PRIME64_1;
+
+    if (length <= 128) {
+        if (length > 32) {
+            if (length > 64) {
+                if (length > 96) {
+                    hash += mix16(data + 48, SECRET + 96);
+                    hash += mix16(data + length - 64, SECRET + 112);
+                }
+                hash += mix16(data + 32, SECRET + 64);
+                hash += mix16(data + length - 48, SECRET + 80);
+            }
+            hash += mix16(data + 16, SECRET + 32);
+            hash += mix16(data + length - 32, SECRET + 48);
+        }
+        hash += mix16(data, SECRET);
+        hash += mix16(data + length - 16, SECRET + 16);
+        return avalanche(hash);
+    }
+
+    for (size_t i = 0; i < 8; ++i) {
+        hash += mix16(data + 16 * i, SECRET + 16 * i);
+    }
+    hash = avalanche(hash);
+
+    uint64_t last = mix16(data + length - 16, SECRET + 136 - 17);
+    for (size_t i = 8; i < length / 16; ++i) {
+        last += mix16(data + 16 * i, SECRET + 16 * (i - 8) + 3);
+    }
+    return avalanche(hash + last);
+}
+
+void ContentHash::accumulate(uint64_t* accumulators, const uint8_t* data, const uint8_t* secret) noexcept {
+    for (size_t i = 0; i < 8; ++i) {
+        uint64_t value = read64(data + 8 * i);
+        uint64_t key = value ^ read64(secret + 8 * i);
+        accumulators[i ^ 1] += value;
+        accumulators[i] += (key & 0xFFFFFFFF) * (key >> 32);
+    }
+}
+
+uint64_t ContentHash::hashLong(const uint8_t* data, size_t length) noexcept {
+    uint64_t accumulators[8] = {
+        PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1
+    };
+
+    constexpr size_t stripesPerBlock = (SECRET_SIZE - STRIPE_LENGTH) / 8;
+    constexpr size_t blockLength = STRIPE_LENGTH * stripesPerBlock;
+    size_t blocks = (length - 1) / blockLength;
+
+    for (size_t block = 0; block < blocks; ++block) {
+        for (size_t stripe = 0; stripe < stripesPerBlock; ++stripe) {
+            accumulate(accumulators, data + block * blockLength + stripe * STRIPE_LENGTH, SECRET + stripe * 8);
+        }
+
+        // Scramble the accumulators between blocks
+        for (size_t i = 0; i < 8; ++i) {
+            uint64_t accumulator = accumulators[i];
+            accumulator ^= accumulator >> 47;
+            accumulator ^= read64(SECRET + SECRET_SIZE - STRIPE_LENGTH + 8 * i);
+            accumulators[i] = accumulator * PRIME32_1;
+        }
+    }
+
+    size_t stripes = ((length - 1) - blockLength * blocks) / STRIPE_LENGTH;
+    for (size_t stripe = 0; stripe < stripes; ++stripe) {
+        accumulate(accumulators, data + blocks * blockLength + stripe * STRIPE_LENGTH, SECRET + stripe * 8);
+    }
+    accumulate(accumulators, data + length - STRIPE_LENGTH, SECRET + SECRET_SIZE - STRIPE_LENGTH - 7);
+
+    uint64_t hash = length * PRIME64_1;
+    for (size_t i = 0; i < 4; ++i) {
+        hash += multiplyFold(accumulators[2 * i] ^ read64(SECRET + 11 + 16 * i),
+            accumulators[2 * i + 1] ^ read64(SECRET + 11 + 16 * i + 8));
+    }
+    return avalanche(hash);
+}
+
+template <typename... Args>
+std::string JsonHelper::buildJson(const std::unordered_map<std::string, std::any>& data) {
+    std::ostringstream oss;
+    oss << "{";
+
+    bool first = true;
+
+    for (auto it = data.begin(); it != data.end(); ++it) {
+        if (!first) {
+            oss << ", ";
+        }
+        first = false;
+
+        const std::string& key = it->first;
+        const std::any& value = it->second;
+
+        appendValue(oss, key, value);
+    }
+
+    oss << "}";
+    return oss.str();
+}
+
+template <typename T> inline std::string JsonHelper::jsonValue(const T& value) {
+    if constexpr (std::is_same_v<T, std::string>) {
+        std::string quoted;
+        quoted.reserve(value.size() + 2);
+        quoted += '"';
+        appendEscaped(quoted, value);
+        quoted += '"';
+        return quoted;
+    }
+
+    else if constexpr (std::is_same_v<T, bool>) {
+        return value ? "true" : "false";
+    }
+
+    else if constexpr (std::is_arithmetic_v<T>) {
+        return std::to_string(value);
+    }
+
+    else {
+        static_assert(always_false<T>::value, "Unsupported type for jsonValue");
+    }
+}
+
+std::string JsonHelper::compact(std::string_view value) {
+    std::string out;
+    out.reserve(value.size());
+
+    bool inString = false;
+    for (size_t i = 0; i < value.size(); ++i) {
+        char ch = value[i];
+        if (inString) {
+            out += ch;
+            if (ch == '\\' && i + 1 < value.size()) {
+                out += value[++i];
+            } else if (ch == '"') {
+                inString = false;
+            }
+        } else if (!isspace(static_cast<unsigned char>(ch))) {
+            inString = ch == '"';
+            out += ch;
+        }
+    }
+    return out;
+}
+
+template <typename T>
+void JsonHelper::appendKeyValue(std::ostringstream& oss, const std::string& key, const T& value) {
+    oss << "\"" << key << "\": ";
+    if constexpr (std::is_same_v<T, std::string>) {
+        if (isRawField(key, value)) {
+            oss << value;
+            return;
+        }
+    }
+    oss << JSON_VALUE(value);
+}
+
+constexpr bool JsonHelper::isRawField(std::string_view key, std::string_view value) noexcept {
+    constexpr std::string_view FIELDS[] = {"headers", "requestCookies", "transportOptions", "h2Settings",
+        "h2SettingsOrder", "supportedSignatureAlgorithms", "supportedVersions", "keyShareCurves",
+        "pseudoHeaderOrder", "priorityFrames", "headerOrder"};
+
+    bool shaped = value.size() >= 2 &&
+        ((value.front() == '{' && value.back() == '}') || (value.front() == '[' && value.back() == ']'));
+    for (std::string_view field : FIELDS) {
+        if (shaped && field == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void JsonHelper::appendValue(std::ostringstream& oss, const std::string& key, const std::any& value) {
+    if (const auto* string = std::any_cast<std::string>(&value)) {
+        appendKeyValue(oss, key, *string);
+    }
+    else if (const auto* integer = std::any_cast<int>(&value)) {
+        appendKeyValue(oss, key, *integer);
+    }
+    else if (const auto* real = std::any_cast<double>(&value)) {
+        appendKeyValue(oss, key, *real);
+    }
+    else if (const auto* boolean = std::any_cast<bool>(&value)) {
+        appendKeyValue(oss, key, *boolean);
+    }
+}
+
+ResponseData JsonHelper::parseResponse(std::string_view json) {
+    return tryParseResponse(json).valueOr(ResponseData());
+}
+
+Expected<ResponseData> JsonHelper::tryParseResponse(std::string_view json) {
+    ResponseData responseData;
+    bool hasStatus = false;
+
+    // The fields are read in place; only the values kept are copied
+    forEachRawField(json, [&](std::string_view key, std::string_view value) {
+        bool quoted = value.size() >= 2 && value.front() == '"';
+        std::string_view text = quoted ? value.substr(1, value.size() - 2) : std::string_view();
+
+        if (key == "status") {
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), responseData.statusCode);
+            hasStatus = ec == std::errc() && end == value.data() + value.size();
+        }
+        else if (key == "body" && quoted) {
+            responseData.body = text;
+        }
+        else if (key == "target" && quoted) {
+            responseData.target = text;
+        }
+        else if (key == "usedProtocol" && quoted) {
+            responseData.usedProtocol = text;
+        }
+        else if (key == "headers") {
+            responseData.headers = compact(value);
+        }
+        else if (key == "cookies") {
+            responseData.cookies = compact(value);
+        }
+        return true;
+    });
+
+    if (!hasStatus) {
+        return Unexpected<Error>{{ErrorCode::Parse, "Malformed library response: " + std::string(json)}};
+    }
+    return responseData;
+}
+
+#if defined(TLS_CLIENT_HAS_YYJSON)
+std::string YyjsonCodec::buildJson(const std::unordered_map<std::string, std::any>& data) {
+    yyjson_mut_doc* doc = yyjson_mut_doc_new(nullptr);
+    yyjson_mut_val* root = yyjson_mut_obj(doc);
+    yyjson_mut_doc_set_root(doc, root);
+
+    for (const auto& [key, value] : data) {
+        yyjson_mut_val* jsonKey = yyjson_mut_strn(doc, key.data(), key.size());
+        yyjson_mut_val* jsonValue = nullptr;
+
+        if (const auto* string = std::any_cast<std::string>(&value)) {
+            jsonValue = JsonHelper::isRawField(key, *string) ? yyjson_mut_rawn(doc, string->data(), string->size())
+                               : yyjson_mut_strn(doc, string->data(), string->size());
+        }
+        else if (const auto* integer = std::any_cast<int>(&value)) {
+            jsonValue = yyjson_mut_sint(doc, *integer);
+        }
+        else if (const auto* real = std::any_cast<double>(&value)) {
+            jsonValue = yyjson_mut_real(doc, *real);
+        }
+        else if (const auto* boolean = std::any_cast<bool>(&value)) {
+            jsonValue = yyjson_mut_bool(doc, *boolean);
+        }
+
+        if (jsonValue) {
+            yyjson_mut_obj_add(root, jsonKey, jsonValue);
+        }
+    }
+
+    size_t length = 0;
+    char* json = yyjson_mut_write(doc, 0, &length);
+    std::string result = json ? std::string(json, length) : "{}";
+
+    free(json);
+    yyjson_mut_doc_free(doc);
+    return result;
+}
+
+std::string YyjsonCodec::writeValue(yyjson_val* value) {
+    size_t length = 0;
+    char* json = yyjson_val_write(value, 0, &length);
+    std::string result = json ? std::string(json, length) : std::string();
+    free(json);
+    return result;
+}
+
+ResponseData YyjsonCodec::parseResponse(std::string_view json) {
+    return tryParseResponse(json).valueOr(ResponseData());
+}
+
+std::string_view YyjsonCodec::rawString(std::string_view json, const std::string& buffer,
+    yyjson_val* value) noexcept {
+    // Strings read in place start at the offset of their content in the input
+    size_t start = static_cast<size_t>(yyjson_get_str(value) - buffer.data());
+    size_t end = json.find_first_of("\"\\", start);
+    while (end != std::string_view::npos && json[end] == '\\') {
+        end = json.find_first_of("\"\\", end + 2);
+    }
+    return json.substr(start, std::min(end, json.size()) - start);
+}
+
+Expected<ResponseData> YyjsonCodec::tryParseResponse(std::string_view json) {
+    ResponseData responseData;
+    bool hasStatus = false;
+
+    std::string buffer;
+    buffer.reserve(json.size() + YYJSON_PADDING_SIZE);
+    buffer.assign(json);
+    buffer.resize(json.size() + YYJSON_PADDING_SIZE, '\0');
+
+    yyjson_doc* doc = yyjson_read_opts(buffer.data(), json.size(), YYJSON_READ_INSITU, nullptr, nullptr);
+    yyjson_val* root = yyjson_doc_get_root(doc);
+    if (!yyjson_is_obj(root)) {
+        yyjson_doc_free(doc);
+        return Unexpected<Error>{{ErrorCode::Parse, "Malformed library response: " + std::string(json)}};
+    }
+
+    size_t index, max;
+    yyjson_val *key, *value;
+    yyjson_obj_foreach(root, index, max, key, value) {
+        std::string_view name(yyjson_get_str(key), yyjson_get_len(key));
+
+        if (name == "status" && yyjson_is_int(value)) {
+            responseData.statusCode = yyjson_get_int(value);
+            hasStatus = true;
+        }
+        // Keep the escape sequences, just like the built-in codec does
+        else if (name == "body" && yyjson_is_str(value)) {
+            responseData.body = rawString(json, buffer, value);
+        }
+        else if (name == "target" && yyjson_is_str(value)) {
+            responseData.target = rawString(json, buffer, value);
+        }
+        else if (name == "usedProtocol" && yyjson_is_str(value)) {
+            responseData.usedProtocol = rawString(json, buffer, value);
+        }
+        else if (name == "headers") {
+            responseData.headers = writeValue(value);
+        }
+        else if (name == "cookies") {
+            responseData.cookies = writeValue(value);
+        }
+    }
+
+    yyjson_doc_free(doc);
+    if (!hasStatus) {
+        return Unexpected<Error>{{ErrorCode::Parse, "Malformed library response: " + std::string(json)}};
+    }
+    return responseData;
+}
+#endif
+
+#if defined(TLS_CLIENT_HAS_SIMDJSON)
+std::string SimdjsonCodec::buildJson(const std::unordered_map<std::string, std::any>& data) {
+    return JsonHelper::buildJson(data);
+}
+
+bool SimdjsonCodec::rawJson(simdjson::ondemand::value value, std::string_view& out) {
+    if (value.raw_json().get(out)) {
+        return false;
+    }
+
+    while (!out.empty() && isspace(static_cast<unsigned char>(out.back()))) {
+        out.remove_suffix(1);
+    }
+    return true;
+}
+
+ResponseData SimdjsonCodec::parseResponse(std::string_view json) {
+    return tryParseResponse(json).valueOr(ResponseData());
+}
+
+Expected<ResponseData> SimdjsonCodec::tryParseResponse(std::string_view json) {
+    static thread_local simdjson::ondemand::parser parser;
+
+    ResponseData responseData;
+    bool hasStatus = false;
+    simdjson::padded_string padded(json);
+
+    simdjson::ondemand::document doc;
+    simdjson::ondemand::object object;
+    if (parser.iterate(padded).get(doc) || doc.get_object().get(object)) {
+        return Unexpected<Error>{{ErrorCode::Parse, "Malformed library response: " + std::string(json)}};
+    }
+
+    for (auto field : object) {
+        std::string_view key;
+        simdjson::ondemand::value value;
+        if (field.unescaped_key().get(key) || field.value().get(value)) {
+            return Unexpected<Error>{{ErrorCode::Parse, "Malformed library response: " + std::string(json)}};
+        }
+
+        std::string_view raw;
+        if (key == "status") {
+            int64_t status;
+            if (!value.get_int64().get(status)) {
+                responseData.statusCode = static_cast<int>(status);
+                hasStatus = true;
+            }
+        }
+        else if ((key == "body" || key == "target" || key == "usedProtocol") && rawJson(value, raw) && raw.size() >= 2) {
+            std::string token(raw.substr(1, raw.size() - 2));
+
+            if (key == "body") {
+                responseData.body = std::move(token);
+            }
+            else if (key == "target") {
+                responseData.target = std::move(token);
+            }
+            else {
+                responseData.usedProtocol = std::move(token);
+            }
+        }
+        else if (key == "headers" && rawJson(value, raw)) {
+            responseData.headers = std::string(raw);
+        }
+        else if (key == "cookies" && rawJson(value, raw)) {
+            responseData.cookies = std::string(raw);
+        }
+    }
+
+    if (!hasStatus) {
+        return Unexpected<Error>{{ErrorCode::Parse, "Malformed library response: " + std::string(json)}};
+    }
+    return responseData;
+}
+#endif
+
+template <typename Codec>
+template <typename T>
+void BasicSession<Codec>::addToBodyIfPresent(std::unordered_map<std::string, std::any>& body,
+    const std::string& key, const T& value) {
+    if (value.has_value()) {
+        body[key] = value.value();
+    }
+};
+
+RequestData RequestTemplate::toRequestData() const {
+    RequestData request = requestData;
+    request.url += urlSuffix;
+    request.data = body;
+    return request;
+}
+
+std::string RequestTemplate::envelope() const {
+    static constexpr std::string_view BODY = "\", \"requestBody\": \"";
+
+    std::string out;
+    out.reserve(prefix.size() + BODY.size() + 3 + (urlSuffix.size() + (body ? body->size() : 0)) * 6 / 5);
+    out += prefix;
+    JsonHelper::appendEscaped(out, urlSuffix);
+    if (body) {
+        out += BODY;
+        JsonHelper::appendEscaped(out, *body);
+    }
+    out += "\"}";
+    return out;
+}
+
+template <typename Codec>
+std::shared_ptr<const SessionData> BasicSession<Codec>::getSessionData() const {
+    return sessionData.load();
+}
+
+template <typename Codec>
+void BasicSession<Codec>::setSessionData(SessionData sessionData) {
+    if (std::shared_ptr<const SessionData> current = this->sessionData.load()) {
+        sessionData.profile = current->profile;
+    }
+    replaceSessionData(std::make_shared<const SessionData>(std::move(sessionData)));
+}
+
+template <typename Codec>
+void BasicSession<Codec>::replaceSessionData(std::shared_ptr<const SessionData> config) {
+    // The new id is retained first, so that keeping the same id never releases its client
+    if (config && config->sessionId) {
+        TlsClient::retainSession(*config->sessionId);
+    }
+    std::shared_ptr<const SessionData> previous = sessionData.exchange(std::move(config));
+    if (previous && previous->sessionId) {
+        TlsClient::releaseSession(*previous->sessionId);
+    }
+}
+
+template <typename Codec>
+SessionStats BasicSession<Codec>::getStats() const {
+    SessionStats result;
+    stats->forEach([&result](const StatsShard& shard) {
+        result.requests += shard.requests.load(std::memory_order_relaxed);
+        result.failures += shard.failures.load(std::memory_order_relaxed);
+        result.bytesSent += shard.bytesSent.load(std::memory_order_relaxed);
+        result.bytesReceived += shard.bytesReceived.load(std::memory_order_relaxed);
+    });
+    return result;
+}
+
+template <typename Codec>
+size_t BasicSession<Codec>::maxResponseSize(const SessionData& config, const RequestData& requestData) {
+    return requestData.maxResponseSize.value_or(config.maxResponseSize.value_or(SIZE_MAX));
+}
+
+template <typename Codec>
+void BasicSession<Codec>::spillBody(const SessionData& config, ResponseData& responseData) {
+    if (!config.spillThreshold || responseData.body.size() <= *config.spillThreshold) {
+        return;
+    }
+
+    if (auto mappedBody = MappedBody::create(responseData.body, config.spillDirectory)) {
+        responseData.mappedBody = std::move(mappedBody);
+        std::string().swap(responseData.body);
+    }
+}
 
-    /**
-     * @brief Sends a POST request using the session.
-     *
-     * @param requestData The request data for the POST request.
-     * @return ResponseData The response from the POST request.
-     */
-    ResponseData POST(RequestData requestData);
+template <typename Codec>
+RequestBackend* BasicSession<Codec>::selectBackend(const SessionData& config, const RequestData& requestData) {
+    if (!config.backend || !config.backend->supports(requestData)) {
+        return nullptr;
+    }
+    if (config.backendHosts.empty()) {
+        return config.backend.get();
+    }
 
-    /**
-     * @brief Sends a PUT request using the session.
-     *
-     * @param requestData The request data for the PUT request.
-     * @return ResponseData The response from the PUT request.
-     */
-    ResponseData PUT(RequestData requestData);
+    std::string host(UrlView::parse(requestData.url).host);
+    std::transform(host.begin(), host.end(), host.begin(),
+        [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
 
-    /**
-     * @brief Sends a DELETE request using the session.
-     *
-     * @param requestData The request data for the DELETE request.
-     * @return ResponseData The response from the DELETE request.
-     */
-    ResponseData _DELETE(RequestData requestData);
+    for (const std::string& rule : config.backendHosts) {
+        bool wildcard = rule.compare(0, 2, "*.") == 0;
+        std::string_view suffix = std::string_view(rule).substr(1);
+        if ((!wildcard && host == rule) || (wildcard && host.size() > suffix.size() &&
+            host.compare(host.size() - suffix.size(), suffix.size(), suffix) == 0)) {
+            return config.backend.get();
+        }
+    }
+    return nullptr;
+}
 
-    /**
-     * @brief Sends a PATCH request using the session.
-     *
-     * @param requestData The request data for the PATCH request.
-     * @return ResponseData The response from the PATCH request
-     */
-    ResponseData PATCH(RequestData requestData);
+template <typename Codec>
+std::optional<std::string> BasicSession<Codec>::buildTransportOptions(const SessionData& config) {
+    std::string options;
+    auto add = [&options](const char* name, const std::string& value) {
+        options += (options.empty() ? "{\"" : ", \"") + std::string(name) + "\": " + value;
+    };
 
-    /**
-     * @brief Sends a HEAD request using the session.
-     *
-     * @param requestData The request data for the HEAD request.
-     * @return ResponseData The response from the HEAD request.
-     */
-    ResponseData HEAD(RequestData requestData);
+    if (const std::optional<TransportOptions>& transport = config.transportOptions) {
+        auto addIfPresent = [&add](const char* name, const std::optional<int>& value) {
+            if (value) {
+                add(name, std::to_string(*value));
+            }
+        };
+        addIfPresent("maxIdleConns", transport->maxIdleConns);
+        addIfPresent("maxIdleConnsPerHost", transport->maxIdleConnsPerHost);
+        addIfPresent("maxConnsPerHost", transport->maxConnsPerHost);
+        addIfPresent("readBufferSize", transport->readBufferSize);
+        addIfPresent("writeBufferSize", transport->writeBufferSize);
 
-    /**
-     * @brief Sends an OPTIONS request using the session.
-     *
-     * @param requestData The request data for the OPTIONS request.
-     * @return ResponseData The response from the OPTIONS request.
-     */
-    ResponseData OPTIONS(RequestData requestData);
+        // The library reads the timeout as a Go time.Duration, in nanoseconds
+        if (transport->idleConnTimeout) {
+            add("idleConnTimeout", std::to_string(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(*transport->idleConnTimeout).count()));
+        }
+        add("disableKeepAlives", transport->disableKeepAlives ? "true" : "false");
+        add("disableCompression", transport->disableCompression ? "true" : "false");
+    }
 
-private:
-    SessionData sessionData; /**< The session data associated with this session. */
+    if (options.empty()) {
+        return std::nullopt;
+    }
+    return options + "}";
+}
 
-    /**
-     * @brief Performs an HTTP request with the specified method.
-     *
-     * @param requestData The request data for the HTTP request.
-     * @param method The HTTP method to use (e.g., "POST", "GET", etc.).
-     * @return ResponseData The response from the HTTP request.
-     */
-    [[nodiscard]] inline ResponseData performRequest(RequestData requestData, const std::string& method);
+template <typename Codec>
+Expected<std::optional<RequestData>> BasicSession<Codec>::resolveHost(const SessionData& config,
+    const RequestData& requestData) {
+    if (!config.resolver || requestData.proxy || requestData.serverNameOverwrite) {
+        return std::optional<RequestData>();
+    }
 
-    /**
-     * @brief Adds a key-value pair to the request body if the value is present.
-     *
-     * @tparam T Type of the value to add.
-     * @param body The map representing the request body.
-     * @param key The key to add to the body.
-     * @param value The value to add to the body.
-     */
-    template <typename T>
-    inline void addToBodyIfPresent(std::unordered_map<std::string, std::any>& body, const std::string& key,
-        const T& value);
+    UrlView url = UrlView::parse(requestData.url);
+    bool literal = url.host.empty() || url.host.front() == '[' ||
+        url.host.find_first_not_of("0123456789.") == std::string_view::npos;
+    if (literal) {
+        return std::optional<RequestData>();
+    }
 
-    /**
-     * @brief Builds the request body for the HTTP request.
-     *
-     * @param requestData The request data for the HTTP request.
-     * @param method The HTTP method being used.
-     * @return std::string The constructed request body.
-     */
-    [[nodiscard]] inline std::string buildRequestBody(RequestData requestData, std::string method);
-};
+    std::string host(url.host);
+    std::transform(host.begin(), host.end(), host.begin(),
+        [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
 
-std::string TlsClient::performRequest(const std::string& input) {
-    ensureInitialized();
+    Expected<std::string> address = config.resolver->resolve(host);
+    if (!address) {
+        return Unexpected<Error>{std::move(address.error())};
+    }
 
-    char* result = request(input.c_str());
-    std::string response(result);
-    freeMemory(result);
-    return response;
+    RequestData resolved = requestData;
+    size_t hostStart = static_cast<size_t>(url.host.data() - requestData.url.data());
+    resolved.requestHostOverride = std::string(url.host) + (url.port.empty() ? "" : ":" + std::string(url.port));
+    resolved.serverNameOverwrite = host;
+    resolved.url.replace(hostStart, url.host.size(),
+        address->find(':') != std::string::npos ? "[" + *address + "]" : *address);
+    return std::optional<RequestData>(std::move(resolved));
 }
 
-void TlsClient::ensureInitialized() {
-    static bool initialized = false;
-    if (!initialized) {
-        std::string root_dir = std::filesystem::current_path().string();
-        std::string lib_path = root_dir + "/dependencies/" + DLL_NAME;
+template <typename Codec>
+void BasicSession<Codec>::restoreTarget(const std::string& originalUrl, const std::string& resolvedUrl,
+    ResponseData& responseData) {
+    UrlView original = UrlView::parse(originalUrl);
+    UrlView resolved = UrlView::parse(resolvedUrl);
 
-        LOAD_LIBRARY(hLib, lib_path);
+    // Only targets on the resolved address are restored; redirects may have left it
+    std::string_view resolvedPrefix(resolvedUrl.data(),
+        static_cast<size_t>(resolved.host.data() - resolvedUrl.data()) + resolved.host.size());
+    std::string_view target(responseData.target);
+    if (target.compare(0, resolvedPrefix.size(), resolvedPrefix) != 0 ||
+        (target.size() > resolvedPrefix.size() && std::string_view("/:?#").find(target[resolvedPrefix.size()]) ==
+            std::string_view::npos)) {
+        return;
+    }
 
-        CHECK_INITIALIZED(request);
-        CHECK_INITIALIZED(freeMemory);
+    std::string_view originalPrefix(originalUrl.data(),
+        static_cast<size_t>(original.host.data() - originalUrl.data()) + original.host.size());
+    responseData.target.replace(0, resolvedPrefix.size(), originalPrefix);
+}
 
-        initialized = true;
+template <typename Codec>
+void BasicSession<Codec>::recordOutcome(const SessionData& config, const RequestData& requestData,
+    const Error* error) {
+    if (!config.failureCache) {
+        return;
+    }
+    if (error) {
+        config.failureCache->recordFailure(requestData, *error);
+    } else {
+        config.failureCache->recordSuccess(requestData);
     }
 }
 
-inline TlsClient::~TlsClient() { hLib.reset(); }
+template <typename Codec>
+void BasicSession<Codec>::dispatchSinks(const SessionData& config, const RequestData& requestData,
+    const std::string& method, ResponseData& responseData) {
+    for (const std::shared_ptr<ResponseSink>& sink : config.sinks) {
+        sink->consume(requestData, method, responseData);
+    }
+}
 
-template <typename... Args>
-std::string JsonHelper::buildJson(const std::unordered_map<std::string, std::any>& data) {
-    std::ostringstream oss;
-    oss << "{";
+template <typename Codec>
+void BasicSession<Codec>::recordRequest(size_t bytesSent, size_t bytesReceived, bool failed) {
+    StatsShard& shard = stats->local();
+    shard.requests.fetch_add(1, std::memory_order_relaxed);
+    shard.bytesSent.fetch_add(bytesSent, std::memory_order_relaxed);
+    shard.bytesReceived.fetch_add(bytesReceived, std::memory_order_relaxed);
+    if (failed) {
+        shard.failures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
-    bool first = true;
+template <typename Codec>
+std::unordered_map<std::string, std::any> BasicSession<Codec>::buildRequestFields(const SessionData& config,
+    const RequestData& requestData, const std::string& method) {
+    std::unordered_map<std::string, std::any> body;
 
-    for (auto it = data.begin(); it != data.end(); ++it) {
-        if (!first) {
-            oss << ", ";
-        }
-        first = false;
+    // A profile writes the fingerprint itself, see appendProfile
+    if (config.profile.empty()) {
+        addToBodyIfPresent(body, "h2Settings", config.h2Settings);
+        addToBodyIfPresent(body, "ja3String", config.ja3String);
+        addToBodyIfPresent(body, "h2SettingsOrder", config.h2SettingsOrder);
+        addToBodyIfPresent(body, "supportedSignatureAlgorithms", config.supportedSignatureAlgorithms);
+        addToBodyIfPresent(body, "supportedVersions", config.supportedVersions);
+        addToBodyIfPresent(body, "keyShareCurves", config.keyShareCurves);
+        addToBodyIfPresent(body, "certCompressionAlgo", config.certCompressionAlgo);
+        addToBodyIfPresent(body, "pseudoHeaderOrder", config.pseudoHeaderOrder);
+        addToBodyIfPresent(body, "connectionFlow", config.connectionFlow);
+        addToBodyIfPresent(body, "priorityFrames", config.priorityFrames);
+        addToBodyIfPresent(body, "headerOrder", config.headerOrder);
+    }
+    addToBodyIfPresent(body, "headers", requestData.headers);
+    addToBodyIfPresent(body, "requestCookies", requestData.cookies);
+    addToBodyIfPresent(body, "requestBody", requestData.data);
+    addToBodyIfPresent(body, "timeoutSeconds", requestData.timeoutSeconds);
+    addToBodyIfPresent(body, "proxyUrl", requestData.proxy);
+    addToBodyIfPresent(body, "serverNameOverwrite", requestData.serverNameOverwrite);
+    addToBodyIfPresent(body, "requestHostOverride", requestData.requestHostOverride);
 
-        const std::string& key = it->first;
-        const std::any& value = it->second;
+    addToBodyIfPresent(body, "sessionId", config.sessionId);
+    addToBodyIfPresent(body, "localAddress", config.localAddress);
+    addToBodyIfPresent(body, "transportOptions", buildTransportOptions(config));
 
-        appendValue(oss, key, value);
+    body["requestMethod"] = method;
+    body["followRedirects"] = requestData.allowRedirects;
+    body["insecureSkipVerify"] = requestData.insecureSkipVerify;
+    body["requestUrl"] = requestData.url;
+    body["clientIdentifier"] = config.clientIdentifier;
+    body["randomTlsExtensionOrder"] = config.randomTlsExtensionOrder;
+    body["forceHttp1"] = config.forceHttp1;
+    body["catchPanics"] = config.catchPanics;
+    body["debug"] = config.debug;
+    return body;
+}
+
+template <typename Codec>
+std::string BasicSession<Codec>::buildRequestBody(const SessionData& config, const RequestData& requestData,
+    const std::string& method) {
+    std::string jsonBody = Codec::buildJson(buildRequestFields(config, requestData, method));
+    if (!config.profile.empty()) {
+        jsonBody.pop_back();
+        appendProfile(config, jsonBody);
+        jsonBody += '}';
     }
+    return jsonBody;
+}
 
-    oss << "}";
-    return oss.str();
+template <typename Codec>
+void BasicSession<Codec>::appendProfile(const SessionData& config, std::string& json) {
+    if (!config.profile.empty()) {
+        json += ", ";
+        json += config.profile;
+    }
 }
 
-template <typename T> inline std::string JsonHelper::jsonValue(const T& value) {
-    if constexpr (std::is_same_v<T, std::string>) {
-        bool isJson = std::regex_match(value, std::regex(R"((\{.*\})|(\[.*\]))"));
-        if (!isJson) {
-            return "\"" + value + "\"";
-        }
-        return value;
+template <typename Codec>
+RequestTemplate BasicSession<Codec>::prepare(const RequestData& requestData, const std::string& method) const {
+    RequestTemplate requestTemplate;
+    requestTemplate.config = sessionData.load();
+    requestTemplate.requestData = requestData;
+    requestTemplate.method = method;
+    requestTemplate.maxResponseSize = maxResponseSize(*requestTemplate.config, requestData);
+    requestTemplate.direct = !requestTemplate.config->resolver && !selectBackend(*requestTemplate.config, requestData);
+    requestTemplate.body = requestData.data;
+
+    // The URL and the body are appended last, escaped, for every request
+    std::unordered_map<std::string, std::any> fields = buildRequestFields(*requestTemplate.config, requestData, method);
+    fields.erase("requestUrl");
+    fields.erase("requestBody");
+
+    std::string& prefix = requestTemplate.prefix;
+    prefix = Codec::buildJson(fields);
+    prefix.pop_back();
+    appendProfile(*requestTemplate.config, prefix);
+    prefix += ", \"requestUrl\": \"";
+    JsonHelper::appendEscaped(prefix, requestData.url);
+    return requestTemplate;
+}
+
+template <typename Codec>
+Expected<ResponseData> BasicSession<Codec>::tryPerform(const RequestTemplate& requestTemplate) {
+    PendingResponse pending;
+    pending.config = sessionData.load();
+    const SessionData& config = *pending.config;
+    if (pending.config != requestTemplate.config || !requestTemplate.direct) {
+        return tryPerformRequest(requestTemplate.toRequestData(), requestTemplate.method);
     }
 
-    else if constexpr (std::is_same_v<T, bool>) {
-        return value ? "true" : "false";
+    // The failure cache only looks at the scheme, host and port, which the suffix leaves as they are
+    const RequestData& requestData = requestTemplate.requestData;
+    if (config.failureCache) {
+        if (std::optional<Error> failure = config.failureCache->lookup(requestData)) {
+            recordRequest(0, 0, true);
+            return Unexpected<Error>{std::move(*failure)};
+        }
     }
 
-    else if constexpr (std::is_arithmetic_v<T>) {
-        return std::to_string(value);
+    std::string envelope = requestTemplate.envelope();
+    pending.bytesSent = envelope.size();
+    Expected<std::pmr::string> response = TlsClient::tryPerformRequest(envelope, requestTemplate.maxResponseSize,
+        pending.payload.get_allocator().resource());
+    if (!response) {
+        recordRequest(envelope.size(), 0, true);
+        recordOutcome(config, requestData, &response.error());
+        return Unexpected<Error>{std::move(response.error())};
     }
+    pending.payload = std::move(*response);
 
-    else {
-        static_assert(always_false<T>::value, "Unsupported type for jsonValue");
+    // Sinks are passed the request as it was sent
+    if (!config.sinks.empty()) {
+        return tryDecode(requestTemplate.toRequestData(), requestTemplate.method, std::move(pending));
     }
+    return tryDecode(requestData, requestTemplate.method, std::move(pending));
 }
 
-std::vector<std::string> JsonHelper::tokenize(const std::string& json) {                            
-    int indents = 0;
-    bool inString = false;
+template <typename Codec>
+ResponseData BasicSession<Codec>::performRequest(RequestData requestData, const std::string& method) {
+    std::shared_ptr<const SessionData> config = sessionData.load();
 
-    std::vector<std::string> tokens;
-    std::string token;
+    if (selectBackend(*config, requestData)) {
+        // Failures are reported like the library does, as status 0 with the message as body
+        Expected<ResponseData> responseData = tryPerformRequest(requestData, method);
+        if (!responseData) {
+            ResponseData failed;
+            failed.body = std::move(responseData.error().message);
+            failed.target = requestData.url;
+            return failed;
+        }
+        return std::move(*responseData);
+    }
 
-    for (size_t i = 0; i < json.size(); ++i) {
-        char ch = json[i];
+    std::optional<Error> failure = config->failureCache ? config->failureCache->lookup(requestData) : std::nullopt;
+    Expected<std::optional<RequestData>> resolved = std::optional<RequestData>();
+    if (!failure) {
+        resolved = resolveHost(*config, requestData);
+        if (!resolved) {
+            failure = std::move(resolved.error());
+            recordOutcome(*config, requestData, &*failure);
+        }
+    }
+    if (failure) {
+        recordRequest(0, 0, true);
+        ResponseData failed;
+        failed.body = std::move(failure->message);
+        failed.target = requestData.url;
+        return failed;
+    }
 
-        if (ch == '"') {
-            inString = !inString;
+    std::string body = buildRequestBody(*config, *resolved ? **resolved : requestData, method);
+    Expected<std::string> response = TlsClient::tryPerformRequest(body, maxResponseSize(*config, requestData));
+    if (!response) {
+        // Recorded like any other failure before throwing as TlsClient::performRequest does
+        recordRequest(body.size(), 0, true);
+        recordOutcome(*config, requestData, &response.error());
+        if (response.error().code == ErrorCode::ResponseTooLarge) {
+            TLS_CLIENT_THROW(std::length_error(response.error().message));
         }
+        TLS_CLIENT_THROW(std::runtime_error(response.error().message));
+    }
+
+    Expected<ResponseData> parsed = parsePayload(*config, *response);
+    ResponseData responseData = parsed ? std::move(*parsed) : ResponseData();
+    recordRequest(body.size(), response->size(), responseData.statusCode == 0);
+    if (responseData.statusCode == 0) {
+        Error error = TlsClient::libraryError(responseData.body);
+        recordOutcome(*config, requestData, &error);
+    } else {
+        recordOutcome(*config, requestData, nullptr);
+    }
+    if (*resolved) {
+        restoreTarget(requestData.url, (*resolved)->url, responseData);
+    }
+
+    if (responseData.statusCode != 0) {
+        dispatchSinks(*config, requestData, method, responseData);
+    }
+    return responseData;
+}
+
+template <typename Codec>
+Expected<ResponseData> BasicSession<Codec>::tryPerformRequest(const RequestData& requestData,
+    const std::string& method) {
+    Expected<PendingResponse> pending = trySend(requestData, method);
+    if (!pending) {
+        return Unexpected<Error>{std::move(pending.error())};
+    }
+    return tryDecode(requestData, method, std::move(*pending));
+}
 
-        if (ch == '{') {
-            indents++;
+template <typename Codec>
+Expected<typename BasicSession<Codec>::PendingResponse> BasicSession<Codec>::trySend(const RequestData& requestData,
+    const std::string& method, bool share) {
+    PendingResponse pending;
+    pending.config = sessionData.load();
+    const SessionData& config = *pending.config;
+
+    if (config.failureCache) {
+        if (std::optional<Error> failure = config.failureCache->lookup(requestData)) {
+            recordRequest(0, 0, true);
+            return Unexpected<Error>{std::move(*failure)};
         }
+    }
 
-        if (ch == '}') {
-            if (indents != 1) {
-                token += ch;
-            }
-            indents--;
+    if (RequestBackend* backend = selectBackend(config, requestData)) {
+        Expected<ResponseData> responseData = backend->perform(requestData, method,
+            maxResponseSize(config, requestData));
+        recordRequest(0, responseData ? responseData->bodyView().size() : 0, !responseData);
+        recordOutcome(config, requestData, responseData ? nullptr : &responseData.error());
+
+        if (!responseData) {
+            return Unexpected<Error>{std::move(responseData.error())};
         }
+        pending.completed = std::move(*responseData);
+        return pending;
+    }
 
-        if (isspace(ch) && !inString) {
-            continue;
+    Expected<std::optional<RequestData>> resolved = resolveHost(config, requestData);
+    if (!resolved) {
+        recordRequest(0, 0, true);
+        recordOutcome(config, requestData, &resolved.error());
+        return Unexpected<Error>{std::move(resolved.error())};
+    }
+    pending.resolved = std::move(*resolved);
+
+    std::string body = buildRequestBody(config, pending.resolved ? *pending.resolved : requestData, method);
+    pending.bytesSent = body.size();
+
+    if (share) {
+        Expected<std::shared_ptr<const SharedResponse>> shared = TlsClient::tryPerformShared(body,
+            maxResponseSize(config, requestData));
+        if (!shared) {
+            recordRequest(body.size(), 0, true);
+            recordOutcome(config, requestData, &shared.error());
+            return Unexpected<Error>{std::move(shared.error())};
         }
+        pending.shared = std::move(*shared);
+        return pending;
+    }
 
-        if (!inString && (ch == '{' || ch == '}' || ch == ':' || ch == ',')) {
-            if (indents != 1) {
-                token += ch;
-                continue;
-            }
+    Expected<std::pmr::string> response = TlsClient::tryPerformRequest(body, maxResponseSize(config, requestData),
+        pending.payload.get_allocator().resource());
+    if (!response) {
+        recordRequest(body.size(), 0, true);
+        recordOutcome(config, requestData, &response.error());
+        return Unexpected<Error>{std::move(response.error())};
+    }
+    pending.payload = std::move(*response);
+    return pending;
+}
 
-            if (!token.empty()) {
-                tokens.push_back(token);
-                token.clear();
+template <typename Codec>
+Expected<ResponseData> BasicSession<Codec>::parsePayload(const SessionData& config, std::string_view payload) {
+    std::shared_ptr<const MappedBody> mappedBody;
+    std::string withoutBody;
+    if (config.spillThreshold && payload.size() > *config.spillThreshold) {
+        std::string_view body;
+        bool failed = false;
+        JsonHelper::forEachRawField(payload, [&](std::string_view key, std::string_view value) {
+            if (key == "status") {
+                failed = value == "0";
+            } else if (key == "body" && value.size() >= 2 && value.front() == '"') {
+                body = value;
             }
-            tokens.push_back(std::string(1, ch));
+            return true;
+        });
+
+        // Error messages stay in the body, where the caller reads them
+        if (!failed && body.size() > *config.spillThreshold + 2) {
+            mappedBody = MappedBody::create(body.substr(1, body.size() - 2), config.spillDirectory);
+        }
+        if (mappedBody) {
+            size_t offset = static_cast<size_t>(body.data() - payload.data());
+            withoutBody.reserve(payload.size() - body.size() + 2);
+            withoutBody.append(payload.substr(0, offset)).append("\"\"").append(payload.substr(offset + body.size()));
+            payload = withoutBody;
         }
+    }
 
-        else {
-            token += ch;
+    // Codecs written before memory scopes take a const std::string&
+    Expected<ResponseData> responseData = [payload]() {
+        if constexpr (std::is_invocable_v<decltype(&Codec::tryParseResponse), std::string_view>) {
+            return Codec::tryParseResponse(payload);
+        } else {
+            return Codec::tryParseResponse(std::string(payload));
         }
+    }();
+    if (responseData && mappedBody) {
+        responseData->mappedBody = std::move(mappedBody);
+    }
+    return responseData;
+}
+
+template <typename Codec>
+Expected<ResponseData> BasicSession<Codec>::tryDecode(const RequestData& requestData, const std::string& method,
+    PendingResponse pending) {
+    const SessionData& config = *pending.config;
+
+    if (pending.completed) {
+        spillBody(config, *pending.completed);
+        dispatchSinks(config, requestData, method, *pending.completed);
+        return std::move(*pending.completed);
     }
 
-    if (!token.empty()) {
-        tokens.push_back(token);
+    Expected<ResponseData> responseData = parsePayload(config, pending.payload);
+    recordRequest(pending.bytesSent, pending.payload.size(), !responseData || responseData->statusCode == 0);
+    if (responseData && pending.resolved) {
+        restoreTarget(requestData.url, pending.resolved->url, *responseData);
     }
 
-    return tokens;
-}
+    if (responseData && responseData->statusCode == 0) {
+        // The library reports failed requests as a response with status 0
+        // and the error message as the body
+        Error error = TlsClient::libraryError(responseData->body);
+        recordOutcome(config, requestData, &error);
+        return Unexpected<Error>{std::move(error)};
+    }
+    if (!responseData) {
+        recordOutcome(config, requestData, &responseData.error());
+    } else {
+        recordOutcome(config, requestData, nullptr);
+    }
 
-template <typename T>
-void JsonHelper::appendKeyValue(std::ostringstream& oss, const std::string& key, const T& value) {
-    oss << "\"" << key << "\": " << JSON_VALUE(value);
+    if (responseData) {
+        dispatchSinks(config, requestData, method, *responseData);
+    }
+    return responseData;
 }
 
-void JsonHelper::appendValue(std::ostringstream& oss, const std::string& key, const std::any& value) {
-    if (!value.has_value()) {
-        return;
+template <typename Codec>
+Expected<std::shared_ptr<const SharedResponse>> BasicSession<Codec>::tryShare(const RequestData& requestData,
+    const std::string& method) {
+    Expected<PendingResponse> pending = trySend(requestData, method, true);
+    if (!pending) {
+        return Unexpected<Error>{std::move(pending.error())};
     }
-    try {
-        const std::type_info& ti = value.type();
-        if (ti == typeid(std::string)) {
-            appendKeyValue(oss, key, std::any_cast<std::string>(value));
-        }
-        else if (ti == typeid(int)) {
-            appendKeyValue(oss, key, std::any_cast<int>(value));
+    const SessionData& config = *pending->config;
+
+    if (pending->shared) {
+        std::shared_ptr<const SharedResponse> shared = std::move(pending->shared);
+        int statusCode = shared->statusCode();
+        recordRequest(pending->bytesSent, shared->size(), statusCode == 0);
+        if (statusCode == 0) {
+            // The library reports failed requests as a response with status 0
+            // and the error message as the body
+            Error error = TlsClient::libraryError(shared->body());
+            recordOutcome(config, requestData, &error);
+            return Unexpected<Error>{std::move(error)};
         }
-        else if (ti == typeid(double)) {
-            appendKeyValue(oss, key, std::any_cast<double>(value));
+        recordOutcome(config, requestData, nullptr);
+
+        bool spills = config.spillThreshold && shared->body().size() > *config.spillThreshold;
+        if (config.sinks.empty() && !pending->resolved && !spills) {
+            return shared;
         }
-        else if (ti == typeid(bool)) {
-            appendKeyValue(oss, key, std::any_cast<bool>(value));
+
+        // Sinks are passed a ResponseData, and the target and body storage are changed on one
+        pending->completed = shared->toResponseData();
+        if (pending->resolved) {
+            restoreTarget(requestData.url, pending->resolved->url, *pending->completed);
         }
     }
-    catch (const std::bad_any_cast& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
+
+    Expected<ResponseData> responseData = tryDecode(requestData, method, std::move(*pending));
+    if (!responseData) {
+        return Unexpected<Error>{std::move(responseData.error())};
     }
+    return SharedResponse::copy(*responseData);
 }
 
-ResponseData JsonHelper::parseResponse(const std::string& json) {
-    auto tokens = tokenize(json);
-    ResponseData responseData;
-    std::string key;
-    bool isKey = true;
-
-    for (size_t i = 0; i < tokens.size(); ++i) {
-        const std::string& token = tokens[i];
+template <typename Codec>
+std::vector<Expected<ResponseData>> BasicSession<Codec>::tryBatch(const std::vector<RequestData>& requests,
+    const std::string& method, ThreadPool& requestExecutor, ThreadPool& decodeExecutor) {
+    std::vector<std::optional<Expected<ResponseData>>> results(requests.size());
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t remaining = requests.size();
 
-        if (token == "{" || token == "}") {
-            continue;
-        }
-        else if (token == ":") {
-            isKey = false;
+    auto finish = [&](size_t index, Expected<ResponseData> result) {
+        results[index].emplace(std::move(result));
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0) {
+            done.notify_one();
         }
-        else if (token == ",") {
-            isKey = true;
+    };
+
+    // A task that throws (a sink, a codec or an allocation) fails its own request, not the executor
+    auto guarded = [&](size_t index, auto&& task) {
+#if defined(TLS_CLIENT_EXCEPTIONS)
+        try {
+            task();
+        } catch (const std::exception& exception) {
+            finish(index, Unexpected<Error>{{ErrorCode::Request, exception.what()}});
+        } catch (...) {
+            finish(index, Unexpected<Error>{{ErrorCode::Request, "Unknown exception in batch request"}});
         }
-        else {
-            if (isKey) {
-                key = token.substr(1, token.size() - 2);
-            }
-            else {
-                if (key == "status" && !token.empty()) {
-                    responseData.statusCode = std::stoi(token);
-                }
-                else if (key == "body" && !token.empty()) {
-                    responseData.body = token.substr(1, token.size() - 2);
-                }
-                else if (key == "target" && !token.empty()) {
-                    responseData.target = token.substr(1, token.size() - 2);
-                }
-                else if (key == "usedProtocol" && !token.empty()) {
-                    responseData.usedProtocol = token.substr(1, token.size() - 2);
-                }
-                else if (key == "headers") {
-                    responseData.headers = token;
-                }
-                else if (key == "cookies") {
-                    responseData.cookies = token;
+#else
+        task();
+#endif
+    };
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        requestExecutor.post([&, i]() {
+            guarded(i, [&, i]() {
+                // The payload is freed on the decode thread, so it does not come from the memory scope of this one
+                Expected<PendingResponse> pending = [&]() {
+                    MemoryScope scope(std::pmr::get_default_resource());
+                    return trySend(requests[i], method);
+                }();
+                if (!pending) {
+                    finish(i, Unexpected<Error>{std::move(pending.error())});
+                    return;
                 }
-                isKey = true;
-            }
-        }
+
+                // The request thread goes back to the library while the response is parsed
+                auto shared = std::make_shared<PendingResponse>(std::move(*pending));
+                decodeExecutor.post([&, i, shared]() {
+                    guarded(i, [&, i, shared]() { finish(i, tryDecode(requests[i], method, std::move(*shared))); });
+                });
+            });
+        });
     }
 
-    return responseData;
-}
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&remaining]() { return remaining == 0; });
 
-template <typename T>
-void Session::addToBodyIfPresent(std::unordered_map<std::string, std::any>& body,
-    const std::string& key, const T& value) {
-    if (value.has_value()) {
-        body[key] = value.value();
+    std::vector<Expected<ResponseData>> responses;
+    responses.reserve(requests.size());
+    for (auto& result : results) {
+        responses.push_back(std::move(*result));
     }
-};
+    return responses;
+}
 
-std::string Session::buildRequestBody(RequestData requestData, std::string method) {
-    std::unordered_map<std::string, std::any> body;
+template <typename Codec>
+template <typename T>
+Expected<T> BasicSession<Codec>::getJson(const RequestData& requestData) {
+    auto httpError = [](int statusCode) {
+        return Unexpected<Error>{{ErrorCode::Request, "Response status " + std::to_string(statusCode)}};
+    };
 
-    addToBodyIfPresent(body, "h2Settings", sessionData.h2Settings);
-    addToBodyIfPresent(body, "ja3String", sessionData.ja3String);
-    addToBodyIfPresent(body, "h2SettingsOrder", sessionData.h2SettingsOrder);
-    addToBodyIfPresent(body, "supportedSignatureAlgorithms", sessionData.supportedSignatureAlgorithms);
-    addToBodyIfPresent(body, "supportedVersions", sessionData.supportedVersions);
-    addToBodyIfPresent(body, "keyShareCurves", sessionData.keyShareCurves);
-    addToBodyIfPresent(body, "certCompressionAlgo", sessionData.certCompressionAlgo);
-    addToBodyIfPresent(body, "pseudoHeaderOrder", sessionData.pseudoHeaderOrder);
-    addToBodyIfPresent(body, "connectionFlow", sessionData.connectionFlow);
-    addToBodyIfPresent(body, "priorityFrames", sessionData.priorityFrames);
-    addToBodyIfPresent(body, "headerOrder", sessionData.headerOrder);
-    addToBodyIfPresent(body, "headers", requestData.headers);
-    addToBodyIfPresent(body, "requestCookies", requestData.cookies);
-    addToBodyIfPresent(body, "requestBody", requestData.data);
-    addToBodyIfPresent(body, "timeoutSeconds", requestData.timeoutSeconds);
-    addToBodyIfPresent(body, "proxyUrl", requestData.proxy);
+    Expected<PendingResponse> pending = trySend(requestData, "GET");
+    if (!pending) {
+        return Unexpected<Error>{std::move(pending.error())};
+    }
+    const SessionData& config = *pending->config;
 
-    body["requestMethod"] = method;
-    body["allowRedirects"] = requestData.allowRedirects;
-    body["insecureSkipVerify"] = requestData.allowRedirects;
-    body["requestUrl"] = requestData.url;
-    body["clientIdentifier"] = sessionData.clientIdentifier;
-    body["randomTlsExtensionOrder"] = sessionData.randomTlsExtensionOrder;
-    body["forceHttp1"] = sessionData.forceHttp1;
-    body["catchPanics"] = sessionData.catchPanics;
-    body["debug"] = sessionData.debug;
+    if (pending->completed || !config.sinks.empty()) {
+        // Backends return a ResponseData, and sinks are passed one
+        Expected<ResponseData> responseData = tryDecode(requestData, "GET", std::move(*pending));
+        if (!responseData) {
+            return Unexpected<Error>{std::move(responseData.error())};
+        }
+        if (responseData->statusCode >= 400) {
+            return httpError(responseData->statusCode);
+        }
+        return JsonDecoder<T>::decodeBody(*responseData);
+    }
 
-    std::string jsonBody = JsonHelper::buildJson(body);
-    return jsonBody;
-}
+    // Only the status and the body of the library response are read
+    int statusCode = -1;
+    std::string_view body;
+    bool wellFormed = JsonHelper::forEachRawField(pending->payload, [&](std::string_view name, std::string_view value) {
+        if (name == "status") {
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), statusCode);
+            if (ec != std::errc() || end != value.data() + value.size()) {
+                statusCode = -1;
+            }
+        } else if (name == "body" && value.size() >= 2 && value.front() == '"') {
+            body = value.substr(1, value.size() - 2);
+        }
+        return true;
+    });
 
-ResponseData Session::performRequest(RequestData requestData, const std::string& method) {
-    std::string body = buildRequestBody(requestData, method);
-    std::string response = TlsClient::performRequest(body);
+    bool malformed = !wellFormed || statusCode < 0;
+    recordRequest(pending->bytesSent, pending->payload.size(), malformed || statusCode == 0);
+    if (malformed) {
+        Error error{ErrorCode::Parse, "Malformed library response: " + std::string(pending->payload)};
+        recordOutcome(config, requestData, &error);
+        return Unexpected<Error>{std::move(error)};
+    }
+    if (statusCode == 0) {
+        // The library reports failed requests as a response with status 0
+        // and the error message as the body
+        Error error = TlsClient::libraryError(body);
+        recordOutcome(config, requestData, &error);
+        return Unexpected<Error>{std::move(error)};
+    }
 
-    ResponseData responseData = JsonHelper::parseResponse(response);
-    return responseData;
+    recordOutcome(config, requestData, nullptr);
+    if (statusCode >= 400) {
+        return httpError(statusCode);
+    }
+    return JsonDecoder<T>::decodeEscaped(body);
 }
 
-ResponseData Session::POST(RequestData requestData) {
+template <typename Codec>
+ResponseData BasicSession<Codec>::POST(RequestData requestData) {
     return performRequest(requestData, "POST");
 }
 
-ResponseData Session::GET(RequestData requestData) {
+template <typename Codec>
+ResponseData BasicSession<Codec>::GET(RequestData requestData) {
     return performRequest(requestData, "GET");
 }
 
-ResponseData Session::PUT(RequestData requestData) {
+template <typename Codec>
+ResponseData BasicSession<Codec>::PUT(RequestData requestData) {
     return performRequest(requestData, "PUT");
 }
 
-ResponseData Session::_DELETE(RequestData requestData) {
+template <typename Codec>
+ResponseData BasicSession<Codec>::_DELETE(RequestData requestData) {
     return performRequest(requestData, "DELETE");
 }
 
-ResponseData Session::PATCH(RequestData requestData) {
+template <typename Codec>
+ResponseData BasicSession<Codec>::PATCH(RequestData requestData) {
     return performRequest(requestData, "PATCH");
 }
 
-ResponseData Session::HEAD(RequestData requestData) {
+template <typename Codec>
+ResponseData BasicSession<Codec>::HEAD(RequestData requestData) {
     return performRequest(requestData, "HEAD");
 }
 
-ResponseData Session::OPTIONS(RequestData requestData) {
+template <typename Codec>
+ResponseData BasicSession<Codec>::OPTIONS(RequestData requestData) {
     return performRequest(requestData, "OPTIONS");
-}
\ No newline at end of file
+}
+
+template <typename Codec>
+Expected<ResponseData> BasicSession<Codec>::tryGET(const RequestData& requestData) {
+    return tryPerformRequest(requestData, "GET");
+}
+
+template <typename Codec>
+Expected<ResponseData> BasicSession<Codec>::tryPOST(const RequestData& requestData) {
+    return tryPerformRequest(requestData, "POST");
+}
+
+template <typename Codec>
+Expected<ResponseData> BasicSession<Codec>::tryPUT(const RequestData& requestData) {
+    return tryPerformRequest(requestData, "PUT");
+}
+
+template <typename Codec>
+Expected<ResponseData> BasicSession<Codec>::tryDELETE(const RequestData& requestData) {
+    return tryPerformRequest(requestData, "DELETE");
+}
+
+template <typename Codec>
+Expected<ResponseData> BasicSession<Codec>::tryPATCH(const RequestData& requestData) {
+    return tryPerformRequest(requestData, "PATCH");
+}
+
+template <typename Codec>
+Expected<ResponseData> BasicSession<Codec>::tryHEAD(const RequestData& requestData) {
+    return tryPerformRequest(requestData, "HEAD");
+}
+
+template <typename Codec>
+Expected<ResponseData> BasicSession<Codec>::tryOPTIONS(const RequestData& requestData) {
+    return tryPerformRequest(requestData, "OPTIONS");
+}
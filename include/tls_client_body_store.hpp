@@ -0,0 +1,459 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client.hpp"
+
+#if !defined(OS_LINUX) && !defined(OS_APPLE)
+#error "BodyStore requires a POSIX platform"
+#endif
+
+#include <cstdio>
+#include <shared_mutex>
+
+#include <sys/stat.h>
+
+/**
+ * @brief BodyStore class storing response bodies by content hash.
+ *
+ * Each distinct body is stored once. The store is a directory with two files:
+ * `bodies.dat`, an append-only file holding the bodies back to back, and
+ * `bodies.idx`, a memory-mapped open-addressing table mapping the
+ * ContentHash of a body to its offset and size. A body whose hash is
+ * already stored is checked against the stored size, and against the
+ * stored bytes when the store is opened with verifyContent; a mismatch is
+ * reported as a hash collision instead of being taken for the stored body.
+ *
+ * Registered as a sink (see SessionData::sinks), the store keeps the decoded
+ * body of every completed response (see ResponseData::decodeBody) and sets its
+ * ResponseData::bodyHash, so repeated fetches of identical content can be
+ * skipped downstream.
+ *
+ * The store is thread-safe and may be shared by several sessions, but not
+ * by several processes.
+ */
+class BodyStore : public ResponseSink {
+public:
+    /**
+     * @brief PutResult struct describing a stored body.
+     */
+    struct PutResult {
+        uint64_t hash; /**< The content hash of the body. */
+        bool inserted; /**< Whether the body was new to the store. */
+    };
+
+    /**
+     * @brief Opens the store in the given directory, creating it if needed.
+     *
+     * @param directory The directory of the store.
+     * @param verifyContent Whether a body whose hash is already stored is compared byte by
+     * byte with the stored one, not only by size.
+     * @return Expected<std::shared_ptr<BodyStore>> The store, or an ErrorCode::Io error.
+     */
+    [[nodiscard]] static inline Expected<std::shared_ptr<BodyStore>> open(const std::string& directory,
+        bool verifyContent = false);
+
+    BodyStore(const BodyStore&) = delete;
+    BodyStore& operator=(const BodyStore&) = delete;
+
+    /**
+     * @brief Destructor unmapping the index and closing the files.
+     */
+    inline ~BodyStore() override;
+
+    /**
+     * @brief Stores a body unless the same body is already stored.
+     *
+     * @param body The body to store.
+     * @return Expected<PutResult> The hash of the body, or an ErrorCode::Io error, also
+     * returned when another body with the same hash is stored.
+     */
+    inline Expected<PutResult> put(std::string_view body);
+
+    /**
+     * @brief Checks whether a body is stored.
+     *
+     * @param hash The content hash of the body.
+     * @return bool Whether the body is stored.
+     */
+    [[nodiscard]] inline bool contains(uint64_t hash) const;
+
+    /**
+     * @brief Reads a stored body.
+     *
+     * @param hash The content hash of the body.
+     * @return std::optional<std::string> The body, or nothing if it is not stored.
+     */
+    [[nodiscard]] inline std::optional<std::string> get(uint64_t hash) const;
+
+    /**
+     * @brief Returns the number of distinct bodies stored.
+     *
+     * @return size_t The number of bodies.
+     */
+    [[nodiscard]] inline size_t size() const;
+
+    /**
+     * @brief Flushes the data and index files to disk.
+     *
+     * @return std::optional<Error> An ErrorCode::Io error, or nothing on success.
+     */
+    inline std::optional<Error> flush();
+
+    /**
+     * @brief Stores the decoded body of a response and sets its bodyHash.
+     */
+    inline void consume(const RequestData& requestData, const std::string& method,
+        ResponseData& responseData) override;
+
+private:
+    static constexpr char MAGIC[8] = {'T', 'L', 'S', 'B', 'O', 'D', 'Y', '1'};
+    static constexpr uint64_t INITIAL_CAPACITY = 1024; /**< Initial number of index slots, a power of two. */
+
+    /**
+     * @brief IndexHeader struct at the start of the index file.
+     */
+    struct IndexHeader {
+        char magic[8];     /**< The MAGIC of the index file. */
+        uint64_t capacity; /**< The number of slots, a power of two. */
+        uint64_t count;    /**< The number of used slots. */
+        uint64_t dataSize; /**< The size of the data file covered by the index. */
+    };
+
+    /**
+     * @brief IndexEntry struct describing one slot of the index.
+     */
+    struct IndexEntry {
+        uint64_t hash;   /**< The content hash of the body, 0 for an empty slot. */
+        uint64_t offset; /**< The offset of the body in the data file. */
+        uint64_t size;   /**< The size of the body. */
+    };
+
+    std::string directory;         /**< The directory of the store. */
+    int dataFile;                  /**< The file descriptor of the data file. */
+    int indexFile;                 /**< The file descriptor of the index file. */
+    IndexHeader* header = nullptr; /**< The mapped index file. */
+    size_t mappedSize = 0;         /**< The size of the mapping. */
+    bool verifyContent;            /**< Whether stored bodies are compared byte by byte. */
+    mutable std::shared_mutex mutex;
+
+    BodyStore(std::string directory, int dataFile, int indexFile, bool verifyContent)
+        : directory(std::move(directory)), dataFile(dataFile), indexFile(indexFile), verifyContent(verifyContent) {}
+
+    /**
+     * @brief Returns the slots of the index.
+     */
+    [[nodiscard]] IndexEntry* entries() const noexcept { return reinterpret_cast<IndexEntry*>(header + 1); }
+
+    /**
+     * @brief Maps the given hash to a key, as 0 marks empty slots.
+     */
+    [[nodiscard]] static uint64_t key(uint64_t hash) noexcept { return hash == 0 ? 1 : hash; }
+
+    /**
+     * @brief Returns the slot holding the key, or the empty slot it would be inserted at.
+     */
+    [[nodiscard]] inline IndexEntry* find(uint64_t key) const noexcept;
+
+    /**
+     * @brief Reads the body of a slot from the data file.
+     *
+     * @return std::optional<std::string> The body, or nothing if it cannot be read.
+     */
+    [[nodiscard]] inline std::optional<std::string> read(const IndexEntry& entry) const;
+
+    /**
+     * @brief Maps an index file holding the given number of slots.
+     *
+     * @return std::optional<Error> An ErrorCode::Io error, or nothing on success.
+     */
+    inline std::optional<Error> mapIndex(int file, uint64_t capacity);
+
+    /**
+     * @brief Replaces the index with one twice as large, written aside and renamed into place.
+     *
+     * @return std::optional<Error> An ErrorCode::Io error, or nothing on success.
+     */
+    inline std::optional<Error> grow();
+
+    [[nodiscard]] static inline Error ioError(const std::string& action, const std::string& path);
+};
+
+Expected<std::shared_ptr<BodyStore>> BodyStore::open(const std::string& directory, bool verifyContent) {
+    std::error_code errorCode;
+    std::filesystem::create_directories(directory, errorCode);
+    if (errorCode) {
+        return Unexpected<Error>{{ErrorCode::Io, "failed to create " + directory + ": " + errorCode.message()}};
+    }
+
+    std::string dataPath = directory + "/bodies.dat";
+    std::string indexPath = directory + "/bodies.idx";
+
+    int dataFile = ::open(dataPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (dataFile == -1) {
+        return Unexpected<Error>{ioError("open", dataPath)};
+    }
+
+    int indexFile = ::open(indexPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (indexFile == -1) {
+        Error error = ioError("open", indexPath);
+        close(dataFile);
+        return Unexpected<Error>{std::move(error)};
+    }
+
+    std::shared_ptr<BodyStore> store(new BodyStore(directory, dataFile, indexFile, verifyContent));
+
+    struct stat status {};
+    if (fstat(indexFile, &status) == -1) {
+        return Unexpected<Error>{ioError("stat", indexPath)};
+    }
+
+    if (status.st_size == 0) {
+        if (std::optional<Error> error = store->mapIndex(indexFile, INITIAL_CAPACITY)) {
+            return Unexpected<Error>{std::move(*error)};
+        }
+        return store;
+    }
+
+    IndexHeader header{};
+    if (pread(indexFile, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+        std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.capacity == 0 ||
+        (header.capacity & (header.capacity - 1)) != 0 ||
+        static_cast<uint64_t>(status.st_size) != sizeof(IndexHeader) + header.capacity * sizeof(IndexEntry)) {
+        return Unexpected<Error>{{ErrorCode::Io, indexPath + " is not a body store index"}};
+    }
+
+    if (std::optional<Error> error = store->mapIndex(indexFile, header.capacity)) {
+        return Unexpected<Error>{std::move(*error)};
+    }
+
+    // Drop bodies appended after the index was last updated
+    if (ftruncate(dataFile, static_cast<off_t>(store->header->dataSize)) == -1) {
+        return Unexpected<Error>{ioError("truncate", dataPath)};
+    }
+    return store;
+}
+
+BodyStore::~BodyStore() {
+    if (header) {
+        munmap(header, mappedSize);
+    }
+    close(indexFile);
+    close(dataFile);
+}
+
+Expected<BodyStore::PutResult> BodyStore::put(std::string_view body) {
+    uint64_t hash = ContentHash::compute(body);
+
+    // The hash alone does not identify a body: another body with the same hash is a collision
+    auto stored = [this, hash, body](const IndexEntry& entry) -> Expected<PutResult> {
+        bool same = entry.size == body.size();
+        if (same && verifyContent) {
+            std::optional<std::string> storedBody = read(entry);
+            same = storedBody && *storedBody == body;
+        }
+        if (!same) {
+            return Unexpected<Error>{{ErrorCode::Io, "content hash collision in " + directory + "/bodies.dat"}};
+        }
+        return PutResult{hash, false};
+    };
+
+    IndexEntry entry{};
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        entry = *find(key(hash));
+    }
+    if (entry.hash != 0) {
+        return stored(entry);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    entry = *find(key(hash));
+    if (entry.hash != 0) {
+        lock.unlock();
+        return stored(entry);
+    }
+
+    if ((header->count + 1) * 10 > header->capacity * 7) {
+        if (std::optional<Error> error = grow()) {
+            return Unexpected<Error>{std::move(*error)};
+        }
+    }
+
+    uint64_t offset = header->dataSize;
+    size_t written = 0;
+    while (written < body.size()) {
+        ssize_t result = pwrite(dataFile, body.data() + written, body.size() - written,
+            static_cast<off_t>(offset + written));
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Unexpected<Error>{ioError("write", directory + "/bodies.dat")};
+        }
+        written += static_cast<size_t>(result);
+    }
+
+    // Publish the entry only after the body is written
+    IndexEntry* slot = find(key(hash));
+    slot->offset = offset;
+    slot->size = body.size();
+    slot->hash = key(hash);
+    header->count += 1;
+    header->dataSize = offset + body.size();
+    return PutResult{hash, true};
+}
+
+bool BodyStore::contains(uint64_t hash) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return find(key(hash))->hash != 0;
+}
+
+std::optional<std::string> BodyStore::get(uint64_t hash) const {
+    IndexEntry entry{};
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        entry = *find(key(hash));
+    }
+
+    if (entry.hash == 0) {
+        return std::nullopt;
+    }
+    return read(entry);
+}
+
+std::optional<std::string> BodyStore::read(const IndexEntry& entry) const {
+    // The data file is append-only, so stored bodies can be read without the lock
+    std::string body(entry.size, '\0');
+    size_t done = 0;
+    while (done < body.size()) {
+        ssize_t result = pread(dataFile, body.data() + done, body.size() - done, static_cast<off_t>(entry.offset + done));
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return std::nullopt;
+        }
+        done += static_cast<size_t>(result);
+    }
+    return body;
+}
+
+size_t BodyStore::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return header->count;
+}
+
+std::optional<Error> BodyStore::flush() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (fsync(dataFile) == -1) {
+        return ioError("sync", directory + "/bodies.dat");
+    }
+    if (msync(header, mappedSize, MS_SYNC) == -1) {
+        return ioError("sync", directory + "/bodies.idx");
+    }
+    return std::nullopt;
+}
+
+void BodyStore::consume(const RequestData&, const std::string&, ResponseData& responseData) {
+    Expected<PutResult> result = put(responseData.decodeBody());
+    if (result) {
+        responseData.bodyHash = result->hash;
+    }
+}
+
+BodyStore::IndexEntry* BodyStore::find(uint64_t key) const noexcept {
+    uint64_t mask = header->capacity - 1;
+    IndexEntry* slots = entries();
+
+    for (uint64_t slot = key & mask;; slot = (slot + 1) & mask) {
+        if (slots[slot].hash == key || slots[slot].hash == 0) {
+            return &slots[slot];
+        }
+    }
+}
+
+std::optional<Error> BodyStore::mapIndex(int file, uint64_t capacity) {
+    size_t size = sizeof(IndexHeader) + capacity * sizeof(IndexEntry);
+
+    struct stat status {};
+    if (fstat(file, &status) == -1) {
+        return ioError("stat", directory + "/bodies.idx");
+    }
+
+    bool created = status.st_size == 0;
+    if (created && ftruncate(file, static_cast<off_t>(size)) == -1) {
+        return ioError("resize", directory + "/bodies.idx");
+    }
+
+    void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (address == MAP_FAILED) {
+        return ioError("map", directory + "/bodies.idx");
+    }
+
+    if (header) {
+        munmap(header, mappedSize);
+    }
+    header = static_cast<IndexHeader*>(address);
+    mappedSize = size;
+
+    if (created) {
+        std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+        header->capacity = capacity;
+    }
+    return std::nullopt;
+}
+
+std::optional<Error> BodyStore::grow() {
+    std::string indexPath = directory + "/bodies.idx";
+    std::string tempPath = indexPath + ".tmp";
+
+    int file = ::open(tempPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (file == -1) {
+        return ioError("open", tempPath);
+    }
+
+    IndexHeader* oldHeader = header;
+    size_t oldSize = mappedSize;
+    header = nullptr;
+
+    if (std::optional<Error> error = mapIndex(file, oldHeader->capacity * 2)) {
+        header = oldHeader;
+        close(file);
+        unlink(tempPath.c_str());
+        return error;
+    }
+
+    IndexEntry* oldEntries = reinterpret_cast<IndexEntry*>(oldHeader + 1);
+    for (uint64_t slot = 0; slot < oldHeader->capacity; ++slot) {
+        if (oldEntries[slot].hash != 0) {
+            *find(oldEntries[slot].hash) = oldEntries[slot];
+        }
+    }
+    header->count = oldHeader->count;
+    header->dataSize = oldHeader->dataSize;
+
+    if (rename(tempPath.c_str(), indexPath.c_str()) == -1) {
+        Error error = ioError("rename", tempPath);
+        munmap(header, mappedSize);
+        header = oldHeader;
+        mappedSize = oldSize;
+        close(file);
+        unlink(tempPath.c_str());
+        return error;
+    }
+
+    munmap(oldHeader, oldSize);
+    close(indexFile);
+    indexFile = file;
+    return std::nullopt;
+}
+
+Error BodyStore::ioError(const std::string& action, const std::string& path) {
+    return {ErrorCode::Io, "failed to " + action + " " + path + ": " + std::strerror(errno)};
+}
@@ -0,0 +1,768 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <fstream>
+
+#if defined(OS_LINUX) || defined(OS_APPLE)
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#endif
+
+/**
+ * @brief DnsAnswer struct containing the answer to a DNS query.
+ */
+struct DnsAnswer {
+    std::vector<std::string> addresses; /**< The IP addresses; empty if the name has none. */
+    std::chrono::seconds ttl{0};        /**< How long the answer, even an empty one, may be cached. */
+};
+
+/**
+ * @brief DnsResolver class querying DNS for the addresses of a host name.
+ *
+ * Implementations must be thread-safe.
+ */
+class DnsResolver {
+public:
+    virtual ~DnsResolver() = default;
+
+    /**
+     * @brief Queries the addresses of a host name.
+     *
+     * @param host The host name.
+     * @return Expected<DnsAnswer> The answer, with no addresses if the name does not
+     * exist, or the error (ErrorCode::Dns) if no answer was received.
+     */
+    [[nodiscard]] virtual Expected<DnsAnswer> query(const std::string& host) = 0;
+};
+
+#if defined(OS_LINUX) || defined(OS_APPLE)
+/**
+ * @brief UdpDnsResolverOptions struct containing the options of a UdpDnsResolver.
+ */
+struct UdpDnsResolverOptions {
+    std::chrono::milliseconds timeout{1000}; /**< How long to wait for each attempt. */
+    int attempts = 2;                        /**< How many times a query is sent. */
+    bool ipv6 = false;                       /**< Whether to query AAAA records after the A records. */
+};
+
+/**
+ * @brief UdpDnsResolver class sending DNS queries over UDP to a name server.
+ *
+ * Answers keep the TTL of their records (the smallest one, CNAMEs included),
+ * and negative answers the TTL of the SOA record of the zone. Truncated
+ * answers are used as received, without retrying over TCP.
+ */
+class UdpDnsResolver : public DnsResolver {
+public:
+    /**
+     * @brief Constructs the resolver.
+     *
+     * @param nameserver The address of the name server, as "ip", "ip:port" or "[ipv6]:port".
+     * @param options The options of the resolver.
+     * @throws std::invalid_argument If the address is not valid; use create without exceptions.
+     */
+    explicit inline UdpDnsResolver(const std::string& nameserver, UdpDnsResolverOptions options = {});
+
+    /**
+     * @brief Creates a resolver without throwing.
+     *
+     * @param nameserver The address of the name server, as for the constructor.
+     * @param options The options of the resolver.
+     * @return Expected<std::shared_ptr<UdpDnsResolver>> The resolver, or an ErrorCode::Dns
+     * error if the address is not valid.
+     */
+    [[nodiscard]] static inline Expected<std::shared_ptr<UdpDnsResolver>> create(const std::string& nameserver,
+        UdpDnsResolverOptions options = {});
+
+    /**
+     * @brief Creates a resolver for the first name server of /etc/resolv.conf.
+     *
+     * @param options The options of the resolver.
+     * @return Expected<std::shared_ptr<UdpDnsResolver>> The resolver, or the error
+     * if no name server is configured.
+     */
+    [[nodiscard]] static inline Expected<std::shared_ptr<UdpDnsResolver>> fromSystem(
+        UdpDnsResolverOptions options = {});
+
+    [[nodiscard]] inline Expected<DnsAnswer> query(const std::string& host) override;
+
+private:
+    sockaddr_storage address{};
+    socklen_t addressLength = 0;
+    UdpDnsResolverOptions options;
+    std::atomic<uint16_t> nextId;
+
+    static constexpr uint16_t TYPE_A = 1;
+    static constexpr uint16_t TYPE_SOA = 6;
+    static constexpr uint16_t TYPE_AAAA = 28;
+
+    /**
+     * @brief Parses the address of a name server, returning false if it is not valid.
+     */
+    [[nodiscard]] static inline bool parseAddress(const std::string& nameserver, sockaddr_storage& address,
+        socklen_t& addressLength);
+
+    /**
+     * @brief Sends one query and parses its answer.
+     */
+    [[nodiscard]] inline Expected<DnsAnswer> queryType(const std::string& host, uint16_t type);
+
+    /**
+     * @brief Skips a possibly compressed name, returning the offset after it or 0 if it is malformed.
+     */
+    [[nodiscard]] static inline size_t skipName(const std::string& message, size_t offset);
+};
+
+/**
+ * @brief SystemDnsResolver class resolving host names with getaddrinfo.
+ *
+ * The system resolver also reads the hosts file, but does not report TTLs,
+ * so every answer gets the same fixed TTL.
+ */
+class SystemDnsResolver : public DnsResolver {
+public:
+    /**
+     * @brief Constructs the resolver.
+     *
+     * @param ttl The TTL of every answer.
+     * @param ipv6 Whether to return IPv6 addresses too.
+     */
+    explicit SystemDnsResolver(std::chrono::seconds ttl = std::chrono::seconds(60), bool ipv6 = false)
+        : ttl(ttl), ipv6(ipv6) {}
+
+    [[nodiscard]] inline Expected<DnsAnswer> query(const std::string& host) override;
+
+private:
+    std::chrono::seconds ttl;
+    bool ipv6;
+};
+#endif
+
+/**
+ * @brief DnsCacheOptions struct containing the options of a DnsCache.
+ */
+struct DnsCacheOptions {
+    std::chrono::seconds minTtl{5};          /**< The shortest time answers are cached. */
+    std::chrono::seconds maxTtl{3600};       /**< The longest time answers are cached. */
+    std::chrono::seconds maxNegativeTtl{30}; /**< The longest time names without addresses are cached. */
+    std::chrono::seconds errorTtl{1};        /**< How long resolver failures are cached. */
+
+    /**
+     * @brief prefetchFraction field
+     *
+     * This field specifies the fraction of its TTL before the expiry of an answer
+     * from which a lookup refreshes it in the background, so that names in use
+     * never expire. 0 disables prefetching.
+     */
+    double prefetchFraction = 0.1;
+
+    /**
+     * @brief maxEntries field
+     *
+     * This field specifies the number of names the cache holds at most. When it
+     * is full, expired entries are dropped first, then the ones expiring soonest.
+     */
+    size_t maxEntries = 100000;
+
+    size_t threads = 1; /**< The number of threads refreshing entries in the background. */
+};
+
+/**
+ * @brief DnsCacheStats struct containing the statistics of a DnsCache.
+ */
+struct DnsCacheStats {
+    uint64_t hits = 0;         /**< Lookups answered from the cache with addresses. */
+    uint64_t negativeHits = 0; /**< Lookups answered from the cache with an error. */
+    uint64_t misses = 0;       /**< Lookups that waited for a query. */
+    uint64_t queries = 0;      /**< Queries sent to the resolver. */
+    uint64_t prefetches = 0;   /**< Queries refreshing an entry before its expiry. */
+};
+
+/**
+ * @brief DnsCache class caching the answers of a DnsResolver.
+ *
+ * Answers are kept for their TTL (clamped to the options), names without
+ * addresses and failures for a shorter time. Concurrent lookups of a name
+ * share one query, and lookups close to the expiry of an answer refresh it
+ * in the background while still returning it.
+ *
+ * As a HostResolver (see SessionData::resolver), the cache returns the
+ * addresses of a name in turn, so that requests spread over them. All public
+ * member functions are thread-safe.
+ */
+class DnsCache : public HostResolver {
+public:
+    /**
+     * @brief Constructs the cache.
+     *
+     * @param resolver The resolver answering the lookups missing from the cache.
+     * @param options The options of the cache.
+     */
+    explicit DnsCache(std::shared_ptr<DnsResolver> resolver, DnsCacheOptions options = {})
+        : resolver(std::move(resolver)), options(options),
+          executor(std::make_unique<ThreadPool>(std::max<size_t>(options.threads, 1))) {}
+
+    DnsCache(const DnsCache&) = delete;
+    DnsCache& operator=(const DnsCache&) = delete;
+
+    /**
+     * @brief Looks up the addresses of a host name.
+     *
+     * @param host The host name.
+     * @return Expected<DnsAnswer> The addresses with the remaining TTL, or the error.
+     * Names without addresses fail with ErrorCode::Dns.
+     */
+    [[nodiscard]] inline Expected<DnsAnswer> lookup(const std::string& host);
+
+    /**
+     * @brief Returns one address of a host name, rotating between its addresses.
+     *
+     * @param host The host name.
+     * @return Expected<std::string> The address, or the error.
+     */
+    [[nodiscard]] inline Expected<std::string> resolve(const std::string& host) override;
+
+    /**
+     * @brief Queries a host name in the background unless it is cached and fresh.
+     *
+     * @param host The host name.
+     */
+    inline void prefetch(const std::string& host);
+
+    /**
+     * @brief Drops every entry, except the ones being queried.
+     */
+    inline void clear();
+
+    /**
+     * @brief Returns the number of cached names.
+     */
+    [[nodiscard]] inline size_t size() const;
+
+    /**
+     * @brief Returns the statistics of the cache.
+     */
+    [[nodiscard]] inline DnsCacheStats getStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Entry struct holding the cached result of a host name.
+     */
+    struct Entry {
+        std::vector<std::string> addresses;
+        std::optional<Error> error;     /**< Set for negative entries. */
+        Clock::time_point fetched;
+        Clock::time_point expires;      /**< Default-constructed until the first answer. */
+        Clock::time_point retry;        /**< When a failed refresh may be prefetched again. */
+        bool querying = false;
+        std::shared_future<void> done;  /**< Ready when the running query completes. */
+        size_t next = 0;                /**< The address returned next by resolve. */
+    };
+
+    std::shared_ptr<DnsResolver> resolver;
+    DnsCacheOptions options;
+
+    mutable std::mutex mutex;           /**< Guards the entries and statistics. */
+    std::unordered_map<std::string, Entry> entries;
+    DnsCacheStats stats;
+
+    std::unique_ptr<ThreadPool> executor; /**< Declared last, so it stops before the entries are destroyed. */
+
+    /**
+     * @brief Looks up a host name, calling found with the fresh entry under the lock.
+     */
+    template <typename F>
+    auto find(const std::string& host, F&& found) -> decltype(found(std::declval<Entry&>(), Clock::now()));
+
+    /**
+     * @brief Marks an entry as being queried. Requires the lock.
+     */
+    [[nodiscard]] inline std::shared_ptr<std::promise<void>> beginQuery(Entry& entry);
+
+    /**
+     * @brief Queries a host name and stores the result in its entry.
+     */
+    inline void query(const std::string& host, const std::shared_ptr<std::promise<void>>& done);
+
+    /**
+     * @brief Drops expired entries, then the ones expiring soonest, if the cache is full.
+     * Requires the lock.
+     */
+    inline void evict();
+};
+
+#if defined(OS_LINUX) || defined(OS_APPLE)
+UdpDnsResolver::UdpDnsResolver(const std::string& nameserver, UdpDnsResolverOptions options)
+    : options(options), nextId(static_cast<uint16_t>(std::random_device{}())) {
+    if (!parseAddress(nameserver, address, addressLength)) {
+        TLS_CLIENT_THROW(std::invalid_argument("Invalid name server address: " + nameserver));
+    }
+}
+
+Expected<std::shared_ptr<UdpDnsResolver>> UdpDnsResolver::create(const std::string& nameserver,
+    UdpDnsResolverOptions options) {
+    sockaddr_storage address{};
+    socklen_t addressLength = 0;
+    if (!parseAddress(nameserver, address, addressLength)) {
+        return Unexpected<Error>{{ErrorCode::Dns, "Invalid name server address: " + nameserver}};
+    }
+    return std::make_shared<UdpDnsResolver>(nameserver, options);
+}
+
+bool UdpDnsResolver::parseAddress(const std::string& nameserver, sockaddr_storage& address,
+    socklen_t& addressLength) {
+    std::string host = nameserver;
+    std::string_view portText = "53";
+
+    size_t colon = nameserver.rfind(':');
+    if (!nameserver.empty() && nameserver.front() == '[') {
+        size_t close = nameserver.find(']');
+        if (close == std::string::npos || (close + 1 < nameserver.size() && nameserver[close + 1] != ':')) {
+            return false;
+        }
+        host = nameserver.substr(1, close - 1);
+        if (close + 1 < nameserver.size()) {
+            portText = std::string_view(nameserver).substr(close + 2);
+        }
+    } else if (colon != std::string::npos && nameserver.find(':') == colon) {
+        host = nameserver.substr(0, colon);
+        portText = std::string_view(nameserver).substr(colon + 1);
+    }
+
+    uint16_t port = 0;
+    auto [end, error] = std::from_chars(portText.data(), portText.data() + portText.size(), port);
+    if (error != std::errc() || end != portText.data() + portText.size() || port == 0) {
+        return false;
+    }
+
+    address = sockaddr_storage{};
+    auto* ipv4 = reinterpret_cast<sockaddr_in*>(&address);
+    auto* ipv6 = reinterpret_cast<sockaddr_in6*>(&address);
+    if (::inet_pton(AF_INET, host.c_str(), &ipv4->sin_addr) == 1) {
+        ipv4->sin_family = AF_INET;
+        ipv4->sin_port = htons(port);
+        addressLength = sizeof(sockaddr_in);
+    } else if (::inet_pton(AF_INET6, host.c_str(), &ipv6->sin6_addr) == 1) {
+        ipv6->sin6_family = AF_INET6;
+        ipv6->sin6_port = htons(port);
+        addressLength = sizeof(sockaddr_in6);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+Expected<std::shared_ptr<UdpDnsResolver>> UdpDnsResolver::fromSystem(UdpDnsResolverOptions options) {
+    std::ifstream file("/etc/resolv.conf");
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream words(line);
+        std::string keyword;
+        std::string nameserver;
+        if (words >> keyword >> nameserver && keyword == "nameserver") {
+            // Scoped IPv6 addresses (fe80::1%eth0) are not supported
+            if (nameserver.find('%') != std::string::npos) {
+                continue;
+            }
+            return create(nameserver.find(':') != std::string::npos ? "[" + nameserver + "]" : nameserver, options);
+        }
+    }
+    return Unexpected<Error>{{ErrorCode::Dns, "No name server in /etc/resolv.conf"}};
+}
+
+Expected<DnsAnswer> UdpDnsResolver::query(const std::string& host) {
+    Expected<DnsAnswer> answer = queryType(host, TYPE_A);
+    if (!answer || !options.ipv6) {
+        return answer;
+    }
+
+    Expected<DnsAnswer> ipv6 = queryType(host, TYPE_AAAA);
+    if (!ipv6) {
+        return answer.value().addresses.empty() ? ipv6 : answer;
+    }
+
+    if (answer->addresses.empty()) {
+        return ipv6;
+    }
+    if (!ipv6->addresses.empty()) {
+        answer->ttl = std::min(answer->ttl, ipv6->ttl);
+        answer->addresses.insert(answer->addresses.end(), ipv6->addresses.begin(), ipv6->addresses.end());
+    }
+    return answer;
+}
+
+Expected<DnsAnswer> UdpDnsResolver::queryType(const std::string& host, uint16_t type) {
+    auto fail = [&host](const std::string& reason) {
+        return Unexpected<Error>{{ErrorCode::Dns, "lookup " + host + ": " + reason}};
+    };
+
+    uint16_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+    std::string request{static_cast<char>(id >> 8), static_cast<char>(id & 0xff), 0x01, 0x00, 0x00, 0x01,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+    std::string_view name(host);
+    if (!name.empty() && name.back() == '.') {
+        name.remove_suffix(1);
+    }
+    if (name.empty() || name.size() > 253) {
+        return fail("invalid host name");
+    }
+    for (size_t start = 0; start <= name.size();) {
+        size_t end = std::min(name.find('.', start), name.size());
+        if (end == start || end - start > 63) {
+            return fail("invalid host name");
+        }
+        request += static_cast<char>(end - start);
+        request.append(name.substr(start, end - start));
+        start = end + 1;
+    }
+    request += std::string{0x00, static_cast<char>(type >> 8), static_cast<char>(type & 0xff), 0x00, 0x01};
+    size_t questionEnd = request.size();
+
+    int socket = ::socket(address.ss_family, SOCK_DGRAM, 0);
+    if (socket < 0) {
+        return fail(std::strerror(errno));
+    }
+    if (::connect(socket, reinterpret_cast<const sockaddr*>(&address), addressLength) != 0) {
+        std::string reason = std::strerror(errno);
+        ::close(socket);
+        return fail(reason);
+    }
+
+    std::string message;
+    for (int attempt = 0; attempt < options.attempts && message.empty(); ++attempt) {
+        if (::send(socket, request.data(), request.size(), 0) < 0) {
+            continue;
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + options.timeout;
+        for (;;) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now());
+            pollfd descriptor{socket, POLLIN, 0};
+            if (remaining.count() <= 0 || ::poll(&descriptor, 1, static_cast<int>(remaining.count())) <= 0) {
+                break;
+            }
+
+            char buffer[4096];
+            ssize_t received = ::recv(socket, buffer, sizeof(buffer), 0);
+            if (received < 0) {
+                break;
+            }
+
+            // Answers to earlier attempts or to other questions are ignored
+            if (static_cast<size_t>(received) >= questionEnd && std::memcmp(buffer, request.data(), 2) == 0 &&
+                std::memcmp(buffer + 12, request.data() + 12, questionEnd - 12) == 0) {
+                message.assign(buffer, static_cast<size_t>(received));
+                break;
+            }
+        }
+    }
+    ::close(socket);
+
+    if (message.empty()) {
+        return fail("i/o timeout");
+    }
+
+    auto read16 = [&message](size_t offset) {
+        return static_cast<uint16_t>((static_cast<uint8_t>(message[offset]) << 8) |
+            static_cast<uint8_t>(message[offset + 1]));
+    };
+    auto read32 = [&read16](size_t offset) {
+        return (static_cast<uint32_t>(read16(offset)) << 16) | read16(offset + 2);
+    };
+
+    int rcode = message[3] & 0x0f;
+    if (rcode != 0 && rcode != 3) {
+        return fail(rcode == 2 ? "server misbehaving" : "server refused the query (rcode " +
+            std::to_string(rcode) + ")");
+    }
+
+    DnsAnswer answer;
+    std::optional<uint32_t> ttl;
+    std::optional<uint32_t> negativeTtl;
+    uint16_t answers = read16(6);
+    uint16_t authorities = read16(8);
+
+    size_t offset = questionEnd;
+    for (uint32_t record = 0; record < static_cast<uint32_t>(answers) + authorities; ++record) {
+        offset = skipName(message, offset);
+        if (offset == 0 || offset + 10 > message.size()) {
+            return fail("malformed answer");
+        }
+        uint16_t recordType = read16(offset);
+        uint32_t recordTtl = read32(offset + 4);
+        uint16_t length = read16(offset + 8);
+        size_t data = offset + 10;
+        offset = data + length;
+        if (offset > message.size()) {
+            return fail("malformed answer");
+        }
+
+        if (record < answers) {
+            ttl = std::min(ttl.value_or(UINT32_MAX), recordTtl);
+
+            char text[INET6_ADDRSTRLEN];
+            if (recordType == type && type == TYPE_A && length == 4) {
+                answer.addresses.push_back(::inet_ntop(AF_INET, message.data() + data, text, sizeof(text)));
+            } else if (recordType == type && type == TYPE_AAAA && length == 16) {
+                answer.addresses.push_back(::inet_ntop(AF_INET6, message.data() + data, text, sizeof(text)));
+            }
+        } else if (recordType == TYPE_SOA) {
+            // The negative TTL is the smaller of the SOA TTL and its minimum field (RFC 2308)
+            size_t minimum = skipName(message, skipName(message, data));
+            if (minimum != 0 && minimum + 20 <= offset) {
+                negativeTtl = std::min(recordTtl, read32(minimum + 16));
+            }
+        }
+    }
+
+    if (answer.addresses.empty()) {
+        answer.ttl = std::chrono::seconds(negativeTtl.value_or(0));
+    } else {
+        answer.ttl = std::chrono::seconds(ttl.value_or(0));
+    }
+    return answer;
+}
+
+size_t UdpDnsResolver::skipName(const std::string& message, size_t offset) {
+    while (offset != 0 && offset < message.size()) {
+        auto length = static_cast<uint8_t>(message[offset]);
+        if (length == 0) {
+            return offset + 1;
+        }
+        if ((length & 0xc0) == 0xc0) {
+            return offset + 2 <= message.size() ? offset + 2 : 0;
+        }
+        offset += length + 1;
+    }
+    return 0;
+}
+
+Expected<DnsAnswer> SystemDnsResolver::query(const std::string& host) {
+    addrinfo hints{};
+    hints.ai_family = ipv6 ? AF_UNSPEC : AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* results = nullptr;
+    int status = ::getaddrinfo(host.c_str(), nullptr, &hints, &results);
+    if (status == EAI_NONAME
+#if defined(EAI_NODATA)
+        || status == EAI_NODATA
+#endif
+    ) {
+        return DnsAnswer{{}, ttl};
+    }
+    if (status != 0) {
+        return Unexpected<Error>{{ErrorCode::Dns, "lookup " + host + ": " + ::gai_strerror(status)}};
+    }
+
+    DnsAnswer answer{{}, ttl};
+    for (addrinfo* result = results; result; result = result->ai_next) {
+        char text[INET6_ADDRSTRLEN];
+        const void* data = result->ai_family == AF_INET
+            ? static_cast<const void*>(&reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr)
+            : static_cast<const void*>(&reinterpret_cast<sockaddr_in6*>(result->ai_addr)->sin6_addr);
+        std::string address = ::inet_ntop(result->ai_family, data, text, sizeof(text));
+        if (std::find(answer.addresses.begin(), answer.addresses.end(), address) == answer.addresses.end()) {
+            answer.addresses.push_back(std::move(address));
+        }
+    }
+    ::freeaddrinfo(results);
+    return answer;
+}
+#endif
+
+template <typename F>
+auto DnsCache::find(const std::string& host, F&& found) -> decltype(found(std::declval<Entry&>(), Clock::now())) {
+    std::unique_lock<std::mutex> lock(mutex);
+    bool counted = false;
+
+    for (;;) {
+        auto it = entries.find(host);
+        if (it == entries.end()) {
+            evict();
+            it = entries.emplace(host, Entry()).first;
+        }
+
+        Entry& entry = it->second;
+        Clock::time_point now = Clock::now();
+        if (entry.expires > now) {
+            if (!counted) {
+                ++(entry.error ? stats.negativeHits : stats.hits);
+            }
+
+            auto remaining = entry.expires - now;
+            if (!entry.error && !entry.querying && options.prefetchFraction > 0 && entry.retry <= now &&
+                remaining < (entry.expires - entry.fetched) * options.prefetchFraction) {
+                ++stats.prefetches;
+                std::shared_ptr<std::promise<void>> done = beginQuery(entry);
+                executor->post([this, host, done]() { query(host, done); });
+            }
+            return found(entry, now);
+        }
+
+        if (!counted) {
+            ++stats.misses;
+            counted = true;
+        }
+
+        if (entry.querying) {
+            std::shared_future<void> done = entry.done;
+            lock.unlock();
+            done.wait();
+            lock.lock();
+            continue;
+        }
+
+        std::shared_ptr<std::promise<void>> done = beginQuery(entry);
+        lock.unlock();
+        query(host, done);
+        lock.lock();
+
+        // The result is used even if its TTL is already over, unless a full cache dropped it meanwhile
+        auto queried = entries.find(host);
+        if (queried == entries.end() || queried->second.querying || queried->second.expires == Clock::time_point()) {
+            continue;
+        }
+        return found(queried->second, std::min(now, queried->second.expires - Clock::duration(1)));
+    }
+}
+
+Expected<DnsAnswer> DnsCache::lookup(const std::string& host) {
+    return find(host, [](Entry& entry, Clock::time_point now) -> Expected<DnsAnswer> {
+        if (entry.error) {
+            return Unexpected<Error>{*entry.error};
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::seconds>(entry.expires - now);
+        return DnsAnswer{entry.addresses, remaining};
+    });
+}
+
+Expected<std::string> DnsCache::resolve(const std::string& host) {
+    return find(host, [](Entry& entry, Clock::time_point) -> Expected<std::string> {
+        if (entry.error) {
+            return Unexpected<Error>{*entry.error};
+        }
+        return entry.addresses[entry.next++ % entry.addresses.size()];
+    });
+}
+
+void DnsCache::prefetch(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = entries.find(host);
+    if (it == entries.end()) {
+        evict();
+        it = entries.emplace(host, Entry()).first;
+    }
+    if (it->second.querying || it->second.expires > Clock::now()) {
+        return;
+    }
+
+    std::shared_ptr<std::promise<void>> done = beginQuery(it->second);
+    executor->post([this, host, done]() { query(host, done); });
+}
+
+void DnsCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = entries.begin(); it != entries.end();) {
+        it = it->second.querying ? std::next(it) : entries.erase(it);
+    }
+}
+
+size_t DnsCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+DnsCacheStats DnsCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+std::shared_ptr<std::promise<void>> DnsCache::beginQuery(Entry& entry) {
+    auto done = std::make_shared<std::promise<void>>();
+    entry.querying = true;
+    entry.done = done->get_future().share();
+    ++stats.queries;
+    return done;
+}
+
+void DnsCache::query(const std::string& host, const std::shared_ptr<std::promise<void>>& done) {
+    Expected<DnsAnswer> answer = resolver->query(host);
+    Clock::time_point now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = entries[host];
+    entry.querying = false;
+
+    if (!answer && !entry.error && !entry.addresses.empty() && entry.expires > now) {
+        // A failed refresh keeps the previous answer until it expires, and is retried after errorTtl
+        entry.retry = now + options.errorTtl;
+        done->set_value();
+        return;
+    }
+
+    entry.fetched = now;
+    entry.next = 0;
+    if (!answer) {
+        entry.addresses.clear();
+        entry.error = answer.error();
+        entry.expires = now + options.errorTtl;
+    } else if (answer->addresses.empty()) {
+        entry.addresses.clear();
+        entry.error = Error{ErrorCode::Dns, "lookup " + host + ": no such host"};
+        entry.expires = now + std::clamp(answer->ttl, std::min(options.minTtl, options.maxNegativeTtl),
+            options.maxNegativeTtl);
+    } else {
+        entry.addresses = std::move(answer->addresses);
+        entry.error.reset();
+        entry.expires = now + std::clamp(answer->ttl, options.minTtl, options.maxTtl);
+    }
+    done->set_value();
+}
+
+void DnsCache::evict() {
+    if (entries.size() < options.maxEntries) {
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+    for (auto it = entries.begin(); it != entries.end();) {
+        it = !it->second.querying && it->second.expires <= now ? entries.erase(it) : std::next(it);
+    }
+    if (entries.size() < options.maxEntries) {
+        return;
+    }
+
+    // Drops a sixteenth of the entries at once, so that a full cache is not scanned on every insert
+    size_t keep = options.maxEntries - std::min(options.maxEntries, std::max<size_t>(options.maxEntries / 16, 1));
+    std::vector<std::pair<Clock::time_point, decltype(entries)::iterator>> candidates;
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (!it->second.querying) {
+            candidates.emplace_back(it->second.expires, it);
+        }
+    }
+    size_t drop = std::min(entries.size() - std::min(entries.size(), keep), candidates.size());
+    std::nth_element(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(drop), candidates.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t i = 0; i < drop; ++i) {
+        entries.erase(candidates[i].second);
+    }
+}
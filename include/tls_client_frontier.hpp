@@ -0,0 +1,562 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <queue>
+
+/**
+ * @brief ScalableBloomFilter class testing set membership in a few bits per element.
+ *
+ * The filter is a series of Bloom filters (Almeida et al., "Scalable Bloom
+ * Filters"). When a stage is full, a stage of twice the capacity and a
+ * tighter false positive rate is added, so the overall false positive rate
+ * stays below the configured one however many elements are inserted.
+ * There are no false negatives.
+ *
+ * Elements are hashed once with ContentHash; the bit positions are derived
+ * by double hashing. The filter is not thread-safe.
+ */
+class ScalableBloomFilter {
+public:
+    /**
+     * @brief Constructs an empty filter.
+     *
+     * @param initialCapacity Number of elements the first stage holds.
+     * @param falsePositiveRate Upper bound of the false positive rate, between 0 and 1.
+     */
+    explicit ScalableBloomFilter(size_t initialCapacity = 1 << 16, double falsePositiveRate = 1e-4)
+        : initialCapacity(std::max<size_t>(initialCapacity, 64)),
+          falsePositiveRate(std::clamp(falsePositiveRate, 1e-12, 0.5)) {}
+
+    /**
+     * @brief Inserts an element.
+     *
+     * @param element The element to insert.
+     * @return bool Whether the element was new, false if it may have been inserted before.
+     */
+    inline bool insert(std::string_view element);
+
+    /**
+     * @brief Checks whether an element may have been inserted.
+     *
+     * @param element The element to check.
+     * @return bool False if the element was never inserted, true if it probably was.
+     */
+    [[nodiscard]] inline bool mayContain(std::string_view element) const;
+
+    /**
+     * @brief Returns the number of inserted elements.
+     *
+     * @return size_t The number of elements.
+     */
+    [[nodiscard]] size_t size() const noexcept { return count; }
+
+    /**
+     * @brief Returns the memory used by the bit arrays.
+     *
+     * @return size_t The size of the filter in bytes.
+     */
+    [[nodiscard]] inline size_t memoryUsage() const noexcept;
+
+private:
+    static constexpr double TIGHTENING = 0.5; /**< Ratio between the false positive rates of two stages. */
+
+    /**
+     * @brief Stage struct containing one Bloom filter of the series.
+     */
+    struct Stage {
+        std::vector<uint64_t> bits; /**< The bit array. */
+        uint64_t bitCount = 0;      /**< The number of bits. */
+        uint32_t hashes = 0;        /**< The number of bits set per element. */
+        size_t capacity = 0;        /**< The number of elements before the next stage is added. */
+        size_t count = 0;           /**< The number of elements inserted into this stage. */
+    };
+
+    size_t initialCapacity;
+    double falsePositiveRate;
+    std::vector<Stage> stages;
+    size_t count = 0;
+
+    /**
+     * @brief Checks whether all bits of a hash are set in a stage.
+     */
+    [[nodiscard]] static inline bool test(const Stage& stage, uint64_t hash) noexcept;
+
+    /**
+     * @brief Adds a stage twice as large as the last one.
+     */
+    inline void grow();
+};
+
+bool ScalableBloomFilter::insert(std::string_view element) {
+    uint64_t hash = ContentHash::compute(element);
+    for (const Stage& stage : stages) {
+        if (test(stage, hash)) {
+            return false;
+        }
+    }
+
+    if (stages.empty() || stages.back().count >= stages.back().capacity) {
+        grow();
+    }
+
+    Stage& stage = stages.back();
+    uint64_t step = (hash >> 32) | (hash << 32) | 1;
+    for (uint32_t i = 0; i < stage.hashes; ++i) {
+        uint64_t bit = (hash + i * step) % stage.bitCount;
+        stage.bits[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+
+    ++stage.count;
+    ++count;
+    return true;
+}
+
+bool ScalableBloomFilter::mayContain(std::string_view element) const {
+    uint64_t hash = ContentHash::compute(element);
+    for (const Stage& stage : stages) {
+        if (test(stage, hash)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t ScalableBloomFilter::memoryUsage() const noexcept {
+    size_t bytes = 0;
+    for (const Stage& stage : stages) {
+        bytes += stage.bits.size() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+bool ScalableBloomFilter::test(const Stage& stage, uint64_t hash) noexcept {
+    uint64_t step = (hash >> 32) | (hash << 32) | 1;
+    for (uint32_t i = 0; i < stage.hashes; ++i) {
+        uint64_t bit = (hash + i * step) % stage.bitCount;
+        if ((stage.bits[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ScalableBloomFilter::grow() {
+    // The rates of the stages form a geometric series summing to falsePositiveRate
+    size_t index = stages.size();
+    double rate = falsePositiveRate * (1 - TIGHTENING) * std::pow(TIGHTENING, static_cast<double>(index));
+    size_t capacity = initialCapacity << index;
+
+    double ln2 = std::log(2.0);
+    Stage stage;
+    stage.capacity = capacity;
+    stage.hashes = static_cast<uint32_t>(std::ceil(-std::log2(rate)));
+    stage.bitCount = static_cast<uint64_t>(std::ceil(-static_cast<double>(capacity) * std::log(rate) / (ln2 * ln2)));
+    stage.bitCount = (stage.bitCount + 63) / 64 * 64;
+    stage.bits.assign(stage.bitCount / 64, 0);
+    stages.push_back(std::move(stage));
+}
+
+/**
+ * @brief FrontierOptions struct containing the options of a crawl frontier.
+ */
+struct FrontierOptions {
+    /**
+     * @brief expectedUrls field
+     *
+     * This field specifies the number of URLs the first stage of the seen
+     * filter is sized for. The filter grows past it, but starts smaller.
+     */
+    size_t expectedUrls = 1 << 20;
+
+    /**
+     * @brief falsePositiveRate field
+     *
+     * This field specifies the probability that a URL never seen before is
+     * considered seen and dropped.
+     */
+    double falsePositiveRate = 1e-6;
+
+    /**
+     * @brief crawlDelay field
+     *
+     * This field specifies the minimum time between two URLs of the same host,
+     * unless set per host with Frontier::setCrawlDelay.
+     */
+    std::chrono::milliseconds crawlDelay{1000};
+
+    /**
+     * @brief maxUrlsInMemory field
+     *
+     * This field specifies the number of queued URLs kept in memory when
+     * spillDirectory is set. Further URLs are appended to segment files.
+     */
+    size_t maxUrlsInMemory = 1 << 20;
+
+    /**
+     * @brief segmentUrls field
+     *
+     * This field specifies the number of URLs per segment file.
+     */
+    size_t segmentUrls = 1 << 16;
+
+    /**
+     * @brief spillDirectory field
+     *
+     * This optional field specifies the directory of the segment files. Without
+     * it every queued URL is kept in memory.
+     */
+    std::optional<std::string> spillDirectory;
+};
+
+/**
+ * @brief Frontier class queuing the URLs of a crawl.
+ *
+ * URLs are deduplicated with a ScalableBloomFilter (a few bytes per URL,
+ * with a small false positive rate instead of an exact set) and queued
+ * first in, first out per host. A host is handed out again only after its
+ * crawl delay, and the ready hosts are kept in a heap ordered by the time
+ * they become ready. A drained host is forgotten once its crawl delay has
+ * passed, unless its delay was set with setCrawlDelay. Queued URLs beyond
+ * FrontierOptions::maxUrlsInMemory
+ * are written to segment files and read back in order as the memory
+ * queues drain.
+ *
+ * URLs are compared without their fragment. All public member functions are
+ * thread-safe; the popped URLs are typically fed to Session::GET from an
+ * executor.
+ */
+class Frontier {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Constructs an empty frontier.
+     *
+     * @param options The options of the frontier.
+     */
+    explicit Frontier(FrontierOptions options = {})
+        : options(std::move(options)), seen(this->options.expectedUrls, this->options.falsePositiveRate) {}
+
+    Frontier(const Frontier&) = delete;
+    Frontier& operator=(const Frontier&) = delete;
+
+    /**
+     * @brief Destructor removing the segment files.
+     */
+    inline ~Frontier();
+
+    /**
+     * @brief Queues a URL unless it was seen before.
+     *
+     * @param url The absolute URL to queue.
+     * @return bool Whether the URL was queued.
+     */
+    inline bool push(std::string url);
+
+    /**
+     * @brief Takes the next URL whose host is ready, without waiting.
+     *
+     * @return std::optional<std::string> The URL, or nothing if no host is ready.
+     */
+    [[nodiscard]] inline std::optional<std::string> tryPop();
+
+    /**
+     * @brief Takes the next URL whose host is ready, waiting for one.
+     *
+     * @param timeout The maximum time to wait.
+     * @return std::optional<std::string> The URL, or nothing if none became ready in time.
+     */
+    [[nodiscard]] inline std::optional<std::string> waitPop(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Sets the crawl delay of a host, e.g. from its robots.txt.
+     *
+     * @param host The host, with the port if not the default one.
+     * @param delay The minimum time between two URLs of the host.
+     */
+    inline void setCrawlDelay(const std::string& host, std::chrono::milliseconds delay);
+
+    /**
+     * @brief Returns the number of queued URLs, in memory and on disk.
+     *
+     * @return size_t The number of URLs.
+     */
+    [[nodiscard]] inline size_t size() const;
+
+    /**
+     * @brief Returns the number of URLs seen so far.
+     *
+     * @return size_t The number of distinct URLs pushed.
+     */
+    [[nodiscard]] inline size_t seenCount() const;
+
+    /**
+     * @brief Returns the number of hosts tracked: with queued URLs, waiting for their
+     * crawl delay, or with a crawl delay set by setCrawlDelay.
+     *
+     * @return size_t The number of hosts.
+     */
+    [[nodiscard]] inline size_t hostCount() const;
+
+    /**
+     * @brief Returns the host of a URL, lowercased and with the port unless it is the default one.
+     *
+     * @param url The URL.
+     * @return std::string The host of the URL.
+     */
+    [[nodiscard]] static inline std::string hostOf(std::string_view url);
+
+private:
+    /**
+     * @brief HostQueue struct containing the queued URLs of a host.
+     */
+    struct HostQueue {
+        std::deque<std::string> urls;                     /**< The queued URLs. */
+        Clock::time_point readyAt;                        /**< When the next URL may be handed out. */
+        std::optional<std::chrono::milliseconds> delay;   /**< The crawl delay set for the host. */
+        bool scheduled = false;                           /**< Whether the host is in the ready heap. */
+    };
+
+    using ReadyEntry = std::pair<Clock::time_point, std::string>;
+
+    FrontierOptions options;
+    mutable std::mutex mutex;
+    std::condition_variable pushed; /**< Signaled when a URL is queued. */
+    ScalableBloomFilter seen;
+    std::unordered_map<std::string, HostQueue> hosts;
+    std::priority_queue<ReadyEntry, std::vector<ReadyEntry>, std::greater<ReadyEntry>> ready;
+    std::priority_queue<ReadyEntry, std::vector<ReadyEntry>, std::greater<ReadyEntry>> idle; /**< Drained hosts, by when they may be forgotten. */
+    size_t urlsInMemory = 0;
+
+    std::deque<std::string> segments; /**< Paths of the segment files, oldest first. */
+    std::ofstream writer;             /**< Writer of the newest segment. */
+    std::ifstream reader;             /**< Reader of the oldest segment. */
+    size_t writerUrls = 0;            /**< URLs written to the newest segment. */
+    size_t urlsOnDisk = 0;            /**< URLs in the segment files. */
+    size_t nextSegment = 0;           /**< Number of the next segment file. */
+
+    /**
+     * @brief Queues a URL in memory. Requires the lock.
+     */
+    inline void enqueue(std::string url);
+
+    /**
+     * @brief Appends a URL to the newest segment file. Requires the lock.
+     *
+     * @return bool Whether the URL was written.
+     */
+    inline bool spill(const std::string& url);
+
+    /**
+     * @brief Reads URLs back from the segment files until memory is full. Requires the lock.
+     */
+    inline void refill();
+
+    /**
+     * @brief Takes the next ready URL. Requires the lock.
+     *
+     * @param now The current time.
+     * @param wakeAt Set to when the next host becomes ready if none is ready now.
+     */
+    inline std::optional<std::string> popReady(Clock::time_point now, std::optional<Clock::time_point>& wakeAt);
+};
+
+Frontier::~Frontier() {
+    writer.close();
+    reader.close();
+
+    std::error_code errorCode;
+    for (const std::string& segment : segments) {
+        std::filesystem::remove(segment, errorCode);
+    }
+}
+
+bool Frontier::push(std::string url) {
+    if (size_t fragment = url.find('#'); fragment != std::string::npos) {
+        url.resize(fragment);
+    }
+    if (url.find_first_of("\r\n") != std::string::npos) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!seen.insert(url)) {
+            return false;
+        }
+
+        bool full = urlsOnDisk > 0 || urlsInMemory >= options.maxUrlsInMemory;
+        if (!options.spillDirectory || !full || !spill(url)) {
+            enqueue(std::move(url));
+        }
+    }
+    pushed.notify_one();
+    return true;
+}
+
+std::optional<std::string> Frontier::tryPop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::optional<Clock::time_point> wakeAt;
+    return popReady(Clock::now(), wakeAt);
+}
+
+std::optional<std::string> Frontier::waitPop(std::chrono::milliseconds timeout) {
+    Clock::time_point deadline = Clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;) {
+        Clock::time_point now = Clock::now();
+        std::optional<Clock::time_point> wakeAt;
+        if (std::optional<std::string> url = popReady(now, wakeAt)) {
+            return url;
+        }
+        if (now >= deadline) {
+            return std::nullopt;
+        }
+        pushed.wait_until(lock, wakeAt ? std::min(*wakeAt, deadline) : deadline);
+    }
+}
+
+void Frontier::setCrawlDelay(const std::string& host, std::chrono::milliseconds delay) {
+    std::lock_guard<std::mutex> lock(mutex);
+    hosts[host].delay = delay;
+}
+
+size_t Frontier::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return urlsInMemory + urlsOnDisk;
+}
+
+size_t Frontier::seenCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return seen.size();
+}
+
+size_t Frontier::hostCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hosts.size();
+}
+
+std::string Frontier::hostOf(std::string_view url) {
+    return UrlView::parse(url).authority();
+}
+
+void Frontier::enqueue(std::string url) {
+    std::string host = hostOf(url);
+    HostQueue& queue = hosts[host];
+    queue.urls.push_back(std::move(url));
+    ++urlsInMemory;
+
+    if (!queue.scheduled) {
+        queue.scheduled = true;
+        ready.emplace(queue.readyAt, std::move(host));
+    }
+}
+
+bool Frontier::spill(const std::string& url) {
+    if (!writer.is_open()) {
+        std::string path = *options.spillDirectory + "/frontier-" +
+            std::to_string(reinterpret_cast<uintptr_t>(this)) + "-" + std::to_string(nextSegment++) + ".seg";
+        writer.open(path, std::ios::binary | std::ios::trunc);
+        if (!writer) {
+            return false;
+        }
+        segments.push_back(std::move(path));
+        writerUrls = 0;
+    }
+
+    writer << url << '\n';
+    if (!writer) {
+        return false;
+    }
+
+    ++urlsOnDisk;
+    if (++writerUrls >= options.segmentUrls) {
+        writer.close();
+    }
+    return true;
+}
+
+void Frontier::refill() {
+    while (urlsOnDisk > 0 && urlsInMemory < options.maxUrlsInMemory) {
+        if (!reader.is_open()) {
+            // The segment being written is read only once it is closed
+            if (segments.size() == 1 && writer.is_open()) {
+                writer.close();
+            }
+            reader.open(segments.front(), std::ios::binary);
+        }
+
+        std::string url;
+        if (std::getline(reader, url)) {
+            --urlsOnDisk;
+            enqueue(std::move(url));
+            continue;
+        }
+
+        reader.close();
+        std::error_code errorCode;
+        std::filesystem::remove(segments.front(), errorCode);
+        segments.pop_front();
+        if (segments.empty()) {
+            // Lines lost to a failed write can no longer be read
+            urlsOnDisk = 0;
+        }
+    }
+}
+
+std::optional<std::string> Frontier::popReady(Clock::time_point now, std::optional<Clock::time_point>& wakeAt) {
+    if (urlsOnDisk > 0 && urlsInMemory <= options.maxUrlsInMemory / 2) {
+        refill();
+    }
+
+    // Forget drained hosts whose crawl delay has passed; entries of hosts queued again since are stale
+    while (!idle.empty() && idle.top().first <= now) {
+        auto it = hosts.find(idle.top().second);
+        if (it != hosts.end() && it->second.urls.empty() && !it->second.scheduled && !it->second.delay &&
+            it->second.readyAt <= now) {
+            hosts.erase(it);
+        }
+        idle.pop();
+    }
+
+    if (ready.empty()) {
+        return std::nullopt;
+    }
+    if (ready.top().first > now) {
+        wakeAt = ready.top().first;
+        return std::nullopt;
+    }
+
+    std::string host = ready.top().second;
+    ready.pop();
+
+    HostQueue& queue = hosts[host];
+    std::string url = std::move(queue.urls.front());
+    queue.urls.pop_front();
+    --urlsInMemory;
+
+    queue.readyAt = now + queue.delay.value_or(options.crawlDelay);
+    if (!queue.urls.empty()) {
+        ready.emplace(queue.readyAt, std::move(host));
+    } else if (!queue.delay && queue.readyAt <= now) {
+        hosts.erase(host);
+    } else {
+        queue.scheduled = false;
+        if (!queue.delay) {
+            idle.emplace(queue.readyAt, std::move(host));
+        }
+    }
+    return url;
+}
@@ -0,0 +1,464 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client_json_bind.hpp"
+
+#include <shared_mutex>
+#include <tuple>
+#include <unordered_set>
+
+/**
+ * @brief The well-known response headers: id, lowercase name, and whether their values are interned.
+ *
+ * Values are interned for headers whose values repeat across responses, such
+ * as content types and server names, and not for per-response values such as
+ * dates, lengths, cookies or request ids. Content security policies are not
+ * interned either, as they often carry a nonce per response.
+ */
+#define TLS_CLIENT_WELL_KNOWN_HEADERS(X) \
+    X(Accept, "accept", true) \
+    X(AcceptCh, "accept-ch", true) \
+    X(AcceptEncoding, "accept-encoding", true) \
+    X(AcceptRanges, "accept-ranges", true) \
+    X(AccessControlAllowCredentials, "access-control-allow-credentials", true) \
+    X(AccessControlAllowHeaders, "access-control-allow-headers", true) \
+    X(AccessControlAllowMethods, "access-control-allow-methods", true) \
+    X(AccessControlAllowOrigin, "access-control-allow-origin", true) \
+    X(AccessControlExposeHeaders, "access-control-expose-headers", true) \
+    X(AccessControlMaxAge, "access-control-max-age", true) \
+    X(Age, "age", false) \
+    X(Allow, "allow", true) \
+    X(AltSvc, "alt-svc", true) \
+    X(CacheControl, "cache-control", true) \
+    X(CdnCacheControl, "cdn-cache-control", true) \
+    X(ClearSiteData, "clear-site-data", true) \
+    X(Connection, "connection", true) \
+    X(ContentDisposition, "content-disposition", false) \
+    X(ContentEncoding, "content-encoding", true) \
+    X(ContentLanguage, "content-language", true) \
+    X(ContentLength, "content-length", false) \
+    X(ContentLocation, "content-location", false) \
+    X(ContentRange, "content-range", false) \
+    X(ContentSecurityPolicy, "content-security-policy", false) \
+    X(ContentSecurityPolicyReportOnly, "content-security-policy-report-only", false) \
+    X(ContentType, "content-type", true) \
+    X(CrossOriginEmbedderPolicy, "cross-origin-embedder-policy", true) \
+    X(CrossOriginOpenerPolicy, "cross-origin-opener-policy", true) \
+    X(CrossOriginResourcePolicy, "cross-origin-resource-policy", true) \
+    X(Date, "date", false) \
+    X(ETag, "etag", false) \
+    X(ExpectCt, "expect-ct", true) \
+    X(Expires, "expires", false) \
+    X(KeepAlive, "keep-alive", true) \
+    X(LastModified, "last-modified", false) \
+    X(Link, "link", false) \
+    X(Location, "location", false) \
+    X(Nel, "nel", true) \
+    X(OriginAgentCluster, "origin-agent-cluster", true) \
+    X(P3p, "p3p", true) \
+    X(PermissionsPolicy, "permissions-policy", true) \
+    X(Pragma, "pragma", true) \
+    X(ProxyAuthenticate, "proxy-authenticate", true) \
+    X(Refresh, "refresh", false) \
+    X(ReferrerPolicy, "referrer-policy", true) \
+    X(ReportTo, "report-to", true) \
+    X(RetryAfter, "retry-after", false) \
+    X(Server, "server", true) \
+    X(ServerTiming, "server-timing", false) \
+    X(SetCookie, "set-cookie", false) \
+    X(StrictTransportSecurity, "strict-transport-security", true) \
+    X(TimingAllowOrigin, "timing-allow-origin", true) \
+    X(Trailer, "trailer", true) \
+    X(TransferEncoding, "transfer-encoding", true) \
+    X(Upgrade, "upgrade", true) \
+    X(Vary, "vary", true) \
+    X(Via, "via", true) \
+    X(Warning, "warning", false) \
+    X(WwwAuthenticate, "www-authenticate", true) \
+    X(XCache, "x-cache", true) \
+    X(XContentTypeOptions, "x-content-type-options", true) \
+    X(XDnsPrefetchControl, "x-dns-prefetch-control", true) \
+    X(XFrameOptions, "x-frame-options", true) \
+    X(XPoweredBy, "x-powered-by", true) \
+    X(XRequestId, "x-request-id", false) \
+    X(XXssProtection, "x-xss-protection", true)
+
+/**
+ * @brief HeaderId enum identifying the well-known response headers.
+ */
+enum class HeaderId : uint8_t {
+#define TLS_CLIENT_HEADER_ID(id, name, interned) id,
+    TLS_CLIENT_WELL_KNOWN_HEADERS(TLS_CLIENT_HEADER_ID)
+#undef TLS_CLIENT_HEADER_ID
+    Unknown /**< Any other header. */
+};
+
+/**
+ * @brief HeaderTable class mapping header names to their HeaderId.
+ *
+ * The names are looked up in a perfect hash table built at compile time, so
+ * finding the id of a name is one lowercase copy, one hash and one comparison.
+ */
+class HeaderTable {
+public:
+    static constexpr size_t COUNT = static_cast<size_t>(HeaderId::Unknown); /**< The number of well-known headers. */
+
+    /**
+     * @brief Finds the id of a header name.
+     *
+     * @param name The name of the header, matched case-insensitively.
+     * @return HeaderId The id of the header, or HeaderId::Unknown.
+     */
+    [[nodiscard]] static inline HeaderId find(std::string_view name) noexcept;
+
+    /**
+     * @brief Returns the lowercase name of a header.
+     *
+     * @param id The id of the header.
+     * @return std::string_view The name, or an empty string for HeaderId::Unknown.
+     */
+    [[nodiscard]] static constexpr std::string_view name(HeaderId id) noexcept {
+        return id == HeaderId::Unknown ? std::string_view() : NAMES[static_cast<size_t>(id)];
+    }
+
+    /**
+     * @brief Checks whether the values of a header are interned.
+     *
+     * @param id The id of the header.
+     * @return bool True if its values usually repeat across responses.
+     */
+    [[nodiscard]] static constexpr bool interned(HeaderId id) noexcept {
+        return id != HeaderId::Unknown && INTERNED[static_cast<size_t>(id)];
+    }
+
+private:
+    static constexpr std::array<std::string_view, COUNT> NAMES{
+#define TLS_CLIENT_HEADER_NAME(id, name, interned) name,
+        TLS_CLIENT_WELL_KNOWN_HEADERS(TLS_CLIENT_HEADER_NAME)
+#undef TLS_CLIENT_HEADER_NAME
+    };
+
+    static constexpr std::array<bool, COUNT> INTERNED{
+#define TLS_CLIENT_HEADER_INTERNED(id, name, interned) interned,
+        TLS_CLIENT_WELL_KNOWN_HEADERS(TLS_CLIENT_HEADER_INTERNED)
+#undef TLS_CLIENT_HEADER_INTERNED
+    };
+
+    static constexpr size_t MAX_NAME_LENGTH = [] {
+        size_t length = 0;
+        for (std::string_view name : NAMES) {
+            length = std::max(length, name.size());
+        }
+        return length;
+    }();
+
+    static constexpr JsonPerfectHash<COUNT> TABLE = JsonPerfectHash<COUNT>::build(NAMES);
+    static_assert(TABLE.valid, "The well-known header names must be distinct");
+};
+
+/**
+ * @brief HeaderInterner class keeping one copy of each header value it is given.
+ *
+ * Values are copied into large blocks that live as long as the interner, so
+ * every response holding a value points to the same bytes. The interner never
+ * drops a value, but ParsedHeaders stops adding to it once it holds maxValues
+ * values and copies new names and values into each response instead, so that
+ * servers sending a new header name per response do not grow it forever. All
+ * public member functions are thread-safe.
+ */
+class HeaderInterner {
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;      /**< The size of the blocks values are copied into. */
+    static constexpr size_t DEFAULT_MAX_VALUES = 16384;  /**< The default number of values tryIntern adds. */
+
+    /**
+     * @brief Constructs the interner.
+     *
+     * @param maxValues The number of distinct values above which tryIntern adds no more.
+     */
+    explicit HeaderInterner(size_t maxValues = DEFAULT_MAX_VALUES) : maxValues(maxValues) {}
+
+    /**
+     * @brief Returns the interner shared by the ParsedHeaders that are not given one.
+     */
+    [[nodiscard]] static const std::shared_ptr<HeaderInterner>& global() {
+        static const std::shared_ptr<HeaderInterner> interner = std::make_shared<HeaderInterner>();
+        return interner;
+    }
+
+    /**
+     * @brief Returns the copy of a value held by the interner, making one if needed.
+     *
+     * @param value The value to intern.
+     * @return std::string_view The interned value, valid as long as the interner.
+     */
+    [[nodiscard]] inline std::string_view intern(std::string_view value);
+
+    /**
+     * @brief Returns the copy of a value held by the interner, making one only if it is not full.
+     *
+     * @param value The value to intern.
+     * @return std::optional<std::string_view> The interned value, or nothing if the
+     * value is not held and the interner already holds maxValues values.
+     */
+    [[nodiscard]] inline std::optional<std::string_view> tryIntern(std::string_view value);
+
+    /**
+     * @brief Returns the number of distinct values held.
+     */
+    [[nodiscard]] size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return values.size();
+    }
+
+    /**
+     * @brief Returns the number of bytes of the values held.
+     */
+    [[nodiscard]] size_t bytes() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return used;
+    }
+
+private:
+    size_t maxValues;
+    mutable std::shared_mutex mutex;              /**< Guards the values and blocks. */
+    std::unordered_set<std::string_view> values;  /**< Views of the values, into the blocks. */
+    std::vector<std::unique_ptr<char[]>> blocks;  /**< The blocks holding the values. */
+    char* current = nullptr;                      /**< The block small values are copied into. */
+    size_t free = 0;                              /**< The free bytes at the end of the current block. */
+    size_t used = 0;                              /**< The bytes of all values. */
+
+    /**
+     * @brief Returns the copy of a value, making one unless the interner holds limit values.
+     */
+    [[nodiscard]] inline std::optional<std::string_view> add(std::string_view value, size_t limit);
+};
+
+/**
+ * @brief HeaderEntry struct holding one value of a parsed response header.
+ */
+struct HeaderEntry {
+    HeaderId id = HeaderId::Unknown; /**< The id of the header. */
+    std::string_view name;           /**< The name, as written by the server for unknown headers. */
+    std::string_view value;          /**< The unescaped value. */
+};
+
+/**
+ * @brief ParsedHeaders class holding the response headers of a response, indexed by HeaderId.
+ *
+ * Looking up a well-known header is an array access, with no string
+ * comparison. The names of well-known headers point to HeaderTable, and the
+ * names of other headers and the values that repeat across responses point
+ * to a HeaderInterner, as long as it is not full. Only the other names and
+ * values are copied, into one buffer per response. Archives holding many
+ * parsed responses thus keep one copy of each content type or server name:
+ *
+ * @code
+ * ParsedHeaders headers = ParsedHeaders::parse(responseData.headers);
+ * std::optional<std::string_view> type = headers.get(HeaderId::ContentType);
+ * std::vector<std::string_view> cookies = headers.getAll(HeaderId::SetCookie);
+ * @endcode
+ */
+class ParsedHeaders {
+public:
+    /**
+     * @brief Parses the headers of a response.
+     *
+     * @param headers The headers, as in ResponseData::headers.
+     * @param interner The interner of the repeated names and values.
+     * @return ParsedHeaders The parsed headers.
+     */
+    [[nodiscard]] static inline ParsedHeaders parse(std::string_view headers,
+        std::shared_ptr<HeaderInterner> interner = HeaderInterner::global());
+
+    /**
+     * @brief Returns the first value of a well-known header.
+     *
+     * @param id The id of the header.
+     * @return std::optional<std::string_view> The value, or nothing if the header is missing.
+     */
+    [[nodiscard]] std::optional<std::string_view> get(HeaderId id) const noexcept {
+        if (id == HeaderId::Unknown || first[static_cast<size_t>(id)] == 0) {
+            return std::nullopt;
+        }
+        return entries[first[static_cast<size_t>(id)] - 1].value;
+    }
+
+    /**
+     * @brief Returns the first value of a header.
+     *
+     * @param name The name of the header, matched case-insensitively.
+     * @return std::optional<std::string_view> The value, or nothing if the header is missing.
+     */
+    [[nodiscard]] inline std::optional<std::string_view> get(std::string_view name) const noexcept;
+
+    /**
+     * @brief Returns every value of a well-known header, in order, e.g. for HeaderId::SetCookie.
+     *
+     * @param id The id of the header.
+     * @return std::vector<std::string_view> The values.
+     */
+    [[nodiscard]] inline std::vector<std::string_view> getAll(HeaderId id) const;
+
+    /**
+     * @brief Returns every value of every header, in order.
+     */
+    [[nodiscard]] const std::vector<HeaderEntry>& all() const noexcept { return entries; }
+
+private:
+    std::shared_ptr<HeaderInterner> interner;             /**< Keeps the interned names and values alive. */
+    std::unique_ptr<char[]> storage;                      /**< The values that are not interned. */
+    std::vector<HeaderEntry> entries;                     /**< The values, in order. */
+    std::array<uint16_t, HeaderTable::COUNT> first{};     /**< The first entry of each header plus 1, or 0. */
+
+    /**
+     * @brief Compares two header names case-insensitively.
+     */
+    [[nodiscard]] static bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs) noexcept {
+        return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        });
+    }
+};
+
+HeaderId HeaderTable::find(std::string_view name) noexcept {
+    if (name.size() > MAX_NAME_LENGTH) {
+        return HeaderId::Unknown;
+    }
+
+    char lower[MAX_NAME_LENGTH];
+    for (size_t i = 0; i < name.size(); ++i) {
+        lower[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(name[i])));
+    }
+    return static_cast<HeaderId>(TABLE.find(std::string_view(lower, name.size())));
+}
+
+std::string_view HeaderInterner::intern(std::string_view value) {
+    return *add(value, SIZE_MAX);
+}
+
+std::optional<std::string_view> HeaderInterner::tryIntern(std::string_view value) {
+    return add(value, maxValues);
+}
+
+std::optional<std::string_view> HeaderInterner::add(std::string_view value, size_t limit) {
+    if (value.empty()) {
+        return std::string_view();
+    }
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = values.find(value);
+        if (it != values.end()) {
+            return *it;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = values.find(value);
+    if (it != values.end()) {
+        return *it;
+    }
+    if (values.size() >= limit) {
+        return std::nullopt;
+    }
+
+    // Large values get a block of their own, so they do not waste the rest of the current one
+    char* out;
+    if (value.size() > BLOCK_SIZE / 4) {
+        out = blocks.emplace_back(std::make_unique<char[]>(value.size())).get();
+    } else {
+        if (free < value.size()) {
+            current = blocks.emplace_back(std::make_unique<char[]>(BLOCK_SIZE)).get();
+            free = BLOCK_SIZE;
+        }
+        out = current + BLOCK_SIZE - free;
+        free -= value.size();
+    }
+
+    std::copy(value.begin(), value.end(), out);
+    used += value.size();
+    return *values.insert(std::string_view(out, value.size())).first;
+}
+
+ParsedHeaders ParsedHeaders::parse(std::string_view headers, std::shared_ptr<HeaderInterner> interner) {
+    ParsedHeaders parsed;
+    parsed.interner = std::move(interner);
+
+    // Interned names and values are final at once; the others are gathered to be copied into one buffer
+    std::vector<std::tuple<size_t, std::string_view HeaderEntry::*, std::string>> copies;
+    size_t length = 0;
+    auto copy = [&](std::string_view HeaderEntry::* field, std::string text) {
+        length += text.size();
+        copies.emplace_back(parsed.entries.size() - 1, field, std::move(text));
+    };
+
+    JsonHelper::forEachField(headers, [&](std::string_view name, std::string value) {
+        HeaderEntry& entry = parsed.entries.emplace_back();
+        entry.id = HeaderTable::find(name);
+        if (entry.id != HeaderId::Unknown) {
+            entry.name = HeaderTable::name(entry.id);
+        } else if (std::optional<std::string_view> interned = parsed.interner->tryIntern(name)) {
+            entry.name = *interned;
+        } else {
+            copy(&HeaderEntry::name, std::string(name));
+        }
+
+        std::optional<std::string_view> interned;
+        if (HeaderTable::interned(entry.id) && (interned = parsed.interner->tryIntern(value))) {
+            entry.value = *interned;
+        } else if (!value.empty()) {
+            copy(&HeaderEntry::value, std::move(value));
+        }
+
+        if (entry.id != HeaderId::Unknown && parsed.entries.size() <= UINT16_MAX) {
+            uint16_t& first = parsed.first[static_cast<size_t>(entry.id)];
+            first = first == 0 ? static_cast<uint16_t>(parsed.entries.size()) : first;
+        }
+        return true;
+    });
+
+    if (length > 0) {
+        parsed.storage = std::make_unique<char[]>(length);
+        char* out = parsed.storage.get();
+        for (const auto& [index, field, text] : copies) {
+            parsed.entries[index].*field = std::string_view(out, text.size());
+            out = std::copy(text.begin(), text.end(), out);
+        }
+    }
+    return parsed;
+}
+
+std::optional<std::string_view> ParsedHeaders::get(std::string_view name) const noexcept {
+    HeaderId id = HeaderTable::find(name);
+    if (id != HeaderId::Unknown) {
+        return get(id);
+    }
+
+    for (const HeaderEntry& entry : entries) {
+        if (entry.id == HeaderId::Unknown && equalsIgnoreCase(entry.name, name)) {
+            return entry.value;
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<std::string_view> ParsedHeaders::getAll(HeaderId id) const {
+    std::vector<std::string_view> values;
+    if (id == HeaderId::Unknown || first[static_cast<size_t>(id)] == 0) {
+        return values;
+    }
+
+    for (size_t i = first[static_cast<size_t>(id)] - 1; i < entries.size(); ++i) {
+        if (entries[i].id == id) {
+            values.push_back(entries[i].value);
+        }
+    }
+    return values;
+}
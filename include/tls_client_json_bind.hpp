@@ -0,0 +1,524 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client_json_sax.hpp"
+
+#include <tuple>
+
+/**
+ * @brief JsonField struct naming a data member read by JsonDecoder.
+ *
+ * @tparam T Type holding the member.
+ * @tparam M Type of the member.
+ */
+template <typename T, typename M>
+struct JsonField {
+    std::string_view name; /**< The key of the member in JSON. */
+    M T::*member;
+};
+
+/**
+ * @brief Creates a JsonField, deducing its types from the member pointer.
+ */
+template <typename T, typename M>
+constexpr JsonField<T, M> makeJsonField(std::string_view name, M T::*member) {
+    return {name, member};
+}
+
+/**
+ * @brief JsonFields struct listing the JSON fields of a type.
+ *
+ * Specialize it with TLS_CLIENT_JSON_FIELDS, or by hand with a static
+ * constexpr tuple of JsonField named fields when the keys differ from the
+ * member names:
+ *
+ * @code
+ * template <>
+ * struct JsonFields<User> {
+ *     static constexpr auto fields = std::make_tuple(makeJsonField("user_id", &User::id));
+ * };
+ * @endcode
+ */
+template <typename T>
+struct JsonFields;
+
+/**
+ * @brief TLS_CLIENT_JSON_FIELDS macro reading the listed members of a type from the JSON keys of the same name.
+ *
+ * Use it at global scope, after the type, with up to 32 members:
+ *
+ * @code
+ * struct User {
+ *     int64_t id = 0;
+ *     std::string name;
+ *     std::vector<std::string> roles;
+ *     std::optional<Address> address;
+ * };
+ * TLS_CLIENT_JSON_FIELDS(User, id, name, roles, address);
+ * @endcode
+ */
+#define TLS_CLIENT_JSON_FIELDS(Type, ...)                                                                              \
+    template <>                                                                                                        \
+    struct JsonFields<Type> {                                                                                          \
+        using Self = Type;                                                                                             \
+        static constexpr auto fields =                                                                                 \
+            std::make_tuple(TLS_CLIENT_JSON_FOR_EACH(TLS_CLIENT_JSON_FIELD, __VA_ARGS__));                             \
+    }
+
+#define TLS_CLIENT_JSON_FIELD(member) makeJsonField(#member, &Self::member)
+
+#define TLS_CLIENT_JSON_EXPAND(x) x
+#define TLS_CLIENT_JSON_EACH_1(f, x) f(x)
+#define TLS_CLIENT_JSON_EACH_2(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_1(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_3(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_2(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_4(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_3(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_5(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_4(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_6(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_5(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_7(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_6(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_8(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_7(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_9(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_8(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_10(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_9(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_11(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_10(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_12(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_11(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_13(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_12(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_14(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_13(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_15(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_14(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_16(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_15(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_17(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_16(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_18(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_17(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_19(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_18(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_20(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_19(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_21(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_20(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_22(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_21(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_23(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_22(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_24(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_23(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_25(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_24(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_26(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_25(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_27(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_26(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_28(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_27(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_29(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_28(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_30(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_29(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_31(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_30(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_EACH_32(f, x, ...) f(x), TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_EACH_31(f, __VA_ARGS__))
+#define TLS_CLIENT_JSON_PICK(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, \
+    _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, NAME, ...) NAME
+#define TLS_CLIENT_JSON_FOR_EACH(f, ...) \
+    TLS_CLIENT_JSON_EXPAND(TLS_CLIENT_JSON_PICK(__VA_ARGS__, TLS_CLIENT_JSON_EACH_32, \
+        TLS_CLIENT_JSON_EACH_31, TLS_CLIENT_JSON_EACH_30, TLS_CLIENT_JSON_EACH_29, TLS_CLIENT_JSON_EACH_28, \
+        TLS_CLIENT_JSON_EACH_27, TLS_CLIENT_JSON_EACH_26, TLS_CLIENT_JSON_EACH_25, TLS_CLIENT_JSON_EACH_24, \
+        TLS_CLIENT_JSON_EACH_23, TLS_CLIENT_JSON_EACH_22, TLS_CLIENT_JSON_EACH_21, TLS_CLIENT_JSON_EACH_20, \
+        TLS_CLIENT_JSON_EACH_19, TLS_CLIENT_JSON_EACH_18, TLS_CLIENT_JSON_EACH_17, TLS_CLIENT_JSON_EACH_16, \
+        TLS_CLIENT_JSON_EACH_15, TLS_CLIENT_JSON_EACH_14, TLS_CLIENT_JSON_EACH_13, TLS_CLIENT_JSON_EACH_12, \
+        TLS_CLIENT_JSON_EACH_11, TLS_CLIENT_JSON_EACH_10, TLS_CLIENT_JSON_EACH_9, TLS_CLIENT_JSON_EACH_8, \
+        TLS_CLIENT_JSON_EACH_7, TLS_CLIENT_JSON_EACH_6, TLS_CLIENT_JSON_EACH_5, TLS_CLIENT_JSON_EACH_4, \
+        TLS_CLIENT_JSON_EACH_3, TLS_CLIENT_JSON_EACH_2, TLS_CLIENT_JSON_EACH_1, unused)(f, __VA_ARGS__))
+
+/**
+ * @brief JsonPerfectHash struct mapping N distinct keys to their index without collisions.
+ *
+ * The table is built at compile time by trying seeds until every key hashes
+ * to a slot of its own, so a lookup is one hash, one slot and one comparison.
+ * There are four slots per key, which keeps the seed search short.
+ *
+ * @tparam N Number of keys.
+ */
+template <size_t N>
+struct JsonPerfectHash {
+    static_assert(N < 256, "Too many keys for a perfect hash table");
+
+    static constexpr size_t SIZE = [] {
+        size_t size = 1;
+        while (size < N * 4) {
+            size *= 2;
+        }
+        return size;
+    }();
+
+    uint32_t seed = 0;
+    std::array<std::string_view, N> keys{};
+    std::array<uint8_t, SIZE> slots{}; /**< The index of the key of each slot plus 1, or 0 if empty. */
+    bool valid = false;                /**< False if the keys are not distinct. */
+
+    /**
+     * @brief Hashes a key with a seed (FNV-1a with a final mix).
+     */
+    [[nodiscard]] static constexpr uint32_t hash(std::string_view key, uint32_t seed) noexcept {
+        uint32_t value = (2166136261u ^ seed) * 16777619u;
+        for (char ch : key) {
+            value = (value ^ static_cast<unsigned char>(ch)) * 16777619u;
+        }
+        value ^= value >> 16;
+        value *= 0x7feb352du;
+        return value ^ (value >> 15);
+    }
+
+    /**
+     * @brief Builds the table of a set of keys.
+     */
+    [[nodiscard]] static constexpr JsonPerfectHash build(const std::array<std::string_view, N>& keys) {
+        JsonPerfectHash table;
+        table.keys = keys;
+        for (size_t i = 0; i < N; ++i) {
+            for (size_t j = i + 1; j < N; ++j) {
+                if (keys[i] == keys[j]) {
+                    return table;
+                }
+            }
+        }
+
+        for (uint32_t seed = 0;; ++seed) {
+            table.seed = seed;
+            table.slots = {};
+            bool collides = false;
+            for (size_t i = 0; i < N && !collides; ++i) {
+                uint8_t& slot = table.slots[hash(keys[i], seed) & (SIZE - 1)];
+                collides = slot != 0;
+                slot = static_cast<uint8_t>(i + 1);
+            }
+            if (!collides) {
+                table.valid = true;
+                return table;
+            }
+        }
+    }
+
+    /**
+     * @brief Finds the index of a key.
+     *
+     * @return size_t The index of the key, or N if it is not one of the keys.
+     */
+    [[nodiscard]] constexpr size_t find(std::string_view key) const noexcept {
+        size_t slot = slots[hash(key, seed) & (SIZE - 1)];
+        return slot != 0 && keys[slot - 1] == key ? slot - 1 : N;
+    }
+};
+
+/**
+ * @brief JsonDecoder struct reading JSON documents into a type.
+ *
+ * Reads bool, arithmetic types, std::string, std::optional, std::vector and
+ * types with JsonFields, nested in any way. The values are written straight
+ * into their members: keys are looked up in a perfect hash table built at
+ * compile time, and strings are unescaped directly into their member.
+ * Unknown keys are skipped, missing keys and null values leave the member as
+ * it was constructed, and a null std::optional is reset.
+ *
+ * @tparam T Type of the value, default constructible.
+ */
+template <typename T>
+struct JsonDecoder {
+    /**
+     * @brief Reads a JSON document.
+     *
+     * @param json The JSON document.
+     * @return Expected<T> The value, or an ErrorCode::Parse error at the first
+     * malformed token or value that does not match its member.
+     */
+    [[nodiscard]] static Expected<T> decode(std::string_view json) {
+        JsonSax::PlainSource source(json);
+        return decodeSource(source);
+    }
+
+    /**
+     * @brief Reads a JSON document held escaped as the content of a JSON string, without the quotes.
+     *
+     * @param escaped The escaped JSON document.
+     * @return Expected<T> See decode.
+     */
+    [[nodiscard]] static Expected<T> decodeEscaped(std::string_view escaped) {
+        JsonSax::EscapedSource source(escaped);
+        return decodeSource(source);
+    }
+
+    /**
+     * @brief Reads the JSON body of a response, in memory or mapped.
+     *
+     * @param responseData The response.
+     * @return Expected<T> See decode.
+     */
+    [[nodiscard]] static Expected<T> decodeBody(const ResponseData& responseData) {
+        return decodeEscaped(responseData.bodyView());
+    }
+
+private:
+    template <typename U>
+    friend struct JsonDecoder;
+
+    template <typename U>
+    struct IsOptional : std::false_type {};
+    template <typename U>
+    struct IsOptional<std::optional<U>> : std::true_type {};
+
+    template <typename U>
+    struct IsVector : std::false_type {};
+    template <typename U, typename A>
+    struct IsVector<std::vector<U, A>> : std::true_type {};
+
+    template <typename U, typename = void>
+    struct HasFields : std::false_type {};
+    template <typename U>
+    struct HasFields<U, std::void_t<decltype(JsonFields<U>::fields)>> : std::true_type {};
+
+    template <typename Source>
+    [[nodiscard]] static Expected<T> decodeSource(Source& source) {
+        T value{};
+        std::pmr::string scratch{MemoryScope::resource()};
+        if (!read(source, value, scratch)) {
+            return Unexpected<Error>{{ErrorCode::Parse, "Cannot decode JSON at offset " +
+                std::to_string(source.offset())}};
+        }
+
+        JsonSax::skipSpace(source);
+        if (source.peek() != JsonSax::END) {
+            return Unexpected<Error>{{ErrorCode::Parse, "Malformed JSON at offset " +
+                std::to_string(source.offset())}};
+        }
+        return value;
+    }
+
+    /**
+     * @brief Reads the value starting at the current position into out.
+     *
+     * @return bool False if the value is malformed or does not match T.
+     */
+    template <typename Source>
+    [[nodiscard]] static bool read(Source& source, T& out, std::pmr::string& scratch);
+
+    /**
+     * @brief Reads the members of an object, the opening brace already consumed.
+     */
+    template <typename Source>
+    [[nodiscard]] static bool readObject(Source& source, T& out, std::pmr::string& scratch);
+
+    /**
+     * @brief Reads the member at an index of JsonFields<T>::fields.
+     */
+    template <typename Source, size_t I>
+    [[nodiscard]] static bool readField(Source& source, T& out, std::pmr::string& scratch) {
+        auto& member = out.*(std::get<I>(JsonFields<T>::fields).member);
+        return JsonDecoder<std::decay_t<decltype(member)>>::read(source, member, scratch);
+    }
+
+    /**
+     * @brief Returns the names of JsonFields<T>::fields.
+     */
+    template <size_t... I>
+    [[nodiscard]] static constexpr auto fieldNames(std::index_sequence<I...>) {
+        return std::array<std::string_view, sizeof...(I)>{std::get<I>(JsonFields<T>::fields).name...};
+    }
+
+    /**
+     * @brief Returns the readers of JsonFields<T>::fields, by index.
+     */
+    template <typename Source, size_t... I>
+    [[nodiscard]] static constexpr auto fieldReaders(std::index_sequence<I...>) {
+        return std::array<bool (*)(Source&, T&, std::pmr::string&), sizeof...(I)>{&readField<Source, I>...};
+    }
+
+    /**
+     * @brief Skips the value starting at the current position.
+     *
+     * Only strings and the nesting of objects and arrays are checked.
+     */
+    template <typename Source>
+    [[nodiscard]] static bool skip(Source& source, std::pmr::string& scratch);
+};
+
+template <typename T>
+template <typename Source>
+bool JsonDecoder<T>::read(Source& source, T& out, std::pmr::string& scratch) {
+    JsonSax::skipSpace(source);
+    int ch = source.peek();
+    if (ch == 'n') {
+        if constexpr (IsOptional<T>::value) {
+            out.reset();
+        }
+        return JsonSax::consume(source, "null");
+    }
+
+    if constexpr (IsOptional<T>::value) {
+        using Value = typename T::value_type;
+        if (!out) {
+            out.emplace();
+        }
+        return JsonDecoder<Value>::read(source, *out, scratch);
+    }
+    else if constexpr (std::is_same_v<T, bool>) {
+        if (ch != 't' && ch != 'f') {
+            return false;
+        }
+        out = ch == 't';
+        return JsonSax::consume(source, ch == 't' ? "true" : "false");
+    }
+    else if constexpr (std::is_arithmetic_v<T>) {
+        char digits[64];
+        size_t length = 0;
+        for (int digit = ch; (digit >= '0' && digit <= '9') || digit == '-' || digit == '+' || digit == '.' ||
+            digit == 'e' || digit == 'E'; digit = source.peek()) {
+            if (length == sizeof(digits)) {
+                return false;
+            }
+            digits[length++] = static_cast<char>(digit);
+            source.advance();
+        }
+        if (length == 0) {
+            return false;
+        }
+
+        if constexpr (std::is_floating_point_v<T>) {
+#if defined(__cpp_lib_to_chars)
+            auto [end, ec] = std::from_chars(digits, digits + length, out);
+            return ec == std::errc() && end == digits + length;
+#else
+            std::string text(digits, length);
+            char* end = nullptr;
+            out = static_cast<T>(std::strtod(text.c_str(), &end));
+            return end == text.c_str() + length;
+#endif
+        }
+        else {
+            auto [end, ec] = std::from_chars(digits, digits + length, out);
+            return ec == std::errc() && end == digits + length;
+        }
+    }
+    else if constexpr (std::is_same_v<T, std::string>) {
+        if (ch != '"') {
+            return false;
+        }
+        source.advance();
+        std::optional<std::string_view> value = JsonSax::readString(source, scratch);
+        if (!value) {
+            return false;
+        }
+        out.assign(value->data(), value->size());
+        return true;
+    }
+    else if constexpr (IsVector<T>::value) {
+        using Value = typename T::value_type;
+        if (ch != '[') {
+            return false;
+        }
+        source.advance();
+        out.clear();
+
+        JsonSax::skipSpace(source);
+        if (source.peek() == ']') {
+            source.advance();
+            return true;
+        }
+        for (;;) {
+            if (!JsonDecoder<Value>::read(source, out.emplace_back(), scratch)) {
+                return false;
+            }
+            JsonSax::skipSpace(source);
+            int next = source.peek();
+            source.advance();
+            if (next == ']') {
+                return true;
+            }
+            if (next != ',') {
+                return false;
+            }
+        }
+    }
+    else {
+        static_assert(HasFields<T>::value, "Describe the type with TLS_CLIENT_JSON_FIELDS");
+        if (ch != '{') {
+            return false;
+        }
+        source.advance();
+        return readObject(source, out, scratch);
+    }
+}
+
+template <typename T>
+template <typename Source>
+bool JsonDecoder<T>::readObject(Source& source, T& out, std::pmr::string& scratch) {
+    using Fields = std::decay_t<decltype(JsonFields<T>::fields)>;
+    constexpr size_t COUNT = std::tuple_size_v<Fields>;
+    static constexpr JsonPerfectHash<COUNT> TABLE =
+        JsonPerfectHash<COUNT>::build(fieldNames(std::make_index_sequence<COUNT>()));
+    static_assert(TABLE.valid, "The JSON fields of a type must have distinct names");
+    static constexpr auto READERS = fieldReaders<Source>(std::make_index_sequence<COUNT>());
+
+    JsonSax::skipSpace(source);
+    if (source.peek() == '}') {
+        source.advance();
+        return true;
+    }
+
+    for (;;) {
+        JsonSax::skipSpace(source);
+        if (source.peek() != '"') {
+            return false;
+        }
+        source.advance();
+        std::optional<std::string_view> key = JsonSax::readString(source, scratch);
+        if (!key) {
+            return false;
+        }
+        size_t index = TABLE.find(*key);
+
+        JsonSax::skipSpace(source);
+        if (source.peek() != ':') {
+            return false;
+        }
+        source.advance();
+
+        if (!(index < COUNT ? READERS[index](source, out, scratch) : skip(source, scratch))) {
+            return false;
+        }
+
+        JsonSax::skipSpace(source);
+        int next = source.peek();
+        source.advance();
+        if (next == '}') {
+            return true;
+        }
+        if (next != ',') {
+            return false;
+        }
+    }
+}
+
+template <typename T>
+template <typename Source>
+bool JsonDecoder<T>::skip(Source& source, std::pmr::string& scratch) {
+    size_t depth = 0;
+    do {
+        JsonSax::skipSpace(source);
+        int ch = source.peek();
+        if (ch < 0) {
+            return false;
+        }
+
+        if (ch == '"') {
+            source.advance();
+            if (!JsonSax::readString(source, scratch)) {
+                return false;
+            }
+        } else if (ch == '{' || ch == '[') {
+            source.advance();
+            ++depth;
+        } else if (ch == '}' || ch == ']' || ch == ',' || ch == ':') {
+            if (depth == 0) {
+                return false;
+            }
+            source.advance();
+            depth -= ch == '}' || ch == ']' ? 1 : 0;
+        } else {
+            // A number or a literal
+            for (; ch >= 0 && ch != ',' && ch != ':' && ch != '}' && ch != ']' && ch != ' ' && ch != '\t' &&
+                ch != '\n' && ch != '\r' && ch != '"'; ch = source.peek()) {
+                source.advance();
+            }
+        }
+    } while (depth > 0);
+    return true;
+}
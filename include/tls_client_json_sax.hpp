@@ -0,0 +1,609 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client.hpp"
+
+/**
+ * @brief JsonVisitor struct with the callbacks of JsonSax, all doing nothing.
+ *
+ * Derive from it and declare the callbacks you need with the same signature;
+ * JsonSax calls them statically, without virtual dispatch. Every callback
+ * returns false to stop the walk. Strings and numbers are passed as views
+ * valid until the callback returns; strings are unescaped, and numbers are
+ * passed as they are written.
+ */
+struct JsonVisitor {
+    bool onObjectStart() { return true; }
+    bool onObjectEnd() { return true; }
+    bool onArrayStart() { return true; }
+    bool onArrayEnd() { return true; }
+    bool onKey(std::string_view) { return true; }
+    bool onString(std::string_view) { return true; }
+    bool onNumber(std::string_view) { return true; }
+    bool onBool(bool) { return true; }
+    bool onNull() { return true; }
+};
+
+/**
+ * @brief JsonSax class walking JSON documents in place, calling a visitor for every token.
+ *
+ * Nothing is built but the current string, when it has escape sequences, and
+ * the stack of open containers, so memory does not grow with the document.
+ * visitBody reads ResponseData::body as it is stored, escaped the way the
+ * library escapes the response envelope, and undoes both levels of escaping
+ * on the fly, without an unescaped copy of the body.
+ */
+class JsonSax {
+public:
+    /**
+     * @brief Walks a JSON document.
+     *
+     * @tparam Visitor Type of the visitor, see JsonVisitor.
+     * @param json The JSON document.
+     * @param visitor The visitor.
+     * @return Expected<bool> True if the whole document was walked, false if the
+     * visitor stopped, or an ErrorCode::Parse error at the first malformed token.
+     */
+    template <typename Visitor>
+    [[nodiscard]] static Expected<bool> visit(std::string_view json, Visitor& visitor) {
+        PlainSource source(json);
+        return walk(source, visitor);
+    }
+
+    /**
+     * @brief Walks a JSON document held escaped as the content of a JSON string, without the quotes.
+     *
+     * @tparam Visitor Type of the visitor, see JsonVisitor.
+     * @param escaped The escaped JSON document.
+     * @param visitor The visitor.
+     * @return Expected<bool> See visit.
+     */
+    template <typename Visitor>
+    [[nodiscard]] static Expected<bool> visitEscaped(std::string_view escaped, Visitor& visitor) {
+        EscapedSource source(escaped);
+        return walk(source, visitor);
+    }
+
+    /**
+     * @brief Walks the JSON body of a response, in memory or mapped.
+     *
+     * @tparam Visitor Type of the visitor, see JsonVisitor.
+     * @param responseData The response.
+     * @param visitor The visitor.
+     * @return Expected<bool> See visit.
+     */
+    template <typename Visitor>
+    [[nodiscard]] static Expected<bool> visitBody(const ResponseData& responseData, Visitor& visitor) {
+        return visitEscaped(responseData.bodyView(), visitor);
+    }
+
+private:
+    template <typename T>
+    friend struct JsonDecoder;
+
+    static constexpr int END = -1;   /**< Returned by peek at the end of the input. */
+    static constexpr int INVALID = -2; /**< Returned by peek after a malformed escape sequence. */
+
+    /**
+     * @brief PlainSource struct reading the characters of a JSON document.
+     */
+    struct PlainSource {
+        std::string_view text;
+        size_t position = 0;
+
+        explicit PlainSource(std::string_view text) : text(text) {}
+
+        [[nodiscard]] int peek() const noexcept {
+            return position < text.size() ? static_cast<unsigned char>(text[position]) : END;
+        }
+
+        void advance() noexcept { ++position; }
+
+        [[nodiscard]] size_t offset() const noexcept { return position; }
+
+        /**
+         * @brief Returns the content of the string at the current position if it has no
+         * escape sequences, and moves past its closing quote.
+         */
+        [[nodiscard]] std::optional<std::string_view> rawString() noexcept {
+            size_t end = text.find_first_of("\"\\", position);
+            if (end == std::string_view::npos || text[end] != '"') {
+                return std::nullopt;
+            }
+            std::string_view content = text.substr(position, end - position);
+            position = end + 1;
+            return content;
+        }
+    };
+
+    /**
+     * @brief EscapedSource struct reading the characters of a JSON document escaped as a JSON string.
+     */
+    struct EscapedSource {
+        std::string_view text;
+        size_t position = 0;     /**< The raw offset after the current character. */
+        size_t start = 0;        /**< The raw offset of the current character. */
+        int current = END;
+        char pending[4] = {};    /**< The remaining UTF-8 bytes of a \\u escape sequence. */
+        size_t pendingSize = 0;
+        size_t pendingIndex = 0;
+
+        explicit EscapedSource(std::string_view text) : text(text) { advance(); }
+
+        [[nodiscard]] int peek() const noexcept { return current; }
+
+        [[nodiscard]] size_t offset() const noexcept { return start; }
+
+        void advance() noexcept {
+            if (pendingIndex < pendingSize) {
+                current = static_cast<unsigned char>(pending[pendingIndex++]);
+                return;
+            }
+
+            start = position;
+            if (position >= text.size()) {
+                current = END;
+                return;
+            }
+
+            char ch = text[position++];
+            if (ch != '\\') {
+                current = static_cast<unsigned char>(ch);
+                return;
+            }
+
+            if (position >= text.size()) {
+                current = INVALID;
+                return;
+            }
+            switch (text[position++]) {
+                case '"': current = '"'; break;
+                case '\\': current = '\\'; break;
+                case '/': current = '/'; break;
+                case 'b': current = '\b'; break;
+                case 'f': current = '\f'; break;
+                case 'n': current = '\n'; break;
+                case 'r': current = '\r'; break;
+                case 't': current = '\t'; break;
+                case 'u': {
+                    std::string utf8;
+                    if (!JsonHelper::readUnicode(text, position, utf8)) {
+                        current = INVALID;
+                        return;
+                    }
+                    current = static_cast<unsigned char>(utf8[0]);
+                    pendingSize = utf8.size() - 1;
+                    pendingIndex = 0;
+                    std::copy(utf8.begin() + 1, utf8.end(), pending);
+                    break;
+                }
+                default: current = INVALID; break;
+            }
+        }
+
+        /**
+         * @brief Returns the content of the string at the current position if it has no
+         * escape sequences of either level, and moves past its closing quote.
+         */
+        [[nodiscard]] std::optional<std::string_view> rawString() noexcept {
+            if (pendingIndex < pendingSize || current == END) {
+                return std::nullopt;
+            }
+
+            // The string ends at an escaped quote; any other backslash needs unescaping
+            size_t end = text.find('\\', start);
+            if (end == std::string_view::npos || end + 1 >= text.size() || text[end + 1] != '"') {
+                return std::nullopt;
+            }
+            std::string_view content = text.substr(start, end - start);
+            position = end + 2;
+            advance();
+            return content;
+        }
+    };
+
+    /**
+     * @brief Walks the document of a source.
+     */
+    template <typename Source, typename Visitor>
+    [[nodiscard]] static Expected<bool> walk(Source& source, Visitor& visitor);
+
+    /**
+     * @brief Reads the string starting after the opening quote, into scratch if it needs unescaping.
+     *
+     * @return std::optional<std::string_view> The unescaped string, or nothing if it is malformed.
+     */
+    template <typename Source>
+    [[nodiscard]] static std::optional<std::string_view> readString(Source& source, std::pmr::string& scratch);
+
+    /**
+     * @brief Skips whitespace.
+     */
+    template <typename Source>
+    static void skipSpace(Source& source) {
+        for (int ch = source.peek(); ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r'; ch = source.peek()) {
+            source.advance();
+        }
+    }
+
+    /**
+     * @brief Consumes a literal such as "true", returning whether it matched.
+     */
+    template <typename Source>
+    [[nodiscard]] static bool consume(Source& source, std::string_view literal) {
+        for (char ch : literal) {
+            if (source.peek() != static_cast<unsigned char>(ch)) {
+                return false;
+            }
+            source.advance();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Checks a token against the JSON number grammar.
+     */
+    [[nodiscard]] static bool isNumber(std::string_view token) {
+        size_t position = 0;
+        auto digits = [&token, &position]() {
+            size_t start = position;
+            while (position < token.size() && token[position] >= '0' && token[position] <= '9') {
+                ++position;
+            }
+            return position - start;
+        };
+
+        if (position < token.size() && token[position] == '-') {
+            ++position;
+        }
+        size_t start = position;
+        size_t integer = digits();
+        if (integer == 0 || (integer > 1 && token[start] == '0')) {
+            return false;
+        }
+        if (position < token.size() && token[position] == '.') {
+            ++position;
+            if (digits() == 0) {
+                return false;
+            }
+        }
+        if (position < token.size() && (token[position] == 'e' || token[position] == 'E')) {
+            ++position;
+            if (position < token.size() && (token[position] == '+' || token[position] == '-')) {
+                ++position;
+            }
+            if (digits() == 0) {
+                return false;
+            }
+        }
+        return position == token.size();
+    }
+};
+
+/**
+ * @brief JsonFieldExtractor class collecting a few scalar fields of a JSON document by JSON pointer.
+ *
+ * The walk stops as soon as every field was found, so the rest of the document
+ * is never read:
+ *
+ * @code
+ * JsonFieldExtractor fields({"/data/id", "/data/items/0/name"});
+ * JsonSax::visitBody(response, fields);
+ * std::optional<std::string> id = fields.get("/data/id");
+ * @endcode
+ *
+ * Values are kept as text: strings unescaped, numbers as written, and
+ * "true", "false" or "null". Objects and arrays are not collected.
+ */
+class JsonFieldExtractor : public JsonVisitor {
+public:
+    /**
+     * @brief Constructs the extractor.
+     *
+     * @param pointers The JSON pointers (RFC 6901) of the fields, e.g. "/a/0/b".
+     */
+    explicit JsonFieldExtractor(const std::vector<std::string>& pointers) {
+        for (const std::string& pointer : pointers) {
+            fields.emplace(pointer, std::nullopt);
+        }
+    }
+
+    /**
+     * @brief Returns the value of a field.
+     *
+     * @param pointer The JSON pointer of the field.
+     * @return std::optional<std::string> The value, or nothing if the field was not found.
+     */
+    [[nodiscard]] std::optional<std::string> get(const std::string& pointer) const {
+        auto it = fields.find(pointer);
+        return it != fields.end() ? it->second : std::nullopt;
+    }
+
+    /**
+     * @brief Checks whether every field was found.
+     */
+    [[nodiscard]] bool complete() const noexcept { return found == fields.size(); }
+
+    bool onObjectStart() { return open(false); }
+    bool onArrayStart() { return open(true); }
+    bool onObjectEnd() { return close(); }
+    bool onArrayEnd() { return close(); }
+
+    bool onKey(std::string_view key) {
+        // Keys are escaped as RFC 6901 requires: ~ as ~0 and / as ~1
+        path.resize(frames.back().base);
+        path += '/';
+        for (char ch : key) {
+            path += ch == '~' ? "~0" : ch == '/' ? "~1" : std::string_view(&ch, 1);
+        }
+        return true;
+    }
+
+    bool onString(std::string_view value) { return scalar(value); }
+    bool onNumber(std::string_view value) { return scalar(value); }
+    bool onBool(bool value) { return scalar(value ? "true" : "false"); }
+    bool onNull() { return scalar("null"); }
+
+private:
+    /**
+     * @brief Frame struct describing an open object or array.
+     */
+    struct Frame {
+        size_t base;       /**< The length of the path of the container. */
+        bool array;
+        size_t index = 0;  /**< The index of the next element of an array. */
+    };
+
+    std::unordered_map<std::string, std::optional<std::string>> fields;
+    size_t found = 0;
+    std::string path;            /**< The JSON pointer of the current value. */
+    std::vector<Frame> frames;
+
+    /**
+     * @brief Sets the path of a value about to start inside an array.
+     */
+    void element() {
+        if (!frames.empty() && frames.back().array) {
+            path.resize(frames.back().base);
+            path += '/';
+            path += std::to_string(frames.back().index++);
+        }
+    }
+
+    bool open(bool array) {
+        element();
+        frames.push_back({path.size(), array});
+        return true;
+    }
+
+    bool close() {
+        frames.pop_back();
+        path.resize(frames.empty() ? 0 : frames.back().base);
+        return true;
+    }
+
+    bool scalar(std::string_view value) {
+        element();
+        auto it = fields.find(path);
+        if (it != fields.end() && !it->second) {
+            it->second.emplace(value);
+            ++found;
+        }
+        return !complete();
+    }
+};
+
+template <typename Source, typename Visitor>
+Expected<bool> JsonSax::walk(Source& source, Visitor& visitor) {
+    auto malformed = [&source]() {
+        return Unexpected<Error>{{ErrorCode::Parse, "Malformed JSON at offset " + std::to_string(source.offset())}};
+    };
+
+    // The walk state lives in the memory scope of the thread
+    std::pmr::string scratch{MemoryScope::resource()};
+    std::pmr::vector<char> stack{MemoryScope::resource()}; // '{' or '[' for each open container
+
+    // Reads a key and its colon, leaving the source at the value
+    auto readKey = [&]() -> std::optional<bool> {
+        skipSpace(source);
+        if (source.peek() != '"') {
+            return std::nullopt;
+        }
+        source.advance();
+        std::optional<std::string_view> key = readString(source, scratch);
+        if (!key) {
+            return std::nullopt;
+        }
+        bool keepGoing = visitor.onKey(*key);
+        skipSpace(source);
+        if (source.peek() != ':') {
+            return std::nullopt;
+        }
+        source.advance();
+        return keepGoing;
+    };
+
+    for (;;) {
+        // A value starts here
+        skipSpace(source);
+        int ch = source.peek();
+        bool keepGoing = true;
+        bool opened = false;
+
+        if (ch == '{' || ch == '[') {
+            source.advance();
+            keepGoing = ch == '{' ? visitor.onObjectStart() : visitor.onArrayStart();
+            if (!keepGoing) {
+                return false;
+            }
+
+            skipSpace(source);
+            if (source.peek() == (ch == '{' ? '}' : ']')) {
+                source.advance();
+                keepGoing = ch == '{' ? visitor.onObjectEnd() : visitor.onArrayEnd();
+            } else {
+                stack.push_back(static_cast<char>(ch));
+                opened = true;
+                if (ch == '{') {
+                    std::optional<bool> key = readKey();
+                    if (!key) {
+                        return malformed();
+                    }
+                    keepGoing = *key;
+                }
+            }
+        } else if (ch == '"') {
+            source.advance();
+            std::optional<std::string_view> value = readString(source, scratch);
+            if (!value) {
+                return malformed();
+            }
+            keepGoing = visitor.onString(*value);
+        } else if (ch == 't' || ch == 'f') {
+            if (!consume(source, ch == 't' ? "true" : "false")) {
+                return malformed();
+            }
+            keepGoing = visitor.onBool(ch == 't');
+        } else if (ch == 'n') {
+            if (!consume(source, "null")) {
+                return malformed();
+            }
+            keepGoing = visitor.onNull();
+        } else if (ch == '-' || (ch >= '0' && ch <= '9')) {
+            scratch.clear();
+            for (int digit = source.peek(); (digit >= '0' && digit <= '9') || digit == '-' || digit == '+' ||
+                digit == '.' || digit == 'e' || digit == 'E'; digit = source.peek()) {
+                scratch += static_cast<char>(digit);
+                source.advance();
+            }
+            if (!isNumber(scratch)) {
+                return malformed();
+            }
+            keepGoing = visitor.onNumber(scratch);
+        } else {
+            return malformed();
+        }
+
+        if (!keepGoing) {
+            return false;
+        }
+        if (opened) {
+            continue;
+        }
+
+        // The value ended: close containers until the next value of one of them
+        for (;;) {
+            skipSpace(source);
+            if (stack.empty()) {
+                if (source.peek() != END) {
+                    return malformed();
+                }
+                return true;
+            }
+
+            int next = source.peek();
+            if (next == ',') {
+                source.advance();
+                if (stack.back() == '{') {
+                    std::optional<bool> key = readKey();
+                    if (!key) {
+                        return malformed();
+                    }
+                    if (!*key) {
+                        return false;
+                    }
+                }
+                break;
+            }
+            if (next != (stack.back() == '{' ? '}' : ']')) {
+                return malformed();
+            }
+
+            source.advance();
+            keepGoing = stack.back() == '{' ? visitor.onObjectEnd() : visitor.onArrayEnd();
+            stack.pop_back();
+            if (!keepGoing) {
+                return false;
+            }
+        }
+    }
+}
+
+template <typename Source>
+std::optional<std::string_view> JsonSax::readString(Source& source, std::pmr::string& scratch) {
+    if (std::optional<std::string_view> raw = source.rawString()) {
+        return raw;
+    }
+
+    scratch.clear();
+    uint32_t highSurrogate = 0; // Waiting for its low surrogate
+    for (;;) {
+        int ch = source.peek();
+        if (ch < 0) {
+            return std::nullopt;
+        }
+        source.advance();
+
+        bool unit = ch == '\\' && source.peek() == 'u';
+        if (highSurrogate != 0 && !unit) {
+            JsonHelper::appendUtf8(scratch, 0xFFFD);
+            highSurrogate = 0;
+        }
+
+        if (ch == '"') {
+            return std::string_view(scratch);
+        }
+        if (ch != '\\') {
+            scratch += static_cast<char>(ch);
+            continue;
+        }
+
+        int escaped = source.peek();
+        source.advance();
+        switch (escaped) {
+            case '"': scratch += '"'; break;
+            case '\\': scratch += '\\'; break;
+            case '/': scratch += '/'; break;
+            case 'b': scratch += '\b'; break;
+            case 'f': scratch += '\f'; break;
+            case 'n': scratch += '\n'; break;
+            case 'r': scratch += '\r'; break;
+            case 't': scratch += '\t'; break;
+            case 'u': {
+                char digits[4];
+                for (char& digit : digits) {
+                    digit = static_cast<char>(std::max(source.peek(), 0));
+                    source.advance();
+                }
+                int value = JsonHelper::readHex(std::string_view(digits, 4), 0);
+                if (value < 0) {
+                    return std::nullopt;
+                }
+
+                uint32_t codePoint = static_cast<uint32_t>(value);
+                if (highSurrogate != 0) {
+                    bool low = codePoint >= 0xDC00 && codePoint <= 0xDFFF;
+                    JsonHelper::appendUtf8(scratch, low ? 0x10000 + ((highSurrogate - 0xD800) << 10) + (codePoint - 0xDC00) : 0xFFFD);
+                    highSurrogate = 0;
+                    if (low) {
+                        break;
+                    }
+                }
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    highSurrogate = codePoint;
+                } else {
+                    JsonHelper::appendUtf8(scratch, codePoint >= 0xDC00 && codePoint <= 0xDFFF ? 0xFFFD : codePoint);
+                }
+                break;
+            }
+            default:
+                return std::nullopt;
+        }
+    }
+}
@@ -0,0 +1,1354 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client.hpp"
+
+#if !defined(OS_LINUX) && !defined(OS_APPLE)
+#error "NativeBackend requires a POSIX platform"
+#endif
+
+#if !defined(TLS_CLIENT_HAS_OPENSSL)
+#error "NativeBackend requires OpenSSL (TLS_CLIENT_HAS_OPENSSL)"
+#endif
+
+#include <cstring>
+#include <map>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+#if defined(TLS_CLIENT_HAS_ZLIB)
+#include <zlib.h>
+#endif
+
+/**
+ * @brief NativeBackendOptions struct containing the options of a native backend.
+ */
+struct NativeBackendOptions {
+    /**
+     * @brief maxIdleConnectionsPerHost field
+     *
+     * This field specifies the number of idle keep-alive connections kept per
+     * host. Further connections are closed once their response is read.
+     */
+    size_t maxIdleConnectionsPerHost = 8;
+
+    /**
+     * @brief idleTimeout field
+     *
+     * This field specifies how long an idle connection is kept before it is closed.
+     */
+    std::chrono::seconds idleTimeout{90};
+
+    /**
+     * @brief defaultTimeout field
+     *
+     * This field specifies the timeout of requests without RequestData::timeoutSeconds.
+     */
+    std::chrono::seconds defaultTimeout{30};
+
+    /**
+     * @brief maxRedirects field
+     *
+     * This field specifies the number of redirects followed before the request fails.
+     */
+    int maxRedirects = 10;
+
+    /**
+     * @brief escapeBody field
+     *
+     * This field specifies whether ResponseData::body keeps JSON escape sequences,
+     * like the bodies returned by the library. Disable it to get the raw body.
+     */
+    bool escapeBody = true;
+
+    /**
+     * @brief maxTlsSessions field
+     *
+     * This field specifies the number of hosts whose TLS session is kept for
+     * resumption. The least recently used sessions are freed beyond it.
+     */
+    size_t maxTlsSessions = 256;
+
+    /**
+     * @brief caFile field
+     *
+     * This optional field specifies a PEM file of trusted certificates. Without
+     * it the default certificate store of OpenSSL is used.
+     */
+    std::optional<std::string> caFile;
+};
+
+/**
+ * @brief NativeBackend class performing HTTP/1.1 requests directly over OpenSSL.
+ *
+ * The backend skips the request envelope, the call into the library and the
+ * parsing of its response, which makes it suited to internal or partner
+ * APIs that do not need a browser TLS fingerprint. Set it in
+ * SessionData::backend, optionally restricted to some hosts with
+ * SessionData::backendHosts; requests through a proxy still go through
+ * the library.
+ *
+ * Connections are kept alive and reused per scheme, host and port. Responses
+ * look like the ones of the library: header names are canonicalized, the
+ * body keeps its JSON escape sequences (see NativeBackendOptions::escapeBody),
+ * gzip bodies are decompressed and redirects are followed when
+ * RequestData::allowRedirects is set.
+ *
+ * The backend is thread-safe and may be shared by several sessions.
+ *
+ * Usage example:
+ * @code
+ * auto backend = NativeBackend::create();
+ * SessionData config;
+ * config.backend = *backend;
+ * config.backendHosts = {"api.internal", "*.partner.example"};
+ * Session session(config);
+ * @endcode
+ */
+class NativeBackend : public RequestBackend {
+public:
+    /**
+     * @brief Creates a backend.
+     *
+     * @param options The options of the backend.
+     * @return Expected<std::shared_ptr<NativeBackend>> The backend, or an ErrorCode::Tls
+     * error if the TLS context or the trusted certificates could not be set up.
+     */
+    [[nodiscard]] static inline Expected<std::shared_ptr<NativeBackend>> create(NativeBackendOptions options = {});
+
+    NativeBackend(const NativeBackend&) = delete;
+    NativeBackend& operator=(const NativeBackend&) = delete;
+
+    /**
+     * @brief Closes the idle connections and frees the TLS contexts.
+     */
+    inline ~NativeBackend() override;
+
+    /**
+     * @brief Checks whether a request is plain HTTP or HTTPS without a proxy.
+     */
+    [[nodiscard]] inline bool supports(const RequestData& requestData) const override;
+
+    /**
+     * @brief Performs a request over a new or an idle keep-alive connection.
+     */
+    [[nodiscard]] inline Expected<ResponseData> perform(const RequestData& requestData, const std::string& method,
+        size_t maxResponseSize) override;
+
+    /**
+     * @brief Returns the number of connections opened so far.
+     *
+     * @return uint64_t The number of connections.
+     */
+    [[nodiscard]] uint64_t connectionsOpened() const noexcept { return opened.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the number of idle connections.
+     *
+     * @return size_t The number of idle connections.
+     */
+    [[nodiscard]] inline size_t idleConnections() const;
+
+    /**
+     * @brief Returns the number of TLS sessions kept for resumption.
+     *
+     * @return size_t The number of TLS sessions.
+     */
+    [[nodiscard]] inline size_t tlsSessions() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t MAX_HEADER_BYTES = 1 << 20; /**< Limit of the status line and headers. */
+    static constexpr size_t READ_CHUNK = 16 * 1024;     /**< Bytes read from the socket at once. */
+
+    /**
+     * @brief Connection struct containing an open socket and its TLS state.
+     */
+    struct Connection {
+        NativeBackend* backend = nullptr; /**< The backend owning the connection. */
+        std::string key;                  /**< The pool key of the connection. */
+        int socket = -1;                  /**< The socket. */
+        SSL* ssl = nullptr;               /**< The TLS state, null for plain HTTP. */
+        std::string buffer;               /**< Bytes read but not consumed yet. */
+        size_t position = 0;              /**< Position of the first unconsumed byte in buffer. */
+        Clock::time_point idleSince;      /**< When the connection was returned to the pool. */
+
+        Connection() = default;
+        Connection(const Connection&) = delete;
+        Connection& operator=(const Connection&) = delete;
+
+        ~Connection() {
+            if (ssl) {
+                SSL_free(ssl);
+            }
+            if (socket >= 0) {
+                ::close(socket);
+            }
+        }
+    };
+
+    using ConnectionPtr = std::unique_ptr<Connection>;
+
+    /**
+     * @brief CachedSession struct containing a TLS session to resume and when it was last used.
+     */
+    struct CachedSession {
+        SSL_SESSION* session = nullptr; /**< The session, owned by the cache. */
+        uint64_t lastUsed = 0;          /**< The value of sessionClock when the session was last used. */
+    };
+
+    /**
+     * @brief Response struct containing a parsed HTTP response.
+     */
+    struct Response {
+        int statusCode = 0;                                      /**< The status code. */
+        std::vector<std::pair<std::string, std::string>> headers; /**< The headers, in order. */
+        std::string body;                                        /**< The decoded body. */
+        bool keepAlive = false;                                  /**< Whether the connection can be reused. */
+    };
+
+    /**
+     * @brief SigpipeGuard struct preventing SIGPIPE while writing to a closed connection.
+     *
+     * OpenSSL writes with write(), which raises SIGPIPE when the peer closed
+     * the connection. On Linux the signal is blocked for the calling thread
+     * and a raised one is consumed; on Apple, sockets use SO_NOSIGPIPE instead.
+     */
+    struct SigpipeGuard {
+#if defined(OS_LINUX)
+        sigset_t previous;
+        bool pending = false;
+
+        SigpipeGuard() {
+            sigset_t pipe;
+            sigemptyset(&pipe);
+            sigaddset(&pipe, SIGPIPE);
+
+            sigset_t current;
+            sigpending(&current);
+            pending = sigismember(&current, SIGPIPE) == 1;
+            pthread_sigmask(SIG_BLOCK, &pipe, &previous);
+        }
+
+        ~SigpipeGuard() {
+            sigset_t current;
+            sigpending(&current);
+            if (!pending && sigismember(&current, SIGPIPE) == 1) {
+                sigset_t pipe;
+                sigemptyset(&pipe);
+                sigaddset(&pipe, SIGPIPE);
+                timespec zero{0, 0};
+                sigtimedwait(&pipe, nullptr, &zero);
+            }
+            pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+        }
+#endif
+    };
+
+    NativeBackendOptions options;
+    SSL_CTX* verifyingContext = nullptr; /**< TLS context verifying certificates. */
+    SSL_CTX* insecureContext = nullptr;  /**< TLS context for RequestData::insecureSkipVerify. */
+
+    mutable std::mutex mutex;                                       /**< Guards idle and sessions. */
+    std::unordered_map<std::string, std::vector<ConnectionPtr>> idle; /**< Idle connections per pool key. */
+    std::unordered_map<std::string, CachedSession> sessions;        /**< TLS sessions to resume per pool key. */
+    uint64_t sessionClock = 0;                                      /**< Orders the uses of sessions. */
+    std::atomic<uint64_t> opened{0};
+
+    explicit NativeBackend(NativeBackendOptions options) : options(std::move(options)) {}
+
+    /**
+     * @brief Performs one request and reads its response, retrying once on a stale connection.
+     */
+    inline Expected<Response> exchange(const UrlView& url, const std::string& request, bool insecure,
+        bool head, bool gzip, Clock::time_point deadline, size_t maxResponseSize);
+
+    /**
+     * @brief Takes an idle connection of a pool key that is still open, or returns null.
+     */
+    inline ConnectionPtr acquire(const std::string& key);
+
+    /**
+     * @brief Returns a connection to the pool of its key.
+     */
+    inline void release(const std::string& key, ConnectionPtr connection);
+
+    /**
+     * @brief Opens a connection and performs the TLS handshake for HTTPS.
+     */
+    inline Expected<ConnectionPtr> connect(const UrlView& url, const std::string& key, bool insecure,
+        Clock::time_point deadline);
+
+    /**
+     * @brief Builds the request head and body; gzip is set if the request asks for a gzip body.
+     *
+     * Fails with ErrorCode::Request if the method, URL, a header or a cookie would break
+     * the framing of the request, e.g. with a CR or LF.
+     */
+    [[nodiscard]] static inline Expected<std::string> buildRequest(const UrlView& url, const RequestData& requestData,
+        const std::string& method, const std::optional<std::string>& body, bool sensitiveHeaders, bool& gzip);
+
+    /**
+     * @brief Reads a response from a connection, decompressing gzip bodies if gzip is set.
+     */
+    static inline Expected<Response> readResponse(Connection& connection, bool head, bool gzip,
+        Clock::time_point deadline, size_t maxResponseSize);
+
+    /**
+     * @brief Reads a line ending with CRLF or LF, without the line ending.
+     */
+    static inline Expected<std::string> readLine(Connection& connection, Clock::time_point deadline,
+        size_t& budget);
+
+    /**
+     * @brief Appends exactly length bytes to out.
+     */
+    static inline std::optional<Error> readExact(Connection& connection, std::string& out, size_t length,
+        Clock::time_point deadline);
+
+    /**
+     * @brief Reads more bytes into the buffer of a connection; false on end of stream.
+     */
+    static inline Expected<bool> fill(Connection& connection, Clock::time_point deadline);
+
+    /**
+     * @brief Writes all bytes to a connection.
+     */
+    static inline std::optional<Error> writeAll(Connection& connection, std::string_view data,
+        Clock::time_point deadline);
+
+    /**
+     * @brief Waits until a socket is readable or writable; false on timeout.
+     */
+    static inline bool wait(int socket, bool write, Clock::time_point deadline);
+
+    /**
+     * @brief Builds an error from the OpenSSL error queue.
+     */
+    [[nodiscard]] static inline Error tlsError(const std::string& prefix);
+
+    /**
+     * @brief Resolves a redirect location against the URL it was received for.
+     */
+    [[nodiscard]] static inline std::string resolve(const std::string& base, const std::string& location);
+
+    /**
+     * @brief Canonicalizes a header name the way Go does, e.g. content-type becomes Content-Type.
+     */
+    [[nodiscard]] static inline std::string canonicalName(std::string_view name);
+
+    /**
+     * @brief Checks that a header or cookie name is a non-empty token.
+     */
+    [[nodiscard]] static inline bool isToken(std::string_view name) noexcept;
+
+    /**
+     * @brief Checks that a header or cookie value has no control characters other than tabs.
+     */
+    [[nodiscard]] static inline bool isFieldValue(std::string_view value) noexcept;
+
+    /**
+     * @brief Checks that a URL has no whitespace or control characters, which would split the request line.
+     */
+    [[nodiscard]] static inline bool isRequestUrl(std::string_view url) noexcept;
+
+    /**
+     * @brief Builds the ResponseData of a response.
+     */
+    [[nodiscard]] inline ResponseData toResponseData(Response response, std::string target) const;
+
+#if defined(TLS_CLIENT_HAS_ZLIB)
+    /**
+     * @brief Decompresses a gzip body.
+     */
+    static inline std::optional<Error> gunzip(std::string& body, size_t maxResponseSize);
+#endif
+
+    /**
+     * @brief Stores the TLS session of a new connection for later resumption.
+     */
+    static inline int onNewSession(SSL* ssl, SSL_SESSION* session);
+};
+
+Expected<std::shared_ptr<NativeBackend>> NativeBackend::create(NativeBackendOptions options) {
+    std::shared_ptr<NativeBackend> backend(new NativeBackend(std::move(options)));
+
+    for (SSL_CTX** context : {&backend->verifyingContext, &backend->insecureContext}) {
+        *context = SSL_CTX_new(TLS_client_method());
+        if (!*context) {
+            return Unexpected<Error>{tlsError("Failed to create TLS context")};
+        }
+        SSL_CTX_set_min_proto_version(*context, TLS1_2_VERSION);
+        SSL_CTX_set_mode(*context, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+        SSL_CTX_set_session_cache_mode(*context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(*context, &NativeBackend::onNewSession);
+    }
+
+    const std::optional<std::string>& caFile = backend->options.caFile;
+    if ((caFile && SSL_CTX_load_verify_locations(backend->verifyingContext, caFile->c_str(), nullptr) != 1) ||
+        (!caFile && SSL_CTX_set_default_verify_paths(backend->verifyingContext) != 1)) {
+        return Unexpected<Error>{tlsError("Failed to load trusted certificates")};
+    }
+    SSL_CTX_set_verify(backend->verifyingContext, SSL_VERIFY_PEER, nullptr);
+    SSL_CTX_set_verify(backend->insecureContext, SSL_VERIFY_NONE, nullptr);
+
+    return backend;
+}
+
+NativeBackend::~NativeBackend() {
+    idle.clear();
+    for (auto& [key, cached] : sessions) {
+        SSL_SESSION_free(cached.session);
+    }
+    SSL_CTX_free(verifyingContext);
+    SSL_CTX_free(insecureContext);
+}
+
+bool NativeBackend::supports(const RequestData& requestData) const {
+    if (requestData.proxy && !requestData.proxy->empty()) {
+        return false;
+    }
+
+    UrlView url = UrlView::parse(requestData.url);
+    auto equalsIgnoreCase = [](std::string_view lhs, std::string_view rhs) {
+        return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == b;
+        });
+    };
+    return !url.host.empty() && (equalsIgnoreCase(url.scheme, "https") || equalsIgnoreCase(url.scheme, "http"));
+}
+
+size_t NativeBackend::idleConnections() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& [key, connections] : idle) {
+        count += connections.size();
+    }
+    return count;
+}
+
+size_t NativeBackend::tlsSessions() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sessions.size();
+}
+
+Expected<ResponseData> NativeBackend::perform(const RequestData& requestData, const std::string& method,
+    size_t maxResponseSize) {
+    auto timeout = requestData.timeoutSeconds ? std::chrono::seconds(*requestData.timeoutSeconds)
+                                              : options.defaultTimeout;
+    Clock::time_point deadline = Clock::now() + timeout;
+
+    std::string target = requestData.url;
+    std::string currentMethod = method;
+    std::optional<std::string> body = requestData.data;
+    std::string origin = UrlView::parse(target).authority();
+
+    for (int redirects = 0;; ++redirects) {
+        UrlView url = UrlView::parse(target);
+
+        // Like Go, credentials are not sent to another host after a redirect
+        bool sensitiveHeaders = url.authority() == origin;
+        bool gzip = false;
+        Expected<std::string> request = buildRequest(url, requestData, currentMethod, body, sensitiveHeaders, gzip);
+        if (!request) {
+            return Unexpected<Error>{std::move(request.error())};
+        }
+
+        Expected<Response> response = exchange(url, *request, requestData.insecureSkipVerify,
+            currentMethod == "HEAD", gzip, deadline, maxResponseSize);
+        if (!response) {
+            return Unexpected<Error>{std::move(response.error())};
+        }
+
+        int status = response->statusCode;
+        bool redirect = status == 301 || status == 302 || status == 303 || status == 307 || status == 308;
+        if (!requestData.allowRedirects || !redirect) {
+            return toResponseData(std::move(*response), std::move(target));
+        }
+
+        auto location = std::find_if(response->headers.begin(), response->headers.end(), [](const auto& header) {
+            return canonicalName(header.first) == "Location";
+        });
+        if (location == response->headers.end()) {
+            return toResponseData(std::move(*response), std::move(target));
+        }
+        if (redirects == options.maxRedirects) {
+            return Unexpected<Error>{{ErrorCode::Request, target + ": stopped after " +
+                std::to_string(options.maxRedirects) + " redirects"}};
+        }
+
+        // Like Go, spaces of the location are escaped; control characters are rejected
+        std::string resolved = resolve(target, location->second);
+        target.clear();
+        for (char ch : resolved) {
+            if (ch == ' ') {
+                target += "%20";
+            } else {
+                target += ch;
+            }
+        }
+        if (!isRequestUrl(target)) {
+            return Unexpected<Error>{{ErrorCode::Request,
+                "failed to parse Location header: net/url: invalid control character in URL"}};
+        }
+        if (status == 303 || ((status == 301 || status == 302) && currentMethod == "POST")) {
+            currentMethod = currentMethod == "HEAD" ? "HEAD" : "GET";
+            body.reset();
+        }
+    }
+}
+
+Expected<NativeBackend::Response> NativeBackend::exchange(const UrlView& url, const std::string& request,
+    bool insecure, bool head, bool gzip, Clock::time_point deadline, size_t maxResponseSize) {
+    std::string key = std::string(url.scheme) + "://" + url.authority() + (insecure ? "#insecure" : "");
+    SigpipeGuard guard;
+
+    for (int attempt = 0;; ++attempt) {
+        ConnectionPtr connection = attempt == 0 ? acquire(key) : nullptr;
+        bool reused = connection != nullptr;
+
+        if (!connection) {
+            Expected<ConnectionPtr> connected = this->connect(url, key, insecure, deadline);
+            if (!connected) {
+                return Unexpected<Error>{std::move(connected.error())};
+            }
+            connection = std::move(*connected);
+        }
+
+        std::optional<Error> error = writeAll(*connection, request, deadline);
+        Expected<Response> response = error ? Expected<Response>(Unexpected<Error>{std::move(*error)})
+                                            : readResponse(*connection, head, gzip, deadline, maxResponseSize);
+
+        // The server may close an idle connection at any time; retry once on a new one
+        // when the reused connection failed before any byte of the response arrived
+        if (!response && reused && connection->buffer.empty() && response.error().code == ErrorCode::Connection) {
+            continue;
+        }
+
+        if (response && response->keepAlive) {
+            release(key, std::move(connection));
+        }
+        return response;
+    }
+}
+
+NativeBackend::ConnectionPtr NativeBackend::acquire(const std::string& key) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = idle.find(key);
+
+    while (it != idle.end() && !it->second.empty()) {
+        ConnectionPtr connection = std::move(it->second.back());
+        it->second.pop_back();
+
+        // An idle connection must not be readable: that means it was closed or got unexpected data
+        pollfd descriptor{connection->socket, POLLIN, 0};
+        bool expired = Clock::now() - connection->idleSince > options.idleTimeout;
+        if (!expired && ::poll(&descriptor, 1, 0) == 0 && (!connection->ssl || SSL_pending(connection->ssl) == 0)) {
+            return connection;
+        }
+
+        lock.unlock();
+        connection.reset();
+        lock.lock();
+        it = idle.find(key);
+    }
+    return nullptr;
+}
+
+void NativeBackend::release(const std::string& key, ConnectionPtr connection) {
+    connection->buffer.clear();
+    connection->position = 0;
+    connection->idleSince = Clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    std::vector<ConnectionPtr>& connections = idle[key];
+    if (connections.size() < options.maxIdleConnectionsPerHost) {
+        connections.push_back(std::move(connection));
+        return;
+    }
+
+    lock.unlock();
+    connection.reset();
+}
+
+Expected<NativeBackend::ConnectionPtr> NativeBackend::connect(const UrlView& url, const std::string& key,
+    bool insecure, Clock::time_point deadline) {
+    bool https = url.scheme.size() == 5;
+    std::string host(url.host);
+    if (host.size() > 1 && host.front() == '[') {
+        host = host.substr(1, host.size() - 2);
+    }
+    std::string port = url.port.empty() ? (https ? "443" : "80") : std::string(url.port);
+    std::string address = host + ":" + port;
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (int status = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses); status != 0) {
+        return Unexpected<Error>{{ErrorCode::Dns, "dial tcp: lookup " + host + ": " + gai_strerror(status)}};
+    }
+    std::unique_ptr<addrinfo, void (*)(addrinfo*)> addressesGuard(addresses, &::freeaddrinfo);
+
+    auto connection = std::make_unique<Connection>();
+    connection->backend = this;
+    connection->key = key;
+    Error error{ErrorCode::Connection, "dial tcp " + address + ": no address"};
+
+    for (addrinfo* candidate = addresses; candidate; candidate = candidate->ai_next) {
+        int socket = ::socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+        if (socket < 0) {
+            continue;
+        }
+        ::fcntl(socket, F_SETFD, FD_CLOEXEC);
+        ::fcntl(socket, F_SETFL, ::fcntl(socket, F_GETFL) | O_NONBLOCK);
+
+        int one = 1;
+        ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#if defined(OS_APPLE)
+        ::setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+        int result = ::connect(socket, candidate->ai_addr, candidate->ai_addrlen);
+        if (result != 0 && errno == EINPROGRESS) {
+            if (!wait(socket, true, deadline)) {
+                ::close(socket);
+                return Unexpected<Error>{{ErrorCode::Timeout, "dial tcp " + address + ": i/o timeout"}};
+            }
+            socklen_t length = sizeof(result);
+            ::getsockopt(socket, SOL_SOCKET, SO_ERROR, &result, &length);
+            errno = result;
+        }
+
+        if (result == 0) {
+            connection->socket = socket;
+            break;
+        }
+        error.message = "dial tcp " + address + ": connect: " + std::strerror(errno);
+        ::close(socket);
+    }
+
+    if (connection->socket < 0) {
+        return Unexpected<Error>{std::move(error)};
+    }
+    opened.fetch_add(1, std::memory_order_relaxed);
+
+    if (!https) {
+        return connection;
+    }
+
+    connection->ssl = SSL_new(insecure ? insecureContext : verifyingContext);
+    if (!connection->ssl) {
+        return Unexpected<Error>{tlsError("Failed to create TLS connection")};
+    }
+    SSL* ssl = connection->ssl;
+    SSL_set_fd(ssl, connection->socket);
+    SSL_set_app_data(ssl, connection.get());
+
+    static const unsigned char ALPN[] = "\x08http/1.1";
+    SSL_set_alpn_protos(ssl, ALPN, sizeof(ALPN) - 1);
+
+    in6_addr ip;
+    bool literal = ::inet_pton(AF_INET, host.c_str(), &ip) == 1 || ::inet_pton(AF_INET6, host.c_str(), &ip) == 1;
+    if (!literal) {
+        SSL_set_tlsext_host_name(ssl, host.c_str());
+    }
+    if (!insecure) {
+        X509_VERIFY_PARAM* param = SSL_get0_param(ssl);
+        if (literal ? X509_VERIFY_PARAM_set1_ip_asc(param, host.c_str()) != 1 : SSL_set1_host(ssl, host.c_str()) != 1) {
+            return Unexpected<Error>{tlsError("Failed to set the expected host")};
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (auto cached = sessions.find(key); cached != sessions.end()) {
+            cached->second.lastUsed = ++sessionClock;
+            SSL_set_session(ssl, cached->second.session);
+        }
+    }
+
+    for (;;) {
+        ERR_clear_error();
+        int result = SSL_connect(ssl);
+        if (result == 1) {
+            break;
+        }
+
+        int reason = SSL_get_error(ssl, result);
+        if (reason == SSL_ERROR_WANT_READ || reason == SSL_ERROR_WANT_WRITE) {
+            if (!wait(connection->socket, reason == SSL_ERROR_WANT_WRITE, deadline)) {
+                return Unexpected<Error>{{ErrorCode::Timeout, "tls: handshake with " + address + ": i/o timeout"}};
+            }
+            continue;
+        }
+
+        long verification = SSL_get_verify_result(ssl);
+        if (verification != X509_V_OK) {
+            return Unexpected<Error>{{ErrorCode::Tls, "tls: failed to verify certificate: " +
+                std::string(X509_verify_cert_error_string(verification))}};
+        }
+        return Unexpected<Error>{tlsError("tls: handshake with " + address + " failed")};
+    }
+
+    return connection;
+}
+
+int NativeBackend::onNewSession(SSL* ssl, SSL_SESSION* session) {
+    // Sessions arrive during the handshake with TLS 1.2, and with the first reads after it with TLS 1.3
+    auto* connection = static_cast<Connection*>(SSL_get_app_data(ssl));
+    if (!connection) {
+        return 0;
+    }
+
+    NativeBackend& backend = *connection->backend;
+    std::lock_guard<std::mutex> lock(backend.mutex);
+    if (backend.options.maxTlsSessions == 0) {
+        return 0;
+    }
+
+    auto [stored, inserted] = backend.sessions.try_emplace(connection->key);
+    if (!inserted) {
+        SSL_SESSION_free(stored->second.session);
+    }
+    stored->second = {session, ++backend.sessionClock};
+
+    if (backend.sessions.size() > backend.options.maxTlsSessions) {
+        // Drops a sixteenth of the sessions at once, so that a full cache is not scanned on every handshake
+        size_t max = backend.options.maxTlsSessions;
+        size_t keep = std::max<size_t>(max - std::max<size_t>(max / 16, 1), 1);
+        std::vector<std::pair<uint64_t, decltype(backend.sessions)::iterator>> candidates;
+        for (auto it = backend.sessions.begin(); it != backend.sessions.end(); ++it) {
+            candidates.emplace_back(it->second.lastUsed, it);
+        }
+        size_t drop = candidates.size() - keep;
+        std::nth_element(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(drop), candidates.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (size_t i = 0; i < drop; ++i) {
+            SSL_SESSION_free(candidates[i].second->second.session);
+            backend.sessions.erase(candidates[i].second);
+        }
+    }
+    return 1;
+}
+
+Expected<std::string> NativeBackend::buildRequest(const UrlView& url, const RequestData& requestData,
+    const std::string& method, const std::optional<std::string>& body, bool sensitiveHeaders, bool& gzip) {
+    std::string target = url.requestTarget();
+    std::string authority = url.authority();
+    if (!isToken(method)) {
+        return Unexpected<Error>{{ErrorCode::Request, "net/http: invalid method \"" + method + "\""}};
+    }
+    if (!isRequestUrl(target) || !isRequestUrl(authority)) {
+        return Unexpected<Error>{{ErrorCode::Request, "net/url: invalid control character in URL"}};
+    }
+    std::string request = method + " " + target + " HTTP/1.1\r\nHost: " + authority + "\r\n";
+
+    // Names and values come from the caller and must not end the header line
+    std::optional<Error> invalid;
+    auto check = [&invalid](const char* kind, std::string_view name, std::string_view value) {
+        if (!isToken(name)) {
+            invalid = Error{ErrorCode::Request, "net/http: invalid " + std::string(kind) + " name \"" +
+                std::string(name) + "\""};
+        } else if (!isFieldValue(value)) {
+            invalid = Error{ErrorCode::Request, "net/http: invalid " + std::string(kind) + " value for \"" +
+                std::string(name) + "\""};
+        }
+        return !invalid;
+    };
+
+    auto isNamed = [](std::string_view name, std::string_view expected) {
+        return name.size() == expected.size() && std::equal(name.begin(), name.end(), expected.begin(),
+            [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+    };
+
+    bool acceptEncoding = false;
+    if (requestData.headers) {
+        JsonHelper::forEachField(*requestData.headers, [&](std::string_view name, std::string value) {
+            // Framing headers are written below, and credentials stay with the original host
+            if (!check("header field", name, value)) {
+                return false;
+            }
+            if (isNamed(name, "host") || isNamed(name, "content-length") || isNamed(name, "connection") ||
+                isNamed(name, "transfer-encoding") || (!sensitiveHeaders && (isNamed(name, "authorization") ||
+                isNamed(name, "cookie")))) {
+                return true;
+            }
+            acceptEncoding = acceptEncoding || isNamed(name, "accept-encoding");
+            request.append(name.data(), name.size()).append(": ").append(value).append("\r\n");
+            return true;
+        });
+    }
+
+    if (requestData.cookies && sensitiveHeaders) {
+        std::string cookies;
+        JsonHelper::forEachField(*requestData.cookies, [&](std::string_view name, std::string value) {
+            if (!check("cookie", name, value) || value.find(';') != std::string::npos) {
+                invalid = invalid.value_or(Error{ErrorCode::Request, "net/http: invalid cookie value for \"" +
+                    std::string(name) + "\""});
+                return false;
+            }
+            cookies.append(cookies.empty() ? "" : "; ").append(name.data(), name.size()).append("=").append(value);
+            return true;
+        });
+        if (!cookies.empty()) {
+            request.append("Cookie: ").append(cookies).append("\r\n");
+        }
+    }
+    if (invalid) {
+        return Unexpected<Error>{std::move(*invalid)};
+    }
+
+#if defined(TLS_CLIENT_HAS_ZLIB)
+    // Like Go, ask for gzip unless the caller chose an encoding, and decompress transparently
+    if (!acceptEncoding && method != "HEAD") {
+        request += "Accept-Encoding: gzip\r\n";
+        gzip = true;
+    }
+#else
+    (void)acceptEncoding;
+#endif
+
+    if (body) {
+        request += "Content-Length: " + std::to_string(body->size()) + "\r\n";
+    } else if (method == "POST" || method == "PUT" || method == "PATCH") {
+        request += "Content-Length: 0\r\n";
+    }
+
+    request += "\r\n";
+    if (body) {
+        request += *body;
+    }
+    return request;
+}
+
+Expected<NativeBackend::Response> NativeBackend::readResponse(Connection& connection, bool head, bool gzip,
+    Clock::time_point deadline, size_t maxResponseSize) {
+    Response response;
+    size_t budget = MAX_HEADER_BYTES;
+    bool http10 = false;
+    bool close = false;
+    bool chunked = false;
+    std::optional<size_t> contentLength;
+    bool gzipBody = false;
+
+    // Informational responses such as 100 Continue precede the final one
+    do {
+        Expected<std::string> statusLine = readLine(connection, deadline, budget);
+        if (!statusLine) {
+            return Unexpected<Error>{std::move(statusLine.error())};
+        }
+
+        int status = 0;
+        if (statusLine->size() < 12 || statusLine->compare(0, 5, "HTTP/") != 0 ||
+            std::from_chars(statusLine->data() + 9, statusLine->data() + 12, status).ec != std::errc()) {
+            return Unexpected<Error>{{ErrorCode::Request, "malformed HTTP response \"" + *statusLine + "\""}};
+        }
+        response.statusCode = status;
+        http10 = statusLine->compare(0, 8, "HTTP/1.0") == 0;
+        response.headers.clear();
+
+        for (;;) {
+            Expected<std::string> line = readLine(connection, deadline, budget);
+            if (!line) {
+                return Unexpected<Error>{std::move(line.error())};
+            }
+            if (line->empty()) {
+                break;
+            }
+
+            size_t colon = line->find(':');
+            if (colon == std::string::npos || colon == 0) {
+                return Unexpected<Error>{{ErrorCode::Request, "malformed MIME header line: " + *line}};
+            }
+            size_t valueStart = line->find_first_not_of(" \t", colon + 1);
+            size_t valueEnd = line->find_last_not_of(" \t");
+            std::string value = valueStart == std::string::npos ? "" : line->substr(valueStart, valueEnd - valueStart + 1);
+            response.headers.emplace_back(canonicalName(std::string_view(*line).substr(0, colon)), std::move(value));
+        }
+    } while (response.statusCode >= 100 && response.statusCode < 200 && response.statusCode != 101);
+
+    bool keepAliveHeader = false;
+    for (auto& [name, value] : response.headers) {
+        std::string lowered = value;
+        std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+            [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+
+        if (name == "Connection") {
+            close = close || lowered.find("close") != std::string::npos;
+            keepAliveHeader = keepAliveHeader || lowered.find("keep-alive") != std::string::npos;
+        } else if (name == "Transfer-Encoding") {
+            chunked = lowered.find("chunked") != std::string::npos;
+        } else if (name == "Content-Length") {
+            size_t length = 0;
+            if (std::from_chars(value.data(), value.data() + value.size(), length).ec != std::errc()) {
+                return Unexpected<Error>{{ErrorCode::Request, "bad Content-Length \"" + value + "\""}};
+            }
+            contentLength = length;
+        } else if (name == "Content-Encoding") {
+            gzipBody = lowered == "gzip";
+        }
+    }
+    // After 101 Switching Protocols the connection no longer speaks HTTP/1.1
+    response.keepAlive = !close && (!http10 || keepAliveHeader) && response.statusCode != 101;
+
+    auto tooLarge = [maxResponseSize]() {
+        return Unexpected<Error>{{ErrorCode::ResponseTooLarge,
+            "Response exceeds the maximum size of " + std::to_string(maxResponseSize) + " bytes"}};
+    };
+
+    bool bodyless = head || response.statusCode == 204 || response.statusCode == 304 || response.statusCode < 200;
+    if (bodyless) {
+        // No body
+    } else if (chunked) {
+        for (;;) {
+            budget = MAX_HEADER_BYTES;
+            Expected<std::string> sizeLine = readLine(connection, deadline, budget);
+            if (!sizeLine) {
+                return Unexpected<Error>{std::move(sizeLine.error())};
+            }
+
+            size_t size = 0;
+            auto [end, ec] = std::from_chars(sizeLine->data(), sizeLine->data() + sizeLine->size(), size, 16);
+            if (ec != std::errc() || end == sizeLine->data()) {
+                return Unexpected<Error>{{ErrorCode::Request, "malformed chunked encoding"}};
+            }
+            if (size == 0) {
+                break;
+            }
+            if (size > maxResponseSize - response.body.size()) {
+                return tooLarge();
+            }
+            if (std::optional<Error> error = readExact(connection, response.body, size, deadline)) {
+                return Unexpected<Error>{std::move(*error)};
+            }
+            Expected<std::string> crlf = readLine(connection, deadline, budget);
+            if (!crlf || !crlf->empty()) {
+                return Unexpected<Error>{{ErrorCode::Request, "malformed chunked encoding"}};
+            }
+        }
+
+        // Skip the trailers
+        for (;;) {
+            Expected<std::string> trailer = readLine(connection, deadline, budget);
+            if (!trailer) {
+                return Unexpected<Error>{std::move(trailer.error())};
+            }
+            if (trailer->empty()) {
+                break;
+            }
+        }
+    } else if (contentLength) {
+        if (*contentLength > maxResponseSize) {
+            return tooLarge();
+        }
+        if (std::optional<Error> error = readExact(connection, response.body, *contentLength, deadline)) {
+            return Unexpected<Error>{std::move(*error)};
+        }
+    } else {
+        response.keepAlive = false;
+        for (;;) {
+            response.body.append(connection.buffer, connection.position);
+            connection.buffer.clear();
+            connection.position = 0;
+            if (response.body.size() > maxResponseSize) {
+                return tooLarge();
+            }
+
+            Expected<bool> more = fill(connection, deadline);
+            if (!more) {
+                return Unexpected<Error>{std::move(more.error())};
+            }
+            if (!*more) {
+                break;
+            }
+        }
+    }
+
+#if defined(TLS_CLIENT_HAS_ZLIB)
+    // Like Go, only bodies compressed on our own request are decompressed; the caller
+    // decodes the body of a request that set Accept-Encoding itself
+    if (gzip && gzipBody && !bodyless) {
+        if (std::optional<Error> error = gunzip(response.body, maxResponseSize)) {
+            return Unexpected<Error>{std::move(*error)};
+        }
+        response.headers.erase(std::remove_if(response.headers.begin(), response.headers.end(), [](const auto& header) {
+            return header.first == "Content-Encoding" || header.first == "Content-Length";
+        }), response.headers.end());
+    }
+#else
+    (void)gzip;
+    (void)gzipBody;
+#endif
+
+    return response;
+}
+
+Expected<std::string> NativeBackend::readLine(Connection& connection, Clock::time_point deadline, size_t& budget) {
+    for (;;) {
+        size_t end = connection.buffer.find('\n', connection.position);
+        if (end != std::string::npos) {
+            size_t length = end - connection.position;
+            if (length > budget) {
+                break;
+            }
+            budget -= length;
+
+            std::string line = connection.buffer.substr(connection.position, length);
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            connection.position = end + 1;
+            return line;
+        }
+        if (connection.buffer.size() - connection.position > budget) {
+            break;
+        }
+
+        Expected<bool> more = fill(connection, deadline);
+        if (!more) {
+            return Unexpected<Error>{std::move(more.error())};
+        }
+        if (!*more) {
+            return Unexpected<Error>{{ErrorCode::Connection, "server closed the connection unexpectedly (EOF)"}};
+        }
+    }
+    return Unexpected<Error>{{ErrorCode::Request, "server response headers exceeded " +
+        std::to_string(MAX_HEADER_BYTES) + " bytes; aborted"}};
+}
+
+std::optional<Error> NativeBackend::readExact(Connection& connection, std::string& out, size_t length,
+    Clock::time_point deadline) {
+    out.reserve(out.size() + length);
+    for (;;) {
+        size_t available = std::min(length, connection.buffer.size() - connection.position);
+        out.append(connection.buffer, connection.position, available);
+        connection.position += available;
+        length -= available;
+        if (length == 0) {
+            return std::nullopt;
+        }
+
+        Expected<bool> more = fill(connection, deadline);
+        if (!more) {
+            return std::move(more.error());
+        }
+        if (!*more) {
+            return Error{ErrorCode::Connection, "unexpected EOF"};
+        }
+    }
+}
+
+Expected<bool> NativeBackend::fill(Connection& connection, Clock::time_point deadline) {
+    // Drop the consumed bytes before reading more
+    if (connection.position == connection.buffer.size()) {
+        connection.buffer.clear();
+        connection.position = 0;
+    } else if (connection.position > READ_CHUNK) {
+        connection.buffer.erase(0, connection.position);
+        connection.position = 0;
+    }
+
+    size_t size = connection.buffer.size();
+    connection.buffer.resize(size + READ_CHUNK);
+    char* data = connection.buffer.data() + size;
+
+    for (;;) {
+        bool write = false;
+
+        if (connection.ssl) {
+            ERR_clear_error();
+            int result = SSL_read(connection.ssl, data, static_cast<int>(READ_CHUNK));
+            if (result > 0) {
+                connection.buffer.resize(size + result);
+                return true;
+            }
+
+            int reason = SSL_get_error(connection.ssl, result);
+            if (reason == SSL_ERROR_ZERO_RETURN || (reason == SSL_ERROR_SYSCALL && ERR_peek_error() == 0 && errno == 0) ||
+                (reason == SSL_ERROR_SSL && ERR_GET_REASON(ERR_peek_error()) == SSL_R_UNEXPECTED_EOF_WHILE_READING)) {
+                connection.buffer.resize(size);
+                return false;
+            }
+            if (reason != SSL_ERROR_WANT_READ && reason != SSL_ERROR_WANT_WRITE) {
+                connection.buffer.resize(size);
+                if (reason == SSL_ERROR_SYSCALL) {
+                    return Unexpected<Error>{{ErrorCode::Connection, std::string("read: ") + std::strerror(errno)}};
+                }
+                return Unexpected<Error>{tlsError("tls: read failed")};
+            }
+            write = reason == SSL_ERROR_WANT_WRITE;
+        } else {
+            ssize_t count = ::recv(connection.socket, data, READ_CHUNK, 0);
+            if (count >= 0) {
+                connection.buffer.resize(size + count);
+                return count > 0;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                connection.buffer.resize(size);
+                return Unexpected<Error>{{ErrorCode::Connection, std::string("read: ") + std::strerror(errno)}};
+            }
+        }
+
+        if (!wait(connection.socket, write, deadline)) {
+            connection.buffer.resize(size);
+            return Unexpected<Error>{{ErrorCode::Timeout,
+                "net/http: request canceled (Client.Timeout exceeded while awaiting headers)"}};
+        }
+    }
+}
+
+std::optional<Error> NativeBackend::writeAll(Connection& connection, std::string_view data,
+    Clock::time_point deadline) {
+    while (!data.empty()) {
+        bool write = true;
+
+        if (connection.ssl) {
+            ERR_clear_error();
+            int result = SSL_write(connection.ssl, data.data(), static_cast<int>(std::min<size_t>(data.size(), INT_MAX)));
+            if (result > 0) {
+                data.remove_prefix(result);
+                continue;
+            }
+
+            int reason = SSL_get_error(connection.ssl, result);
+            if (reason == SSL_ERROR_SYSCALL || reason == SSL_ERROR_ZERO_RETURN) {
+                return Error{ErrorCode::Connection, std::string("write: ") + std::strerror(errno ? errno : EPIPE)};
+            }
+            if (reason != SSL_ERROR_WANT_READ && reason != SSL_ERROR_WANT_WRITE) {
+                return tlsError("tls: write failed");
+            }
+            write = reason == SSL_ERROR_WANT_WRITE;
+        } else {
+#if defined(MSG_NOSIGNAL)
+            ssize_t count = ::send(connection.socket, data.data(), data.size(), MSG_NOSIGNAL);
+#else
+            ssize_t count = ::send(connection.socket, data.data(), data.size(), 0);
+#endif
+            if (count >= 0) {
+                data.remove_prefix(count);
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return Error{ErrorCode::Connection, std::string("write: ") + std::strerror(errno)};
+            }
+        }
+
+        if (!wait(connection.socket, write, deadline)) {
+            return Error{ErrorCode::Timeout, "write: i/o timeout"};
+        }
+    }
+    return std::nullopt;
+}
+
+bool NativeBackend::wait(int socket, bool write, Clock::time_point deadline) {
+    for (;;) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+        if (remaining.count() <= 0) {
+            return false;
+        }
+
+        pollfd descriptor{socket, static_cast<short>(write ? POLLOUT : POLLIN), 0};
+        int result = ::poll(&descriptor, 1, static_cast<int>(std::min<int64_t>(remaining.count(), INT_MAX)));
+        if (result > 0) {
+            return true;
+        }
+        if (result < 0 && errno != EINTR) {
+            return true; // Let the next read or write report the error
+        }
+    }
+}
+
+Error NativeBackend::tlsError(const std::string& prefix) {
+    unsigned long code = ERR_get_error();
+    ERR_clear_error();
+    if (code == 0) {
+        return {ErrorCode::Tls, prefix};
+    }
+
+    char reason[256];
+    ERR_error_string_n(code, reason, sizeof(reason));
+    return {ErrorCode::Tls, prefix + ": " + reason};
+}
+
+std::string NativeBackend::resolve(const std::string& base, const std::string& location) {
+    UrlView url = UrlView::parse(base);
+
+    if (location.find("://") != std::string::npos) {
+        return location;
+    }
+    if (location.compare(0, 2, "//") == 0) {
+        return std::string(url.scheme) + ":" + location;
+    }
+
+    std::string origin = std::string(url.scheme) + "://" + url.authority();
+    if (!location.empty() && location.front() == '/') {
+        return origin + location;
+    }
+
+    std::string path = url.requestTarget();
+    path = path.substr(0, path.find('?'));
+    if (!location.empty() && location.front() == '?') {
+        return origin + path + location;
+    }
+    return origin + path.substr(0, path.rfind('/') + 1) + location;
+}
+
+std::string NativeBackend::canonicalName(std::string_view name) {
+    std::string result(name);
+
+    // Names with characters outside of a token are left as they are
+    if (!isToken(result)) {
+        return result;
+    }
+
+    bool upper = true;
+    for (char& ch : result) {
+        ch = static_cast<char>(upper ? std::toupper(static_cast<unsigned char>(ch))
+                                     : std::tolower(static_cast<unsigned char>(ch)));
+        upper = ch == '-';
+    }
+    return result;
+}
+
+bool NativeBackend::isToken(std::string_view name) noexcept {
+    return !name.empty() && std::all_of(name.begin(), name.end(), [](unsigned char ch) {
+        return ch != '\0' && (std::isalnum(ch) || std::strchr("!#$%&'*+-.^_`|~", ch) != nullptr);
+    });
+}
+
+bool NativeBackend::isFieldValue(std::string_view value) noexcept {
+    return std::none_of(value.begin(), value.end(), [](unsigned char ch) {
+        return (ch < 0x20 && ch != '\t') || ch == 0x7f;
+    });
+}
+
+bool NativeBackend::isRequestUrl(std::string_view url) noexcept {
+    return std::none_of(url.begin(), url.end(), [](unsigned char ch) { return ch <= 0x20 || ch == 0x7f; });
+}
+
+ResponseData NativeBackend::toResponseData(Response response, std::string target) const {
+    ResponseData responseData;
+    responseData.statusCode = response.statusCode;
+    responseData.target = std::move(target);
+    responseData.usedProtocol = "HTTP/1.1";
+
+    // Headers and cookies are JSON objects with sorted names, like the library encodes them
+    std::map<std::string, std::vector<std::string>> headers;
+    std::map<std::string, std::string> cookies;
+    for (auto& [name, value] : response.headers) {
+        if (name == "Set-Cookie") {
+            std::string_view cookie = std::string_view(value).substr(0, value.find(';'));
+            size_t equals = cookie.find('=');
+            if (equals != std::string_view::npos && equals != 0) {
+                auto trim = [](std::string_view text) {
+                    size_t start = text.find_first_not_of(" \t");
+                    size_t end = text.find_last_not_of(" \t");
+                    return start == std::string_view::npos ? std::string_view() : text.substr(start, end - start + 1);
+                };
+                std::string_view cookieValue = trim(cookie.substr(equals + 1));
+                if (cookieValue.size() >= 2 && cookieValue.front() == '"' && cookieValue.back() == '"') {
+                    cookieValue = cookieValue.substr(1, cookieValue.size() - 2);
+                }
+                cookies[std::string(trim(cookie.substr(0, equals)))] = std::string(cookieValue);
+            }
+        }
+        headers[name].push_back(std::move(value));
+    }
+
+    responseData.headers = "{";
+    for (const auto& [name, values] : headers) {
+        responseData.headers += responseData.headers.size() > 1 ? ",\"" : "\"";
+        JsonHelper::appendEscaped(responseData.headers, name);
+        responseData.headers += "\":[";
+        for (size_t i = 0; i < values.size(); ++i) {
+            responseData.headers += i ? ",\"" : "\"";
+            JsonHelper::appendEscaped(responseData.headers, values[i]);
+            responseData.headers += "\"";
+        }
+        responseData.headers += "]";
+    }
+    responseData.headers += "}";
+
+    responseData.cookies = "{";
+    for (const auto& [name, value] : cookies) {
+        responseData.cookies += responseData.cookies.size() > 1 ? ",\"" : "\"";
+        JsonHelper::appendEscaped(responseData.cookies, name);
+        responseData.cookies += "\":\"";
+        JsonHelper::appendEscaped(responseData.cookies, value);
+        responseData.cookies += "\"";
+    }
+    responseData.cookies += "}";
+
+    if (options.escapeBody) {
+        JsonHelper::appendEscaped(responseData.body, response.body);
+    } else {
+        responseData.body = std::move(response.body);
+        responseData.bodyEscaped = false;
+    }
+    return responseData;
+}
+
+#if defined(TLS_CLIENT_HAS_ZLIB)
+std::optional<Error> NativeBackend::gunzip(std::string& body, size_t maxResponseSize) {
+    z_stream stream{};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+        return Error{ErrorCode::Request, "gzip: failed to initialize"};
+    }
+
+    std::string output;
+    output.resize(std::min(std::max<size_t>(body.size() * 4, 4096), maxResponseSize));
+    stream.next_in = reinterpret_cast<Bytef*>(body.data());
+    stream.avail_in = static_cast<uInt>(body.size());
+
+    int status = Z_OK;
+    while (status == Z_OK) {
+        if (stream.total_out == output.size()) {
+            if (output.size() >= maxResponseSize) {
+                inflateEnd(&stream);
+                return Error{ErrorCode::ResponseTooLarge,
+                    "Response exceeds the maximum size of " + std::to_string(maxResponseSize) + " bytes"};
+            }
+            output.resize(output.size() > maxResponseSize / 2 ? maxResponseSize : output.size() * 2);
+        }
+
+        stream.next_out = reinterpret_cast<Bytef*>(output.data() + stream.total_out);
+        stream.avail_out = static_cast<uInt>(std::min<size_t>(output.size() - stream.total_out, UINT_MAX));
+        status = inflate(&stream, Z_NO_FLUSH);
+        if (status == Z_BUF_ERROR && stream.avail_out != 0) {
+            break; // Truncated input
+        }
+        if (status == Z_BUF_ERROR) {
+            status = Z_OK;
+        }
+    }
+
+    output.resize(stream.total_out);
+    inflateEnd(&stream);
+    if (status != Z_STREAM_END) {
+        return Error{ErrorCode::Request, "gzip: invalid or truncated body"};
+    }
+
+    body = std::move(output);
+    return std::nullopt;
+}
+#endif
@@ -0,0 +1,282 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client.hpp"
+
+#include <chrono>
+
+/**
+ * @brief NegativeCacheOptions struct containing the options of a NegativeCache.
+ */
+struct NegativeCacheOptions {
+    /**
+     * @brief ttls field
+     *
+     * This field specifies how long each class of error is cached. Errors of the
+     * other classes, which depend on the request rather than on the host or proxy
+     * (e.g. ErrorCode::Request or ErrorCode::ResponseTooLarge), are never cached.
+     */
+    std::map<ErrorCode, std::chrono::milliseconds> ttls{
+        {ErrorCode::Dns, std::chrono::seconds(30)},
+        {ErrorCode::Connection, std::chrono::seconds(5)},
+        {ErrorCode::Tls, std::chrono::seconds(30)},
+        {ErrorCode::Proxy, std::chrono::seconds(5)},
+    };
+
+    /**
+     * @brief threshold field
+     *
+     * This field specifies how many failures in a row, without a request
+     * completing in between, it takes to cache an error.
+     */
+    uint32_t threshold = 1;
+
+    /**
+     * @brief window field
+     *
+     * This field specifies how long failures count towards the threshold: the
+     * count starts over once this time has passed since its first failure.
+     */
+    std::chrono::milliseconds window{std::chrono::seconds(60)};
+
+    /**
+     * @brief maxEntries field
+     *
+     * This field specifies the number of cached errors and failure counters the
+     * cache holds at most. When it is full, expired entries are dropped first,
+     * then the ones expiring soonest.
+     */
+    size_t maxEntries = 10000;
+};
+
+/**
+ * @brief NegativeCacheStats struct containing the statistics of a NegativeCache.
+ */
+struct NegativeCacheStats {
+    uint64_t hits = 0;     /**< Requests failed from the cache. */
+    uint64_t failures = 0; /**< Failures recorded with a cacheable error. */
+    uint64_t cached = 0;   /**< Errors cached. */
+};
+
+/**
+ * @brief NegativeCache class failing requests at once while their host or proxy keeps failing.
+ *
+ * Errors are cached by what they are about:
+ * - ErrorCode::Proxy: the proxy, for every request through it
+ * - ErrorCode::Dns: the host name (and proxy)
+ * - other classes, e.g. ErrorCode::Connection and ErrorCode::Tls: the scheme,
+ *   host and port (and proxy)
+ *
+ * A request matching a cached error fails with it, as it was reported, until
+ * its TTL is over; the next request then goes out again. A request that
+ * completes clears the errors of its host. Failure counts last for a window,
+ * and the cache holds at most maxEntries keys, so hosts that fail once and are
+ * never requested again do not accumulate. Set it as SessionData::failureCache;
+ * one cache may be shared by several sessions. All public member functions are
+ * thread-safe.
+ */
+class NegativeCache : public FailureCache {
+public:
+    /**
+     * @brief Constructs the cache.
+     *
+     * @param options The options of the cache.
+     */
+    explicit NegativeCache(NegativeCacheOptions options = {}) : options(std::move(options)) {}
+
+    [[nodiscard]] inline std::optional<Error> lookup(const RequestData& requestData) override;
+
+    inline void recordFailure(const RequestData& requestData, const Error& error) override;
+
+    inline void recordSuccess(const RequestData& requestData) override;
+
+    /**
+     * @brief Drops every cached error.
+     */
+    inline void clear();
+
+    /**
+     * @brief Returns the number of cached errors and failure counters.
+     */
+    [[nodiscard]] size_t size() const noexcept { return count.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the statistics of the cache.
+     */
+    [[nodiscard]] inline NegativeCacheStats getStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Entry struct holding the failures of one key.
+     */
+    struct Entry {
+        std::optional<Error> error;   /**< Set once the threshold is reached. */
+        Clock::time_point expires;    /**< The end of the TTL of the error, or of the window of the count. */
+        uint32_t failures = 0;
+    };
+
+    NegativeCacheOptions options;
+    mutable std::mutex mutex;        /**< Guards the entries and statistics. */
+    std::unordered_map<std::string, Entry> entries;
+    std::atomic<size_t> count{0};    /**< The number of entries, read without the lock. */
+    NegativeCacheStats stats;
+
+    /**
+     * @brief Drops expired entries, then the ones expiring soonest, if the cache is full.
+     * Requires the lock.
+     */
+    inline void evict(Clock::time_point now);
+
+    /**
+     * @brief Returns the key of the scope of an error class: "proxy", "dns" or "origin".
+     */
+    [[nodiscard]] static inline std::string key(const RequestData& requestData, std::string_view scope);
+
+    /**
+     * @brief Returns the scope of an error class.
+     */
+    [[nodiscard]] static std::string_view scope(ErrorCode code) noexcept {
+        return code == ErrorCode::Proxy ? "proxy" : code == ErrorCode::Dns ? "dns" : "origin";
+    }
+};
+
+std::optional<Error> NegativeCache::lookup(const RequestData& requestData) {
+    if (count.load(std::memory_order_relaxed) == 0) {
+        return std::nullopt;
+    }
+
+    Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::string_view name : {"proxy", "dns", "origin"}) {
+        if (name == "proxy" && !requestData.proxy) {
+            continue;
+        }
+
+        auto it = entries.find(key(requestData, name));
+        if (it == entries.end() || !it->second.error) {
+            continue;
+        }
+        if (it->second.expires <= now) {
+            // The request tries again
+            entries.erase(it);
+            count.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        ++stats.hits;
+        return it->second.error;
+    }
+    return std::nullopt;
+}
+
+void NegativeCache::recordFailure(const RequestData& requestData, const Error& error) {
+    auto ttl = options.ttls.find(error.code);
+    if (ttl == options.ttls.end() || (error.code == ErrorCode::Proxy && !requestData.proxy)) {
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+    std::string name = key(requestData, scope(error.code));
+    std::lock_guard<std::mutex> lock(mutex);
+    ++stats.failures;
+
+    auto it = entries.find(name);
+    if (it == entries.end()) {
+        evict(now);
+        it = entries.emplace(std::move(name), Entry()).first;
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Entry& entry = it->second;
+    if (entry.expires <= now) {
+        // The window of the count, or the TTL of the error, is over
+        entry = Entry();
+        entry.expires = now + options.window;
+    }
+    if (++entry.failures >= options.threshold) {
+        ++stats.cached;
+        entry.error = error;
+        entry.expires = now + ttl->second;
+    }
+}
+
+void NegativeCache::recordSuccess(const RequestData& requestData) {
+    if (count.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::string_view name : {"proxy", "dns", "origin"}) {
+        if (name == "proxy" && !requestData.proxy) {
+            continue;
+        }
+        if (entries.erase(key(requestData, name)) != 0) {
+            count.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void NegativeCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    count.store(0, std::memory_order_relaxed);
+}
+
+void NegativeCache::evict(Clock::time_point now) {
+    if (entries.size() < options.maxEntries) {
+        return;
+    }
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        it = it->second.expires <= now ? entries.erase(it) : std::next(it);
+    }
+    if (entries.size() >= options.maxEntries) {
+        // Drops a sixteenth of the entries at once, so that a full cache is not scanned on every failure
+        size_t keep = options.maxEntries - std::min(options.maxEntries, std::max<size_t>(options.maxEntries / 16, 1));
+        std::vector<std::pair<Clock::time_point, decltype(entries)::iterator>> candidates;
+        candidates.reserve(entries.size());
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            candidates.emplace_back(it->second.expires, it);
+        }
+        size_t drop = entries.size() - std::min(entries.size(), keep);
+        std::nth_element(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(drop),
+            candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (size_t i = 0; i < drop; ++i) {
+            entries.erase(candidates[i].second);
+        }
+    }
+    count.store(entries.size(), std::memory_order_relaxed);
+}
+
+NegativeCacheStats NegativeCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+std::string NegativeCache::key(const RequestData& requestData, std::string_view scope) {
+    std::string key(scope);
+    key += ' ';
+
+    if (scope != "proxy") {
+        UrlView url = UrlView::parse(requestData.url);
+        if (scope == "dns") {
+            key += url.host;
+            std::transform(key.begin(), key.end(), key.begin(),
+                [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+        } else {
+            key += url.scheme;
+            key += "://";
+            key += url.authority();
+        }
+        key += ' ';
+    }
+    return key + requestData.proxy.value_or("");
+}
@@ -0,0 +1,733 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client.hpp"
+
+#include <chrono>
+
+/**
+ * @brief BoundedQueue class passing items between threads with a fixed capacity.
+ *
+ * push waits while the queue is full, which is how a slow consumer holds back
+ * its producers. Once closed, pushes fail and pops drain the remaining items.
+ * All public member functions are thread-safe.
+ *
+ * @tparam T Type of the items.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    /**
+     * @brief Constructs the queue.
+     *
+     * @param capacity The maximum number of queued items, at least one.
+     */
+    explicit BoundedQueue(size_t capacity) : limit(std::max<size_t>(capacity, 1)) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Queues an item, waiting while the queue is full.
+     *
+     * @param value The item to queue.
+     * @return bool Whether the item was queued, false if the queue is closed.
+     */
+    inline bool push(T value);
+
+    /**
+     * @brief Queues an item if there is room.
+     *
+     * @param value The item to queue, only moved from if it was queued.
+     * @return bool Whether the item was queued.
+     */
+    inline bool tryPush(T& value);
+
+    /**
+     * @brief Takes the next item, waiting while the queue is empty and open.
+     *
+     * @return std::optional<T> The item, or nothing once the queue is closed and empty.
+     */
+    [[nodiscard]] inline std::optional<T> pop();
+
+    /**
+     * @brief Closes the queue. Waiting pushes fail, and pops return the remaining items.
+     */
+    inline void close();
+
+    /**
+     * @brief Returns the number of queued items.
+     */
+    [[nodiscard]] inline size_t size() const;
+
+    /**
+     * @brief Returns the maximum number of queued items.
+     */
+    [[nodiscard]] size_t capacity() const noexcept { return limit; }
+
+    /**
+     * @brief Returns the largest number of items queued at once.
+     */
+    [[nodiscard]] inline size_t maxSize() const;
+
+    /**
+     * @brief Returns the number of pushes that waited for room.
+     */
+    [[nodiscard]] inline uint64_t blockedPushes() const;
+
+private:
+    const size_t limit;
+    mutable std::mutex mutex;           /**< Guards every member below. */
+    std::condition_variable notEmpty;   /**< Signaled when an item is queued or the queue closes. */
+    std::condition_variable notFull;    /**< Signaled when an item is taken or the queue closes. */
+    std::deque<T> items;
+    size_t highWater = 0;
+    uint64_t blocked = 0;
+    bool closed = false;
+};
+
+template <typename T>
+bool BoundedQueue<T>::push(T value) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (items.size() >= limit && !closed) {
+            ++blocked;
+            notFull.wait(lock, [this]() { return items.size() < limit || closed; });
+        }
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(value));
+        highWater = std::max(highWater, items.size());
+    }
+    notEmpty.notify_one();
+    return true;
+}
+
+template <typename T>
+bool BoundedQueue<T>::tryPush(T& value) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (items.size() >= limit || closed) {
+            return false;
+        }
+        items.push_back(std::move(value));
+        highWater = std::max(highWater, items.size());
+    }
+    notEmpty.notify_one();
+    return true;
+}
+
+template <typename T>
+std::optional<T> BoundedQueue<T>::pop() {
+    std::optional<T> value;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]() { return !items.empty() || closed; });
+        if (items.empty()) {
+            return std::nullopt;
+        }
+        value.emplace(std::move(items.front()));
+        items.pop_front();
+    }
+    notFull.notify_one();
+    return value;
+}
+
+template <typename T>
+void BoundedQueue<T>::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    notEmpty.notify_all();
+    notFull.notify_all();
+}
+
+template <typename T>
+size_t BoundedQueue<T>::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return items.size();
+}
+
+template <typename T>
+size_t BoundedQueue<T>::maxSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return highWater;
+}
+
+template <typename T>
+uint64_t BoundedQueue<T>::blockedPushes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return blocked;
+}
+
+/**
+ * @brief StageOptions struct containing the options of a pipeline stage.
+ */
+struct StageOptions {
+    /**
+     * @brief concurrency field
+     *
+     * This field specifies the number of worker threads of the stage. Each stage
+     * has its own threads, so requests blocked on the network never hold up the
+     * transforms of later stages, nor the other way round.
+     */
+    size_t concurrency = 1;
+
+    /**
+     * @brief capacity field
+     *
+     * This field specifies how many items may wait for the stage. Once its queue
+     * is full, the previous stage (or the caller of push) waits.
+     */
+    size_t capacity = 64;
+};
+
+/**
+ * @brief StageStats struct containing the statistics of a pipeline stage.
+ */
+struct StageStats {
+    std::string name;                  /**< The name of the stage. */
+    size_t concurrency = 0;            /**< The number of worker threads. */
+    size_t capacity = 0;               /**< The capacity of the queue. */
+    size_t queued = 0;                 /**< Items waiting in the queue. */
+    size_t maxQueued = 0;              /**< The largest number of items waiting at once. */
+    size_t active = 0;                 /**< Items being processed. */
+    uint64_t processed = 0;            /**< Items processed and passed on. */
+    uint64_t failed = 0;               /**< Items that failed and were dropped. */
+    uint64_t blocked = 0;              /**< Pushes into the queue that waited for room. */
+    std::chrono::nanoseconds busy{0};  /**< Time spent processing, including waits on the next queue. */
+    std::chrono::nanoseconds elapsed{0}; /**< Time since the stage started, until it drained. */
+
+    /**
+     * @brief Returns the number of items processed or failed per second.
+     */
+    [[nodiscard]] double throughput() const noexcept {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        return seconds > 0 ? static_cast<double>(processed + failed) / seconds : 0.0;
+    }
+
+    /**
+     * @brief Returns the fraction of the worker time spent processing, from 0 to 1.
+     */
+    [[nodiscard]] double utilization() const noexcept {
+        double available = std::chrono::duration<double>(elapsed).count() * static_cast<double>(concurrency);
+        return available > 0 ? std::min(1.0, std::chrono::duration<double>(busy).count() / available) : 0.0;
+    }
+};
+
+/**
+ * @brief PipelineStage class running the workers of one pipeline stage.
+ *
+ * Stages are created by BasicPipeline; the class only holds what does not
+ * depend on the item type.
+ */
+class PipelineStage {
+public:
+    using ErrorHandler = std::function<void(const std::string&, const Error&)>;
+
+    virtual ~PipelineStage() = default;
+
+    /**
+     * @brief Starts the worker threads.
+     */
+    virtual void start() = 0;
+
+    /**
+     * @brief Closes the queue of the stage.
+     */
+    virtual void close() = 0;
+
+    /**
+     * @brief Waits for the worker threads to drain the queue.
+     */
+    virtual void join() = 0;
+
+    /**
+     * @brief Returns the statistics of the stage.
+     */
+    [[nodiscard]] virtual StageStats getStats() const = 0;
+};
+
+/**
+ * @brief QueuedStage class processing the items of a bounded queue on its own threads.
+ *
+ * @tparam In Type of the items of the stage.
+ */
+template <typename In>
+class QueuedStage : public PipelineStage {
+public:
+    using Process = std::function<std::optional<Error>(In&&)>;
+
+    /**
+     * @brief Constructs the stage.
+     *
+     * @param name The name of the stage, used in statistics and errors.
+     * @param options The options of the stage.
+     * @param process The function processing an item and passing on its result.
+     * @param onError The function called when an item fails, shared by the pipeline.
+     */
+    QueuedStage(std::string name, StageOptions options, Process process, const ErrorHandler& onError)
+        : name(std::move(name)), options(options), queue(options.capacity), process(std::move(process)),
+          onError(onError) {
+        this->options.concurrency = std::max<size_t>(options.concurrency, 1);
+    }
+
+    ~QueuedStage() override {
+        close();
+        join();
+    }
+
+    /**
+     * @brief Returns the queue of the stage.
+     */
+    [[nodiscard]] BoundedQueue<In>& input() noexcept { return queue; }
+
+    /**
+     * @brief Sets the function called once every item has been processed, to close the next stage.
+     */
+    void setOnDrained(std::function<void()> function) { onDrained = std::move(function); }
+
+    inline void start() override;
+
+    void close() override { queue.close(); }
+
+    inline void join() override;
+
+    [[nodiscard]] inline StageStats getStats() const override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string name;
+    StageOptions options;
+    BoundedQueue<In> queue;
+    Process process;
+    const ErrorHandler& onError;
+    std::function<void()> onDrained;
+    std::vector<std::thread> workers;
+
+    std::atomic<size_t> running{0};
+    std::atomic<size_t> active{0};
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<int64_t> busy{0};       /**< Nanoseconds spent processing. */
+    Clock::time_point started;
+    std::atomic<bool> launched{false};  /**< Set once started is. */
+    std::atomic<int64_t> drainedAt{0};  /**< Nanoseconds from start to drain, 0 while running. */
+
+    /**
+     * @brief Processes items until the queue is closed and empty.
+     */
+    inline void work();
+};
+
+template <typename In>
+void QueuedStage<In>::start() {
+    started = Clock::now();
+    launched.store(true, std::memory_order_release);
+    running = options.concurrency;
+    workers.reserve(options.concurrency);
+    for (size_t i = 0; i < options.concurrency; ++i) {
+        workers.emplace_back([this]() { work(); });
+    }
+}
+
+template <typename In>
+void QueuedStage<In>::join() {
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+template <typename In>
+StageStats QueuedStage<In>::getStats() const {
+    StageStats stats;
+    stats.name = name;
+    stats.concurrency = options.concurrency;
+    stats.capacity = queue.capacity();
+    stats.queued = queue.size();
+    stats.maxQueued = queue.maxSize();
+    stats.blocked = queue.blockedPushes();
+    stats.active = active.load(std::memory_order_relaxed);
+    stats.processed = processed.load(std::memory_order_relaxed);
+    stats.failed = failed.load(std::memory_order_relaxed);
+    stats.busy = std::chrono::nanoseconds(busy.load(std::memory_order_relaxed));
+
+    if (launched.load(std::memory_order_acquire)) {
+        int64_t drained = drainedAt.load(std::memory_order_acquire);
+        stats.elapsed = drained != 0 ? std::chrono::nanoseconds(drained)
+                                     : std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started);
+    }
+    return stats;
+}
+
+template <typename In>
+void QueuedStage<In>::work() {
+    while (std::optional<In> item = queue.pop()) {
+        active.fetch_add(1, std::memory_order_relaxed);
+        Clock::time_point begin = Clock::now();
+
+        std::optional<Error> error;
+#if defined(TLS_CLIENT_EXCEPTIONS)
+        try {
+            error = process(std::move(*item));
+        } catch (const std::exception& exception) {
+            error = Error{ErrorCode::Request, exception.what()};
+        } catch (...) {
+            error = Error{ErrorCode::Request, "Unknown exception in stage " + name};
+        }
+#else
+        error = process(std::move(*item));
+#endif
+
+        busy.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count(),
+            std::memory_order_relaxed);
+        active.fetch_sub(1, std::memory_order_relaxed);
+
+        if (error) {
+            failed.fetch_add(1, std::memory_order_relaxed);
+            if (onError) {
+                onError(name, *error);
+            }
+        } else {
+            processed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // The last worker out closes the next stage
+    if (running.fetch_sub(1) == 1) {
+        drainedAt.store(std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - started).count()), std::memory_order_release);
+        if (onDrained) {
+            onDrained();
+        }
+    }
+}
+
+/**
+ * @brief PipelineCore struct holding the stages of a pipeline, shared by its outputs.
+ */
+struct PipelineCore {
+    std::vector<std::unique_ptr<PipelineStage>> stages; /**< The stages, in order. */
+    PipelineStage::ErrorHandler onError;                /**< Called when an item fails. */
+    bool started = false;                               /**< Whether the workers run. */
+};
+
+/**
+ * @brief PipelineOutput class standing for the results of a pipeline stage.
+ *
+ * Adding a stage with then makes it the consumer of these results. Results
+ * of the last stage are dropped, so pipelines usually end with a stage
+ * returning void.
+ *
+ * @tparam T Type of the results.
+ */
+template <typename T>
+class PipelineOutput {
+public:
+    /**
+     * @brief Link struct holding the queue the results are pushed to.
+     */
+    struct Link {
+        BoundedQueue<T>* next = nullptr; /**< The queue of the next stage, if any. */
+    };
+
+    PipelineOutput(PipelineCore& core, std::shared_ptr<Link> link) : core(&core), link(std::move(link)) {}
+
+    /**
+     * @brief Adds a stage transforming these results.
+     *
+     * The function is called with each result, as an rvalue, on the threads
+     * of the new stage. It may return a value, which is passed to the next
+     * stage, an Expected, whose errors count as failures, or void. Failures
+     * and exceptions drop the item and are reported to the error handler of
+     * the pipeline. Items are not kept in order when the concurrency is
+     * above one.
+     *
+     * @tparam F Type of the function.
+     * @param name The name of the stage.
+     * @param function The function of the stage.
+     * @param options The options of the stage.
+     * @return PipelineOutput The results of the new stage.
+     * @throws std::logic_error if the pipeline started, or if these results already have a stage.
+     */
+    template <typename F>
+    auto then(std::string name, F function, StageOptions options = {});
+
+private:
+    PipelineCore* core;
+    std::shared_ptr<Link> link;
+
+    template <typename U>
+    struct IsExpected : std::false_type {};
+    template <typename U>
+    struct IsExpected<Expected<U>> : std::true_type {};
+    template <typename U>
+    struct ResultOf { using type = U; };
+    template <typename U>
+    struct ResultOf<Expected<U>> { using type = U; };
+};
+
+template <typename T>
+template <typename F>
+auto PipelineOutput<T>::then(std::string name, F function, StageOptions options) {
+    using Result = std::invoke_result_t<F&, T&&>;
+    using Out = typename ResultOf<Result>::type;
+    using NextLink = typename PipelineOutput<std::conditional_t<std::is_void_v<Out>, char, Out>>::Link;
+
+    if (core->started) {
+        TLS_CLIENT_THROW(std::logic_error("Stages must be added before the pipeline starts"));
+    }
+    if (link->next != nullptr) {
+        TLS_CLIENT_THROW(std::logic_error("Stage " + name + " has no input, the results already have a stage"));
+    }
+
+    auto nextLink = std::make_shared<NextLink>();
+    auto process = [function = std::move(function), nextLink](T&& item) mutable -> std::optional<Error> {
+        if constexpr (std::is_void_v<Result>) {
+            function(std::move(item));
+        } else if constexpr (IsExpected<Result>::value) {
+            Result result = function(std::move(item));
+            if (!result) {
+                return std::move(result.error());
+            }
+            if (nextLink->next != nullptr) {
+                nextLink->next->push(std::move(*result));
+            }
+        } else {
+            Result result = function(std::move(item));
+            if (nextLink->next != nullptr) {
+                nextLink->next->push(std::move(result));
+            }
+        }
+        return std::nullopt;
+    };
+
+    auto stage = std::make_unique<QueuedStage<T>>(std::move(name), options, std::move(process), core->onError);
+    stage->setOnDrained([nextLink]() {
+        if (nextLink->next != nullptr) {
+            nextLink->next->close();
+        }
+    });
+    link->next = &stage->input();
+    core->stages.push_back(std::move(stage));
+
+    if constexpr (std::is_void_v<Out>) {
+        return;
+    } else {
+        return PipelineOutput<Out>(*core, std::move(nextLink));
+    }
+}
+
+/**
+ * @brief BasicPipeline class running requests through a chain of stages.
+ *
+ * The first stage sends the pushed requests with the session; the stages added
+ * with then transform the responses, then the results of each other. Every stage
+ * has its own worker threads and bounded queue, so network-bound and CPU-bound
+ * work run side by side, and a slow stage holds back the ones before it instead
+ * of letting its queue grow:
+ *
+ * @code
+ * Pipeline pipeline(session, {16, 256});
+ * pipeline.then("parse", [](ResponseData&& response) { return parse(response.body); }, {4, 64})
+ *     .then("store", [&](Document&& document) { store.insert(document); });
+ *
+ * for (const RequestData& request : requests) {
+ *     pipeline.push(request);
+ * }
+ * pipeline.close();
+ * pipeline.wait();
+ * @endcode
+ *
+ * Failed requests (see Session::tryGET) and failed transforms are dropped and
+ * reported to the error handler. push, tryPush, close, wait and getStats are
+ * thread-safe; stages and the error handler must be set before the pipeline
+ * starts.
+ *
+ * @tparam Codec The JSON codec of the session.
+ */
+template <typename Codec>
+class BasicPipeline {
+public:
+    /**
+     * @brief Constructs the pipeline and its fetch stage.
+     *
+     * @param session The session sending the requests.
+     * @param fetchOptions The options of the fetch stage, whose concurrency is the number of requests in flight.
+     * @param method The HTTP method of the requests.
+     */
+    explicit BasicPipeline(BasicSession<Codec>& session, StageOptions fetchOptions = {}, std::string method = "GET");
+
+    BasicPipeline(const BasicPipeline&) = delete;
+    BasicPipeline& operator=(const BasicPipeline&) = delete;
+
+    /**
+     * @brief Destructor closing the pipeline and waiting for the items in it.
+     */
+    ~BasicPipeline() {
+        close();
+        wait();
+    }
+
+    /**
+     * @brief Adds a stage transforming the responses. See PipelineOutput::then.
+     */
+    template <typename F>
+    auto then(std::string name, F function, StageOptions options = {}) {
+        return responses.then(std::move(name), std::move(function), options);
+    }
+
+    /**
+     * @brief Sets the function called with the name of the stage and the error when an item fails.
+     *
+     * @param handler The error handler, called on the threads of the stage.
+     */
+    void onError(PipelineStage::ErrorHandler handler) { core->onError = std::move(handler); }
+
+    /**
+     * @brief Starts the worker threads of every stage. Called by the first push.
+     */
+    inline void start();
+
+    /**
+     * @brief Queues a request, waiting while the fetch stage is full.
+     *
+     * @param requestData The request to send.
+     * @return bool Whether the request was queued, false once the pipeline is closed.
+     */
+    inline bool push(RequestData requestData);
+
+    /**
+     * @brief Queues a request if the fetch stage has room.
+     *
+     * @param requestData The request to send, only moved from if it was queued.
+     * @return bool Whether the request was queued.
+     */
+    inline bool tryPush(RequestData& requestData);
+
+    /**
+     * @brief Closes the pipeline; the queued items still go through every stage.
+     */
+    void close() { fetchStage->close(); }
+
+    /**
+     * @brief Waits until every stage has drained. Requires close.
+     */
+    inline void wait();
+
+    /**
+     * @brief Returns the statistics of every stage, in order.
+     */
+    [[nodiscard]] inline std::vector<StageStats> getStats() const;
+
+private:
+    std::unique_ptr<PipelineCore> core;
+    QueuedStage<RequestData>* fetchStage;
+    PipelineOutput<ResponseData> responses;
+    std::once_flag startFlag;
+
+    /**
+     * @brief Sends a request with the given method.
+     */
+    [[nodiscard]] static inline Expected<ResponseData> send(BasicSession<Codec>& session, const std::string& method,
+        const RequestData& requestData);
+
+    /**
+     * @brief Creates the fetch stage in a new core and returns its results.
+     */
+    [[nodiscard]] static inline PipelineOutput<ResponseData> makeFetch(PipelineCore& core,
+        BasicSession<Codec>& session, StageOptions options, std::string method);
+};
+
+using Pipeline = BasicPipeline<TLS_CLIENT_JSON_CODEC>;
+
+template <typename Codec>
+BasicPipeline<Codec>::BasicPipeline(BasicSession<Codec>& session, StageOptions fetchOptions, std::string method)
+    : core(std::make_unique<PipelineCore>()),
+      fetchStage(nullptr),
+      responses(makeFetch(*core, session, fetchOptions, std::move(method))) {
+    fetchStage = static_cast<QueuedStage<RequestData>*>(core->stages.front().get());
+}
+
+template <typename Codec>
+void BasicPipeline<Codec>::start() {
+    std::call_once(startFlag, [this]() {
+        core->started = true;
+        for (auto& stage : core->stages) {
+            stage->start();
+        }
+    });
+}
+
+template <typename Codec>
+bool BasicPipeline<Codec>::push(RequestData requestData) {
+    start();
+    return fetchStage->input().push(std::move(requestData));
+}
+
+template <typename Codec>
+bool BasicPipeline<Codec>::tryPush(RequestData& requestData) {
+    start();
+    return fetchStage->input().tryPush(requestData);
+}
+
+template <typename Codec>
+void BasicPipeline<Codec>::wait() {
+    // Stages close the next one as they drain, so joining in order waits for everything
+    for (auto& stage : core->stages) {
+        stage->join();
+    }
+}
+
+template <typename Codec>
+std::vector<StageStats> BasicPipeline<Codec>::getStats() const {
+    std::vector<StageStats> stats;
+    stats.reserve(core->stages.size());
+    for (const auto& stage : core->stages) {
+        stats.push_back(stage->getStats());
+    }
+    return stats;
+}
+
+template <typename Codec>
+Expected<ResponseData> BasicPipeline<Codec>::send(BasicSession<Codec>& session, const std::string& method,
+    const RequestData& requestData) {
+    if (method == "GET") {
+        return session.tryGET(requestData);
+    } else if (method == "POST") {
+        return session.tryPOST(requestData);
+    } else if (method == "PUT") {
+        return session.tryPUT(requestData);
+    } else if (method == "DELETE") {
+        return session.tryDELETE(requestData);
+    } else if (method == "PATCH") {
+        return session.tryPATCH(requestData);
+    } else if (method == "HEAD") {
+        return session.tryHEAD(requestData);
+    } else if (method == "OPTIONS") {
+        return session.tryOPTIONS(requestData);
+    }
+    return Unexpected<Error>{{ErrorCode::Request, "Unsupported method " + method}};
+}
+
+template <typename Codec>
+PipelineOutput<ResponseData> BasicPipeline<Codec>::makeFetch(PipelineCore& core, BasicSession<Codec>& session,
+    StageOptions options, std::string method) {
+    auto link = std::make_shared<PipelineOutput<RequestData>::Link>();
+    PipelineOutput<RequestData> requests(core, link);
+
+    return requests.then("fetch", [&session, method = std::move(method)](RequestData&& requestData) {
+        return send(session, method, requestData);
+    }, options);
+}
@@ -0,0 +1,599 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client.hpp"
+
+#include <chrono>
+
+/**
+ * @brief TimerWheel class scheduling timers on a hierarchical timing wheel.
+ *
+ * Timers are identified by small integer ids and expire at an absolute tick.
+ * The wheel has four levels of 64 slots; level n covers delays up to 64^(n+1)
+ * ticks, and timers are moved one level down when the level above wraps. Scheduling
+ * and cancelling are O(1), and each timer is moved at most once per level.
+ * Delays longer than 64^4 ticks are parked in the last level and placed again
+ * until they fit.
+ *
+ * The wheel is not thread-safe.
+ */
+class TimerWheel {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX; /**< Marks a missing id. */
+
+    /**
+     * @brief Schedules a timer, replacing any pending deadline of the id.
+     *
+     * @param id The id of the timer.
+     * @param deadline The tick to expire at; past ticks expire on the next tick.
+     */
+    inline void schedule(uint32_t id, uint64_t deadline);
+
+    /**
+     * @brief Cancels a timer.
+     *
+     * @param id The id of the timer.
+     * @return bool Whether the timer was pending.
+     */
+    inline bool cancel(uint32_t id);
+
+    /**
+     * @brief Checks whether a timer is pending.
+     *
+     * @param id The id of the timer.
+     * @return bool Whether the timer is pending.
+     */
+    [[nodiscard]] bool pending(uint32_t id) const noexcept { return id < nodes.size() && nodes[id].slot != NONE; }
+
+    /**
+     * @brief Advances the wheel, expiring every timer due up to the given tick.
+     *
+     * Timers are expired in deadline order. The function may schedule timers again.
+     *
+     * @tparam F Type of the function.
+     * @param now The tick to advance to.
+     * @param expire The function called with the id of each expired timer.
+     */
+    template <typename F>
+    void advance(uint64_t now, F&& expire);
+
+    /**
+     * @brief Returns the tick the wheel was advanced to.
+     *
+     * @return uint64_t The current tick.
+     */
+    [[nodiscard]] uint64_t now() const noexcept { return current; }
+
+    /**
+     * @brief Returns the number of pending timers.
+     *
+     * @return size_t The number of timers.
+     */
+    [[nodiscard]] size_t size() const noexcept { return count; }
+
+private:
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+    static constexpr uint64_t MAX_DELAY = (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+
+    /**
+     * @brief Node struct linking a timer into the list of its slot.
+     */
+    struct Node {
+        uint32_t next = NONE;  /**< The next timer of the slot. */
+        uint32_t prev = NONE;  /**< The previous timer of the slot. */
+        uint32_t slot = NONE;  /**< The slot holding the timer, NONE if not pending. */
+        uint64_t deadline = 0; /**< The tick to expire at. */
+    };
+
+    std::vector<Node> nodes;     /**< The timers, indexed by id. */
+    std::array<uint32_t, LEVELS * SLOTS> heads = filledHeads(); /**< The first timer of each slot. */
+    std::vector<uint32_t> due;   /**< Timers expiring on the current tick. */
+    uint64_t current = 0;        /**< The current tick. */
+    size_t count = 0;            /**< The number of pending timers. */
+
+    static std::array<uint32_t, LEVELS * SLOTS> filledHeads() noexcept {
+        std::array<uint32_t, LEVELS * SLOTS> result{};
+        result.fill(NONE);
+        return result;
+    }
+
+    /**
+     * @brief Links a timer into the slot matching its deadline.
+     */
+    inline void link(uint32_t id);
+
+    /**
+     * @brief Unlinks a timer from its slot.
+     */
+    inline void unlink(uint32_t id);
+
+    /**
+     * @brief Moves the timers of a slot to the levels below.
+     */
+    inline void cascade(size_t level);
+};
+
+void TimerWheel::schedule(uint32_t id, uint64_t deadline) {
+    if (id >= nodes.size()) {
+        nodes.resize(static_cast<size_t>(id) + 1);
+    }
+    if (nodes[id].slot != NONE) {
+        unlink(id);
+    }
+
+    nodes[id].deadline = std::max(deadline, current + 1);
+    link(id);
+}
+
+bool TimerWheel::cancel(uint32_t id) {
+    if (!pending(id)) {
+        return false;
+    }
+    unlink(id);
+    return true;
+}
+
+template <typename F>
+void TimerWheel::advance(uint64_t now, F&& expire) {
+    while (current < now) {
+        if (count == 0) {
+            current = now;
+            return;
+        }
+
+        ++current;
+        for (size_t level = 1; level < LEVELS; ++level) {
+            if ((current & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+
+        // Detach the slot first, so expire may schedule and cancel freely
+        due.clear();
+        for (uint32_t id = heads[current & (SLOTS - 1)]; id != NONE; id = nodes[id].next) {
+            due.push_back(id);
+        }
+        for (uint32_t id : due) {
+            unlink(id);
+        }
+        for (uint32_t id : due) {
+            expire(id);
+        }
+    }
+}
+
+void TimerWheel::link(uint32_t id) {
+    Node& node = nodes[id];
+    uint64_t delay = node.deadline - current;
+    uint64_t deadline = delay > MAX_DELAY ? current + MAX_DELAY : node.deadline;
+
+    size_t level = 0;
+    while (level + 1 < LEVELS && (deadline - current) >= (uint64_t(1) << (SLOT_BITS * (level + 1)))) {
+        ++level;
+    }
+
+    uint32_t slot = static_cast<uint32_t>(level * SLOTS + ((deadline >> (SLOT_BITS * level)) & (SLOTS - 1)));
+    node.slot = slot;
+    node.prev = NONE;
+    node.next = heads[slot];
+    if (node.next != NONE) {
+        nodes[node.next].prev = id;
+    }
+    heads[slot] = id;
+    ++count;
+}
+
+void TimerWheel::unlink(uint32_t id) {
+    Node& node = nodes[id];
+    if (node.prev != NONE) {
+        nodes[node.prev].next = node.next;
+    } else {
+        heads[node.slot] = node.next;
+    }
+    if (node.next != NONE) {
+        nodes[node.next].prev = node.prev;
+    }
+
+    node.next = NONE;
+    node.prev = NONE;
+    node.slot = NONE;
+    --count;
+}
+
+void TimerWheel::cascade(size_t level) {
+    size_t slot = level * SLOTS + ((current >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+    uint32_t id = heads[slot];
+    while (id != NONE) {
+        uint32_t next = nodes[id].next;
+        unlink(id);
+        link(id);
+        id = next;
+    }
+}
+
+/**
+ * @brief PollOptions struct containing the options of a recurring poll.
+ */
+struct PollOptions {
+    /**
+     * @brief jitter field
+     *
+     * This field specifies the fraction of the interval every delay is randomly
+     * moved by, from 0 to 1. Jitter keeps polls of the same interval from
+     * hitting a host in lockstep.
+     */
+    double jitter = 0.1;
+
+    /**
+     * @brief immediate field
+     *
+     * This field specifies if the first poll runs right away. By default it runs
+     * at a random point of the first interval, so that bulk adds spread out.
+     */
+    bool immediate = false;
+
+    /**
+     * @brief onError field
+     *
+     * This optional field specifies a function called when a poll fails or
+     * returns a status other than 2xx and 304.
+     */
+    std::function<void(const RequestData&, const Error&)> onError;
+};
+
+/**
+ * @brief BasicPollScheduler class polling URLs on recurring intervals.
+ *
+ * Polls are kept on a TimerWheel driven by a single timer thread and run as
+ * GET requests on the given executor, so scheduling costs O(1) per poll
+ * whatever the number of URLs. Every poll after the first is conditional
+ * (If-None-Match / If-Modified-Since from the last ETag and Last-Modified
+ * headers), and the callback only fires when the body hash differs from the
+ * previous response: on the first response, and whenever the content changes.
+ * If a sink already set ResponseData::bodyHash (see BodyStore), it is reused.
+ *
+ * All public member functions are thread-safe. Callbacks run on the executor.
+ *
+ * @tparam Codec The JSON codec of the session.
+ */
+template <typename Codec>
+class BasicPollScheduler {
+public:
+    using PollId = uint64_t;
+    using Callback = std::function<void(const RequestData&, const ResponseData&)>;
+
+    /**
+     * @brief Constructs the scheduler.
+     *
+     * @param session The session performing the polls.
+     * @param executor The executor running the polls and callbacks.
+     * @param tick The resolution of the schedule.
+     */
+    BasicPollScheduler(BasicSession<Codec>& session, ThreadPool& executor,
+        std::chrono::milliseconds tick = std::chrono::milliseconds(100))
+        : session(session), executor(executor), tick(tick), epoch(std::chrono::steady_clock::now()) {}
+
+    BasicPollScheduler(const BasicPollScheduler&) = delete;
+    BasicPollScheduler& operator=(const BasicPollScheduler&) = delete;
+
+    /**
+     * @brief Destructor stopping the scheduler.
+     */
+    ~BasicPollScheduler() { stop(); }
+
+    /**
+     * @brief Adds a recurring poll.
+     *
+     * @param requestData The request data of the poll, sent as GET.
+     * @param interval The interval between polls.
+     * @param onChange The function called with every changed response.
+     * @param options The options of the poll.
+     * @return PollId The id of the poll.
+     */
+    inline PollId add(RequestData requestData, std::chrono::milliseconds interval, Callback onChange,
+        PollOptions options = {});
+
+    /**
+     * @brief Removes a poll. A poll in flight completes, but its callback no longer fires.
+     *
+     * @param id The id of the poll.
+     * @return bool Whether the poll existed.
+     */
+    inline bool remove(PollId id);
+
+    /**
+     * @brief Returns the number of polls.
+     *
+     * @return size_t The number of polls.
+     */
+    [[nodiscard]] inline size_t size() const;
+
+    /**
+     * @brief Starts the timer thread. Polls added before start are kept.
+     */
+    inline void start();
+
+    /**
+     * @brief Stops the timer thread and waits for polls in flight.
+     */
+    inline void stop();
+
+private:
+    /**
+     * @brief PollState struct containing a poll and its validators.
+     */
+    struct PollState {
+        RequestData requestData;               /**< The request data of the poll. */
+        std::chrono::milliseconds interval{0}; /**< The interval between polls. */
+        Callback onChange;                     /**< The change callback. */
+        PollOptions options;                   /**< The options of the poll. */
+        std::optional<std::string> etag;       /**< The last ETag header. */
+        std::optional<std::string> lastModified; /**< The last Last-Modified header. */
+        std::optional<uint64_t> bodyHash;      /**< The hash of the last body. */
+        uint32_t generation = 0;               /**< Incremented when the slot is freed. */
+        bool active = false;                   /**< Whether the slot holds a poll. */
+    };
+
+    BasicSession<Codec>& session;
+    ThreadPool& executor;
+    std::chrono::milliseconds tick;
+    std::chrono::steady_clock::time_point epoch; /**< Tick 0 of the wheel. */
+
+    mutable std::mutex mutex;                  /**< Guards every member below. */
+    std::condition_variable changed;           /**< Signaled on stop and when a poll completes. */
+    TimerWheel wheel;
+    std::vector<PollState> polls;              /**< The polls, indexed by wheel id. */
+    std::vector<uint32_t> freeSlots;           /**< Indexes of removed polls. */
+    size_t active = 0;                         /**< Number of polls. */
+    size_t inFlight = 0;                       /**< Number of polls on the executor. */
+    std::mt19937_64 random{std::random_device{}()};
+    std::thread timer;
+    bool stopping = false;
+
+    /**
+     * @brief Returns the number of ticks covering the given duration, at least one.
+     */
+    [[nodiscard]] uint64_t ticks(std::chrono::milliseconds duration) const noexcept {
+        return std::max<uint64_t>(1, static_cast<uint64_t>((duration + tick - std::chrono::milliseconds(1)) / tick));
+    }
+
+    /**
+     * @brief Schedules the next run of a poll, moved by its jitter. Requires the lock.
+     */
+    inline void reschedule(uint32_t index);
+
+    /**
+     * @brief Advances the wheel and dispatches due polls until stopped.
+     */
+    inline void run();
+
+    /**
+     * @brief Performs a poll on the executor.
+     */
+    inline void poll(uint32_t index, uint32_t generation);
+
+    /**
+     * @brief Sets a header of a JSON headers object, replacing any header with the same name.
+     */
+    [[nodiscard]] static inline std::string withHeader(const std::optional<std::string>& headers,
+        const std::string& name, const std::string& value);
+};
+
+using PollScheduler = BasicPollScheduler<TLS_CLIENT_JSON_CODEC>;
+
+template <typename Codec>
+typename BasicPollScheduler<Codec>::PollId BasicPollScheduler<Codec>::add(RequestData requestData,
+    std::chrono::milliseconds interval, Callback onChange, PollOptions options) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32_t index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        index = static_cast<uint32_t>(polls.size());
+        polls.emplace_back();
+    }
+
+    PollState& state = polls[index];
+    state.requestData = std::move(requestData);
+    state.interval = interval;
+    state.onChange = std::move(onChange);
+    state.options = std::move(options);
+    state.active = true;
+    ++active;
+
+    uint64_t delay = 0;
+    if (!state.options.immediate) {
+        delay = std::uniform_int_distribution<uint64_t>(0, ticks(interval) - 1)(random);
+    }
+    wheel.schedule(index, wheel.now() + delay);
+
+    return (static_cast<PollId>(state.generation) << 32) | index;
+}
+
+template <typename Codec>
+bool BasicPollScheduler<Codec>::remove(PollId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32_t index = static_cast<uint32_t>(id);
+    if (index >= polls.size() || !polls[index].active || polls[index].generation != (id >> 32)) {
+        return false;
+    }
+
+    wheel.cancel(index);
+    polls[index] = PollState{};
+    polls[index].generation = static_cast<uint32_t>(id >> 32) + 1;
+    freeSlots.push_back(index);
+    --active;
+    return true;
+}
+
+template <typename Codec>
+size_t BasicPollScheduler<Codec>::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return active;
+}
+
+template <typename Codec>
+void BasicPollScheduler<Codec>::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (timer.joinable()) {
+        return;
+    }
+    stopping = false;
+    timer = std::thread([this]() { run(); });
+}
+
+template <typename Codec>
+void BasicPollScheduler<Codec>::stop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    stopping = true;
+    changed.notify_all();
+
+    if (timer.joinable()) {
+        lock.unlock();
+        timer.join();
+        lock.lock();
+        timer = std::thread();
+    }
+    changed.wait(lock, [this]() { return inFlight == 0; });
+}
+
+template <typename Codec>
+void BasicPollScheduler<Codec>::reschedule(uint32_t index) {
+    PollState& state = polls[index];
+
+    double jitter = std::clamp(state.options.jitter, 0.0, 1.0);
+    double factor = std::uniform_real_distribution<double>(1.0 - jitter, 1.0 + jitter)(random);
+    auto delay = std::chrono::milliseconds(static_cast<int64_t>(static_cast<double>(state.interval.count()) * factor));
+
+    wheel.schedule(index, wheel.now() + ticks(delay));
+}
+
+template <typename Codec>
+void BasicPollScheduler<Codec>::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (!stopping) {
+        auto elapsed = std::chrono::steady_clock::now() - epoch;
+        uint64_t now = static_cast<uint64_t>(elapsed / tick);
+
+        wheel.advance(now, [this](uint32_t index) {
+            ++inFlight;
+            uint32_t generation = polls[index].generation;
+            executor.post([this, index, generation]() { poll(index, generation); });
+        });
+
+        changed.wait_until(lock, epoch + tick * (now + 1), [this]() { return stopping; });
+    }
+}
+
+template <typename Codec>
+void BasicPollScheduler<Codec>::poll(uint32_t index, uint32_t generation) {
+    RequestData requestData;
+    RequestData conditionalRequest;
+    Callback onChange;
+    std::function<void(const RequestData&, const Error&)> onError;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const PollState& state = polls[index];
+        if (state.active && state.generation == generation) {
+            requestData = state.requestData;
+            onChange = state.onChange;
+            onError = state.options.onError;
+
+            conditionalRequest = requestData;
+            if (state.etag) {
+                conditionalRequest.headers = withHeader(conditionalRequest.headers, "If-None-Match", *state.etag);
+            }
+            if (state.lastModified) {
+                conditionalRequest.headers = withHeader(conditionalRequest.headers, "If-Modified-Since",
+                    *state.lastModified);
+            }
+        }
+    }
+
+    if (onChange) {
+        Expected<ResponseData> response = session.tryGET(conditionalRequest);
+
+        if (!response) {
+            if (onError) {
+                onError(requestData, response.error());
+            }
+        } else if (response->statusCode >= 200 && response->statusCode < 300) {
+            if (!response->bodyHash) {
+                response->bodyHash = ContentHash::compute(response->decodeBody());
+            }
+
+            bool isChanged = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                PollState& state = polls[index];
+                if (state.active && state.generation == generation) {
+                    isChanged = state.bodyHash != response->bodyHash;
+                    state.bodyHash = response->bodyHash;
+                    state.etag = response->header("ETag");
+                    state.lastModified = response->header("Last-Modified");
+                }
+            }
+
+            if (isChanged) {
+                onChange(requestData, *response);
+            }
+        } else if (response->statusCode != 304 && onError) {
+            onError(requestData, {ErrorCode::Request, "unexpected status " + std::to_string(response->statusCode)});
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (polls[index].active && polls[index].generation == generation) {
+        reschedule(index);
+    }
+    --inFlight;
+    changed.notify_all();
+}
+
+template <typename Codec>
+std::string BasicPollScheduler<Codec>::withHeader(const std::optional<std::string>& headers,
+    const std::string& name, const std::string& value) {
+    auto equalsIgnoreCase = [](std::string_view lhs, std::string_view rhs) {
+        return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        });
+    };
+
+    // Keeps every other field as it is, dropping the ones this header replaces
+    std::string result = "{";
+    if (headers) {
+        std::string kept;
+        bool valid = JsonHelper::forEachRawField(*headers, [&](std::string_view key, std::string_view rawValue) {
+            std::string field;
+            JsonHelper::appendUnescaped(field, key);
+            if (!equalsIgnoreCase(field, name)) {
+                kept.append("\"").append(key).append("\":").append(rawValue).append(",");
+            }
+            return true;
+        });
+        if (valid) {
+            result += kept;
+        }
+    }
+
+    result.append("\"");
+    JsonHelper::appendEscaped(result, name);
+    result.append("\":\"");
+    JsonHelper::appendEscaped(result, value);
+    result.append("\"}");
+    return result;
+}
@@ -0,0 +1,280 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client.hpp"
+
+#include <chrono>
+
+/**
+ * @brief AddressStats struct containing the statistics of one local address of a session pool.
+ */
+struct AddressStats {
+    std::string address;          /**< The local address, as given to the pool. */
+    SessionStats session;         /**< The statistics of the session bound to the address. */
+    uint64_t inFlight = 0;        /**< Requests running now, each holding a connection. */
+    uint64_t peakInFlight = 0;    /**< The most requests that ran at once. */
+    double requestsPerSecond = 0; /**< Requests completed per second since the pool was created. */
+    double bytesPerSecond = 0;    /**< Bytes received per second since the pool was created. */
+};
+
+/**
+ * @brief BasicSessionPool class spreading requests over sessions bound to several local addresses.
+ *
+ * A host sees at most about 28k concurrent connections from one source
+ * address (the ephemeral port range), and origins often rate-limit per
+ * source address. The pool keeps one session per local address, created from
+ * the same session data with SessionData::localAddress set, and sends each
+ * request through the session with the fewest requests in flight, rotating
+ * between equally loaded ones.
+ *
+ * If the session data has a sessionId, every session gets its own id
+ * ("id@address"), since a library client is bound to one address.
+ *
+ * All public member functions are thread-safe.
+ *
+ * @tparam Codec The JSON codec of the sessions.
+ */
+template <typename Codec>
+class BasicSessionPool {
+public:
+    /**
+     * @brief Lease class holding one session of the pool for the duration of a request.
+     *
+     * The session counts as busy until the lease is destroyed.
+     */
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept : pool(std::exchange(other.pool, nullptr)), index(other.index) {}
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                release();
+                pool = std::exchange(other.pool, nullptr);
+                index = other.index;
+            }
+            return *this;
+        }
+        ~Lease() { release(); }
+
+        /**
+         * @brief Returns the leased session.
+         */
+        [[nodiscard]] BasicSession<Codec>& session() const noexcept { return *pool->entries[index]->session; }
+
+        /**
+         * @brief Returns the local address of the leased session, as given to the pool.
+         */
+        [[nodiscard]] const std::string& address() const noexcept { return pool->entries[index]->address; }
+
+    private:
+        friend class BasicSessionPool;
+
+        BasicSessionPool* pool;
+        size_t index;
+
+        Lease(BasicSessionPool* pool, size_t index) : pool(pool), index(index) {}
+
+        void release() noexcept {
+            if (pool) {
+                pool->entries[index]->inFlight.fetch_sub(1, std::memory_order_relaxed);
+                pool = nullptr;
+            }
+        }
+    };
+
+    /**
+     * @brief Constructs the pool.
+     *
+     * @param sessionData The session data of every session.
+     * @param localAddresses The local addresses to bind to, as "ip" or "ip:port"
+     * (IPv6 as "::1" or "[::1]:port"). Must not be empty.
+     * @throws std::invalid_argument If localAddresses is empty; use create without exceptions.
+     */
+    inline BasicSessionPool(const SessionData& sessionData, std::vector<std::string> localAddresses);
+
+    /**
+     * @brief Creates a pool without throwing.
+     *
+     * @param sessionData The session data of every session.
+     * @param localAddresses The local addresses to bind to, as for the constructor.
+     * @return Expected<std::unique_ptr<BasicSessionPool>> The pool, or an ErrorCode::Request
+     * error if localAddresses is empty.
+     */
+    [[nodiscard]] static inline Expected<std::unique_ptr<BasicSessionPool>> create(const SessionData& sessionData,
+        std::vector<std::string> localAddresses);
+
+    BasicSessionPool(const BasicSessionPool&) = delete;
+    BasicSessionPool& operator=(const BasicSessionPool&) = delete;
+
+    /**
+     * @brief Leases the session with the fewest requests in flight.
+     *
+     * @return Lease The lease of the session.
+     */
+    [[nodiscard]] inline Lease acquire();
+
+    /**
+     * @brief Sends a GET request through the least busy session.
+     *
+     * @param requestData The request data for the GET request.
+     * @return ResponseData The response from the GET request.
+     */
+    [[nodiscard]] ResponseData GET(const RequestData& requestData) { return acquire().session().GET(requestData); }
+
+    /**
+     * @brief Sends a POST request through the least busy session.
+     *
+     * @param requestData The request data for the POST request.
+     * @return ResponseData The response from the POST request.
+     */
+    [[nodiscard]] ResponseData POST(const RequestData& requestData) { return acquire().session().POST(requestData); }
+
+    /**
+     * @brief Sends a GET request through the least busy session without throwing.
+     *
+     * @param requestData The request data for the GET request.
+     * @return Expected<ResponseData> The response from the GET request, or the
+     * error that prevented it from completing.
+     */
+    [[nodiscard]] Expected<ResponseData> tryGET(const RequestData& requestData) {
+        return acquire().session().tryGET(requestData);
+    }
+
+    /**
+     * @brief Sends a POST request through the least busy session without throwing.
+     *
+     * @param requestData The request data for the POST request.
+     * @return Expected<ResponseData> The response from the POST request, or the
+     * error that prevented it from completing.
+     */
+    [[nodiscard]] Expected<ResponseData> tryPOST(const RequestData& requestData) {
+        return acquire().session().tryPOST(requestData);
+    }
+
+    /**
+     * @brief Returns the number of local addresses.
+     */
+    [[nodiscard]] size_t size() const noexcept { return entries.size(); }
+
+    /**
+     * @brief Returns the statistics of every local address, in the order given to the pool.
+     *
+     * @return std::vector<AddressStats> The statistics.
+     */
+    [[nodiscard]] inline std::vector<AddressStats> getStats() const;
+
+private:
+    /**
+     * @brief Entry struct holding the session of one local address.
+     */
+    struct Entry {
+        std::string address;
+        std::unique_ptr<BasicSession<Codec>> session;
+        std::atomic<uint64_t> inFlight{0};
+        std::atomic<uint64_t> peakInFlight{0};
+    };
+
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::atomic<size_t> cursor{0};               /**< Where the next scan starts, to rotate ties. */
+    std::chrono::steady_clock::time_point created;
+
+    /**
+     * @brief Returns an address as "ip:port", with port 0 if it has none.
+     */
+    [[nodiscard]] static inline std::string bindAddress(const std::string& address);
+};
+
+using SessionPool = BasicSessionPool<TLS_CLIENT_JSON_CODEC>;
+
+template <typename Codec>
+BasicSessionPool<Codec>::BasicSessionPool(const SessionData& sessionData, std::vector<std::string> localAddresses)
+    : created(std::chrono::steady_clock::now()) {
+    if (localAddresses.empty()) {
+        TLS_CLIENT_THROW(std::invalid_argument("A session pool needs at least one local address"));
+    }
+
+    for (std::string& address : localAddresses) {
+        SessionData config = sessionData;
+        config.localAddress = bindAddress(address);
+        if (config.sessionId) {
+            *config.sessionId += "@" + *config.localAddress;
+        }
+
+        auto entry = std::make_unique<Entry>();
+        entry->address = std::move(address);
+        entry->session = std::make_unique<BasicSession<Codec>>(std::move(config));
+        entries.push_back(std::move(entry));
+    }
+}
+
+template <typename Codec>
+Expected<std::unique_ptr<BasicSessionPool<Codec>>> BasicSessionPool<Codec>::create(const SessionData& sessionData,
+    std::vector<std::string> localAddresses) {
+    if (localAddresses.empty()) {
+        return Unexpected<Error>{{ErrorCode::Request, "A session pool needs at least one local address"}};
+    }
+    return std::make_unique<BasicSessionPool>(sessionData, std::move(localAddresses));
+}
+
+template <typename Codec>
+typename BasicSessionPool<Codec>::Lease BasicSessionPool<Codec>::acquire() {
+    size_t start = cursor.fetch_add(1, std::memory_order_relaxed);
+
+    // Concurrent scans may pick the same entry; the balance only has to be approximate
+    size_t best = start % entries.size();
+    uint64_t bestLoad = UINT64_MAX;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        size_t index = (start + i) % entries.size();
+        uint64_t load = entries[index]->inFlight.load(std::memory_order_relaxed);
+        if (load < bestLoad) {
+            best = index;
+            bestLoad = load;
+        }
+    }
+
+    Entry& entry = *entries[best];
+    uint64_t load = entry.inFlight.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint64_t peak = entry.peakInFlight.load(std::memory_order_relaxed);
+    while (peak < load && !entry.peakInFlight.compare_exchange_weak(peak, load, std::memory_order_relaxed)) {
+    }
+    return Lease(this, best);
+}
+
+template <typename Codec>
+std::vector<AddressStats> BasicSessionPool<Codec>::getStats() const {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - created).count();
+
+    std::vector<AddressStats> stats;
+    stats.reserve(entries.size());
+    for (const std::unique_ptr<Entry>& entry : entries) {
+        AddressStats address;
+        address.address = entry->address;
+        address.session = entry->session->getStats();
+        address.inFlight = entry->inFlight.load(std::memory_order_relaxed);
+        address.peakInFlight = entry->peakInFlight.load(std::memory_order_relaxed);
+        if (seconds > 0) {
+            address.requestsPerSecond = static_cast<double>(address.session.requests) / seconds;
+            address.bytesPerSecond = static_cast<double>(address.session.bytesReceived) / seconds;
+        }
+        stats.push_back(std::move(address));
+    }
+    return stats;
+}
+
+template <typename Codec>
+std::string BasicSessionPool<Codec>::bindAddress(const std::string& address) {
+    if (!address.empty() && address.front() == '[') {
+        return address.find("]:") == std::string::npos ? address + ":0" : address;
+    }
+
+    size_t colons = std::count(address.begin(), address.end(), ':');
+    if (colons > 1) {
+        return "[" + address + "]:0"; // A bare IPv6 address
+    }
+    return colons == 0 ? address + ":0" : address;
+}
@@ -0,0 +1,202 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client.hpp"
+
+/**
+ * @brief FingerprintProfile struct with the fingerprint fields of a compile-time profile, all unset.
+ *
+ * Derive a profile from it and redeclare the fields it sets, with the same
+ * names and formats as in SessionData:
+ *
+ * @code
+ * struct Chrome120Custom : FingerprintProfile {
+ *     static constexpr std::string_view ja3String = "771,4865-4866-4867-49195-49199,0-23-65281-10-11-35-16,29-23-24,0";
+ *     static constexpr std::string_view h2Settings = R"({"HEADER_TABLE_SIZE": 65536, "ENABLE_PUSH": 0})";
+ *     static constexpr std::string_view pseudoHeaderOrder = R"([":method", ":authority", ":scheme", ":path"])";
+ *     static constexpr std::optional<int> connectionFlow = 15663105;
+ * };
+ * @endcode
+ */
+struct FingerprintProfile {
+    static constexpr std::string_view ja3String{};
+    static constexpr std::string_view h2Settings{};
+    static constexpr std::string_view h2SettingsOrder{};
+    static constexpr std::string_view supportedSignatureAlgorithms{};
+    static constexpr std::string_view supportedVersions{};
+    static constexpr std::string_view keyShareCurves{};
+    static constexpr std::string_view certCompressionAlgo{};
+    static constexpr std::string_view pseudoHeaderOrder{};
+    static constexpr std::optional<int> connectionFlow{};
+    static constexpr std::string_view priorityFrames{};
+    static constexpr std::string_view headerOrder{};
+};
+
+/**
+ * @brief ProfileJson class generating the request envelope members of a profile at compile time.
+ *
+ * The members are written the way the codecs write SessionData: values that
+ * look like a JSON object or array are embedded as they are, and other
+ * strings are quoted. The result is a constant in read-only data, so it costs
+ * nothing at startup and is shared by every session of the profile.
+ *
+ * @tparam Profile The profile, derived from FingerprintProfile.
+ */
+template <typename Profile>
+class ProfileJson {
+private:
+    /**
+     * @brief Writer struct counting, or writing if it has a buffer, the characters of the members.
+     */
+    struct Writer {
+        char* data = nullptr;
+        size_t length = 0;
+
+        constexpr void put(char ch) {
+            if (data) {
+                data[length] = ch;
+            }
+            ++length;
+        }
+
+        constexpr void put(std::string_view text) {
+            for (char ch : text) {
+                put(ch);
+            }
+        }
+    };
+
+    static constexpr void writeMember(Writer& writer, std::string_view name, std::string_view value) {
+        if (value.empty()) {
+            return;
+        }
+        if (writer.length > 0) {
+            writer.put(", ");
+        }
+        writer.put('"');
+        writer.put(name);
+        writer.put("\": ");
+
+        if (JsonHelper::isRawField(name, value)) {
+            writer.put(value);
+            return;
+        }
+
+        constexpr std::string_view HEX = "0123456789abcdef";
+        writer.put('"');
+        for (char ch : value) {
+            if (ch == '"' || ch == '\\') {
+                writer.put('\\');
+                writer.put(ch);
+            } else if (static_cast<unsigned char>(ch) < 0x20) {
+                writer.put("\\u00");
+                writer.put(HEX[static_cast<unsigned char>(ch) >> 4]);
+                writer.put(HEX[ch & 0xF]);
+            } else {
+                writer.put(ch);
+            }
+        }
+        writer.put('"');
+    }
+
+    static constexpr void writeMember(Writer& writer, std::string_view name, std::optional<int> value) {
+        if (!value) {
+            return;
+        }
+        if (writer.length > 0) {
+            writer.put(", ");
+        }
+        writer.put('"');
+        writer.put(name);
+        writer.put("\": ");
+
+        long long number = *value;
+        if (number < 0) {
+            writer.put('-');
+            number = -number;
+        }
+        char digits[20] = {};
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + number % 10);
+            number /= 10;
+        } while (number > 0);
+        while (count > 0) {
+            writer.put(digits[--count]);
+        }
+    }
+
+    static constexpr void write(Writer& writer) {
+        writeMember(writer, "ja3String", Profile::ja3String);
+        writeMember(writer, "h2Settings", Profile::h2Settings);
+        writeMember(writer, "h2SettingsOrder", Profile::h2SettingsOrder);
+        writeMember(writer, "supportedSignatureAlgorithms", Profile::supportedSignatureAlgorithms);
+        writeMember(writer, "supportedVersions", Profile::supportedVersions);
+        writeMember(writer, "keyShareCurves", Profile::keyShareCurves);
+        writeMember(writer, "certCompressionAlgo", Profile::certCompressionAlgo);
+        writeMember(writer, "pseudoHeaderOrder", Profile::pseudoHeaderOrder);
+        writeMember(writer, "connectionFlow", Profile::connectionFlow);
+        writeMember(writer, "priorityFrames", Profile::priorityFrames);
+        writeMember(writer, "headerOrder", Profile::headerOrder);
+    }
+
+    static constexpr size_t LENGTH = [] {
+        Writer writer;
+        write(writer);
+        return writer.length;
+    }();
+
+    static constexpr std::array<char, LENGTH + 1> DATA = [] {
+        std::array<char, LENGTH + 1> data{};
+        Writer writer{data.data()};
+        write(writer);
+        return data;
+    }();
+
+public:
+    /**
+     * @brief The members, separated by ", ", without braces.
+     */
+    static constexpr std::string_view members{DATA.data(), LENGTH};
+};
+
+/**
+ * @brief ProfileSession class for sessions whose fingerprint is a compile-time profile.
+ *
+ * The session data keeps only a view of the members generated by ProfileJson,
+ * instead of a copy of every fingerprint string per session, which matters
+ * when many sessions share one fingerprint:
+ *
+ * @code
+ * ProfileSession<Chrome120Custom> session(sessionData);
+ * @endcode
+ *
+ * The fingerprint fields of the session data are ignored, and setSessionData
+ * keeps the profile, also when called through a BasicSession reference.
+ *
+ * @tparam Profile The profile, derived from FingerprintProfile.
+ * @tparam Codec The JSON codec of the session.
+ */
+template <typename Profile, typename Codec = TLS_CLIENT_JSON_CODEC>
+class ProfileSession : public BasicSession<Codec> {
+public:
+    /**
+     * @brief Constructor to initialize the session with provided session data.
+     *
+     * @param sessionData The session data to initialize the session with.
+     */
+    explicit ProfileSession(SessionData sessionData = SessionData())
+        : BasicSession<Codec>(withProfile(std::move(sessionData))) {}
+
+private:
+    static SessionData withProfile(SessionData sessionData) {
+        sessionData.profile = ProfileJson<Profile>::members;
+        return sessionData;
+    }
+};
@@ -0,0 +1,620 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "tls_client.hpp"
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+
+#if defined(TLS_CLIENT_HAS_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(TLS_CLIENT_HAS_ZSTD)
+#include <zstd.h>
+#endif
+
+/**
+ * @brief WarcCompression enum describing how WARC records are compressed.
+ */
+enum class WarcCompression {
+    None, /**< Plain `.warc` files. */
+    Gzip, /**< One gzip member per record (`.warc.gz`), requires zlib. */
+    Zstd  /**< One zstd frame per record (`.warc.zst`), requires zstd. */
+};
+
+/**
+ * @brief WarcOptions struct containing the options of a WARC writer.
+ */
+struct WarcOptions {
+    /**
+     * @brief directory field
+     *
+     * This field specifies the directory the WARC and CDX files are written to.
+     */
+    std::string directory = ".";
+
+    /**
+     * @brief prefix field
+     *
+     * This field specifies the start of the file names, followed by the
+     * creation time and a serial number.
+     */
+    std::string prefix = "tls-client";
+
+    /**
+     * @brief compression field
+     *
+     * This field specifies the compression of the records.
+     */
+    WarcCompression compression = WarcCompression::Gzip;
+
+    /**
+     * @brief compressionLevel field
+     *
+     * This optional field specifies the level of the compressor, its default if not set.
+     */
+    std::optional<int> compressionLevel;
+
+    /**
+     * @brief compressionThreads field
+     *
+     * This field specifies the number of background threads compressing records.
+     */
+    size_t compressionThreads = 2;
+
+    /**
+     * @brief maxFileSize field
+     *
+     * This field specifies the size after which a new WARC file is started.
+     */
+    size_t maxFileSize = size_t(1) << 30;
+
+    /**
+     * @brief batchSize field
+     *
+     * This field specifies the number of compressed bytes collected before they
+     * are written to the file.
+     */
+    size_t batchSize = size_t(4) << 20;
+
+    /**
+     * @brief maxPendingRecords field
+     *
+     * This field specifies the number of records waiting for compression after
+     * which consume blocks, bounding the memory held by the writer.
+     */
+    size_t maxPendingRecords = 1024;
+
+    /**
+     * @brief cdx field
+     *
+     * This field specifies if a CDX index is written next to each WARC file.
+     */
+    bool cdx = true;
+};
+
+/**
+ * @brief WarcWriter class archiving responses as WARC 1.1 files.
+ *
+ * Registered as a sink (see SessionData::sinks), the writer stores every
+ * completed response as a `request` and a `response` record. Records are
+ * serialized on the calling thread, compressed on a background ThreadPool,
+ * and appended to the current file in batches. Compressed records are
+ * written in completion order, each as an independent gzip member or zstd
+ * frame, so every record can be read from its offset alone.
+ *
+ * Files are rotated once they reach WarcOptions::maxFileSize, and each starts
+ * with a `warcinfo` record. Next to each file, a CDX index (" CDX N b a m s k r M S V g")
+ * sorted by URL key is written by flush() and when the file is closed.
+ *
+ * The library returns decoded bodies, so the Content-Encoding, Transfer-Encoding
+ * and Content-Length headers of a response are kept as `X-Archive-Orig-*`
+ * headers and a Content-Length matching the stored body is added.
+ *
+ * The writer is thread-safe. Write errors are kept and reported by flush() and
+ * close(). Keep a handle to the writer and close it once the crawl is over: the
+ * sessions it is registered with may hold it longer than expected.
+ */
+class WarcWriter : public ResponseSink {
+public:
+    /**
+     * @brief Opens the first WARC file.
+     *
+     * @param options The options of the writer.
+     * @return Expected<std::shared_ptr<WarcWriter>> The writer, or an ErrorCode::Io error if the
+     * file cannot be created or an ErrorCode::Library error if the compression is not available.
+     */
+    [[nodiscard]] static inline Expected<std::shared_ptr<WarcWriter>> open(WarcOptions options);
+
+    WarcWriter(const WarcWriter&) = delete;
+    WarcWriter& operator=(const WarcWriter&) = delete;
+
+    /**
+     * @brief Destructor writing the pending records and closing the files.
+     */
+    inline ~WarcWriter() override;
+
+    /**
+     * @brief Archives a completed response.
+     */
+    inline void consume(const RequestData& requestData, const std::string& method,
+        ResponseData& responseData) override;
+
+    /**
+     * @brief Waits for the pending records and writes them to the file.
+     *
+     * @return std::optional<Error> The first write error since the last flush, or nothing.
+     */
+    inline std::optional<Error> flush();
+
+    /**
+     * @brief Waits for the pending records, writes them and the CDX index, and closes the file.
+     *
+     * Responses passed to the writer afterwards are not archived.
+     *
+     * @return std::optional<Error> The first write error since the last flush, or nothing.
+     */
+    inline std::optional<Error> close();
+
+    /**
+     * @brief Returns the paths of the WARC files written so far, including the current one.
+     *
+     * @return std::vector<std::string> The paths of the files.
+     */
+    [[nodiscard]] inline std::vector<std::string> files() const;
+
+    /**
+     * @brief Returns the SURT form of a URL used as CDX key.
+     *
+     * @param url The URL.
+     * @return std::string The key, e.g. `com,example)/path?q` for `https://www.example.com/path?q`.
+     */
+    [[nodiscard]] static inline std::string surt(std::string_view url);
+
+private:
+    /**
+     * @brief CdxEntry struct describing a response record of the current file.
+     */
+    struct CdxEntry {
+        std::string key;      /**< The SURT of the URL. */
+        std::string line;     /**< The fields from the timestamp to the robot flags. */
+        uint64_t offset = 0;  /**< The offset of the record in the file. */
+        uint64_t length = 0;  /**< The compressed length of the record. */
+    };
+
+    WarcOptions options;
+    std::unique_ptr<ThreadPool> pool; /**< The compression threads. */
+
+    mutable std::mutex mutex;         /**< Guards every member below. */
+    std::condition_variable drained;  /**< Signaled when a record is written. */
+    size_t pending = 0;               /**< Records handed to the pool and not yet written. */
+    std::ofstream file;               /**< The current WARC file. */
+    std::string path;                 /**< The path of the current WARC file. */
+    std::vector<std::string> paths;   /**< The paths of every WARC file. */
+    uint64_t fileSize = 0;            /**< Bytes written to the current file, including the batch. */
+    std::string batch;                /**< Compressed records not yet written. */
+    std::vector<CdxEntry> cdxEntries; /**< The CDX entries of the current file. */
+    size_t serial = 0;                /**< Number of files started. */
+    bool closed = false;              /**< Whether close() was called. */
+    std::optional<Error> error;       /**< The first write error. */
+
+    explicit WarcWriter(WarcOptions options) : options(std::move(options)) {}
+
+    /**
+     * @brief Starts a new file and writes its warcinfo record. Requires the lock.
+     */
+    inline std::optional<Error> startFile();
+
+    /**
+     * @brief Writes the batch and CDX index and closes the current file. Requires the lock.
+     */
+    inline void finishFile();
+
+    /**
+     * @brief Writes the CDX index of the current file, as far as it is written. Requires the lock.
+     */
+    inline void writeCdx();
+
+    /**
+     * @brief Writes the batch to the current file. Requires the lock.
+     */
+    inline void writeBatch();
+
+    /**
+     * @brief Appends a compressed record to the batch, rotating the file if needed. Requires the lock.
+     */
+    inline void append(const std::string& record, std::optional<CdxEntry> cdxEntry);
+
+    /**
+     * @brief Compresses a record as configured.
+     */
+    [[nodiscard]] inline std::string compress(const std::string& record) const;
+
+    /**
+     * @brief Builds a WARC record from its type-specific header fields and block.
+     */
+    [[nodiscard]] static inline std::string record(const std::string& type, const std::string& id,
+        const std::string& date, const std::string& fields, std::string_view block);
+
+    [[nodiscard]] static inline std::string requestBlock(const RequestData& requestData, const std::string& method);
+    [[nodiscard]] static inline std::string responseBlock(const ResponseData& responseData);
+    [[nodiscard]] static inline std::string recordId();
+    [[nodiscard]] static inline std::string timestamp(std::time_t time, const char* format);
+};
+
+Expected<std::shared_ptr<WarcWriter>> WarcWriter::open(WarcOptions options) {
+#if !defined(TLS_CLIENT_HAS_ZLIB)
+    if (options.compression == WarcCompression::Gzip) {
+        return Unexpected<Error>{{ErrorCode::Library, "gzip compression requires zlib (TLS_CLIENT_HAS_ZLIB)"}};
+    }
+#endif
+#if !defined(TLS_CLIENT_HAS_ZSTD)
+    if (options.compression == WarcCompression::Zstd) {
+        return Unexpected<Error>{{ErrorCode::Library, "zstd compression requires zstd (TLS_CLIENT_HAS_ZSTD)"}};
+    }
+#endif
+
+    std::shared_ptr<WarcWriter> writer(new WarcWriter(std::move(options)));
+    writer->pool = std::make_unique<ThreadPool>(writer->options.compressionThreads);
+
+    std::lock_guard<std::mutex> lock(writer->mutex);
+    if (std::optional<Error> error = writer->startFile()) {
+        return Unexpected<Error>{std::move(*error)};
+    }
+    return writer;
+}
+
+WarcWriter::~WarcWriter() {
+    pool.reset();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    finishFile();
+}
+
+void WarcWriter::consume(const RequestData& requestData, const std::string& method, ResponseData& responseData) {
+    std::time_t now = std::time(nullptr);
+    std::string date = timestamp(now, "%Y-%m-%dT%H:%M:%SZ");
+    std::string requestId = recordId();
+    std::string responseId = recordId();
+    std::string target = "WARC-Target-URI: " + requestData.url + "\r\n";
+
+    // Serialize on the calling thread, which owns the request and response
+    std::string requestRecord = record("request", requestId, date,
+        target + "WARC-Concurrent-To: " + responseId + "\r\nContent-Type: application/http;msgtype=request\r\n",
+        requestBlock(requestData, method));
+    std::string responseRecord = record("response", responseId, date,
+        target + "Content-Type: application/http;msgtype=response\r\n", responseBlock(responseData));
+
+    CdxEntry cdxEntry;
+    if (options.cdx) {
+        std::string mime = responseData.header("Content-Type").value_or("-");
+        mime = mime.substr(0, mime.find(';'));
+        mime.erase(std::remove_if(mime.begin(), mime.end(), [](unsigned char ch) { return std::isspace(ch); }),
+            mime.end());
+
+        cdxEntry.key = surt(requestData.url);
+        cdxEntry.line = timestamp(now, "%Y%m%d%H%M%S") + " " + requestData.url + " " + (mime.empty() ? "-" : mime) + " " +
+            std::to_string(responseData.statusCode) + " - " + responseData.header("Location").value_or("-") + " -";
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [this]() { return pending < options.maxPendingRecords; });
+        if (closed) {
+            return;
+        }
+        pending += 1;
+    }
+
+    pool->post([this, responseRecord = std::move(responseRecord), requestRecord = std::move(requestRecord),
+                   cdxEntry = std::move(cdxEntry)]() mutable {
+        std::string compressedResponse = compress(responseRecord);
+        std::string compressedRequest = compress(requestRecord);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        append(compressedResponse, options.cdx ? std::optional<CdxEntry>(std::move(cdxEntry)) : std::nullopt);
+        append(compressedRequest, std::nullopt);
+        pending -= 1;
+        drained.notify_all();
+    });
+}
+
+std::optional<Error> WarcWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    drained.wait(lock, [this]() { return pending == 0; });
+
+    writeBatch();
+    if (file.is_open()) {
+        file.flush();
+        writeCdx();
+    }
+
+    std::optional<Error> result = std::move(error);
+    error.reset();
+    return result;
+}
+
+std::optional<Error> WarcWriter::close() {
+    std::unique_lock<std::mutex> lock(mutex);
+    closed = true;
+    drained.wait(lock, [this]() { return pending == 0; });
+
+    finishFile();
+
+    std::optional<Error> result = std::move(error);
+    error.reset();
+    return result;
+}
+
+std::vector<std::string> WarcWriter::files() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return paths;
+}
+
+std::string WarcWriter::surt(std::string_view url) {
+    UrlView view = UrlView::parse(url);
+
+    std::string host = view.authority();
+    std::string port;
+    if (size_t colon = host.rfind(':'); colon != std::string::npos && host.find(']', colon) == std::string::npos) {
+        port = host.substr(colon);
+        host.resize(colon);
+    }
+    if (host.compare(0, 4, "www.") == 0) {
+        host.erase(0, 4);
+    }
+
+    // Reverse the labels of the host: sub.example.com becomes com,example,sub
+    std::string key;
+    for (size_t position = host.size(); position != std::string::npos;) {
+        size_t dot = position == 0 ? std::string::npos : host.rfind('.', position - 1);
+        size_t labelStart = dot == std::string::npos ? 0 : dot + 1;
+        key += host.substr(labelStart, position - labelStart);
+        key += dot == std::string::npos ? "" : ",";
+        position = dot;
+    }
+
+    key += port + ")";
+    for (char ch : view.requestTarget()) {
+        key += static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    }
+    return key;
+}
+
+std::optional<Error> WarcWriter::startFile() {
+    const char* extension = options.compression == WarcCompression::Gzip ? ".warc.gz"
+        : options.compression == WarcCompression::Zstd ? ".warc.zst" : ".warc";
+
+    std::ostringstream name;
+    std::time_t now = std::time(nullptr);
+    name << options.prefix << "-" << timestamp(now, "%Y%m%d%H%M%S") << "-" << std::setw(5) << std::setfill('0')
+         << serial++ << extension;
+    path = (std::filesystem::path(options.directory) / name.str()).string();
+
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return Error{ErrorCode::Io, "failed to create " + path};
+    }
+    paths.push_back(path);
+    fileSize = 0;
+
+    std::string info = "software: tls-client-cpp\r\nformat: WARC File Format 1.1\r\n"
+        "conformsTo: https://iipc.github.io/warc-specifications/specifications/warc-format/warc-1.1/\r\n";
+    std::string filename = std::filesystem::path(path).filename().string();
+    append(compress(record("warcinfo", recordId(), timestamp(now, "%Y-%m-%dT%H:%M:%SZ"),
+        "WARC-Filename: " + filename + "\r\nContent-Type: application/warc-fields\r\n", info)), std::nullopt);
+    return std::nullopt;
+}
+
+void WarcWriter::finishFile() {
+    if (!file.is_open()) {
+        return;
+    }
+
+    writeBatch();
+    file.close();
+    writeCdx();
+    cdxEntries.clear();
+}
+
+void WarcWriter::writeCdx() {
+    if (options.cdx) {
+        std::sort(cdxEntries.begin(), cdxEntries.end(), [](const CdxEntry& lhs, const CdxEntry& rhs) {
+            return std::tie(lhs.key, lhs.line) < std::tie(rhs.key, rhs.line);
+        });
+
+        std::string filename = std::filesystem::path(path).filename().string();
+        std::string cdxPath = path.substr(0, path.find(".warc", path.size() - filename.size())) + ".cdx";
+
+        std::ofstream cdx(cdxPath, std::ios::binary | std::ios::trunc);
+        cdx << " CDX N b a m s k r M S V g\n";
+        for (const CdxEntry& entry : cdxEntries) {
+            cdx << entry.key << ' ' << entry.line << ' ' << entry.length << ' ' << entry.offset << ' '
+                << filename << '\n';
+        }
+        if (!cdx && !error) {
+            error = Error{ErrorCode::Io, "failed to write " + cdxPath};
+        }
+    }
+}
+
+void WarcWriter::writeBatch() {
+    if (batch.empty() || !file.is_open()) {
+        return;
+    }
+
+    file.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+    if (!file && !error) {
+        error = Error{ErrorCode::Io, "failed to write " + path};
+    }
+    batch.clear();
+}
+
+void WarcWriter::append(const std::string& record, std::optional<CdxEntry> cdxEntry) {
+    if (fileSize > 0 && fileSize + record.size() > options.maxFileSize) {
+        finishFile();
+        if (std::optional<Error> startError = startFile()) {
+            if (!error) {
+                error = std::move(startError);
+            }
+            return;
+        }
+    }
+
+    if (cdxEntry) {
+        cdxEntry->offset = fileSize;
+        cdxEntry->length = record.size();
+        cdxEntries.push_back(std::move(*cdxEntry));
+    }
+
+    batch += record;
+    fileSize += record.size();
+    if (batch.size() >= options.batchSize) {
+        writeBatch();
+    }
+}
+
+std::string WarcWriter::compress(const std::string& record) const {
+#if defined(TLS_CLIENT_HAS_ZLIB)
+    if (options.compression == WarcCompression::Gzip) {
+        z_stream stream{};
+        // 16 added to the window bits selects the gzip format
+        if (deflateInit2(&stream, options.compressionLevel.value_or(Z_DEFAULT_COMPRESSION), Z_DEFLATED, 15 + 16, 8,
+                Z_DEFAULT_STRATEGY) != Z_OK) {
+            return record;
+        }
+
+        std::string output(deflateBound(&stream, static_cast<uLong>(record.size())), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(record.data()));
+        stream.avail_in = static_cast<uInt>(record.size());
+        stream.next_out = reinterpret_cast<Bytef*>(output.data());
+        stream.avail_out = static_cast<uInt>(output.size());
+
+        int result = deflate(&stream, Z_FINISH);
+        output.resize(stream.total_out);
+        deflateEnd(&stream);
+        return result == Z_STREAM_END ? output : record;
+    }
+#endif
+
+#if defined(TLS_CLIENT_HAS_ZSTD)
+    if (options.compression == WarcCompression::Zstd) {
+        std::string output(ZSTD_compressBound(record.size()), '\0');
+        size_t size = ZSTD_compress(output.data(), output.size(), record.data(), record.size(),
+            options.compressionLevel.value_or(ZSTD_CLEVEL_DEFAULT));
+        if (ZSTD_isError(size)) {
+            return record;
+        }
+        output.resize(size);
+        return output;
+    }
+#endif
+
+    return record;
+}
+
+std::string WarcWriter::record(const std::string& type, const std::string& id, const std::string& date,
+    const std::string& fields, std::string_view block) {
+    std::string result;
+    result.reserve(256 + fields.size() + block.size());
+    result += "WARC/1.1\r\nWARC-Type: " + type + "\r\nWARC-Record-ID: " + id + "\r\nWARC-Date: " + date + "\r\n";
+    result += fields;
+    result += "Content-Length: " + std::to_string(block.size()) + "\r\n\r\n";
+    result += block;
+    result += "\r\n\r\n";
+    return result;
+}
+
+std::string WarcWriter::requestBlock(const RequestData& requestData, const std::string& method) {
+    UrlView view = UrlView::parse(requestData.url);
+
+    std::string block = method + " " + view.requestTarget() + " HTTP/1.1\r\nHost: " + view.authority() + "\r\n";
+    if (requestData.headers) {
+        JsonHelper::forEachField(*requestData.headers, [&block](std::string_view name, std::string value) {
+            block.append(name.data(), name.size()).append(": ").append(value).append("\r\n");
+            return true;
+        });
+    }
+    block += "\r\n";
+    if (requestData.data) {
+        block += *requestData.data;
+    }
+    return block;
+}
+
+std::string WarcWriter::responseBlock(const ResponseData& responseData) {
+    static const std::unordered_map<int, const char*> reasons = {
+        {200, "OK"}, {201, "Created"}, {202, "Accepted"}, {204, "No Content"}, {206, "Partial Content"},
+        {301, "Moved Permanently"}, {302, "Found"}, {303, "See Other"}, {304, "Not Modified"},
+        {307, "Temporary Redirect"}, {308, "Permanent Redirect"}, {400, "Bad Request"}, {401, "Unauthorized"},
+        {403, "Forbidden"}, {404, "Not Found"}, {405, "Method Not Allowed"}, {410, "Gone"},
+        {429, "Too Many Requests"}, {500, "Internal Server Error"}, {502, "Bad Gateway"},
+        {503, "Service Unavailable"}, {504, "Gateway Timeout"},
+    };
+
+    auto reason = reasons.find(responseData.statusCode);
+    // The body keeps the JSON escape sequences of the library response, the record holds the payload as sent
+    std::string body = responseData.decodeBody();
+
+    std::string block;
+    block.reserve(512 + responseData.headers.size() + body.size());
+    block += "HTTP/1.1 " + std::to_string(responseData.statusCode) + " " +
+        (reason != reasons.end() ? reason->second : "") + "\r\n";
+
+    JsonHelper::forEachField(responseData.headers, [&block](std::string_view name, std::string value) {
+        auto equalsIgnoreCase = [name](std::string_view other) {
+            return name.size() == other.size() && std::equal(name.begin(), name.end(), other.begin(),
+                [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); });
+        };
+
+        if (equalsIgnoreCase("Content-Encoding") || equalsIgnoreCase("Transfer-Encoding") ||
+            equalsIgnoreCase("Content-Length")) {
+            block += "X-Archive-Orig-";
+        }
+        block.append(name.data(), name.size()).append(": ").append(value).append("\r\n");
+        return true;
+    });
+
+    block += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    block += body;
+    return block;
+}
+
+std::string WarcWriter::recordId() {
+    thread_local std::mt19937_64 random{std::random_device{}()};
+    uint64_t high = random();
+    uint64_t low = random();
+
+    // Version 4 and variant 1 bits of a random UUID
+    high = (high & 0xFFFFFFFFFFFF0FFFULL) | 0x0000000000004000ULL;
+    low = (low & 0x3FFFFFFFFFFFFFFFULL) | 0x8000000000000000ULL;
+
+    char uuid[64];
+    std::snprintf(uuid, sizeof(uuid), "<urn:uuid:%08x-%04x-%04x-%04x-%012llx>",
+        static_cast<unsigned>(high >> 32), static_cast<unsigned>((high >> 16) & 0xFFFF),
+        static_cast<unsigned>(high & 0xFFFF), static_cast<unsigned>(low >> 48),
+        static_cast<unsigned long long>(low & 0xFFFFFFFFFFFFULL));
+    return uuid;
+}
+
+std::string WarcWriter::timestamp(std::time_t time, const char* format) {
+    std::tm utc{};
+#if defined(OS_WIN)
+    gmtime_s(&utc, &time);
+#else
+    gmtime_r(&time, &utc);
+#endif
+
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), format, &utc);
+    return buffer;
+}
@@ -0,0 +1,160 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <fstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client.hpp"
+
+TEST(ContentHashTest, TestKnownValues) {
+    // Reference values of XXH3_64bits from the xxHash library
+    ASSERT_EQ(ContentHash::compute(""), 0x2D06800538D394C2ULL);
+    ASSERT_EQ(ContentHash::compute("a"), 0xE6C632B61E964E1FULL);
+    ASSERT_EQ(ContentHash::compute("Hello, world!"), 0xF3C34BF11915E869ULL);
+    ASSERT_EQ(ContentHash::compute(std::string(100, 'x')), 0xC90984FFDF50CE42ULL);
+    ASSERT_EQ(ContentHash::compute(std::string(200, 'x')), 0x50EF124FB1E4DE53ULL);
+    ASSERT_EQ(ContentHash::compute(std::string(5000, 'x')), 0x8D8567CBC9EE3D90ULL);
+}
+
+#if defined(OS_LINUX) || defined(OS_APPLE)
+#include "../include/tls_client_body_store.hpp"
+
+class BodyStoreTest : public ::testing::Test {
+protected:
+    std::string directory;
+
+    void SetUp() override {
+        const ::testing::TestInfo* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        directory = (std::filesystem::temp_directory_path() / ("tls-client-body-store-" + std::string(info->name()))).string();
+        std::filesystem::remove_all(directory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+};
+
+TEST_F(BodyStoreTest, TestDeduplication) {
+    Expected<std::shared_ptr<BodyStore>> store = BodyStore::open(directory);
+    ASSERT_TRUE(store) << store.error().message;
+
+    Expected<BodyStore::PutResult> first = (*store)->put("<html>unchanged</html>");
+    Expected<BodyStore::PutResult> second = (*store)->put("<html>unchanged</html>");
+    Expected<BodyStore::PutResult> third = (*store)->put("<html>changed</html>");
+
+    ASSERT_TRUE(first && second && third);
+    ASSERT_TRUE(first->inserted);
+    ASSERT_FALSE(second->inserted);
+    ASSERT_TRUE(third->inserted);
+    ASSERT_EQ(first->hash, second->hash);
+    ASSERT_NE(first->hash, third->hash);
+    ASSERT_EQ((*store)->size(), 2u);
+    ASSERT_EQ(std::filesystem::file_size(directory + "/bodies.dat"),
+        std::string("<html>unchanged</html><html>changed</html>").size());
+
+    ASSERT_EQ((*store)->get(first->hash), "<html>unchanged</html>");
+    ASSERT_EQ((*store)->get(third->hash), "<html>changed</html>");
+    ASSERT_FALSE((*store)->get(first->hash ^ 1));
+}
+
+TEST_F(BodyStoreTest, TestReopenAndGrow) {
+    std::vector<uint64_t> hashes;
+    {
+        Expected<std::shared_ptr<BodyStore>> store = BodyStore::open(directory);
+        ASSERT_TRUE(store) << store.error().message;
+
+        // Enough bodies to grow the index a few times
+        for (int i = 0; i < 5000; ++i) {
+            Expected<BodyStore::PutResult> result = (*store)->put("body " + std::to_string(i));
+            ASSERT_TRUE(result) << result.error().message;
+            hashes.push_back(result->hash);
+        }
+        ASSERT_FALSE((*store)->flush());
+    }
+
+    Expected<std::shared_ptr<BodyStore>> store = BodyStore::open(directory);
+    ASSERT_TRUE(store) << store.error().message;
+    ASSERT_EQ((*store)->size(), 5000u);
+
+    for (int i = 0; i < 5000; ++i) {
+        ASSERT_TRUE((*store)->contains(hashes[i]));
+        ASSERT_EQ((*store)->get(hashes[i]), "body " + std::to_string(i));
+    }
+}
+
+TEST_F(BodyStoreTest, TestSink) {
+    Expected<std::shared_ptr<BodyStore>> store = BodyStore::open(directory);
+    ASSERT_TRUE(store) << store.error().message;
+
+    RequestData requestData;
+    ResponseData responseData;
+    responseData.statusCode = 200;
+    responseData.body = "Hello, world!";
+
+    (*store)->consume(requestData, "GET", responseData);
+
+    ASSERT_EQ(responseData.bodyHash, ContentHash::compute("Hello, world!"));
+    ASSERT_TRUE((*store)->contains(*responseData.bodyHash));
+
+    // The body is stored without the escape sequences of the library response
+    responseData.body = R"({\"a\": \"\u003cb\u003e\"})";
+    (*store)->consume(requestData, "GET", responseData);
+
+    ASSERT_EQ(responseData.bodyHash, ContentHash::compute(R"({"a": "<b>"})"));
+    ASSERT_EQ((*store)->get(*responseData.bodyHash), R"({"a": "<b>"})");
+}
+
+TEST_F(BodyStoreTest, TestCollision) {
+    uint64_t hash = 0;
+    {
+        Expected<std::shared_ptr<BodyStore>> store = BodyStore::open(directory);
+        ASSERT_TRUE(store) << store.error().message;
+        hash = (*store)->put("original").value().hash;
+        ASSERT_FALSE((*store)->flush());
+    }
+
+    // Replace the stored bytes, as if another body of the same size and hash had been stored
+    std::fstream(directory + "/bodies.dat", std::ios::in | std::ios::out | std::ios::binary) << "imitated";
+    {
+        Expected<std::shared_ptr<BodyStore>> store = BodyStore::open(directory);
+        ASSERT_TRUE(store) << store.error().message;
+        ASSERT_TRUE((*store)->put("original"));
+    }
+    {
+        Expected<std::shared_ptr<BodyStore>> store = BodyStore::open(directory, true);
+        ASSERT_TRUE(store) << store.error().message;
+        Expected<BodyStore::PutResult> result = (*store)->put("original");
+        ASSERT_FALSE(result);
+        ASSERT_EQ(result.error().code, ErrorCode::Io);
+    }
+
+    // Change the stored size, as if another body of another size had been stored
+    std::fstream index(directory + "/bodies.idx", std::ios::in | std::ios::out | std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(index)), std::istreambuf_iterator<char>());
+    size_t slot = bytes.find(std::string(reinterpret_cast<const char*>(&hash), sizeof(hash)));
+    ASSERT_NE(slot, std::string::npos);
+    uint64_t size = 4;
+    index.seekp(static_cast<std::streamoff>(slot + 2 * sizeof(uint64_t)));
+    index.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    index.close();
+
+    Expected<std::shared_ptr<BodyStore>> store = BodyStore::open(directory);
+    ASSERT_TRUE(store) << store.error().message;
+    ASSERT_FALSE((*store)->put("original"));
+}
+
+TEST_F(BodyStoreTest, TestInvalidIndex) {
+    std::filesystem::create_directories(directory);
+    std::ofstream(directory + "/bodies.idx") << "not an index";
+
+    Expected<std::shared_ptr<BodyStore>> store = BodyStore::open(directory);
+    ASSERT_FALSE(store);
+    ASSERT_EQ(store.error().code, ErrorCode::Io);
+}
+#endif
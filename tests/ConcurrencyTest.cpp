@@ -0,0 +1,168 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client.hpp"
+
+TEST(ConcurrencyTest, TestShardedCounters) {
+    Sharded<std::atomic<int>, 8> counters;
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 16; ++i) {
+        threads.emplace_back([&counters]() {
+            for (int j = 0; j < 1000; ++j) {
+                counters.local().fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    int total = 0;
+    counters.forEach([&total](const std::atomic<int>& counter) { total += counter.load(); });
+    ASSERT_EQ(total, 16000);
+}
+
+TEST(ConcurrencyTest, TestSessionDataSwap) {
+    SessionData sessionData;
+    Session session(sessionData);
+    std::atomic<bool> running{true};
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < 8; ++i) {
+        readers.emplace_back([&session, &running]() {
+            while (running.load()) {
+                std::shared_ptr<const SessionData> snapshot = session.getSessionData();
+                ASSERT_TRUE(snapshot->clientIdentifier == "chrome_120" ||
+                    snapshot->clientIdentifier == "firefox_120");
+            }
+        });
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        sessionData.clientIdentifier = i % 2 ? "chrome_120" : "firefox_120";
+        session.setSessionData(sessionData);
+    }
+
+    running = false;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQ(session.getSessionData()->clientIdentifier, "chrome_120");
+}
+
+TEST(ConcurrencyTest, TestAtomicSharedPtrSnapshots) {
+    std::vector<std::unique_ptr<AtomicSharedPtr<const int>>> pointers;
+    for (int i = 0; i < 20; ++i) {
+        pointers.push_back(std::make_unique<AtomicSharedPtr<const int>>(std::make_shared<const int>(i)));
+    }
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&pointers, &running]() {
+            while (running.load()) {
+                for (size_t j = 0; j < pointers.size(); ++j) {
+                    ASSERT_EQ(*pointers[j]->load() % 100, static_cast<int>(j));
+                }
+            }
+        });
+    }
+
+    for (int round = 1; round <= 200; ++round) {
+        for (size_t j = 0; j < pointers.size(); ++j) {
+            pointers[j]->store(std::make_shared<const int>(round * 100 + static_cast<int>(j)));
+        }
+    }
+
+    running = false;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    for (size_t j = 0; j < pointers.size(); ++j) {
+        ASSERT_EQ(*pointers[j]->load(), 20000 + static_cast<int>(j));
+    }
+
+    // Values loaded before are released as soon as they are replaced, or the pointer destroyed
+    std::weak_ptr<const int> replaced = pointers[0]->load();
+    ASSERT_EQ(*pointers[0]->exchange(std::make_shared<const int>(-1)), 20000);
+    ASSERT_TRUE(replaced.expired());
+    std::weak_ptr<const int> destroyed = pointers[0]->load();
+    pointers[0].reset();
+    ASSERT_TRUE(destroyed.expired());
+}
+
+/**
+ * @brief CountingSink class counting its live instances.
+ */
+class CountingSink : public ResponseSink {
+public:
+    explicit CountingSink(std::atomic<int>& live) : live(live) { ++live; }
+    ~CountingSink() override { --live; }
+
+    void consume(const RequestData&, const std::string&, ResponseData&) override {}
+
+private:
+    std::atomic<int>& live;
+};
+
+TEST(ConcurrencyTest, TestSinkDestroyedWithSession) {
+    std::atomic<int> live{0};
+    {
+        SessionData sessionData;
+        sessionData.sinks.push_back(std::make_shared<CountingSink>(live));
+        Session session(sessionData);
+        sessionData.sinks.clear();
+
+        // Snapshots read from other threads do not outlive the session
+        std::thread([&session]() { ASSERT_EQ(session.getSessionData()->sinks.size(), 1u); }).join();
+        ASSERT_EQ(session.getSessionData()->sinks.size(), 1u);
+        ASSERT_EQ(live, 1);
+    }
+    ASSERT_EQ(live, 0);
+
+    // Replacing the session data releases the previous sinks
+    SessionData sessionData;
+    sessionData.sinks.push_back(std::make_shared<CountingSink>(live));
+    Session session(sessionData);
+    sessionData.sinks.clear();
+    ASSERT_FALSE(session.getSessionData()->sinks.empty());
+    session.setSessionData(SessionData());
+    ASSERT_EQ(live, 0);
+}
+
+TEST(ConcurrencyTest, TestCopyAndMoveSession) {
+    SessionData sessionData;
+    sessionData.clientIdentifier = "firefox_120";
+    Session first(sessionData);
+
+    Session copy = first;
+    ASSERT_EQ(copy.getSessionData(), first.getSessionData());
+
+    std::vector<Session> sessions;
+    sessions.push_back(Session(sessionData));
+    sessions.push_back(std::move(copy));
+    ASSERT_EQ(sessions[1].getSessionData()->clientIdentifier, "firefox_120");
+
+    Session assigned(SessionData{});
+    assigned = first;
+    ASSERT_EQ(assigned.getSessionData(), first.getSessionData());
+    ASSERT_EQ(assigned.getStats().requests, 0u);
+}
+
+TEST(ConcurrencyTest, TestEmptyStats) {
+    Session session(SessionData{});
+    SessionStats stats = session.getStats();
+
+    ASSERT_EQ(stats.requests, 0u);
+    ASSERT_EQ(stats.failures, 0u);
+}
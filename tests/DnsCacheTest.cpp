@@ -0,0 +1,291 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_dns.hpp"
+#include "DnsStubServer.hpp"
+
+#if defined(TLS_CLIENT_HAS_OPENSSL)
+#include "LoopbackServer.hpp"
+#endif
+
+class DnsCacheTest : public ::testing::Test {
+protected:
+    DnsStubServer server;
+    std::shared_ptr<UdpDnsResolver> resolver;
+
+    void SetUp() override {
+        UdpDnsResolverOptions options;
+        options.timeout = std::chrono::milliseconds(300);
+        options.ipv6 = true;
+        resolver = std::make_shared<UdpDnsResolver>(server.address(), options);
+    }
+
+    DnsCacheOptions cacheOptions() const {
+        DnsCacheOptions options;
+        options.minTtl = std::chrono::seconds(1);
+        return options;
+    }
+};
+
+TEST_F(DnsCacheTest, TestUdpResolver) {
+    server.addRecord("api.test", "10.0.0.1", 300);
+    server.addRecord("api.test", "10.0.0.2", 60);
+    server.addRecord("api.test", "2001:db8::1", 120);
+
+    auto answer = resolver->query("api.test");
+    ASSERT_TRUE(answer) << answer.error().message;
+    ASSERT_EQ(answer->addresses, (std::vector<std::string>{"10.0.0.1", "10.0.0.2", "2001:db8::1"}));
+    ASSERT_EQ(answer->ttl, std::chrono::seconds(60));
+
+    // Unknown names get an empty answer with the TTL of the SOA record
+    auto missing = resolver->query("missing.test");
+    ASSERT_TRUE(missing) << missing.error().message;
+    ASSERT_TRUE(missing->addresses.empty());
+    ASSERT_EQ(missing->ttl, std::chrono::seconds(DnsStubServer::NEGATIVE_TTL));
+
+    server.fail("broken.test");
+    auto broken = resolver->query("broken.test");
+    ASSERT_FALSE(broken);
+    ASSERT_EQ(broken.error().code, ErrorCode::Dns);
+
+    ASSERT_FALSE(resolver->query("bad..name"));
+    ASSERT_FALSE(resolver->query(std::string(64, 'a') + ".test"));
+}
+
+TEST_F(DnsCacheTest, TestTimeout) {
+    UdpDnsResolverOptions options;
+    options.timeout = std::chrono::milliseconds(100);
+    options.attempts = 2;
+    server.setDelay(std::chrono::milliseconds(500));
+    UdpDnsResolver slow(server.address(), options);
+
+    auto start = std::chrono::steady_clock::now();
+    auto answer = slow.query("api.test");
+    ASSERT_FALSE(answer);
+    ASSERT_EQ(answer.error().code, ErrorCode::Dns);
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(400));
+}
+
+TEST_F(DnsCacheTest, TestCachesAndRotates) {
+    server.addRecord("api.test", "10.0.0.1", 1);
+    server.addRecord("api.test", "10.0.0.2", 1);
+    DnsCache cache(resolver, cacheOptions());
+
+    ASSERT_EQ(*cache.resolve("api.test"), "10.0.0.1");
+    ASSERT_EQ(*cache.resolve("api.test"), "10.0.0.2");
+    ASSERT_EQ(*cache.resolve("api.test"), "10.0.0.1");
+    ASSERT_EQ(server.queries("api.test"), 2); // A and AAAA
+
+    auto answer = cache.lookup("api.test");
+    ASSERT_TRUE(answer);
+    ASSERT_LE(answer->ttl, std::chrono::seconds(1));
+
+    // The answer expires with its TTL
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    ASSERT_TRUE(cache.resolve("api.test"));
+    ASSERT_EQ(server.queries("api.test"), 4);
+
+    DnsCacheStats stats = cache.getStats();
+    ASSERT_EQ(stats.misses, 2u);
+    ASSERT_EQ(stats.hits, 3u);
+    ASSERT_EQ(stats.queries, 2u);
+}
+
+TEST_F(DnsCacheTest, TestNegativeCaching) {
+    server.fail("broken.test");
+    DnsCacheOptions options = cacheOptions();
+    options.maxNegativeTtl = std::chrono::seconds(1);
+    DnsCache cache(resolver, options);
+
+    for (int i = 0; i < 3; ++i) {
+        auto missing = cache.resolve("missing.test");
+        ASSERT_FALSE(missing);
+        ASSERT_EQ(missing.error().code, ErrorCode::Dns);
+        ASSERT_NE(missing.error().message.find("no such host"), std::string::npos);
+
+        auto broken = cache.resolve("broken.test");
+        ASSERT_FALSE(broken);
+        ASSERT_EQ(broken.error().code, ErrorCode::Dns);
+    }
+    ASSERT_EQ(server.queries("missing.test"), 2); // A and AAAA
+    ASSERT_EQ(server.queries("broken.test"), 1);
+    ASSERT_EQ(cache.getStats().negativeHits, 4u);
+
+    // Negative answers are kept for at most maxNegativeTtl, failures for errorTtl
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    ASSERT_FALSE(cache.resolve("missing.test"));
+    ASSERT_FALSE(cache.resolve("broken.test"));
+    ASSERT_EQ(server.queries("missing.test"), 4);
+    ASSERT_EQ(server.queries("broken.test"), 2);
+}
+
+TEST_F(DnsCacheTest, TestPrefetch) {
+    server.addRecord("api.test", "10.0.0.1", 2);
+    DnsCacheOptions options = cacheOptions();
+    options.prefetchFraction = 0.5;
+    DnsCache cache(resolver, options);
+
+    ASSERT_TRUE(cache.resolve("api.test"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1200));
+
+    // Within the last half of the TTL, the cached answer is returned and refreshed
+    ASSERT_EQ(*cache.resolve("api.test"), "10.0.0.1");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_EQ(server.queries("api.test"), 4);
+    ASSERT_EQ(cache.getStats().prefetches, 1u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    ASSERT_TRUE(cache.resolve("api.test"));
+    ASSERT_EQ(cache.getStats().misses, 1u);
+
+    // Names can be queried ahead of their first use
+    server.addRecord("next.test", "10.0.0.3", 60);
+    cache.prefetch("next.test");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_EQ(*cache.resolve("next.test"), "10.0.0.3");
+    ASSERT_EQ(cache.getStats().misses, 1u);
+}
+
+TEST_F(DnsCacheTest, TestConcurrentLookupsShareQueries) {
+    server.addRecord("api.test", "10.0.0.1", 60);
+    server.setDelay(std::chrono::milliseconds(100));
+    DnsCache cache(resolver, cacheOptions());
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&cache]() {
+            auto address = cache.resolve("api.test");
+            ASSERT_TRUE(address) << address.error().message;
+            ASSERT_EQ(*address, "10.0.0.1");
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(server.queries("api.test"), 2);
+    ASSERT_EQ(cache.getStats().queries, 1u);
+}
+
+TEST_F(DnsCacheTest, TestNameServerAddress) {
+    ASSERT_TRUE(UdpDnsResolver::create("127.0.0.1"));
+    ASSERT_TRUE(UdpDnsResolver::create("127.0.0.1:5353"));
+    ASSERT_TRUE(UdpDnsResolver::create("[::1]:5353"));
+    ASSERT_TRUE(UdpDnsResolver::create("::1"));
+    for (std::string nameserver : {"", "localhost", "127.0.0.1:", "127.0.0.1:x", "127.0.0.1:53x", "127.0.0.1:65536",
+             "127.0.0.1:99999999999999999999", "[::1", "[::1]x", "[::1]:-1"}) {
+        auto created = UdpDnsResolver::create(nameserver);
+        ASSERT_FALSE(created) << nameserver;
+        ASSERT_EQ(created.error().code, ErrorCode::Dns);
+    }
+    ASSERT_THROW(UdpDnsResolver("127.0.0.1:x"), std::invalid_argument);
+}
+
+/**
+ * @brief ScriptedResolver class answering every name with a TTL of its own, or failing.
+ */
+class ScriptedResolver : public DnsResolver {
+public:
+    std::atomic<bool> failing{false};
+    std::atomic<int> queries{0};
+
+    Expected<DnsAnswer> query(const std::string& host) override {
+        ++queries;
+        if (failing) {
+            return Unexpected<Error>{{ErrorCode::Dns, "lookup " + host + ": server misbehaving"}};
+        }
+        return DnsAnswer{{"10.0.0.1"}, std::chrono::seconds(host.size())};
+    }
+};
+
+TEST(DnsCacheLimitsTest, TestFailedRefreshBacksOff) {
+    auto resolver = std::make_shared<ScriptedResolver>();
+    DnsCacheOptions options;
+    options.minTtl = std::chrono::seconds(1);
+    options.prefetchFraction = 0.9;
+    options.errorTtl = std::chrono::seconds(1);
+    DnsCache cache(resolver, options);
+
+    ASSERT_TRUE(cache.resolve("a.test.padding")); // 14s
+    resolver->failing = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+
+    // The failed refresh keeps the answer and its TTL, and is not retried on every lookup
+    for (int i = 0; i < 5; ++i) {
+        auto answer = cache.lookup("a.test.padding");
+        ASSERT_TRUE(answer);
+        ASSERT_LE(answer->ttl, std::chrono::seconds(13));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    ASSERT_EQ(resolver->queries, 2);
+
+    // After errorTtl, lookups refresh it again before it expires
+    resolver->failing = false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    ASSERT_TRUE(cache.lookup("a.test.padding"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(resolver->queries, 3);
+    ASSERT_GE(cache.lookup("a.test.padding")->ttl, std::chrono::seconds(13));
+
+    DnsCacheStats stats = cache.getStats();
+    ASSERT_EQ(stats.prefetches, 2u);
+    ASSERT_EQ(stats.misses, 1u);
+}
+
+TEST(DnsCacheLimitsTest, TestMaxEntries) {
+    auto resolver = std::make_shared<ScriptedResolver>();
+    DnsCacheOptions options;
+    options.maxEntries = 4;
+    options.prefetchFraction = 0;
+    DnsCache cache(resolver, options);
+
+    // Nothing is expired, so the names expiring soonest make room
+    for (std::string host : {"aaaaaaaaaaaaaaaaaaaa", "bbbbbbbbbb", "cccccccccccccccccccccccccccccc", "dd", "eeeeeeeeeeee",
+             "ffffffffffffffffffffffffff"}) {
+        ASSERT_TRUE(cache.resolve(host));
+        ASSERT_LE(cache.size(), 4u);
+    }
+    ASSERT_EQ(resolver->queries, 6);
+    ASSERT_TRUE(cache.resolve("cccccccccccccccccccccccccccccc"));
+    ASSERT_TRUE(cache.resolve("ffffffffffffffffffffffffff"));
+    ASSERT_EQ(resolver->queries, 6);
+    ASSERT_TRUE(cache.resolve("dd"));
+    ASSERT_EQ(resolver->queries, 7);
+}
+
+#if defined(TLS_CLIENT_HAS_OPENSSL)
+TEST_F(DnsCacheTest, TestSessionResolver) {
+    LoopbackServer loopback;
+    server.addRecord("api.test", "127.0.0.1", 60);
+
+    SessionData sessionData;
+    sessionData.resolver = std::make_shared<DnsCache>(resolver, cacheOptions());
+    Session session(sessionData);
+
+    RequestData requestData;
+    requestData.url = "https://API.test:" + std::to_string(loopback.port()) + "/get?q=1";
+    requestData.insecureSkipVerify = true;
+
+    // The library connects to the address, with the host name in the Host header
+    auto response = session.tryGET(requestData);
+    ASSERT_TRUE(response) << response.error().message;
+    ASSERT_EQ(response->statusCode, 200);
+    ASSERT_NE(response->body.find(R"(\"Host\": \"API.test:)" + std::to_string(loopback.port())), std::string::npos);
+    ASSERT_EQ(response->target, requestData.url);
+
+    requestData.url = "https://missing.test/get";
+    auto missing = session.tryGET(requestData);
+    ASSERT_FALSE(missing);
+    ASSERT_EQ(missing.error().code, ErrorCode::Dns);
+    ASSERT_EQ(session.GET(requestData).statusCode, 0);
+}
+#endif
@@ -0,0 +1,201 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @brief DnsStubServer class answering DNS queries over UDP on 127.0.0.1 for tests.
+ *
+ * Names are answered from the records added with addRecord. Unknown names get
+ * NXDOMAIN with an SOA record, and names added with fail get SERVFAIL.
+ */
+class DnsStubServer {
+public:
+    static constexpr uint32_t NEGATIVE_TTL = 5; /**< The TTL of the SOA record of NXDOMAIN answers. */
+
+    DnsStubServer() {
+        socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (::bind(socket, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+            ::getsockname(socket, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            ::close(socket);
+            throw std::runtime_error("Failed to bind the DNS stub server");
+        }
+        boundPort = ntohs(address.sin_port);
+        worker = std::thread([this] { serve(); });
+    }
+
+    DnsStubServer(const DnsStubServer&) = delete;
+    DnsStubServer& operator=(const DnsStubServer&) = delete;
+
+    ~DnsStubServer() {
+        stopping = true;
+        worker.join();
+        ::close(socket);
+    }
+
+    /**
+     * @brief Returns the address of the server, as "127.0.0.1:port".
+     */
+    [[nodiscard]] std::string address() const { return "127.0.0.1:" + std::to_string(boundPort); }
+
+    /**
+     * @brief Adds an A (IPv4) or AAAA (IPv6) record.
+     */
+    void addRecord(const std::string& name, const std::string& ip, uint32_t ttl) {
+        std::lock_guard<std::mutex> lock(mutex);
+        records[name].push_back({ip, ttl});
+    }
+
+    /**
+     * @brief Makes the queries of a name fail with SERVFAIL.
+     */
+    void fail(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        failing.push_back(name);
+    }
+
+    /**
+     * @brief Delays every answer.
+     */
+    void setDelay(std::chrono::milliseconds value) { delay = value; }
+
+    /**
+     * @brief Returns the number of queries received for a name.
+     */
+    [[nodiscard]] int queries(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return counts[name];
+    }
+
+private:
+    struct Record {
+        std::string ip;
+        uint32_t ttl;
+    };
+
+    int socket = -1;
+    uint16_t boundPort = 0;
+    std::atomic<bool> stopping{false};
+    std::atomic<std::chrono::milliseconds> delay{std::chrono::milliseconds(0)};
+    std::thread worker;
+    std::mutex mutex;
+    std::map<std::string, std::vector<Record>> records;
+    std::map<std::string, int> counts;
+    std::vector<std::string> failing;
+
+    void serve() {
+        while (!stopping) {
+            pollfd descriptor{socket, POLLIN, 0};
+            if (::poll(&descriptor, 1, 50) <= 0) {
+                continue;
+            }
+
+            char buffer[512];
+            sockaddr_in client{};
+            socklen_t length = sizeof(client);
+            ssize_t received = ::recvfrom(socket, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&client),
+                &length);
+            if (received < 17) {
+                continue;
+            }
+
+            // Queries hold a single question: labels, then type and class
+            std::string name;
+            size_t offset = 12;
+            while (offset < static_cast<size_t>(received) && buffer[offset] != 0) {
+                size_t label = static_cast<uint8_t>(buffer[offset]);
+                name += (name.empty() ? "" : ".") + std::string(buffer + offset + 1, label);
+                offset += label + 1;
+            }
+            size_t questionEnd = offset + 5;
+            uint16_t type = static_cast<uint16_t>((static_cast<uint8_t>(buffer[offset + 1]) << 8) |
+                static_cast<uint8_t>(buffer[offset + 2]));
+
+            std::this_thread::sleep_for(delay.load());
+            std::string answer = respond(std::string(buffer, questionEnd), name, type);
+            ::sendto(socket, answer.data(), answer.size(), 0, reinterpret_cast<sockaddr*>(&client), length);
+        }
+    }
+
+    std::string respond(std::string message, const std::string& name, uint16_t type) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++counts[name];
+
+        auto append16 = [&message](uint16_t value) {
+            message += static_cast<char>(value >> 8);
+            message += static_cast<char>(value & 0xff);
+        };
+        auto append32 = [&append16](uint32_t value) {
+            append16(static_cast<uint16_t>(value >> 16));
+            append16(static_cast<uint16_t>(value & 0xffff));
+        };
+
+        message[2] = static_cast<char>(0x81); // Response, recursion desired
+        message[3] = static_cast<char>(0x80); // Recursion available
+        message.replace(6, 6, std::string(6, '\0'));
+
+        if (std::find(failing.begin(), failing.end(), name) != failing.end()) {
+            message[3] |= 2;
+            return message;
+        }
+
+        auto it = records.find(name);
+        if (it == records.end()) {
+            // NXDOMAIN, with the SOA record of the root zone
+            message[3] |= 3;
+            message[9] = 1;
+            message += std::string{0x00};
+            append16(6);
+            append16(1);
+            append32(3600);
+            std::string soa = std::string{0x00, 0x00} + std::string(12, '\0');
+            append16(static_cast<uint16_t>(soa.size() + 8));
+            message += soa;
+            append32(3600);
+            append32(NEGATIVE_TTL);
+            return message;
+        }
+
+        uint16_t answers = 0;
+        for (const Record& record : it->second) {
+            unsigned char address[16];
+            bool ipv6 = record.ip.find(':') != std::string::npos;
+            if ((type == 28) != ipv6 || ::inet_pton(ipv6 ? AF_INET6 : AF_INET, record.ip.c_str(), address) != 1) {
+                continue;
+            }
+
+            append16(0xc00c); // A pointer to the question name
+            append16(type);
+            append16(1);
+            append32(record.ttl);
+            append16(ipv6 ? 16 : 4);
+            message.append(reinterpret_cast<const char*>(address), ipv6 ? 16 : 4);
+            ++answers;
+        }
+        message[7] = static_cast<char>(answers);
+        return message;
+    }
+};
@@ -0,0 +1,88 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client.hpp"
+#include "../include/tls_client_dns.hpp"
+#include "../include/tls_client_pool.hpp"
+
+TEST(ExpectedTest, TestValue) {
+    Expected<int> expected(42);
+
+    ASSERT_TRUE(expected.hasValue());
+    ASSERT_EQ(*expected, 42);
+    ASSERT_EQ(expected.valueOr(0), 42);
+}
+
+TEST(ExpectedTest, TestError) {
+    Expected<int> expected(Unexpected<Error>{{ErrorCode::Timeout, "timed out"}});
+
+    ASSERT_FALSE(expected);
+    ASSERT_EQ(expected.error().code, ErrorCode::Timeout);
+    ASSERT_EQ(expected.error().message, "timed out");
+    ASSERT_EQ(expected.valueOr(0), 0);
+}
+
+TEST(ExpectedTest, TestClassifyError) {
+    ASSERT_EQ(TlsClient::classifyError("failed to do request: Get \"https://httpbin.org/delay/10\": "
+        "context deadline exceeded (Client.Timeout exceeded while awaiting headers)"), ErrorCode::Timeout);
+    ASSERT_EQ(TlsClient::classifyError("failed to do request: Get \"https://httpbin.org\": proxyconnect tcp: "
+        "dial tcp: lookup test_proxy: no such host"), ErrorCode::Proxy);
+    ASSERT_EQ(TlsClient::classifyError("failed to do request: Get \"https://expired.badssl.com\": "
+        "tls: failed to verify certificate: x509: certificate has expired"), ErrorCode::Tls);
+    ASSERT_EQ(TlsClient::classifyError("failed to do request: Get \"https://unknown.invalid\": "
+        "dial tcp: lookup unknown.invalid: no such host"), ErrorCode::Dns);
+    ASSERT_EQ(TlsClient::classifyError("failed to do request: Get \"https://127.0.0.1:1\": "
+        "dial tcp 127.0.0.1:1: connect: connection refused"), ErrorCode::Connection);
+    ASSERT_EQ(TlsClient::classifyError("failed to build request"), ErrorCode::Request);
+
+    // Keywords inside the URL do not change the class
+    ASSERT_EQ(TlsClient::classifyError("failed to do request: Post \"https://example.com/proxy/x\": "
+        "dial tcp 127.0.0.1:1: connect: connection refused"), ErrorCode::Connection);
+    ASSERT_EQ(TlsClient::classifyError("failed to do request: Get \"https://example.com/certificate?timeout=1\": "
+        "dial tcp: lookup example.com: no such host"), ErrorCode::Dns);
+    ASSERT_EQ(TlsClient::classifyError("failed to do request: Get \"https://example.com/eof\": "
+        "unexpected status"), ErrorCode::Request);
+}
+
+TEST(ExpectedTest, TestLibraryError) {
+    Error error = TlsClient::libraryError(R"(failed to do request: Get \"https://example.com/proxy\": )"
+        R"(tls: failed to verify certificate)");
+
+    ASSERT_EQ(error.code, ErrorCode::Tls);
+    ASSERT_EQ(error.message, "failed to do request: Get \"https://example.com/proxy\": tls: failed to verify certificate");
+}
+
+TEST(ExpectedTest, TestTryParseMalformedResponse) {
+    Expected<ResponseData> responseData = JsonHelper::tryParseResponse(R"({"body":"no status"})");
+
+    ASSERT_FALSE(responseData);
+    ASSERT_EQ(responseData.error().code, ErrorCode::Parse);
+}
+
+TEST(ExpectedTest, TestParseMalformedStatus) {
+    ResponseData responseData = JsonHelper::parseResponse(R"({"status":"abc"})");
+
+    ASSERT_EQ(responseData.statusCode, 0);
+}
+
+TEST(ExpectedTest, TestCreateSessionPool) {
+    Expected<std::unique_ptr<SessionPool>> pool = SessionPool::create(SessionData(), {});
+    ASSERT_FALSE(pool);
+    ASSERT_EQ(pool.error().code, ErrorCode::Request);
+}
+
+#if defined(OS_LINUX) || defined(OS_APPLE)
+TEST(ExpectedTest, TestCreateDnsResolver) {
+    Expected<std::shared_ptr<UdpDnsResolver>> resolver = UdpDnsResolver::create("127.0.0.1:x");
+    ASSERT_FALSE(resolver);
+    ASSERT_EQ(resolver.error().code, ErrorCode::Dns);
+    ASSERT_TRUE(UdpDnsResolver::create("127.0.0.1:53"));
+}
+#endif
@@ -0,0 +1,151 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_frontier.hpp"
+
+TEST(ScalableBloomFilterTest, TestNoFalseNegatives) {
+    ScalableBloomFilter filter(1000, 1e-3);
+
+    // Far past the initial capacity, so several stages are added
+    size_t inserted = 0;
+    for (int i = 0; i < 50000; ++i) {
+        inserted += filter.insert("https://example.com/" + std::to_string(i));
+    }
+    for (int i = 0; i < 50000; ++i) {
+        ASSERT_TRUE(filter.mayContain("https://example.com/" + std::to_string(i)));
+        ASSERT_FALSE(filter.insert("https://example.com/" + std::to_string(i)));
+    }
+
+    // A new element may be a false positive, in which case it is not counted
+    ASSERT_GT(inserted, 50000u * 0.999);
+    ASSERT_EQ(filter.size(), inserted);
+}
+
+TEST(ScalableBloomFilterTest, TestFalsePositiveRate) {
+    ScalableBloomFilter filter(1000, 1e-3);
+    for (int i = 0; i < 50000; ++i) {
+        filter.insert("https://example.com/" + std::to_string(i));
+    }
+
+    int falsePositives = 0;
+    for (int i = 0; i < 100000; ++i) {
+        falsePositives += filter.mayContain("https://example.org/" + std::to_string(i));
+    }
+    ASSERT_LT(falsePositives, 100000 * 1e-3 * 1.5);
+    ASSERT_LT(filter.memoryUsage(), 50000u * 4);
+}
+
+TEST(FrontierTest, TestHostOf) {
+    ASSERT_EQ(Frontier::hostOf("https://User@Example.COM:8443/path?q#f"), "example.com:8443");
+    ASSERT_EQ(Frontier::hostOf("http://example.com"), "example.com");
+    ASSERT_EQ(Frontier::hostOf("https://example.com?q"), "example.com");
+}
+
+TEST(FrontierTest, TestDeduplication) {
+    Frontier frontier;
+    ASSERT_TRUE(frontier.push("https://example.com/a"));
+    ASSERT_FALSE(frontier.push("https://example.com/a"));
+    ASSERT_FALSE(frontier.push("https://example.com/a#section"));
+    ASSERT_TRUE(frontier.push("https://example.com/b"));
+    ASSERT_EQ(frontier.size(), 2u);
+    ASSERT_EQ(frontier.seenCount(), 2u);
+}
+
+TEST(FrontierTest, TestCrawlDelay) {
+    FrontierOptions options;
+    options.crawlDelay = std::chrono::milliseconds(200);
+    Frontier frontier(options);
+
+    frontier.push("https://a.example/1");
+    frontier.push("https://a.example/2");
+    frontier.push("https://b.example/1");
+
+    // One URL per host, then the hosts wait for their delay
+    std::vector<std::string> first = {*frontier.tryPop(), *frontier.tryPop()};
+    ASSERT_EQ(first, (std::vector<std::string>{"https://a.example/1", "https://b.example/1"}));
+    ASSERT_FALSE(frontier.tryPop());
+
+    auto start = Frontier::Clock::now();
+    ASSERT_EQ(frontier.waitPop(std::chrono::seconds(5)), "https://a.example/2");
+    ASSERT_GE(Frontier::Clock::now() - start, std::chrono::milliseconds(150));
+    ASSERT_FALSE(frontier.waitPop(std::chrono::milliseconds(10)));
+}
+
+TEST(FrontierTest, TestSetCrawlDelay) {
+    FrontierOptions options;
+    options.crawlDelay = std::chrono::hours(1);
+    Frontier frontier(options);
+    frontier.setCrawlDelay("fast.example", std::chrono::milliseconds(0));
+
+    for (int i = 0; i < 3; ++i) {
+        frontier.push("https://fast.example/" + std::to_string(i));
+    }
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(frontier.tryPop(), "https://fast.example/" + std::to_string(i));
+    }
+}
+
+TEST(FrontierTest, TestForgetIdleHosts) {
+    FrontierOptions options;
+    options.crawlDelay = std::chrono::milliseconds(20);
+    Frontier frontier(options);
+    frontier.setCrawlDelay("kept.example", std::chrono::milliseconds(20));
+
+    for (int i = 0; i < 100; ++i) {
+        frontier.push("https://host" + std::to_string(i) + ".example/");
+    }
+    frontier.push("https://kept.example/");
+    for (int i = 0; i < 101; ++i) {
+        ASSERT_TRUE(frontier.tryPop());
+    }
+    ASSERT_EQ(frontier.hostCount(), 101u);
+
+    // Drained hosts are forgotten after their delay, except the ones with an explicit delay
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    ASSERT_FALSE(frontier.tryPop());
+    ASSERT_EQ(frontier.hostCount(), 1u);
+
+    // A forgotten host is handed out again right away
+    frontier.push("https://host0.example/again");
+    ASSERT_EQ(frontier.tryPop(), "https://host0.example/again");
+}
+
+TEST(FrontierTest, TestSpillToDisk) {
+    std::string directory = (std::filesystem::temp_directory_path() / "tls-client-frontier-test").string();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    FrontierOptions options;
+    options.crawlDelay = std::chrono::milliseconds(0);
+    options.maxUrlsInMemory = 100;
+    options.segmentUrls = 64;
+    options.spillDirectory = directory;
+
+    {
+        Frontier frontier(options);
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_TRUE(frontier.push("https://example.com/" + std::to_string(i)));
+        }
+        ASSERT_EQ(frontier.size(), 1000u);
+        ASSERT_FALSE(std::filesystem::is_empty(directory));
+
+        // A single host is handed out in push order across memory and disk
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(frontier.tryPop(), "https://example.com/" + std::to_string(i));
+        }
+        ASSERT_FALSE(frontier.tryPop());
+        ASSERT_EQ(frontier.size(), 0u);
+    }
+
+    ASSERT_TRUE(std::filesystem::is_empty(directory));
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,151 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_headers.hpp"
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+#include "LoopbackServer.hpp"
+#endif
+
+// Resolved at compile time
+static_assert(HeaderTable::COUNT > 60);
+static_assert(HeaderTable::name(HeaderId::ContentType) == "content-type");
+static_assert(HeaderTable::interned(HeaderId::Server));
+static_assert(!HeaderTable::interned(HeaderId::SetCookie));
+static_assert(!HeaderTable::interned(HeaderId::ContentSecurityPolicy));
+
+TEST(HeadersTest, TestFind) {
+    ASSERT_EQ(HeaderTable::find("content-type"), HeaderId::ContentType);
+    ASSERT_EQ(HeaderTable::find("Content-Type"), HeaderId::ContentType);
+    ASSERT_EQ(HeaderTable::find("SET-COOKIE"), HeaderId::SetCookie);
+    ASSERT_EQ(HeaderTable::find("Location"), HeaderId::Location);
+
+    for (size_t i = 0; i < HeaderTable::COUNT; ++i) {
+        HeaderId id = static_cast<HeaderId>(i);
+        ASSERT_EQ(HeaderTable::find(HeaderTable::name(id)), id) << HeaderTable::name(id);
+    }
+    for (std::string_view name : {"", "content", "content-typ", "content-types", "x-custom",
+             "content-security-policy-report-only-and-more"}) {
+        ASSERT_EQ(HeaderTable::find(name), HeaderId::Unknown) << name;
+    }
+}
+
+TEST(HeadersTest, TestParse) {
+    auto interner = std::make_shared<HeaderInterner>();
+    ParsedHeaders headers = ParsedHeaders::parse(R"({"Content-Type": ["text/html; charset=utf-8"],)"
+        R"( "Set-Cookie": ["a=1", "b=\"2\""], "X-Custom": ["yes"], "Date": ["Mon, 01 Jan 2024 00:00:00 GMT"]})",
+        interner);
+
+    ASSERT_EQ(headers.get(HeaderId::ContentType), "text/html; charset=utf-8");
+    ASSERT_EQ(headers.get("content-type"), "text/html; charset=utf-8");
+    ASSERT_EQ(headers.get(HeaderId::SetCookie), "a=1");
+    ASSERT_EQ(headers.getAll(HeaderId::SetCookie), (std::vector<std::string_view>{"a=1", "b=\"2\""}));
+    ASSERT_EQ(headers.get("x-custom"), "yes");
+    ASSERT_EQ(headers.get(HeaderId::Date), "Mon, 01 Jan 2024 00:00:00 GMT");
+    ASSERT_FALSE(headers.get(HeaderId::Location));
+    ASSERT_FALSE(headers.get("x-missing"));
+    ASSERT_TRUE(headers.getAll(HeaderId::Location).empty());
+
+    ASSERT_EQ(headers.all().size(), 5u);
+    ASSERT_EQ(headers.all()[3].name, "X-Custom");
+    ASSERT_EQ(headers.all()[0].name, "content-type");
+
+    // Only the content type and the unknown name are interned
+    ASSERT_EQ(interner->size(), 2u);
+}
+
+TEST(HeadersTest, TestInterning) {
+    auto interner = std::make_shared<HeaderInterner>();
+    std::string json = R"({"Server": ["nginx"], "Content-Type": ["application/json"], "Etag": ["\"1\""]})";
+    ParsedHeaders first = ParsedHeaders::parse(json, interner);
+    ParsedHeaders second = ParsedHeaders::parse(json, interner);
+
+    // Repeated values point to the same bytes, per-response values do not
+    ASSERT_EQ(first.get(HeaderId::Server)->data(), second.get(HeaderId::Server)->data());
+    ASSERT_EQ(first.get(HeaderId::ContentType)->data(), second.get(HeaderId::ContentType)->data());
+    ASSERT_NE(first.get(HeaderId::ETag)->data(), second.get(HeaderId::ETag)->data());
+    ASSERT_EQ(interner->size(), 2u);
+    ASSERT_EQ(interner->bytes(), std::string("nginxapplication/json").size());
+
+    // Moving keeps the views valid
+    ParsedHeaders moved = std::move(first);
+    ASSERT_EQ(moved.get(HeaderId::ETag), "\"1\"");
+}
+
+TEST(HeadersTest, TestFullInterner) {
+    auto interner = std::make_shared<HeaderInterner>(2);
+    ParsedHeaders first = ParsedHeaders::parse(R"({"Server": ["nginx"], "X-Known": ["1"]})", interner);
+    ASSERT_EQ(interner->size(), 2u);
+    ASSERT_EQ(first.get("x-known"), "1");
+
+    // Once full, new names and values are copied per response
+    std::vector<ParsedHeaders> responses;
+    for (int i = 0; i < 100; ++i) {
+        std::string id = std::to_string(i);
+        responses.push_back(ParsedHeaders::parse(R"({"Server": ["nginx"], "X-Known": ["2"], "X-Trace-)" + id +
+            R"(": ["a"], "Via": ["proxy-)" + id + R"("]})", interner));
+    }
+    ASSERT_EQ(interner->size(), 2u);
+    ASSERT_EQ(responses[0].get(HeaderId::Server)->data(), responses[99].get(HeaderId::Server)->data());
+    ASSERT_EQ(responses[0].all()[1].name.data(), responses[99].all()[1].name.data());
+    ASSERT_EQ(responses[42].all()[2].name, "X-Trace-42");
+    ASSERT_EQ(responses[42].get("x-trace-42"), "a");
+    ASSERT_EQ(responses[42].get(HeaderId::Via), "proxy-42");
+
+    // Explicit interning is not limited
+    ASSERT_EQ(interner->intern("value"), "value");
+    ASSERT_EQ(interner->size(), 3u);
+    ASSERT_FALSE(interner->tryIntern("other"));
+}
+
+TEST(HeadersTest, TestConcurrentInterning) {
+    HeaderInterner interner;
+    std::string large(HeaderInterner::BLOCK_SIZE, 'x');
+    std::vector<std::thread> threads;
+    std::vector<std::vector<std::string_view>> results(4);
+    for (size_t t = 0; t < results.size(); ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 2000; ++i) {
+                results[t].push_back(interner.intern("value-" + std::to_string(i % 500)));
+            }
+            results[t].push_back(interner.intern(large));
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(interner.size(), 501u);
+    for (size_t t = 1; t < results.size(); ++t) {
+        ASSERT_EQ(results[t], results[0]);
+        ASSERT_EQ(results[t].back().data(), results[0].back().data());
+    }
+    ASSERT_EQ(results[0][499], "value-499");
+    ASSERT_EQ(results[0].back(), large);
+    ASSERT_TRUE(interner.intern("").empty());
+}
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+TEST(HeadersTest, TestResponseHeaders) {
+    LoopbackServer server;
+    Session session{SessionData()};
+
+    RequestData requestData;
+    requestData.url = server.url("/get");
+    requestData.insecureSkipVerify = true;
+    Expected<ResponseData> response = session.tryGET(requestData);
+    ASSERT_TRUE(response) << response.error().message;
+
+    ParsedHeaders headers = ParsedHeaders::parse(response->headers);
+    ASSERT_EQ(headers.get(HeaderId::ContentType), "application/json");
+    ASSERT_EQ(headers.get(HeaderId::ContentType), response->header("content-type"));
+}
+#endif
@@ -0,0 +1,213 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_json_bind.hpp"
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+#include "LoopbackServer.hpp"
+#endif
+
+struct Address {
+    std::string city;
+    std::optional<std::string> zip;
+};
+TLS_CLIENT_JSON_FIELDS(Address, city, zip);
+
+struct User {
+    int64_t id = 0;
+    std::string name;
+    double score = 0;
+    bool active = false;
+    unsigned visits = 7;
+    std::vector<std::string> roles;
+    std::vector<Address> addresses;
+    std::optional<Address> home;
+    std::optional<int> age = 30;
+};
+TLS_CLIENT_JSON_FIELDS(User, id, name, score, active, visits, roles, addresses, home, age);
+
+struct Renamed {
+    std::string id;
+};
+
+template <>
+struct JsonFields<Renamed> {
+    static constexpr auto fields = std::make_tuple(makeJsonField("user_id", &Renamed::id));
+};
+
+static const std::string DOCUMENT = R"({
+    "id": 9007199254740993,
+    "ignored": {"nested": [1, {"id": "not this one"}, "]}"], "more": null},
+    "name": "caf\u00e9 \"quoted\" <b>&amp;</b>",
+    "score": -2.5e3,
+    "active": true,
+    "roles": ["admin", "ops\/dev"],
+    "addresses": [{"city": "Paris", "zip": "75001"}, {"city": "Lyon", "zip": null}],
+    "home": {"city": "Nice", "unknown": false},
+    "age": null
+})";
+
+TEST(JsonBindTest, TestDecode) {
+    Expected<User> user = JsonDecoder<User>::decode(DOCUMENT);
+    ASSERT_TRUE(user) << user.error().message;
+    ASSERT_EQ(user->id, 9007199254740993);
+    ASSERT_EQ(user->name, "caf\xC3\xA9 \"quoted\" <b>&amp;</b>");
+    ASSERT_EQ(user->score, -2500);
+    ASSERT_TRUE(user->active);
+    ASSERT_EQ(user->visits, 7u); // Missing keys keep their default
+    ASSERT_EQ(user->roles, (std::vector<std::string>{"admin", "ops/dev"}));
+    ASSERT_EQ(user->addresses.size(), 2u);
+    ASSERT_EQ(user->addresses[0].city, "Paris");
+    ASSERT_EQ(user->addresses[0].zip, "75001");
+    ASSERT_EQ(user->addresses[1].city, "Lyon");
+    ASSERT_FALSE(user->addresses[1].zip);
+    ASSERT_TRUE(user->home);
+    ASSERT_EQ(user->home->city, "Nice");
+    ASSERT_FALSE(user->age);
+}
+
+TEST(JsonBindTest, TestDecodeEscapedMatchesDecode) {
+    // The body of a response is kept escaped the way the library escapes it
+    std::string escaped;
+    JsonHelper::appendEscaped(escaped, DOCUMENT);
+
+    ResponseData responseData;
+    responseData.body = escaped;
+    Expected<User> user = JsonDecoder<User>::decodeBody(responseData);
+    ASSERT_TRUE(user) << user.error().message;
+    ASSERT_EQ(user->name, "caf\xC3\xA9 \"quoted\" <b>&amp;</b>");
+    ASSERT_EQ(user->roles, (std::vector<std::string>{"admin", "ops/dev"}));
+    ASSERT_EQ(user->addresses[1].city, "Lyon");
+    ASSERT_EQ(user->home->city, "Nice");
+}
+
+TEST(JsonBindTest, TestMismatch) {
+    for (std::string json : {"", "[]", "{\"id\": \"1\"}", "{\"id\": 1.5}", "{\"visits\": -1}", "{\"active\": 1}",
+             "{\"roles\": \"admin\"}", "{\"roles\": [1]}", "{\"home\": []}", "{\"id\": 1", "{\"id\": 1,}",
+             "{\"id\" 1}", "{\"ignored\": [}", "{} x", "{\"name\": \"\\q\"}"}) {
+        Expected<User> user = JsonDecoder<User>::decode(json);
+        ASSERT_FALSE(user) << json;
+        ASSERT_EQ(user.error().code, ErrorCode::Parse);
+    }
+
+    ASSERT_TRUE(JsonDecoder<User>::decode("{}"));
+    ASSERT_TRUE(JsonDecoder<User>::decode(" null "));
+    ASSERT_EQ(JsonDecoder<std::vector<int>>::decode("[1, 2, 3]").valueOr({}), (std::vector<int>{1, 2, 3}));
+}
+
+TEST(JsonBindTest, TestRenamedFields) {
+    Expected<Renamed> renamed = JsonDecoder<Renamed>::decode(R"({"id": "no", "user_id": "yes"})");
+    ASSERT_TRUE(renamed) << renamed.error().message;
+    ASSERT_EQ(renamed->id, "yes");
+}
+
+TEST(JsonBindTest, TestPerfectHash) {
+    constexpr std::array<std::string_view, 6> keys{"id", "name", "score", "active", "roles", "addresses"};
+    constexpr auto table = JsonPerfectHash<6>::build(keys);
+    static_assert(table.valid);
+    static_assert(table.find("score") == 2);
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT_EQ(table.find(keys[i]), i);
+    }
+    for (std::string_view key : {"", "i", "idx", "Name", "addresse", "zip"}) {
+        ASSERT_EQ(table.find(key), keys.size()) << key;
+    }
+
+    constexpr std::array<std::string_view, 2> duplicates{"id", "id"};
+    static_assert(!JsonPerfectHash<2>::build(duplicates).valid);
+}
+
+TEST(JsonBindTest, TestForEachRawField) {
+    std::string json = R"( {"id": "1", "body": "{\"a\": \"}\"}", "cookies": {"a": ["}", "b"]}, "status": 200} )";
+    std::vector<std::pair<std::string, std::string>> fields;
+    ASSERT_TRUE(JsonHelper::forEachRawField(json, [&](std::string_view name, std::string_view value) {
+        fields.emplace_back(name, value);
+        return true;
+    }));
+    ASSERT_EQ(fields, (std::vector<std::pair<std::string, std::string>>{{"id", R"("1")"},
+        {"body", R"("{\"a\": \"}\"}")"}, {"cookies", R"({"a": ["}", "b"]})"}, {"status", "200"}}));
+
+    size_t visited = 0;
+    ASSERT_TRUE(JsonHelper::forEachRawField(json, [&](std::string_view, std::string_view) { return ++visited < 2; }));
+    ASSERT_EQ(visited, 2u);
+
+    for (std::string malformed : {"", "[]", R"({"a")", R"({"a": })", R"({"a": "b)", R"({"a": 1 "b": 2})"}) {
+        ASSERT_FALSE(JsonHelper::forEachRawField(malformed, [](std::string_view, std::string_view) { return true; }))
+            << malformed;
+    }
+}
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+struct EchoArgs {
+    std::string q;
+};
+TLS_CLIENT_JSON_FIELDS(EchoArgs, q);
+
+struct Echo {
+    std::string method;
+    std::string url;
+    EchoArgs args;
+};
+TLS_CLIENT_JSON_FIELDS(Echo, method, url, args);
+
+TEST(JsonBindTest, TestGetJson) {
+    LoopbackServer server;
+    Session session{SessionData()};
+
+    RequestData requestData;
+    requestData.url = server.url("/get?q=<1>");
+    requestData.insecureSkipVerify = true;
+    Expected<Echo> echo = session.getJson<Echo>(requestData);
+    ASSERT_TRUE(echo) << echo.error().message;
+    ASSERT_EQ(echo->method, "GET");
+    ASSERT_EQ(echo->url, requestData.url);
+    ASSERT_EQ(echo->args.q, "<1>");
+    ASSERT_EQ(session.getStats().requests, 1u);
+
+    requestData.url = server.url("/status/404");
+    echo = session.getJson<Echo>(requestData);
+    ASSERT_FALSE(echo);
+    ASSERT_EQ(echo.error().code, ErrorCode::Request);
+
+    requestData.url = server.url("/bytes/4");
+    echo = session.getJson<Echo>(requestData);
+    ASSERT_FALSE(echo);
+    ASSERT_EQ(echo.error().code, ErrorCode::Parse);
+
+    requestData.url = "https://127.0.0.1:1/get";
+    echo = session.getJson<Echo>(requestData);
+    ASSERT_FALSE(echo);
+    ASSERT_EQ(echo.error().code, ErrorCode::Connection);
+    ASSERT_EQ(session.getStats().failures, 1u);
+}
+
+TEST(JsonBindTest, TestGetJsonWithSinks) {
+    // Sinks are passed the ResponseData, so the body is read from it
+    struct CountingSink : ResponseSink {
+        std::atomic<size_t> responses{0};
+        void consume(const RequestData&, const std::string&, ResponseData&) override { ++responses; }
+    };
+
+    LoopbackServer server;
+    auto sink = std::make_shared<CountingSink>();
+    SessionData sessionData;
+    sessionData.sinks.push_back(sink);
+    Session session(sessionData);
+
+    RequestData requestData;
+    requestData.url = server.url("/anything?q=1");
+    requestData.insecureSkipVerify = true;
+    Expected<Echo> echo = session.getJson<Echo>(requestData);
+    ASSERT_TRUE(echo) << echo.error().message;
+    ASSERT_EQ(echo->args.q, "1");
+    ASSERT_EQ(sink->responses, 1u);
+}
+#endif
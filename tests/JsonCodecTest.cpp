@@ -0,0 +1,142 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client.hpp"
+
+template <typename Codec>
+class JsonCodecTest : public ::testing::Test {
+protected:
+    const std::string response =
+        R"({"id":"1","body":"<p class=\"title\">Hello</p>",)"
+        R"("cookies":{"session":"abc"},"headers":{"Content-Type":["application/json"]},)"
+        R"("sessionId":"","status":200,"target":"https://httpbin.org/get","usedProtocol":"HTTP/2.0"})";
+};
+
+using Codecs = ::testing::Types<
+    JsonHelper
+#if defined(TLS_CLIENT_HAS_YYJSON)
+    , YyjsonCodec
+#endif
+#if defined(TLS_CLIENT_HAS_SIMDJSON)
+    , SimdjsonCodec
+#endif
+>;
+
+TYPED_TEST_SUITE(JsonCodecTest, Codecs);
+
+TYPED_TEST(JsonCodecTest, TestParseResponse) {
+    ResponseData responseData = TypeParam::parseResponse(this->response);
+
+    ASSERT_EQ(responseData.statusCode, 200);
+    ASSERT_EQ(responseData.body, R"(<p class=\"title\">Hello</p>)");
+    ASSERT_EQ(responseData.cookies, R"({"session":"abc"})");
+    ASSERT_EQ(responseData.headers, R"({"Content-Type":["application/json"]})");
+    ASSERT_EQ(responseData.target, "https://httpbin.org/get");
+    ASSERT_EQ(responseData.usedProtocol, "HTTP/2.0");
+}
+
+TYPED_TEST(JsonCodecTest, TestParseJsonBody) {
+    // Braces, spaces and escaped quotes inside the body are kept as they are
+    std::string response = R"({"body":"{\"a\": {\"b\": [{\"c\": \"} {\\\" x\"}]}}","cookies":{},)"
+        R"("headers":{"A":["1, 2"]},"status":200,"target":"t","usedProtocol":"HTTP/1.1"})";
+    ResponseData responseData = TypeParam::parseResponse(response);
+
+    ASSERT_EQ(responseData.statusCode, 200);
+    ASSERT_EQ(responseData.body, R"({\"a\": {\"b\": [{\"c\": \"} {\\\" x\"}]}})");
+    ASSERT_EQ(responseData.headers, R"({"A":["1, 2"]})");
+    ASSERT_EQ(responseData.target, "t");
+}
+
+TYPED_TEST(JsonCodecTest, TestBuildJson) {
+    std::unordered_map<std::string, std::any> data;
+    data["requestUrl"] = std::string("https://httpbin.org/get");
+    data["headers"] = std::string(R"({"accept":"*/*"})");
+    data["timeoutSeconds"] = 30;
+    data["debug"] = false;
+
+    std::string json = TypeParam::buildJson(data);
+
+    ASSERT_EQ(json.front(), '{');
+    ASSERT_EQ(json.back(), '}');
+    ASSERT_NE(json.find(R"("https://httpbin.org/get")"), std::string::npos);
+    ASSERT_NE(json.find(R"({"accept":"*/*"})"), std::string::npos);
+    ASSERT_NE(json.find("30"), std::string::npos);
+    ASSERT_NE(json.find("false"), std::string::npos);
+}
+
+TYPED_TEST(JsonCodecTest, TestBuildJsonEscapesStrings) {
+    std::unordered_map<std::string, std::any> data;
+    data["requestBody"] = std::string("say \"hi\"\n\\ {x}");
+    data["requestUrl"] = std::string("{not json");
+
+    std::string json = TypeParam::buildJson(data);
+
+    ASSERT_NE(json.find(R"("say \"hi\"\n\\ {x}")"), std::string::npos) << json;
+    ASSERT_NE(json.find(R"("{not json")"), std::string::npos) << json;
+}
+
+TYPED_TEST(JsonCodecTest, TestBuildJsonEmbedsOnlyObjectFields) {
+    // Only the fields the library reads as an object or array are embedded
+    std::unordered_map<std::string, std::any> data;
+    data["requestBody"] = std::string(R"({"a": 1})");
+    data["requestUrl"] = std::string("[1]");
+    data["ja3String"] = std::string("{}");
+    data["headers"] = std::string(R"({"x": "1"})");
+    data["headerOrder"] = std::string(R"(["x"])");
+
+    std::string json = TypeParam::buildJson(data);
+
+    ASSERT_NE(json.find(R"("{\"a\": 1}")"), std::string::npos) << json;
+    ASSERT_NE(json.find(R"("[1]")"), std::string::npos) << json;
+    ASSERT_NE(json.find(R"("{}")"), std::string::npos) << json;
+    ASSERT_NE(json.find(R"({"x": "1"})"), std::string::npos) << json;
+    ASSERT_NE(json.find(R"(["x"])"), std::string::npos) << json;
+    ASSERT_EQ(json.find(R"("["x"]")"), std::string::npos) << json;
+}
+
+TYPED_TEST(JsonCodecTest, TestSessionInstantiation) {
+    SessionData sessionData;
+    BasicSession<TypeParam> session(sessionData);
+    (void)session;
+}
+
+TEST(JsonEscapeTest, TestEscapeAtEveryOffset) {
+    // Special characters at every offset of the blocks scanned at once, and of the tail
+    for (std::string special : {"\"", "\\", "\n", "\x01", "<", "&", "\xc3\xa9", "\xe2\x80\xa8", "\xf0\x9f\x98\x80",
+             "\xff", "\x7f"}) {
+        std::string expected;
+        JsonHelper::appendEscaped(expected, special);
+
+        for (size_t length : {15u, 16u, 31u, 32u, 33u, 70u}) {
+            for (size_t position = 0; position + special.size() <= length; ++position) {
+                std::string value(length, 'a');
+                value.replace(position, special.size(), special);
+
+                std::string escaped;
+                JsonHelper::appendEscaped(escaped, value);
+                ASSERT_EQ(escaped, std::string(position, 'a') + expected +
+                    std::string(length - position - special.size(), 'a')) << position;
+            }
+        }
+    }
+}
+
+TEST(JsonEscapeTest, TestUnescapeHeaderValues) {
+    std::string headers = R"({"Link":["\u003chttps://a/?x=1\u0026y=2\u003e; rel=\"next\""],)"
+        R"("X-Emoji":["\ud83d\ude00 \ud83d \/\t"]})";
+
+    ASSERT_EQ(ResponseData::findHeader(headers, "link"), R"(<https://a/?x=1&y=2>; rel="next")");
+    ASSERT_EQ(ResponseData::findHeader(headers, "x-emoji"), "\xf0\x9f\x98\x80 \xef\xbf\xbd /\t");
+
+    // Malformed escape sequences are kept as they are
+    std::string unescaped;
+    JsonHelper::appendUnescaped(unescaped, "\\u00zz \\q \xc3\xa9\\");
+    ASSERT_EQ(unescaped, "\\u00zz \\q \xc3\xa9\\");
+}
@@ -0,0 +1,145 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_json_sax.hpp"
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+#include "LoopbackServer.hpp"
+#endif
+
+// Records every callback as a line
+struct RecordingVisitor : JsonVisitor {
+    std::string log;
+
+    bool onObjectStart() { log += "{\n"; return true; }
+    bool onObjectEnd() { log += "}\n"; return true; }
+    bool onArrayStart() { log += "[\n"; return true; }
+    bool onArrayEnd() { log += "]\n"; return true; }
+    bool onKey(std::string_view key) { log += "key " + std::string(key) + "\n"; return true; }
+    bool onString(std::string_view value) { log += "string " + std::string(value) + "\n"; return true; }
+    bool onNumber(std::string_view value) { log += "number " + std::string(value) + "\n"; return true; }
+    bool onBool(bool value) { log += value ? "true\n" : "false\n"; return true; }
+    bool onNull() { log += "null\n"; return true; }
+};
+
+static const std::string DOCUMENT = R"({
+    "name": "caf\u00e9 \"quoted\" <b>&amp;</b>",
+    "emoji": "\ud83d\ude00 and \ud83d alone",
+    "path": "C:\\temp\/x\n",
+    "values": [1, -2.5e3, true, false, null, [], {}],
+    "nested": {"a": [{"b": "c"}], "empty": ""}
+})";
+
+TEST(JsonSaxTest, TestVisit) {
+    RecordingVisitor visitor;
+    auto result = JsonSax::visit(DOCUMENT, visitor);
+    ASSERT_TRUE(result) << result.error().message;
+    ASSERT_TRUE(*result);
+    ASSERT_EQ(visitor.log,
+        "{\n"
+        "key name\nstring caf\xC3\xA9 \"quoted\" <b>&amp;</b>\n"
+        "key emoji\nstring \xF0\x9F\x98\x80 and \xEF\xBF\xBD alone\n"
+        "key path\nstring C:\\temp/x\n\n"
+        "key values\n[\nnumber 1\nnumber -2.5e3\ntrue\nfalse\nnull\n[\n]\n{\n}\n]\n"
+        "key nested\n{\nkey a\n[\n{\nkey b\nstring c\n}\n]\nkey empty\nstring \n}\n"
+        "}\n");
+}
+
+TEST(JsonSaxTest, TestVisitEscapedMatchesVisit) {
+    RecordingVisitor plain;
+    ASSERT_TRUE(JsonSax::visit(DOCUMENT, plain));
+
+    // The body of a response is kept escaped the way the library escapes it
+    std::string escaped;
+    JsonHelper::appendEscaped(escaped, DOCUMENT);
+    ASSERT_NE(escaped.find("\\u003c"), std::string::npos);
+
+    RecordingVisitor visitor;
+    auto result = JsonSax::visitEscaped(escaped, visitor);
+    ASSERT_TRUE(result) << result.error().message;
+    ASSERT_TRUE(*result);
+    ASSERT_EQ(visitor.log, plain.log);
+
+    ResponseData responseData;
+    responseData.body = escaped;
+    RecordingVisitor bodyVisitor;
+    ASSERT_TRUE(JsonSax::visitBody(responseData, bodyVisitor));
+    ASSERT_EQ(bodyVisitor.log, plain.log);
+}
+
+TEST(JsonSaxTest, TestMalformed) {
+    for (std::string json : {"", "{", "{\"a\":}", "{\"a\" 1}", "[1,2", "[1 2]", "{} x", "\"\\q\"", "tru",
+             "{\"a\":1,}", "[\"\\ud83d\\u00\"]", "}", "-", "1.2.3", "1e", "+1", "[01]", "1.", ".5", "-e1",
+             "1e+", "2-1"}) {
+        RecordingVisitor visitor;
+        auto result = JsonSax::visit(json, visitor);
+        ASSERT_FALSE(result) << json;
+        ASSERT_EQ(result.error().code, ErrorCode::Parse);
+
+        std::string escaped;
+        JsonHelper::appendEscaped(escaped, json);
+        ASSERT_FALSE(JsonSax::visitEscaped(escaped, visitor)) << json;
+    }
+
+    // Numbers at the edges of the grammar
+    for (std::string json : {"0", "-0", "0.5", "10E+2", "1e-07"}) {
+        RecordingVisitor numbers;
+        ASSERT_TRUE(JsonSax::visit(json, numbers)) << json;
+        ASSERT_EQ(numbers.log, "number " + json + "\n");
+    }
+
+    // A broken escape sequence of the envelope
+    RecordingVisitor visitor;
+    ASSERT_FALSE(JsonSax::visitEscaped(R"({\"a\": \u12)", visitor));
+}
+
+TEST(JsonSaxTest, TestFieldExtractorStopsEarly) {
+    // Everything after the last field is never read, so the truncated tail does not matter
+    std::string json = R"({"data": {"id": 42, "items": [{"name": "first"}, {"name": "a\/b"}]}, "meta": [1, 2,)";
+    JsonFieldExtractor fields({"/data/id", "/data/items/1/name", "/missing"});
+    auto result = JsonSax::visit(json, fields);
+    ASSERT_FALSE(result); // Without /missing, the document runs out
+    ASSERT_EQ(fields.get("/data/id"), "42");
+    ASSERT_EQ(fields.get("/data/items/1/name"), "a/b");
+    ASSERT_FALSE(fields.get("/missing"));
+    ASSERT_FALSE(fields.complete());
+
+    JsonFieldExtractor found({"/data/id", "/data/items/1/name"});
+    result = JsonSax::visit(json, found);
+    ASSERT_TRUE(result);
+    ASSERT_FALSE(*result);
+    ASSERT_TRUE(found.complete());
+
+    JsonFieldExtractor escapedKeys({"/a~1b/c~0d", "/list/0"});
+    ASSERT_TRUE(JsonSax::visit(R"({"x": {"list": [0]}, "a/b": {"c~d": null}, "list": ["v"]})", escapedKeys));
+    ASSERT_EQ(escapedKeys.get("/a~1b/c~0d"), "null");
+    ASSERT_EQ(escapedKeys.get("/list/0"), "v");
+}
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+TEST(JsonSaxTest, TestResponseBody) {
+    LoopbackServer server;
+    Session session{SessionData()};
+
+    RequestData requestData;
+    requestData.url = server.url("/anything?q=1");
+    requestData.data = "<x> & y";
+    requestData.insecureSkipVerify = true;
+    auto response = session.tryPOST(requestData);
+    ASSERT_TRUE(response) << response.error().message;
+
+    JsonFieldExtractor fields({"/method", "/args/q", "/data"});
+    auto result = JsonSax::visitBody(*response, fields);
+    ASSERT_TRUE(result) << result.error().message;
+    ASSERT_EQ(fields.get("/method"), "POST");
+    ASSERT_EQ(fields.get("/args/q"), "1");
+    ASSERT_EQ(fields.get("/data"), "<x> & y");
+}
+#endif
@@ -0,0 +1,814 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#pragma once
+
+#include "../include/tls_client.hpp"
+
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if defined(TLS_CLIENT_HAS_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(TLS_CLIENT_HAS_NGHTTP2)
+#include <nghttp2/nghttp2.h>
+#endif
+
+/**
+ * @brief LoopbackServerOptions struct containing the options of a loopback server.
+ */
+struct LoopbackServerOptions {
+    bool tls = true;    /**< Whether to serve HTTPS rather than plain HTTP. */
+    bool http2 = true;  /**< Whether to offer HTTP/2 over TLS (when built with nghttp2). */
+    uint16_t port = 0;  /**< The port to listen on, 0 for an ephemeral one. */
+};
+
+/**
+ * @brief LoopbackServer class serving httpbin-like endpoints on 127.0.0.1 for tests and benchmarks.
+ *
+ * The server listens over TLS with a self-signed certificate generated at
+ * startup (for localhost and 127.0.0.1), or in plain text. Over TLS, HTTP/2
+ * is negotiated with ALPN when built with nghttp2; otherwise HTTP/1.1 is
+ * used. Connections are kept alive and served by one thread each.
+ *
+ * Endpoints:
+ * - `/get`, `/post`, `/put`, `/patch`, `/delete`, `/anything/...`: echo the
+ *   request as JSON, like httpbin (args, data, headers, method, origin, url)
+ * - `/bytes/N`: N bytes
+ * - `/gzip/N`: N bytes compressed with gzip (when built with zlib)
+ * - `/status/N`: an empty response with status N
+ * - `/redirect/N`: a 302 redirect to /redirect/N-1, and /redirect/0 answers "redirected"
+ * - `/redirect-to?url=URL`: a 302 redirect to the percent-decoded URL
+ * - `/etag/TAG`: an echo with ETag "TAG", or 304 if If-None-Match matches
+ * - `/cookies/set?name=value`: sets a cookie
+ * - `/close`: a response closing the connection
+ *
+ * Every endpoint accepts these query parameters:
+ * - `delay=MS`: waits before answering
+ * - `status=N`: overrides the status code
+ * - `chunked=1`: sends the body in chunks of `chunk_size` bytes (1000 by default)
+ *   instead of with a Content-Length
+ */
+class LoopbackServer {
+public:
+    /**
+     * @brief Starts the server.
+     *
+     * @param options The options of the server.
+     */
+    explicit LoopbackServer(LoopbackServerOptions options = {}) : options(options) {
+        // Clients may close a connection before its response is written
+        ::signal(SIGPIPE, SIG_IGN);
+
+        if (options.tls) {
+            createCertificate();
+        }
+
+        listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(options.port);
+        socklen_t length = sizeof(address);
+        if (::bind(listener, reinterpret_cast<sockaddr*>(&address), length) != 0 || ::listen(listener, 1024) != 0 ||
+            ::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            std::string message = std::string("Failed to listen: ") + std::strerror(errno);
+            ::close(listener);
+            throw std::runtime_error(message);
+        }
+        boundPort = ntohs(address.sin_port);
+
+        acceptor = std::thread([this] { acceptLoop(); });
+    }
+
+    LoopbackServer(const LoopbackServer&) = delete;
+    LoopbackServer& operator=(const LoopbackServer&) = delete;
+
+    /**
+     * @brief Stops the server, closing every connection.
+     */
+    ~LoopbackServer() {
+        stopping = true;
+        ::shutdown(listener, SHUT_RDWR);
+        ::close(listener);
+        acceptor.join();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int client : clients) {
+                ::shutdown(client, SHUT_RDWR);
+            }
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        SSL_CTX_free(context);
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+    }
+
+    /**
+     * @brief Returns the port the server listens on.
+     */
+    [[nodiscard]] uint16_t port() const noexcept { return boundPort; }
+
+    /**
+     * @brief Returns the URL of a path on the server, e.g. url("/bytes/10").
+     */
+    [[nodiscard]] std::string url(std::string_view path) const {
+        return std::string(options.tls ? "https" : "http") + "://127.0.0.1:" + std::to_string(boundPort) +
+            std::string(path);
+    }
+
+    /**
+     * @brief Returns the certificate of the server in PEM format, to trust it explicitly.
+     */
+    [[nodiscard]] std::string certificatePem() const {
+        if (!certificate) {
+            return "";
+        }
+        BIO* bio = BIO_new(BIO_s_mem());
+        PEM_write_bio_X509(bio, certificate);
+        char* data = nullptr;
+        long length = BIO_get_mem_data(bio, &data);
+        std::string pem(data, static_cast<size_t>(length));
+        BIO_free(bio);
+        return pem;
+    }
+
+    /**
+     * @brief Returns the number of connections accepted so far.
+     */
+    [[nodiscard]] uint64_t connectionsAccepted() const noexcept { return accepted.load(); }
+
+    /**
+     * @brief Returns the number of requests answered so far.
+     */
+    [[nodiscard]] uint64_t requestsServed() const noexcept { return served.load(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    LoopbackServerOptions options;
+    int listener = -1;
+    uint16_t boundPort = 0;
+    SSL_CTX* context = nullptr;
+    X509* certificate = nullptr;
+    EVP_PKEY* key = nullptr;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> served{0};
+    std::thread acceptor;
+    std::mutex mutex;
+    std::vector<std::thread> workers;
+    std::vector<int> clients;
+
+    /**
+     * @brief Request struct containing a parsed request, with lowercase header names.
+     */
+    struct Request {
+        std::string origin; /**< The address of the client. */
+        std::string scheme;
+        std::string method;
+        std::string path;
+        std::string query;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+    };
+
+    /**
+     * @brief Reply struct containing the response to a request.
+     */
+    struct Reply {
+        int status = 200;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+        std::chrono::milliseconds delay{0};
+        size_t chunkSize = 0; /**< The chunk size of a chunked body, 0 for a Content-Length. */
+        bool close = false;
+    };
+
+    /**
+     * @brief Stream struct reading and writing a plain or TLS connection.
+     */
+    struct Stream {
+        int socket;
+        SSL* ssl;
+        std::string buffer;
+
+        bool read() {
+            char chunk[16 * 1024];
+            int count = ssl ? SSL_read(ssl, chunk, sizeof(chunk))
+                            : static_cast<int>(::recv(socket, chunk, sizeof(chunk), 0));
+            if (count <= 0) {
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(count));
+            return true;
+        }
+
+        bool write(std::string_view data) {
+            while (!data.empty()) {
+                int count = ssl ? SSL_write(ssl, data.data(), static_cast<int>(data.size()))
+                                : static_cast<int>(::send(socket, data.data(), data.size(), MSG_NOSIGNAL));
+                if (count <= 0) {
+                    return false;
+                }
+                data.remove_prefix(static_cast<size_t>(count));
+            }
+            return true;
+        }
+    };
+
+    void createCertificate() {
+        EVP_PKEY_CTX* keyContext = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+        EVP_PKEY_keygen_init(keyContext);
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(keyContext, NID_X9_62_prime256v1);
+        EVP_PKEY_keygen(keyContext, &key);
+        EVP_PKEY_CTX_free(keyContext);
+
+        certificate = X509_new();
+        X509_set_version(certificate, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(certificate), -3600);
+        X509_gmtime_adj(X509_getm_notAfter(certificate), 7 * 24 * 3600);
+        X509_set_pubkey(certificate, key);
+
+        X509_NAME* name = X509_get_subject_name(certificate);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"),
+            -1, -1, 0);
+        X509_set_issuer_name(certificate, name);
+
+        X509V3_CTX extensionContext;
+        X509V3_set_ctx_nodb(&extensionContext);
+        X509V3_set_ctx(&extensionContext, certificate, certificate, nullptr, nullptr, 0);
+        for (auto [nid, value] : {std::pair{NID_subject_alt_name, "DNS:localhost,IP:127.0.0.1"},
+                                  std::pair{NID_basic_constraints, "critical,CA:TRUE"}}) {
+            X509_EXTENSION* extension = X509V3_EXT_conf_nid(nullptr, &extensionContext, nid, value);
+            X509_add_ext(certificate, extension, -1);
+            X509_EXTENSION_free(extension);
+        }
+        X509_sign(certificate, key, EVP_sha256());
+
+        context = SSL_CTX_new(TLS_server_method());
+        SSL_CTX_use_certificate(context, certificate);
+        SSL_CTX_use_PrivateKey(context, key);
+        SSL_CTX_set_alpn_select_cb(context, &LoopbackServer::selectProtocol, this);
+    }
+
+    static int selectProtocol(SSL*, const unsigned char** out, unsigned char* outLength, const unsigned char* in,
+        unsigned int inLength, void* argument) {
+        static const unsigned char BOTH[] = "\x02h2\x08http/1.1";
+        static const unsigned char HTTP1[] = "\x08http/1.1";
+
+#if defined(TLS_CLIENT_HAS_NGHTTP2)
+        bool http2 = static_cast<LoopbackServer*>(argument)->options.http2;
+#else
+        bool http2 = false;
+        (void)argument;
+#endif
+        const unsigned char* protocols = http2 ? BOTH : HTTP1;
+        unsigned int length = http2 ? sizeof(BOTH) - 1 : sizeof(HTTP1) - 1;
+        if (SSL_select_next_proto(const_cast<unsigned char**>(out), outLength, protocols, length, in, inLength) !=
+            OPENSSL_NPN_NEGOTIATED) {
+            return SSL_TLSEXT_ERR_NOACK;
+        }
+        return SSL_TLSEXT_ERR_OK;
+    }
+
+    void acceptLoop() {
+        while (!stopping) {
+            int client = ::accept(listener, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+
+            int one = 1;
+            ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            ++accepted;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                ::close(client);
+                break;
+            }
+            clients.push_back(client);
+            workers.emplace_back([this, client] { serve(client); });
+        }
+    }
+
+    void serve(int client) {
+        SSL* ssl = nullptr;
+        if (options.tls) {
+            ssl = SSL_new(context);
+            SSL_set_fd(ssl, client);
+        }
+
+        sockaddr_in peer{};
+        socklen_t peerLength = sizeof(peer);
+        char origin[INET_ADDRSTRLEN] = "";
+        ::getpeername(client, reinterpret_cast<sockaddr*>(&peer), &peerLength);
+        ::inet_ntop(AF_INET, &peer.sin_addr, origin, sizeof(origin));
+
+        Stream stream{client, ssl, {}};
+        if (!ssl || SSL_accept(ssl) == 1) {
+            const unsigned char* protocol = nullptr;
+            unsigned int protocolLength = 0;
+            if (ssl) {
+                SSL_get0_alpn_selected(ssl, &protocol, &protocolLength);
+            }
+
+#if defined(TLS_CLIENT_HAS_NGHTTP2)
+            if (protocolLength == 2 && std::memcmp(protocol, "h2", 2) == 0) {
+                serveHttp2(stream, origin);
+            } else
+#endif
+            {
+                serveHttp1(stream, origin);
+            }
+        }
+
+        if (ssl) {
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        clients.erase(std::find(clients.begin(), clients.end(), client));
+        ::close(client);
+    }
+
+    void serveHttp1(Stream& stream, const std::string& origin) {
+        Request request;
+        request.origin = origin;
+        request.scheme = options.tls ? "https" : "http";
+
+        while (readRequest(stream, request)) {
+            Reply reply = handle(request);
+            if (reply.delay.count() > 0) {
+                std::this_thread::sleep_for(reply.delay);
+            }
+
+            bool close = reply.close || headerValue(request, "connection") == "close";
+            if (close) {
+                reply.headers.emplace_back("Connection", "close");
+            }
+            if (!stream.write(serialize(request, reply))) {
+                break;
+            }
+            ++served;
+            if (close) {
+                break;
+            }
+        }
+    }
+
+    static bool readRequest(Stream& stream, Request& request) {
+        size_t end;
+        while ((end = stream.buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!stream.read()) {
+                return false;
+            }
+        }
+
+        std::string head = stream.buffer.substr(0, end + 2);
+        stream.buffer.erase(0, end + 4);
+
+        size_t methodEnd = head.find(' ');
+        size_t targetEnd = head.find(' ', methodEnd + 1);
+        request.method = head.substr(0, methodEnd);
+        setTarget(request, head.substr(methodEnd + 1, targetEnd - methodEnd - 1));
+        request.headers.clear();
+
+        for (size_t start = head.find("\r\n") + 2; start < head.size();) {
+            size_t next = head.find("\r\n", start);
+            std::string line = head.substr(start, next - start);
+            start = next + 2;
+
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string name = line.substr(0, colon);
+            std::transform(name.begin(), name.end(), name.begin(),
+                [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+            size_t valueStart = line.find_first_not_of(' ', colon + 1);
+            request.headers.emplace_back(name, valueStart == std::string::npos ? "" : line.substr(valueStart));
+        }
+
+        size_t length = 0;
+        if (std::string contentLength = headerValue(request, "content-length"); !contentLength.empty()) {
+            length = std::stoul(contentLength);
+        }
+        while (stream.buffer.size() < length) {
+            if (!stream.read()) {
+                return false;
+            }
+        }
+        request.body = stream.buffer.substr(0, length);
+        stream.buffer.erase(0, length);
+        return true;
+    }
+
+    static std::string serialize(const Request& request, const Reply& reply) {
+        std::string response = "HTTP/1.1 " + std::to_string(reply.status) + " Status\r\n";
+        for (const auto& [name, value] : reply.headers) {
+            response += name + ": " + value + "\r\n";
+        }
+
+        bool bodyless = request.method == "HEAD" || reply.status == 204 || reply.status == 304;
+        if (reply.chunkSize == 0 || bodyless) {
+            response += "Content-Length: " + std::to_string(reply.body.size()) + "\r\n\r\n";
+            if (!bodyless) {
+                response += reply.body;
+            }
+            return response;
+        }
+
+        response += "Transfer-Encoding: chunked\r\n\r\n";
+        for (size_t offset = 0; offset < reply.body.size(); offset += reply.chunkSize) {
+            size_t size = std::min(reply.chunkSize, reply.body.size() - offset);
+            char line[32];
+            std::snprintf(line, sizeof(line), "%zx\r\n", size);
+            response += line;
+            response.append(reply.body, offset, size).append("\r\n");
+        }
+        return response + "0\r\n\r\n";
+    }
+
+#if defined(TLS_CLIENT_HAS_NGHTTP2)
+    /**
+     * @brief Http2Stream struct containing the state of an HTTP/2 stream.
+     */
+    struct Http2Stream {
+        Request request;
+        Reply reply;
+        size_t offset = 0;
+        Clock::time_point readyAt;
+    };
+
+    /**
+     * @brief Http2Connection struct containing the state of an HTTP/2 connection.
+     */
+    struct Http2Connection {
+        LoopbackServer* server;
+        Stream* stream;
+        std::string origin;
+        std::map<int32_t, Http2Stream> streams;
+        std::vector<int32_t> waiting; /**< Streams with a complete request whose reply is not submitted yet. */
+    };
+
+    void serveHttp2(Stream& stream, const std::string& origin) {
+        Http2Connection connection{this, &stream, origin, {}, {}};
+
+        nghttp2_session_callbacks* callbacks = nullptr;
+        nghttp2_session_callbacks_new(&callbacks);
+        nghttp2_session_callbacks_set_send_callback(callbacks, [](nghttp2_session*, const uint8_t* data,
+            size_t length, int, void* user) -> ssize_t {
+            auto* connection = static_cast<Http2Connection*>(user);
+            bool written = connection->stream->write({reinterpret_cast<const char*>(data), length});
+            return written ? static_cast<ssize_t>(length) : NGHTTP2_ERR_CALLBACK_FAILURE;
+        });
+        nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks, [](nghttp2_session*,
+            const nghttp2_frame* frame, void* user) -> int {
+            auto* connection = static_cast<Http2Connection*>(user);
+            if (frame->hd.type == NGHTTP2_HEADERS && frame->headers.cat == NGHTTP2_HCAT_REQUEST) {
+                Request& request = connection->streams[frame->hd.stream_id].request;
+                request.origin = connection->origin;
+                request.scheme = "https";
+            }
+            return 0;
+        });
+        nghttp2_session_callbacks_set_on_header_callback(callbacks, [](nghttp2_session*, const nghttp2_frame* frame,
+            const uint8_t* name, size_t nameLength, const uint8_t* value, size_t valueLength, uint8_t,
+            void* user) -> int {
+            auto* connection = static_cast<Http2Connection*>(user);
+            auto it = connection->streams.find(frame->hd.stream_id);
+            if (it == connection->streams.end()) {
+                return 0;
+            }
+
+            Request& request = it->second.request;
+            std::string headerName(reinterpret_cast<const char*>(name), nameLength);
+            std::string headerValue(reinterpret_cast<const char*>(value), valueLength);
+            if (headerName == ":method") {
+                request.method = headerValue;
+            } else if (headerName == ":path") {
+                setTarget(request, headerValue);
+            } else if (headerName == ":authority") {
+                request.headers.emplace_back("host", headerValue);
+            } else if (headerName[0] != ':') {
+                request.headers.emplace_back(headerName, headerValue);
+            }
+            return 0;
+        });
+        nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, [](nghttp2_session*, uint8_t,
+            int32_t streamId, const uint8_t* data, size_t length, void* user) -> int {
+            auto* connection = static_cast<Http2Connection*>(user);
+            if (auto it = connection->streams.find(streamId); it != connection->streams.end()) {
+                it->second.request.body.append(reinterpret_cast<const char*>(data), length);
+            }
+            return 0;
+        });
+        nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, [](nghttp2_session*,
+            const nghttp2_frame* frame, void* user) -> int {
+            auto* connection = static_cast<Http2Connection*>(user);
+            bool request = frame->hd.type == NGHTTP2_HEADERS || frame->hd.type == NGHTTP2_DATA;
+            auto it = connection->streams.find(frame->hd.stream_id);
+            if (request && (frame->hd.flags & NGHTTP2_FLAG_END_STREAM) && it != connection->streams.end()) {
+                it->second.reply = connection->server->handle(it->second.request);
+                it->second.readyAt = Clock::now() + it->second.reply.delay;
+                connection->waiting.push_back(frame->hd.stream_id);
+            }
+            return 0;
+        });
+        nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, [](nghttp2_session*, int32_t streamId,
+            uint32_t, void* user) -> int {
+            auto* connection = static_cast<Http2Connection*>(user);
+            connection->streams.erase(streamId);
+            connection->waiting.erase(std::remove(connection->waiting.begin(), connection->waiting.end(), streamId),
+                connection->waiting.end());
+            return 0;
+        });
+
+        nghttp2_session* session = nullptr;
+        nghttp2_session_server_new(&session, callbacks, &connection);
+        nghttp2_session_callbacks_del(callbacks);
+
+        nghttp2_settings_entry settings[] = {{NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 1000}};
+        nghttp2_submit_settings(session, NGHTTP2_FLAG_NONE, settings, 1);
+
+        for (;;) {
+            // Submit the replies whose delay has passed; streams answer out of order
+            Clock::time_point now = Clock::now();
+            std::optional<Clock::time_point> next;
+            for (size_t i = 0; i < connection.waiting.size();) {
+                Http2Stream& http2Stream = connection.streams[connection.waiting[i]];
+                if (http2Stream.readyAt > now) {
+                    next = next ? std::min(*next, http2Stream.readyAt) : http2Stream.readyAt;
+                    ++i;
+                    continue;
+                }
+                submitReply(session, connection.waiting[i], http2Stream);
+                connection.waiting.erase(connection.waiting.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+
+            if (nghttp2_session_send(session) != 0 ||
+                (!nghttp2_session_want_read(session) && !nghttp2_session_want_write(session))) {
+                break;
+            }
+
+            if (SSL_pending(stream.ssl) == 0) {
+                int timeout = next ? static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    *next - Clock::now()).count()) + 1 : -1;
+                pollfd descriptor{stream.socket, POLLIN, 0};
+                int ready = ::poll(&descriptor, 1, timeout);
+                if (ready < 0 && errno != EINTR) {
+                    break;
+                }
+                if (ready <= 0) {
+                    continue;
+                }
+            }
+
+            stream.buffer.clear();
+            if (!stream.read() || nghttp2_session_mem_recv(session,
+                reinterpret_cast<const uint8_t*>(stream.buffer.data()), stream.buffer.size()) < 0) {
+                break;
+            }
+        }
+
+        nghttp2_session_del(session);
+    }
+
+    void submitReply(nghttp2_session* session, int32_t streamId, Http2Stream& http2Stream) {
+        Reply& reply = http2Stream.reply;
+        bool bodyless = http2Stream.request.method == "HEAD" || reply.status == 204 || reply.status == 304;
+
+        // HTTP/2 header names are lowercase, and there is no chunked encoding
+        std::vector<std::pair<std::string, std::string>> headers{{":status", std::to_string(reply.status)}};
+        for (const auto& [name, value] : reply.headers) {
+            std::string lowered = name;
+            std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+            headers.emplace_back(lowered, value);
+        }
+        if (reply.chunkSize == 0) {
+            headers.emplace_back("content-length", std::to_string(reply.body.size()));
+        }
+
+        std::vector<nghttp2_nv> nameValues;
+        for (auto& [name, value] : headers) {
+            nameValues.push_back({reinterpret_cast<uint8_t*>(name.data()), reinterpret_cast<uint8_t*>(value.data()),
+                name.size(), value.size(), NGHTTP2_NV_FLAG_NONE});
+        }
+
+        nghttp2_data_provider provider{};
+        provider.source.ptr = &http2Stream;
+        provider.read_callback = [](nghttp2_session*, int32_t, uint8_t* buffer, size_t length, uint32_t* flags,
+            nghttp2_data_source* source, void*) -> ssize_t {
+            auto* http2Stream = static_cast<Http2Stream*>(source->ptr);
+            const std::string& body = http2Stream->reply.body;
+            size_t count = std::min(length, body.size() - http2Stream->offset);
+            std::memcpy(buffer, body.data() + http2Stream->offset, count);
+            http2Stream->offset += count;
+            if (http2Stream->offset == body.size()) {
+                *flags |= NGHTTP2_DATA_FLAG_EOF;
+            }
+            return static_cast<ssize_t>(count);
+        };
+
+        nghttp2_submit_response(session, streamId, nameValues.data(), nameValues.size(),
+            bodyless ? nullptr : &provider);
+        ++served;
+    }
+#endif
+
+    static void setTarget(Request& request, const std::string& target) {
+        size_t question = target.find('?');
+        request.path = target.substr(0, question);
+        request.query = question == std::string::npos ? "" : target.substr(question + 1);
+    }
+
+    static std::string headerValue(const Request& request, std::string_view name) {
+        for (const auto& [header, value] : request.headers) {
+            if (header == name) {
+                return value;
+            }
+        }
+        return "";
+    }
+
+    static std::vector<std::pair<std::string, std::string>> queryArguments(const std::string& query) {
+        std::vector<std::pair<std::string, std::string>> arguments;
+        for (size_t start = 0; start < query.size();) {
+            size_t end = std::min(query.find('&', start), query.size());
+            std::string pair = query.substr(start, end - start);
+            size_t equals = pair.find('=');
+            arguments.emplace_back(pair.substr(0, equals), equals == std::string::npos ? "" : pair.substr(equals + 1));
+            start = end + 1;
+        }
+        return arguments;
+    }
+
+    static std::string percentDecoded(const std::string& value) {
+        std::string out;
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (value[i] == '%' && i + 2 < value.size()) {
+                out += static_cast<char>(std::stoi(value.substr(i + 1, 2), nullptr, 16));
+                i += 2;
+            } else {
+                out += value[i];
+            }
+        }
+        return out;
+    }
+
+    static std::string canonicalName(std::string name) {
+        bool upper = true;
+        for (char& ch : name) {
+            ch = static_cast<char>(upper ? std::toupper(static_cast<unsigned char>(ch))
+                                         : std::tolower(static_cast<unsigned char>(ch)));
+            upper = ch == '-';
+        }
+        return name;
+    }
+
+    static std::string quoted(std::string_view value) {
+        std::string out = "\"";
+        JsonHelper::appendEscaped(out, value);
+        return out + "\"";
+    }
+
+    // Formats the request like httpbin does, with sorted keys and two-space indentation
+    static std::string echo(const Request& request) {
+        auto object = [](const std::map<std::string, std::string>& fields) {
+            if (fields.empty()) {
+                return std::string("{}");
+            }
+            std::string out = "{";
+            for (const auto& [name, value] : fields) {
+                out += (out.size() > 1 ? ", \n    " : "\n    ") + quoted(name) + ": " + quoted(value);
+            }
+            return out + "\n  }";
+        };
+
+        std::map<std::string, std::string> arguments;
+        for (auto& [name, value] : queryArguments(request.query)) {
+            arguments[name] = value;
+        }
+        std::map<std::string, std::string> headers;
+        for (const auto& [name, value] : request.headers) {
+            std::string& joined = headers[canonicalName(name)];
+            joined += joined.empty() ? value : "," + value;
+        }
+
+        std::string url = request.scheme + "://" + headerValue(request, "host") + request.path +
+            (request.query.empty() ? "" : "?" + request.query);
+        return "{\n  \"args\": " + object(arguments) + ", \n  \"data\": " + quoted(request.body) +
+            ", \n  \"headers\": " + object(headers) + ", \n  \"method\": " + quoted(request.method) +
+            ", \n  \"origin\": " + quoted(request.origin) + ", \n  \"url\": " + quoted(url) + "\n}\n";
+    }
+
+    Reply handle(const Request& request) const {
+        const std::string& path = request.path;
+        auto number = [&path](size_t prefix) { return static_cast<size_t>(std::stoul(path.substr(prefix))); };
+
+        Reply reply;
+        if (path == "/get" || path == "/post" || path == "/put" || path == "/patch" || path == "/delete" ||
+            path.compare(0, 9, "/anything") == 0) {
+            reply.headers.emplace_back("Content-Type", "application/json");
+            reply.body = echo(request);
+        } else if (path.compare(0, 7, "/bytes/") == 0) {
+            reply.headers.emplace_back("Content-Type", "application/octet-stream");
+            reply.body.assign(number(7), 'x');
+#if defined(TLS_CLIENT_HAS_ZLIB)
+        } else if (path.compare(0, 6, "/gzip/") == 0) {
+            std::string plain(number(6), 'x');
+            z_stream stream{};
+            deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+            reply.body.resize(deflateBound(&stream, static_cast<uLong>(plain.size())));
+            stream.next_in = reinterpret_cast<Bytef*>(plain.data());
+            stream.avail_in = static_cast<uInt>(plain.size());
+            stream.next_out = reinterpret_cast<Bytef*>(reply.body.data());
+            stream.avail_out = static_cast<uInt>(reply.body.size());
+            deflate(&stream, Z_FINISH);
+            reply.body.resize(stream.total_out);
+            deflateEnd(&stream);
+            reply.headers.emplace_back("Content-Encoding", "gzip");
+#endif
+        } else if (path.compare(0, 8, "/status/") == 0) {
+            reply.status = static_cast<int>(number(8));
+        } else if (path.compare(0, 10, "/redirect/") == 0) {
+            if (size_t remaining = number(10); remaining > 0) {
+                reply.status = 302;
+                reply.headers.emplace_back("Location", "/redirect/" + std::to_string(remaining - 1));
+            } else {
+                reply.body = "redirected";
+            }
+        } else if (path == "/redirect-to") {
+            for (const auto& [name, value] : queryArguments(request.query)) {
+                if (name == "url") {
+                    reply.status = 302;
+                    reply.headers.emplace_back("Location", percentDecoded(value));
+                }
+            }
+        } else if (path.compare(0, 6, "/etag/") == 0) {
+            std::string etag = "\"" + path.substr(6) + "\"";
+            reply.headers.emplace_back("ETag", etag);
+            if (headerValue(request, "if-none-match") == etag) {
+                reply.status = 304;
+            } else {
+                reply.body = echo(request);
+            }
+        } else if (path == "/cookies/set") {
+            for (const auto& [name, value] : queryArguments(request.query)) {
+                reply.headers.emplace_back("Set-Cookie", name + "=" + value + "; Path=/");
+            }
+        } else if (path == "/close") {
+            reply.body = "closing";
+            reply.close = true;
+        } else {
+            reply.status = 404;
+        }
+
+        for (const auto& [name, value] : queryArguments(request.query)) {
+            if (name == "delay") {
+                reply.delay = std::chrono::milliseconds(std::stoul(value));
+            } else if (name == "status") {
+                reply.status = std::stoi(value);
+            } else if (name == "chunked" && value == "1") {
+                reply.chunkSize = reply.chunkSize ? reply.chunkSize : 1000;
+            } else if (name == "chunk_size") {
+                reply.chunkSize = std::max<size_t>(std::stoul(value), 1);
+            }
+        }
+        return reply;
+    }
+};
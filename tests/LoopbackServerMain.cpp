@@ -0,0 +1,53 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "LoopbackServer.hpp"
+
+// Runs the loopback server until interrupted, e.g. for external benchmarks:
+//   tls-client-loopback-server [--port N] [--plain] [--http1] [--cert FILE]
+int main(int argc, char** argv) {
+    LoopbackServerOptions options;
+    std::string certificateFile;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--port" && i + 1 < argc) {
+            options.port = static_cast<uint16_t>(std::stoul(argv[++i]));
+        } else if (argument == "--plain") {
+            options.tls = false;
+        } else if (argument == "--http1") {
+            options.http2 = false;
+        } else if (argument == "--cert" && i + 1 < argc) {
+            certificateFile = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--port N] [--plain] [--http1] [--cert FILE]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Block the signals before the server threads start, so only sigwait receives them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    LoopbackServer server(options);
+    if (!certificateFile.empty()) {
+        std::ofstream(certificateFile) << server.certificatePem();
+    }
+    std::cout << server.url("") << std::endl;
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    std::cout << server.requestsServed() << " requests served" << std::endl;
+    return 0;
+}
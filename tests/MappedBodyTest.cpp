@@ -0,0 +1,46 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client.hpp"
+
+#if defined(OS_LINUX) || defined(OS_APPLE)
+TEST(MappedBodyTest, TestInMemoryFile) {
+    std::string data(1024 * 1024, 'x');
+    data.back() = 'y';
+
+    std::shared_ptr<const MappedBody> mappedBody = MappedBody::create(data);
+
+    ASSERT_TRUE(mappedBody);
+    ASSERT_GE(mappedBody->fd(), 0);
+    ASSERT_EQ(mappedBody->view(), data);
+}
+
+TEST(MappedBodyTest, TestDirectoryFile) {
+    std::string directory = std::filesystem::temp_directory_path().string();
+    std::shared_ptr<const MappedBody> mappedBody = MappedBody::create("Hello, world!", directory);
+
+    ASSERT_TRUE(mappedBody);
+    ASSERT_EQ(mappedBody->view(), "Hello, world!");
+}
+
+TEST(MappedBodyTest, TestEmptyData) {
+    ASSERT_FALSE(MappedBody::create(""));
+}
+
+TEST(MappedBodyTest, TestBodyView) {
+    ResponseData responseData;
+    responseData.body = "in memory";
+    ASSERT_EQ(responseData.bodyView(), "in memory");
+
+    responseData.mappedBody = MappedBody::create("mapped");
+    std::string().swap(responseData.body);
+    ASSERT_EQ(responseData.bodyView(), "mapped");
+}
+#endif
@@ -0,0 +1,134 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_json_bind.hpp"
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+#include "LoopbackServer.hpp"
+#endif
+
+/**
+ * Counts the bytes allocated through it, passing the allocations on to the default resource.
+ */
+struct CountingResource : std::pmr::memory_resource {
+    size_t allocated = 0;
+    size_t allocations = 0;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        allocated += bytes;
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+struct Named {
+    std::string name;
+};
+TLS_CLIENT_JSON_FIELDS(Named, name);
+
+TEST(MemoryScopeTest, TestNesting) {
+    CountingResource outer;
+    CountingResource inner;
+    ASSERT_EQ(MemoryScope::resource(), std::pmr::get_default_resource());
+    {
+        MemoryScope outerScope(&outer);
+        ASSERT_EQ(MemoryScope::resource(), &outer);
+        {
+            MemoryScope innerScope(&inner);
+            ASSERT_EQ(MemoryScope::resource(), &inner);
+
+            // Other threads keep their own scopes
+            std::pmr::memory_resource* other = nullptr;
+            std::thread([&other] { other = MemoryScope::resource(); }).join();
+            ASSERT_EQ(other, std::pmr::get_default_resource());
+        }
+        ASSERT_EQ(MemoryScope::resource(), &outer);
+    }
+    ASSERT_EQ(MemoryScope::resource(), std::pmr::get_default_resource());
+}
+
+TEST(MemoryScopeTest, TestDecoderScratch) {
+    // Strings with escape sequences are unescaped into the scratch buffer of the scope
+    CountingResource resource;
+    Expected<Named> named = [&resource] {
+        MemoryScope scope(&resource);
+        return JsonDecoder<Named>::decode(R"({"name": "a long name with an escaped \"quote\" in it"})");
+    }();
+    ASSERT_TRUE(named) << named.error().message;
+    ASSERT_EQ(named->name, "a long name with an escaped \"quote\" in it");
+    ASSERT_GT(resource.allocations, 0u);
+}
+
+TEST(MemoryScopeTest, TestParseResponseView) {
+    std::pmr::string payload(R"({"status": 200, "headers": {"A": ["1", "b c"]}, "body": "x\"y", "target": "t"})",
+        std::pmr::new_delete_resource());
+    Expected<ResponseData> responseData = JsonHelper::tryParseResponse(payload);
+    ASSERT_TRUE(responseData) << responseData.error().message;
+    ASSERT_EQ(responseData->statusCode, 200);
+    ASSERT_EQ(responseData->headers, R"({"A":["1","b c"]})");
+    ASSERT_EQ(responseData->body, R"(x\"y)");
+    ASSERT_EQ(responseData->target, "t");
+}
+
+TEST(MemoryScopeTest, TestHugePageResource) {
+    HugePageResource hugePages;
+    std::vector<std::string> copies;
+    {
+        std::pmr::monotonic_buffer_resource arena(HugePageResource::HUGE_PAGE_SIZE, &hugePages);
+        std::pmr::vector<std::pmr::string> strings(&arena);
+        for (int i = 0; i < 1000; ++i) {
+            strings.emplace_back(std::string(100, static_cast<char>('a' + i % 26)));
+        }
+        // Larger than a block, so the arena asks for more
+        strings.emplace_back(3 * HugePageResource::HUGE_PAGE_SIZE, 'z');
+        for (const std::pmr::string& string : strings) {
+            copies.emplace_back(string);
+        }
+    }
+    ASSERT_EQ(copies.size(), 1001u);
+    ASSERT_EQ(copies[27], std::string(100, 'b'));
+    ASSERT_EQ(copies.back().size(), 3 * HugePageResource::HUGE_PAGE_SIZE);
+
+    // Over-aligned allocations are passed on to the default resource
+    std::pmr::memory_resource& resource = hugePages;
+    void* pointer = resource.allocate(64, 8192);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(pointer) % 8192, 0u);
+    resource.deallocate(pointer, 64, 8192);
+}
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+TEST(MemoryScopeTest, TestRequest) {
+    LoopbackServer server;
+    Session session{SessionData()};
+
+    RequestData requestData;
+    requestData.url = server.url("/bytes/4096");
+    requestData.insecureSkipVerify = true;
+
+    CountingResource resource;
+    Expected<ResponseData> response = [&] {
+        MemoryScope scope(&resource);
+        return session.tryGET(requestData);
+    }();
+    ASSERT_TRUE(response) << response.error().message;
+    ASSERT_EQ(response->statusCode, 200);
+
+    // The library response was copied into the scope, and the result outlives it
+    ASSERT_GT(resource.allocated, response->body.size());
+    ASSERT_FALSE(response->body.empty());
+}
+#endif
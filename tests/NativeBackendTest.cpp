@@ -0,0 +1,319 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_native.hpp"
+#include "LoopbackServer.hpp"
+
+class NativeBackendTest : public ::testing::Test {
+protected:
+    LoopbackServer server;
+    std::shared_ptr<NativeBackend> backend;
+
+    void SetUp() override {
+        auto created = NativeBackend::create();
+        ASSERT_TRUE(created);
+        backend = *created;
+    }
+
+    RequestData request(const std::string& path) const {
+        RequestData requestData;
+        requestData.url = server.url(path);
+        requestData.insecureSkipVerify = true;
+        return requestData;
+    }
+};
+
+TEST(JsonEscapeTest, TestAppendEscaped) {
+    std::string out;
+    JsonHelper::appendEscaped(out, "a\"b\\c\n\t\x01<>&\x7f");
+    EXPECT_EQ(out, R"(a\"b\\c\n\t\u0001\u003c\u003e\u0026)" "\x7f");
+
+    out.clear();
+    JsonHelper::appendEscaped(out, "caf\xc3\xa9 \xe2\x80\xa8 \xf0\x9f\x98\x80");
+    EXPECT_EQ(out, "caf\xc3\xa9 \\u2028 \xf0\x9f\x98\x80");
+
+    // Invalid, overlong and surrogate sequences are replaced byte by byte
+    out.clear();
+    JsonHelper::appendEscaped(out, "\xff\xc0\xaf\xed\xa0\x80x");
+    EXPECT_EQ(out, R"(\ufffd\ufffd\ufffd\ufffd\ufffd\ufffdx)");
+}
+
+TEST_F(NativeBackendTest, TestSupports) {
+    RequestData requestData = request("/");
+    EXPECT_TRUE(backend->supports(requestData));
+
+    requestData.proxy = "http://127.0.0.1:8080";
+    EXPECT_FALSE(backend->supports(requestData));
+
+    requestData = request("/");
+    requestData.url = "ftp://example.com/file";
+    EXPECT_FALSE(backend->supports(requestData));
+}
+
+TEST_F(NativeBackendTest, TestGETReusesConnection) {
+    for (int i = 0; i < 5; ++i) {
+        auto response = backend->perform(request("/bytes/100"), "GET", SIZE_MAX);
+        ASSERT_TRUE(response) << response.error().message;
+        EXPECT_EQ(response->statusCode, 200);
+        EXPECT_EQ(response->body, std::string(100, 'x'));
+        EXPECT_EQ(response->usedProtocol, "HTTP/1.1");
+        EXPECT_EQ(response->target, server.url("/bytes/100"));
+        EXPECT_EQ(response->header("content-length"), "100");
+    }
+
+    EXPECT_EQ(backend->connectionsOpened(), 1u);
+    EXPECT_EQ(server.connectionsAccepted(), 1u);
+    EXPECT_EQ(backend->idleConnections(), 1u);
+}
+
+TEST_F(NativeBackendTest, TestSwitchingProtocolsClosesConnection) {
+    auto response = backend->perform(request("/status/101"), "GET", SIZE_MAX);
+    ASSERT_TRUE(response) << response.error().message;
+    EXPECT_EQ(response->statusCode, 101);
+    EXPECT_EQ(backend->idleConnections(), 0u);
+
+    ASSERT_TRUE(backend->perform(request("/bytes/10"), "GET", SIZE_MAX));
+    EXPECT_EQ(backend->connectionsOpened(), 2u);
+}
+
+TEST_F(NativeBackendTest, TestTlsSessionsBounded) {
+    std::vector<std::unique_ptr<LoopbackServer>> servers;
+    for (int i = 0; i < 3; ++i) {
+        servers.push_back(std::make_unique<LoopbackServer>());
+    }
+
+    auto sessionsAfterVisits = [&servers](size_t max) {
+        NativeBackendOptions options;
+        options.maxTlsSessions = max;
+        std::shared_ptr<NativeBackend> limited = *NativeBackend::create(options);
+        for (const auto& other : servers) {
+            RequestData requestData;
+            requestData.url = other->url("/bytes/10");
+            requestData.insecureSkipVerify = true;
+            EXPECT_TRUE(limited->perform(requestData, "GET", SIZE_MAX));
+        }
+        return limited->tlsSessions();
+    };
+
+    // One session per server, and the least recently used ones freed beyond the limit
+    EXPECT_EQ(sessionsAfterVisits(8), 3u);
+    size_t bounded = sessionsAfterVisits(2);
+    EXPECT_GE(bounded, 1u);
+    EXPECT_LE(bounded, 2u);
+    EXPECT_EQ(sessionsAfterVisits(0), 0u);
+}
+
+TEST_F(NativeBackendTest, TestChunkedAndGzipBodies) {
+    auto chunked = backend->perform(request("/bytes/5500?chunked=1"), "GET", SIZE_MAX);
+    ASSERT_TRUE(chunked) << chunked.error().message;
+    EXPECT_EQ(chunked->body, std::string(5500, 'x'));
+
+#if defined(TLS_CLIENT_HAS_ZLIB)
+    auto gzip = backend->perform(request("/gzip/100000"), "GET", SIZE_MAX);
+    ASSERT_TRUE(gzip) << gzip.error().message;
+    EXPECT_EQ(gzip->body, std::string(100000, 'x'));
+    EXPECT_EQ(gzip->header("Content-Encoding"), std::nullopt);
+#endif
+
+    EXPECT_EQ(backend->connectionsOpened(), 1u);
+}
+
+TEST_F(NativeBackendTest, TestRequestHeadersCookiesAndBody) {
+    RequestData requestData = request("/anything");
+    requestData.headers = R"({"X-Test": "value"})";
+    requestData.cookies = R"({"session": "abc"})";
+    requestData.data = R"({"key": "<value>"})";
+
+    auto response = backend->perform(requestData, "POST", SIZE_MAX);
+    ASSERT_TRUE(response) << response.error().message;
+
+    // The echoed body keeps its JSON escape sequences, like the library returns it
+    EXPECT_NE(response->body.find(R"(\"method\": \"POST\")"), std::string::npos);
+    EXPECT_NE(response->body.find(R"(\"X-Test\": \"value\")"), std::string::npos);
+    EXPECT_NE(response->body.find(R"(\"Cookie\": \"session=abc\")"), std::string::npos);
+    EXPECT_NE(response->body.find(R"(\"Content-Length\": \"18\")"), std::string::npos);
+    EXPECT_NE(response->body.find(R"(\"data\": \"{\\\"key\\\": \\\"\\u003cvalue\\u003e\\\"}\")"),
+        std::string::npos);
+}
+
+TEST_F(NativeBackendTest, TestRawBody) {
+    NativeBackendOptions options;
+    options.escapeBody = false;
+    auto created = NativeBackend::create(options);
+    ASSERT_TRUE(created);
+
+    RequestData requestData = request("/anything");
+    requestData.data = "line\n\"quoted\"";
+    auto response = (*created)->perform(requestData, "PUT", SIZE_MAX);
+    ASSERT_TRUE(response) << response.error().message;
+    EXPECT_NE(response->body.find(R"("data": "line\n\"quoted\"")"), std::string::npos);
+}
+
+TEST_F(NativeBackendTest, TestRedirects) {
+    RequestData requestData = request("/redirect/3");
+    requestData.allowRedirects = true;
+
+    auto followed = backend->perform(requestData, "GET", SIZE_MAX);
+    ASSERT_TRUE(followed) << followed.error().message;
+    EXPECT_EQ(followed->statusCode, 200);
+    EXPECT_EQ(followed->body, "redirected");
+    EXPECT_EQ(followed->target, server.url("/redirect/0"));
+
+    requestData.allowRedirects = false;
+    auto notFollowed = backend->perform(requestData, "GET", SIZE_MAX);
+    ASSERT_TRUE(notFollowed) << notFollowed.error().message;
+    EXPECT_EQ(notFollowed->statusCode, 302);
+    EXPECT_EQ(notFollowed->header("Location"), "/redirect/2");
+
+    requestData = request("/redirect/11");
+    requestData.allowRedirects = true;
+    auto tooMany = backend->perform(requestData, "GET", SIZE_MAX);
+    ASSERT_FALSE(tooMany);
+    EXPECT_EQ(tooMany.error().code, ErrorCode::Request);
+}
+
+TEST_F(NativeBackendTest, TestRejectsInjection) {
+    RequestData requestData = request("/get");
+    requestData.headers = R"({"X-Test": "a\r\nX-Injected: 1"})";
+    auto value = backend->perform(requestData, "GET", SIZE_MAX);
+    ASSERT_FALSE(value);
+    EXPECT_EQ(value.error().code, ErrorCode::Request);
+
+    requestData.headers = R"({"X-Test\nX-Injected": "1"})";
+    EXPECT_FALSE(backend->perform(requestData, "GET", SIZE_MAX));
+    requestData.headers = R"({"X Test": "1"})";
+    EXPECT_FALSE(backend->perform(requestData, "GET", SIZE_MAX));
+    requestData.headers = R"({"X-Test": "nul\u0000"})";
+    EXPECT_FALSE(backend->perform(requestData, "GET", SIZE_MAX));
+
+    requestData.headers.reset();
+    requestData.cookies = R"({"session": "abc\r\nX-Injected: 1"})";
+    EXPECT_FALSE(backend->perform(requestData, "GET", SIZE_MAX));
+    requestData.cookies = R"({"session": "abc; other=1"})";
+    EXPECT_FALSE(backend->perform(requestData, "GET", SIZE_MAX));
+
+    requestData.cookies.reset();
+    requestData.url = server.url("/get") + "\r\nX-Injected: 1";
+    EXPECT_FALSE(backend->perform(requestData, "GET", SIZE_MAX));
+    EXPECT_FALSE(backend->perform(request("/get"), "GET /x", SIZE_MAX));
+
+    // Redirect locations are checked before going on the request line
+    requestData = request("/redirect-to?url=/get%0bX-Injected:%201");
+    requestData.allowRedirects = true;
+    auto location = backend->perform(requestData, "GET", SIZE_MAX);
+    ASSERT_FALSE(location);
+    EXPECT_EQ(location.error().code, ErrorCode::Request);
+
+    requestData = request("/redirect-to?url=/anything/a%20b");
+    requestData.allowRedirects = true;
+    auto escaped = backend->perform(requestData, "GET", SIZE_MAX);
+    ASSERT_TRUE(escaped) << escaped.error().message;
+    EXPECT_EQ(escaped->target, server.url("/anything/a%20b"));
+}
+
+TEST_F(NativeBackendTest, TestCookiesAndClose) {
+    auto cookies = backend->perform(request("/cookies/set?theme=dark"), "GET", SIZE_MAX);
+    ASSERT_TRUE(cookies) << cookies.error().message;
+    EXPECT_EQ(cookies->cookies, R"({"theme":"dark"})");
+    EXPECT_EQ(cookies->header("Set-Cookie"), "theme=dark; Path=/");
+
+    auto closed = backend->perform(request("/close"), "GET", SIZE_MAX);
+    ASSERT_TRUE(closed) << closed.error().message;
+    EXPECT_EQ(closed->body, "closing");
+    EXPECT_EQ(backend->idleConnections(), 0u);
+
+    auto reopened = backend->perform(request("/status/204"), "GET", SIZE_MAX);
+    ASSERT_TRUE(reopened) << reopened.error().message;
+    EXPECT_EQ(reopened->statusCode, 204);
+    EXPECT_EQ(backend->connectionsOpened(), 2u);
+}
+
+TEST_F(NativeBackendTest, TestErrors) {
+    auto tooLarge = backend->perform(request("/bytes/1000"), "GET", 100);
+    ASSERT_FALSE(tooLarge);
+    EXPECT_EQ(tooLarge.error().code, ErrorCode::ResponseTooLarge);
+
+    RequestData slow = request("/bytes/1?delay=1500");
+    slow.timeoutSeconds = 1;
+    auto timeout = backend->perform(slow, "GET", SIZE_MAX);
+    ASSERT_FALSE(timeout);
+    EXPECT_EQ(timeout.error().code, ErrorCode::Timeout);
+
+    // The self-signed certificate is rejected unless verification is skipped
+    RequestData verified = request("/bytes/1");
+    verified.insecureSkipVerify = false;
+    auto untrusted = backend->perform(verified, "GET", SIZE_MAX);
+    ASSERT_FALSE(untrusted);
+    EXPECT_EQ(untrusted.error().code, ErrorCode::Tls);
+
+    uint16_t port = 0;
+    {
+        LoopbackServer closed;
+        port = closed.port();
+    }
+    RequestData refused;
+    refused.url = "https://127.0.0.1:" + std::to_string(port) + "/";
+    auto connection = backend->perform(refused, "GET", SIZE_MAX);
+    ASSERT_FALSE(connection);
+    EXPECT_EQ(connection.error().code, ErrorCode::Connection);
+}
+
+TEST_F(NativeBackendTest, TestTrustedCertificate) {
+    std::string caFile = (std::filesystem::temp_directory_path() / "tls-client-native-ca.pem").string();
+    std::ofstream(caFile) << server.certificatePem();
+
+    NativeBackendOptions options;
+    options.caFile = caFile;
+    auto created = NativeBackend::create(options);
+    std::filesystem::remove(caFile);
+    ASSERT_TRUE(created);
+
+    RequestData requestData = request("/bytes/1");
+    requestData.insecureSkipVerify = false;
+    auto response = (*created)->perform(requestData, "GET", SIZE_MAX);
+    ASSERT_TRUE(response) << response.error().message;
+    EXPECT_EQ(response->body, "x");
+
+    // The host name is verified against the certificate as well
+    requestData.url = "https://localhost:" + std::to_string(server.port()) + "/bytes/2";
+    response = (*created)->perform(requestData, "GET", SIZE_MAX);
+    ASSERT_TRUE(response) << response.error().message;
+    EXPECT_EQ(response->body, "xx");
+}
+
+TEST_F(NativeBackendTest, TestSessionBackendHosts) {
+    SessionData config;
+    config.backend = backend;
+    config.backendHosts = {"*.example.com", "127.0.0.1"};
+    Session session(config);
+
+    auto response = session.tryGET(request("/bytes/10"));
+    ASSERT_TRUE(response) << response.error().message;
+    EXPECT_EQ(response->body, std::string(10, 'x'));
+    EXPECT_EQ(session.getStats().requests, 1u);
+
+    // Failures are reported like the library reports them
+    RequestData tooLarge = request("/bytes/1000");
+    tooLarge.maxResponseSize = 10;
+    ResponseData rejected = session.GET(tooLarge);
+    EXPECT_EQ(rejected.statusCode, 0);
+    EXPECT_FALSE(rejected.body.empty());
+    EXPECT_EQ(session.getStats().failures, 1u);
+
+    // Other hosts still go through the library
+    config.backendHosts = {"*.example.com"};
+    Session other(config);
+    (void)other.tryGET(request("/bytes/10"));
+    EXPECT_EQ(backend->connectionsOpened(), 1u);
+}
@@ -0,0 +1,136 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_negative_cache.hpp"
+
+static RequestData request(const std::string& url, std::optional<std::string> proxy = std::nullopt) {
+    RequestData requestData;
+    requestData.url = url;
+    requestData.proxy = std::move(proxy);
+    return requestData;
+}
+
+TEST(NegativeCacheTest, TestScopes) {
+    NegativeCache cache;
+    ASSERT_FALSE(cache.lookup(request("https://a.test/")));
+
+    // Connection and TLS errors are cached for the scheme, host and port
+    cache.recordFailure(request("https://A.test:8443/x"), {ErrorCode::Connection, "connection refused"});
+    auto cached = cache.lookup(request("https://a.test:8443/y?q=1"));
+    ASSERT_TRUE(cached);
+    ASSERT_EQ(cached->code, ErrorCode::Connection);
+    ASSERT_EQ(cached->message, "connection refused");
+    ASSERT_FALSE(cache.lookup(request("https://a.test/")));
+    ASSERT_FALSE(cache.lookup(request("http://a.test:8443/")));
+    ASSERT_FALSE(cache.lookup(request("https://a.test:8443/", "http://proxy:8080")));
+
+    // DNS errors are cached for the host name
+    cache.recordFailure(request("https://b.test/"), {ErrorCode::Dns, "no such host"});
+    ASSERT_TRUE(cache.lookup(request("http://B.test:8080/")));
+
+    // Proxy errors are cached for every request through the proxy
+    cache.recordFailure(request("https://c.test/", "http://proxy:8080"), {ErrorCode::Proxy, "proxyconnect"});
+    ASSERT_TRUE(cache.lookup(request("https://d.test/", "http://proxy:8080")));
+    ASSERT_FALSE(cache.lookup(request("https://d.test/")));
+
+    // Errors about the request itself are not cached
+    cache.recordFailure(request("https://e.test/"), {ErrorCode::Request, "bad request"});
+    cache.recordFailure(request("https://e.test/"), {ErrorCode::ResponseTooLarge, "too large"});
+    ASSERT_FALSE(cache.lookup(request("https://e.test/")));
+
+    ASSERT_EQ(cache.size(), 3u);
+    NegativeCacheStats stats = cache.getStats();
+    ASSERT_EQ(stats.hits, 3u);
+    ASSERT_EQ(stats.failures, 3u);
+}
+
+TEST(NegativeCacheTest, TestThresholdSuccessAndExpiry) {
+    NegativeCacheOptions options;
+    options.threshold = 2;
+    options.ttls[ErrorCode::Connection] = std::chrono::milliseconds(100);
+    NegativeCache cache(options);
+
+    RequestData requestData = request("https://a.test/");
+    cache.recordFailure(requestData, {ErrorCode::Connection, "connection refused"});
+    ASSERT_FALSE(cache.lookup(requestData));
+
+    // A completed request resets the count
+    cache.recordSuccess(requestData);
+    ASSERT_EQ(cache.size(), 0u);
+    cache.recordFailure(requestData, {ErrorCode::Connection, "connection refused"});
+    ASSERT_FALSE(cache.lookup(requestData));
+    cache.recordFailure(requestData, {ErrorCode::Connection, "connection refused"});
+    ASSERT_TRUE(cache.lookup(requestData));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    ASSERT_FALSE(cache.lookup(requestData));
+    ASSERT_EQ(cache.size(), 0u);
+
+    cache.recordFailure(requestData, {ErrorCode::Connection, "connection refused"});
+    cache.recordFailure(requestData, {ErrorCode::Connection, "connection refused"});
+    ASSERT_TRUE(cache.lookup(requestData));
+    cache.clear();
+    ASSERT_FALSE(cache.lookup(requestData));
+}
+
+TEST(NegativeCacheTest, TestWindowAndMaxEntries) {
+    NegativeCacheOptions options;
+    options.threshold = 2;
+    options.window = std::chrono::milliseconds(100);
+    options.maxEntries = 32;
+    NegativeCache cache(options);
+
+    // Failures further apart than the window do not add up
+    RequestData requestData = request("https://a.test/");
+    cache.recordFailure(requestData, {ErrorCode::Connection, "connection refused"});
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    cache.recordFailure(requestData, {ErrorCode::Connection, "connection refused"});
+    ASSERT_FALSE(cache.lookup(requestData));
+    cache.recordFailure(requestData, {ErrorCode::Connection, "connection refused"});
+    ASSERT_TRUE(cache.lookup(requestData));
+
+    // Hosts failing once and never requested again are dropped
+    for (int i = 0; i < 1000; ++i) {
+        cache.recordFailure(request("https://h" + std::to_string(i) + ".test/"), {ErrorCode::Dns, "no such host"});
+        ASSERT_LE(cache.size(), 32u);
+    }
+    for (int i : {0, 999}) {
+        cache.recordFailure(request("https://h" + std::to_string(i) + ".test/"), {ErrorCode::Dns, "no such host"});
+    }
+    ASSERT_TRUE(cache.lookup(request("https://h999.test/")));
+    ASSERT_FALSE(cache.lookup(request("https://h0.test/")));
+}
+
+TEST(NegativeCacheTest, TestSessionFailsFast) {
+    auto cache = std::make_shared<NegativeCache>();
+    SessionData sessionData;
+    sessionData.failureCache = cache;
+    Session session(sessionData);
+
+    RequestData requestData = request("https://127.0.0.1:1/"); // Nothing listens there
+    auto first = session.tryGET(requestData);
+    ASSERT_FALSE(first);
+    ASSERT_EQ(first.error().code, ErrorCode::Connection);
+    ASSERT_EQ(cache->getStats().failures, 1u);
+
+    auto second = session.tryGET(request("https://127.0.0.1:1/other"));
+    ASSERT_FALSE(second);
+    ASSERT_EQ(second.error().code, ErrorCode::Connection);
+    ASSERT_EQ(second.error().message, first.error().message);
+
+    ResponseData third = session.GET(requestData);
+    ASSERT_EQ(third.statusCode, 0);
+    ASSERT_EQ(third.body, first.error().message);
+
+    ASSERT_EQ(cache->getStats().hits, 2u);
+    ASSERT_EQ(cache->getStats().failures, 1u);
+    ASSERT_EQ(session.getStats().failures, 3u);
+}
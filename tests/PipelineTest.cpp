@@ -0,0 +1,160 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_pipeline.hpp"
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+#include "LoopbackServer.hpp"
+#endif
+
+TEST(PipelineTest, TestBoundedQueue) {
+    BoundedQueue<int> queue(2);
+    ASSERT_TRUE(queue.push(1));
+    int value = 2;
+    ASSERT_TRUE(queue.tryPush(value));
+    value = 3;
+    ASSERT_FALSE(queue.tryPush(value));
+
+    // A full queue holds the producer back until an item is taken
+    std::thread producer([&queue]() { ASSERT_TRUE(queue.push(3)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_EQ(queue.size(), 2u);
+    ASSERT_EQ(*queue.pop(), 1);
+    producer.join();
+    ASSERT_EQ(queue.blockedPushes(), 1u);
+    ASSERT_EQ(queue.maxSize(), 2u);
+
+    queue.close();
+    ASSERT_FALSE(queue.push(4));
+    ASSERT_EQ(*queue.pop(), 2);
+    ASSERT_EQ(*queue.pop(), 3);
+    ASSERT_FALSE(queue.pop());
+}
+
+TEST(PipelineTest, TestFailuresAreReported) {
+    Session session{SessionData()};
+    Pipeline pipeline(session, {4, 8});
+
+    std::mutex mutex;
+    std::multiset<std::string> failedStages;
+    pipeline.onError([&](const std::string& stage, const Error& error) {
+        std::lock_guard<std::mutex> lock(mutex);
+        failedStages.insert(stage + " " + std::to_string(static_cast<int>(error.code)));
+    });
+
+    std::atomic<int> reached{0};
+    pipeline.then("parse", [&reached](ResponseData&&) { ++reached; });
+
+    RequestData requestData;
+    requestData.url = "https://127.0.0.1:1/"; // Nothing listens there
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(pipeline.push(requestData));
+    }
+    pipeline.close();
+    pipeline.wait();
+    ASSERT_FALSE(pipeline.push(requestData));
+
+    ASSERT_EQ(reached, 0);
+    ASSERT_EQ(failedStages.count("fetch " + std::to_string(static_cast<int>(ErrorCode::Connection))), 6u);
+
+    std::vector<StageStats> stats = pipeline.getStats();
+    ASSERT_EQ(stats.size(), 2u);
+    ASSERT_EQ(stats[0].name, "fetch");
+    ASSERT_EQ(stats[0].concurrency, 4u);
+    ASSERT_EQ(stats[0].failed, 6u);
+    ASSERT_EQ(stats[1].processed + stats[1].failed, 0u);
+
+    ASSERT_THROW(pipeline.then("late", [](ResponseData&&) {}), std::logic_error);
+}
+
+TEST(PipelineTest, TestUnsupportedMethod) {
+    Session session{SessionData()};
+    Pipeline pipeline(session, {}, "TRACE");
+
+    std::string message;
+    pipeline.onError([&message](const std::string&, const Error& error) { message = error.message; });
+    ASSERT_TRUE(pipeline.push(RequestData()));
+    pipeline.close();
+    pipeline.wait();
+    ASSERT_EQ(message, "Unsupported method TRACE");
+}
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+TEST(PipelineTest, TestStagesAndBackpressure) {
+    LoopbackServer server;
+    Session session{SessionData()};
+    Pipeline pipeline(session, {8, 16});
+
+    std::atomic<int> transformErrors{0};
+    pipeline.onError([&transformErrors](const std::string& stage, const Error&) {
+        if (stage != "fetch") {
+            ++transformErrors;
+        }
+    });
+
+    std::mutex mutex;
+    std::vector<int> stored;
+    pipeline
+        .then("parse", [](ResponseData&& response) -> Expected<int> {
+            if (response.statusCode != 200) {
+                return Unexpected<Error>{{ErrorCode::Parse, "Status " + std::to_string(response.statusCode)}};
+            }
+            return static_cast<int>(response.body.size());
+        }, {2, 4})
+        .then("check", [](int size) {
+            if (size == 0) {
+                throw std::runtime_error("Empty body");
+            }
+            return size;
+        })
+        .then("store", [&](int size) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5)); // Slower than the fetches
+            std::lock_guard<std::mutex> lock(mutex);
+            stored.push_back(size);
+        }, {1, 2});
+
+    RequestData requestData;
+    requestData.insecureSkipVerify = true;
+    for (int i = 0; i < 40; ++i) {
+        requestData.url = server.url(i % 10 == 0 ? "/status/500" : i % 10 == 5 ? "/bytes/0" : "/bytes/100");
+        ASSERT_TRUE(pipeline.push(requestData));
+    }
+    pipeline.close();
+    pipeline.wait();
+
+    ASSERT_EQ(stored.size(), 32u);
+    ASSERT_EQ(transformErrors, 8);
+    for (int size : stored) {
+        ASSERT_EQ(size, 100);
+    }
+
+    std::vector<StageStats> stats = pipeline.getStats();
+    ASSERT_EQ(stats.size(), 4u);
+    ASSERT_EQ(stats[0].processed, 40u);
+    ASSERT_EQ(stats[1].processed, 36u);
+    ASSERT_EQ(stats[1].failed, 4u);
+    ASSERT_EQ(stats[2].failed, 4u);
+    ASSERT_EQ(stats[3].name, "store");
+    ASSERT_EQ(stats[3].processed, 32u);
+
+    // The slow stage filled its queue and held back the stage before it
+    ASSERT_LE(stats[3].maxQueued, 2u);
+    ASSERT_GT(stats[3].blocked, 0u);
+    for (const StageStats& stage : stats) {
+        ASSERT_EQ(stage.queued, 0u);
+        ASSERT_EQ(stage.active, 0u);
+        ASSERT_GT(stage.throughput(), 0.0);
+        ASSERT_LE(stage.utilization(), 1.0);
+    }
+}
+#endif
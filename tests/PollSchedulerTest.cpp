@@ -0,0 +1,152 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_poll.hpp"
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+#include "LoopbackServer.hpp"
+#endif
+
+TEST(TimerWheelTest, TestExpiresInOrder) {
+    TimerWheel wheel;
+    wheel.schedule(0, 70);
+    wheel.schedule(1, 5);
+    wheel.schedule(2, 5000);
+    wheel.schedule(3, 0);
+
+    std::vector<std::pair<uint64_t, uint32_t>> expired;
+    for (uint64_t now = 1; now <= 6000; ++now) {
+        wheel.advance(now, [&](uint32_t id) { expired.emplace_back(now, id); });
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> expected = {{1, 3}, {5, 1}, {70, 0}, {5000, 2}};
+    ASSERT_EQ(expired, expected);
+    ASSERT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheelTest, TestCancelAndReschedule) {
+    TimerWheel wheel;
+    wheel.schedule(0, 10);
+    wheel.schedule(1, 10);
+    wheel.schedule(1, 20);
+    ASSERT_TRUE(wheel.cancel(0));
+    ASSERT_FALSE(wheel.cancel(0));
+    ASSERT_TRUE(wheel.pending(1));
+
+    std::vector<uint32_t> expired;
+    wheel.advance(15, [&](uint32_t id) { expired.push_back(id); });
+    ASSERT_TRUE(expired.empty());
+
+    wheel.advance(20, [&](uint32_t id) {
+        expired.push_back(id);
+        wheel.schedule(id, wheel.now() + 1);
+    });
+    ASSERT_EQ(expired, std::vector<uint32_t>{1});
+    ASSERT_TRUE(wheel.pending(1));
+}
+
+TEST(TimerWheelTest, TestRandomDeadlines) {
+    TimerWheel wheel;
+    std::multimap<uint64_t, uint32_t> reference;
+    std::mt19937_64 random(42);
+
+    // Delays span every level, including ones beyond the last level
+    for (uint32_t id = 0; id < 20000; ++id) {
+        uint64_t deadline = 1 + random() % (uint64_t(1) << (id % 5 == 0 ? 25 : 20));
+        wheel.schedule(id, deadline);
+        reference.emplace(deadline, id);
+    }
+
+    uint64_t now = 0;
+    size_t checked = 0;
+    while (wheel.size() > 0) {
+        now += 1 + random() % 5000;
+        std::vector<uint32_t> expired;
+        wheel.advance(now, [&](uint32_t id) { expired.push_back(id); });
+
+        std::vector<uint32_t> expected;
+        while (!reference.empty() && reference.begin()->first <= now) {
+            expected.push_back(reference.begin()->second);
+            reference.erase(reference.begin());
+        }
+
+        std::sort(expired.begin(), expired.end());
+        std::sort(expected.begin(), expected.end());
+        ASSERT_EQ(expired, expected) << "at tick " << now;
+        checked += expired.size();
+    }
+    ASSERT_EQ(checked, 20000u);
+}
+
+TEST(PollSchedulerTest, TestConditionalPolling) {
+    SessionData sessionData;
+    Session session(sessionData);
+    ThreadPool executor(2);
+    PollScheduler scheduler(session, executor, std::chrono::milliseconds(10));
+
+    RequestData requestData;
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+    LoopbackServer server;
+    requestData.url = server.url("/etag/poll-test");
+    requestData.insecureSkipVerify = true;
+#else
+    requestData.url = "https://httpbin.org/etag/poll-test";
+#endif
+
+    std::atomic<int> changes{0};
+    PollOptions options;
+    options.immediate = true;
+    scheduler.add(requestData, std::chrono::milliseconds(200), [&](const RequestData&, const ResponseData& response) {
+        ASSERT_EQ(response.header("ETag"), "\"poll-test\"");
+        ASSERT_TRUE(response.bodyHash);
+        changes++;
+    }, options);
+
+    scheduler.start();
+    std::this_thread::sleep_for(std::chrono::seconds(3));
+    scheduler.stop();
+
+    // Later polls send If-None-Match and get 304 Not Modified
+    ASSERT_EQ(changes, 1);
+}
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+TEST(PollSchedulerTest, TestConditionalHeaderReplaced) {
+    SessionData sessionData;
+    Session session(sessionData);
+    ThreadPool executor(2);
+    PollScheduler scheduler(session, executor, std::chrono::milliseconds(10));
+
+    // A stale validator the caller set must not shadow the one the scheduler sends
+    LoopbackServer server;
+    RequestData requestData;
+    requestData.url = server.url("/etag/poll-replace");
+    requestData.insecureSkipVerify = true;
+    requestData.headers = R"({"accept":"*/*","if-none-match":"\"stale\""})";
+
+    std::atomic<int> changes{0};
+    PollOptions options;
+    options.immediate = true;
+    scheduler.add(requestData, std::chrono::milliseconds(200), [&](const RequestData&, const ResponseData&) {
+        changes++;
+    }, options);
+
+    scheduler.start();
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    scheduler.stop();
+
+    ASSERT_EQ(changes, 1);
+}
+#endif
@@ -0,0 +1,82 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <string>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_profile.hpp"
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+#include "LoopbackServer.hpp"
+#endif
+
+struct CustomProfile : FingerprintProfile {
+    static constexpr std::string_view ja3String = "771,4865-4866,0-23,29-23,0";
+    static constexpr std::string_view h2Settings = R"({"HEADER_TABLE_SIZE": 65536, "ENABLE_PUSH": 0})";
+    static constexpr std::string_view certCompressionAlgo = "brotli \"quoted\"\n";
+    static constexpr std::optional<int> connectionFlow = 15663105;
+    static constexpr std::string_view pseudoHeaderOrder = R"([":method", ":authority", ":scheme", ":path"])";
+};
+
+struct HeaderOrderProfile : FingerprintProfile {
+    static constexpr std::string_view headerOrder = R"(["x-second", "x-first"])";
+};
+
+// Generated at compile time
+static_assert(ProfileJson<FingerprintProfile>::members.empty());
+static_assert(ProfileJson<HeaderOrderProfile>::members == R"("headerOrder": ["x-second", "x-first"])");
+
+TEST(ProfileTest, TestMembers) {
+    ASSERT_EQ(ProfileJson<CustomProfile>::members,
+        R"("ja3String": "771,4865-4866,0-23,29-23,0", )"
+        R"("h2Settings": {"HEADER_TABLE_SIZE": 65536, "ENABLE_PUSH": 0}, )"
+        R"("certCompressionAlgo": "brotli \"quoted\"\u000a", )"
+        R"("pseudoHeaderOrder": [":method", ":authority", ":scheme", ":path"], )"
+        R"("connectionFlow": 15663105)");
+}
+
+TEST(ProfileTest, TestEnvelope) {
+    // The fingerprint fields of the session data are replaced by the profile
+    SessionData sessionData;
+    sessionData.ja3String = "ignored";
+    sessionData.headerOrder = R"(["ignored"])";
+    ProfileSession<CustomProfile> session(sessionData);
+    ASSERT_EQ(session.getSessionData()->profile, ProfileJson<CustomProfile>::members);
+
+    RequestData requestData;
+    requestData.url = "https://example.com/";
+    std::string envelope = session.prepare(requestData, "GET").envelope();
+    ASSERT_NE(envelope.find(ProfileJson<CustomProfile>::members), std::string::npos);
+    ASSERT_EQ(envelope.find("ignored"), std::string::npos);
+    ASSERT_NE(envelope.find(R"("requestUrl": "https://example.com/")"), std::string::npos);
+
+    session.setSessionData(SessionData());
+    ASSERT_EQ(session.getSessionData()->profile, ProfileJson<CustomProfile>::members);
+
+    // Also through the base class
+    BasicSession<TLS_CLIENT_JSON_CODEC>& base = session;
+    base.setSessionData(SessionData());
+    ASSERT_EQ(session.getSessionData()->profile, ProfileJson<CustomProfile>::members);
+    ASSERT_NE(session.prepare(requestData, "GET").envelope().find(ProfileJson<CustomProfile>::members),
+        std::string::npos);
+}
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+TEST(ProfileTest, TestRequest) {
+    LoopbackServer server;
+    ProfileSession<HeaderOrderProfile> session;
+
+    RequestData requestData;
+    requestData.url = server.url("/get");
+    requestData.insecureSkipVerify = true;
+    requestData.headers = R"({"x-first": "1", "x-second": "2"})";
+    Expected<ResponseData> response = session.tryGET(requestData);
+    ASSERT_TRUE(response) << response.error().message;
+    ASSERT_EQ(response->statusCode, 200);
+    ASSERT_NE(response->body.find(R"(\"X-First\": \"1\")"), std::string::npos);
+}
+#endif
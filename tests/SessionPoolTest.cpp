@@ -0,0 +1,121 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_pool.hpp"
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+#include "LoopbackServer.hpp"
+#endif
+
+TEST(SessionPoolTest, TestBindAddresses) {
+    SessionData sessionData;
+    sessionData.sessionId = "pool";
+    SessionPool pool(sessionData, {"127.0.0.2", "127.0.0.3:4000", "::1", "[::1]:5000"});
+    ASSERT_EQ(pool.size(), 4u);
+
+    std::vector<std::pair<std::string, std::string>> bound;
+    std::vector<SessionPool::Lease> leases;
+    for (int i = 0; i < 4; ++i) {
+        leases.push_back(pool.acquire());
+        auto config = leases.back().session().getSessionData();
+        bound.emplace_back(*config->localAddress, *config->sessionId);
+    }
+    std::sort(bound.begin(), bound.end());
+
+    std::vector<std::pair<std::string, std::string>> expected{
+        {"127.0.0.2:0", "pool@127.0.0.2:0"},
+        {"127.0.0.3:4000", "pool@127.0.0.3:4000"},
+        {"[::1]:0", "pool@[::1]:0"},
+        {"[::1]:5000", "pool@[::1]:5000"},
+    };
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(bound, expected);
+
+    ASSERT_THROW(SessionPool(sessionData, {}), std::invalid_argument);
+
+    Expected<std::unique_ptr<SessionPool>> empty = SessionPool::create(sessionData, {});
+    ASSERT_FALSE(empty);
+    ASSERT_EQ(empty.error().code, ErrorCode::Request);
+    Expected<std::unique_ptr<SessionPool>> created = SessionPool::create(sessionData, {"127.0.0.2"});
+    ASSERT_TRUE(created);
+    ASSERT_EQ((*created)->size(), 1u);
+}
+
+TEST(SessionPoolTest, TestLeastBusyAddress) {
+    SessionPool pool(SessionData(), {"127.0.0.1", "127.0.0.2"});
+
+    {
+        SessionPool::Lease first = pool.acquire();
+        SessionPool::Lease second = pool.acquire();
+        ASSERT_NE(first.address(), second.address());
+
+        SessionPool::Lease third = pool.acquire();
+        std::vector<AddressStats> stats = pool.getStats();
+        ASSERT_EQ(stats[0].inFlight + stats[1].inFlight, 3u);
+        ASSERT_EQ(std::max(stats[0].peakInFlight, stats[1].peakInFlight), 2u);
+
+        SessionPool::Lease moved = std::move(third);
+        ASSERT_EQ(pool.getStats()[0].inFlight + pool.getStats()[1].inFlight, 3u);
+    }
+
+    std::vector<AddressStats> stats = pool.getStats();
+    ASSERT_EQ(stats[0].address, "127.0.0.1");
+    ASSERT_EQ(stats[0].inFlight + stats[1].inFlight, 0u);
+}
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+// Every address of 127.0.0.0/8 is local on Linux, so the loopback server sees both sources
+TEST(SessionPoolTest, TestSpreadsRequests) {
+    LoopbackServer server;
+    SessionData sessionData;
+    sessionData.sessionId = "pool-spread";
+    SessionPool pool(sessionData, {"127.0.0.1", "127.0.0.2"});
+
+    RequestData requestData;
+    requestData.url = server.url("/get");
+    requestData.insecureSkipVerify = true;
+
+    std::mutex mutex;
+    std::set<std::string> origins;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 10; ++j) {
+                Expected<ResponseData> response = pool.tryGET(requestData);
+                ASSERT_TRUE(response) << response.error().message;
+
+                size_t start = response->body.find(R"(\"origin\": \")");
+                ASSERT_NE(start, std::string::npos);
+                start += 14;
+                std::lock_guard<std::mutex> lock(mutex);
+                origins.insert(response->body.substr(start, response->body.find('\\', start) - start));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(origins, (std::set<std::string>{"127.0.0.1", "127.0.0.2"}));
+
+    std::vector<AddressStats> stats = pool.getStats();
+    ASSERT_EQ(stats[0].session.requests + stats[1].session.requests, 40u);
+    for (const AddressStats& address : stats) {
+        ASSERT_GT(address.session.requests, 0u);
+        ASSERT_EQ(address.session.failures, 0u);
+        ASSERT_EQ(address.inFlight, 0u);
+        ASSERT_GT(address.requestsPerSecond, 0);
+        ASSERT_GT(address.bytesPerSecond, 0);
+    }
+}
+#endif
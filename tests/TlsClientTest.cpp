@@ -7,15 +7,30 @@
  */
 #include <string>
 #include <gtest/gtest.h>
+#include <atomic>
 #include <filesystem>
 #include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
 
 #include "../include/tls_client.hpp"
 
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+#include "LoopbackServer.hpp"
+#endif
+
 class TlsClientTest : public ::testing::Test {
 protected:
     void SetUp() override {
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+        // The loopback server answers like httpbin, without leaving the machine
+        static LoopbackServer server;
+        requestData.url = server.url("");
+        requestData.insecureSkipVerify = true;
+#else
         requestData.url = "https://httpbin.org";
+#endif
         session = new Session(sessionData);
     }
 
@@ -94,7 +109,19 @@ TEST_F(TlsClientTest, TestRequestData) {
 
     responseData = session->GET(requestData);
 
-    ASSERT_TRUE(responseData.body.find(R"(\"data\": \"Hello,world!\")") != std::string::npos);
+    ASSERT_TRUE(responseData.body.find(R"(\"data\": \"Hello, world!\")") != std::string::npos);
+}
+
+TEST_F(TlsClientTest, TestRequestJsonData) {
+    // A body that is itself JSON is sent as a string, not embedded into the envelope
+    requestData.url += "/post";
+    requestData.headers = R"({"content-type": "application/json"})";
+    requestData.data = R"({"a": 1})";
+
+    responseData = session->POST(requestData);
+
+    ASSERT_EQ(responseData.statusCode, 200);
+    ASSERT_NE(responseData.decodeBody().find(R"("data": "{\"a\": 1}")"), std::string::npos) << responseData.body;
 }
 
 TEST_F(TlsClientTest, TestRequestCookies) {
@@ -145,6 +172,363 @@ TEST_F(TlsClientTest, TestRequestProxy) {
     ASSERT_EQ(responseData.statusCode, 0);
 }
 
+// Test the non-throwing API
+TEST_F(TlsClientTest, TestTryGETRequest) {
+    requestData.url += "/get";
+    Expected<ResponseData> result = session->tryGET(requestData);
+
+    ASSERT_TRUE(result.hasValue());
+    ASSERT_EQ(result->statusCode, 200);
+}
+
+TEST_F(TlsClientTest, TestTryRequestProxy) {
+    requestData.url += "/anything";
+    requestData.proxy = "https://test_proxy:1234";
+    requestData.timeoutSeconds = 10;
+
+    Expected<ResponseData> result = session->tryGET(requestData);
+
+    ASSERT_FALSE(result.hasValue());
+    ASSERT_EQ(result.error().code, ErrorCode::Proxy);
+}
+
+// Test response size limits
+TEST_F(TlsClientTest, TestTryRequestMaxResponseSize) {
+    requestData.url += "/get";
+    requestData.maxResponseSize = 16;
+
+    Expected<ResponseData> result = session->tryGET(requestData);
+
+    ASSERT_FALSE(result.hasValue());
+    ASSERT_EQ(result.error().code, ErrorCode::ResponseTooLarge);
+}
+
+TEST_F(TlsClientTest, TestSessionMaxResponseSize) {
+    sessionData.maxResponseSize = 16;
+    Session limitedSession(sessionData);
+    requestData.url += "/get";
+
+    ASSERT_THROW(limitedSession.GET(requestData), std::length_error);
+    ASSERT_EQ(limitedSession.getStats().requests, 1u);
+    ASSERT_EQ(limitedSession.getStats().failures, 1u);
+
+    requestData.maxResponseSize = 1024 * 1024;
+    ASSERT_EQ(limitedSession.GET(requestData).statusCode, 200);
+}
+
+// Test spilling large bodies out of the heap
+TEST_F(TlsClientTest, TestSpillThreshold) {
+    sessionData.spillThreshold = 64;
+    Session spillingSession(sessionData);
+    requestData.url += "/get";
+
+    responseData = spillingSession.GET(requestData);
+
+    ASSERT_EQ(responseData.statusCode, 200);
+    ASSERT_TRUE(responseData.body.empty());
+    ASSERT_TRUE(responseData.mappedBody);
+    ASSERT_GT(responseData.bodyView().size(), 64u);
+
+    // The body is written from the library response, the other fields are parsed as usual
+    requestData.url = requestData.url.substr(0, requestData.url.size() - 4) + "/bytes/1000";
+    Expected<ResponseData> spilled = spillingSession.tryGET(requestData);
+    ASSERT_TRUE(spilled) << spilled.error().message;
+    ASSERT_EQ(spilled->statusCode, 200);
+    ASSERT_TRUE(spilled->body.empty());
+    ASSERT_EQ(spilled->bodyView(), std::string(1000, 'x'));
+    ASSERT_FALSE(spilled->headers.empty());
+    ASSERT_EQ(spilled->target, requestData.url);
+}
+
+#if defined(TLS_CLIENT_HAS_NGHTTP2)
+// Test the protocol negotiated with the loopback server
+TEST_F(TlsClientTest, TestHttp2AndForceHttp1) {
+    requestData.url += "/bytes/100000?chunked=1&delay=10";
+    responseData = session->GET(requestData);
+    ASSERT_EQ(responseData.statusCode, 200);
+    ASSERT_EQ(responseData.usedProtocol, "HTTP/2.0");
+    ASSERT_EQ(responseData.body, std::string(100000, 'x'));
+
+    sessionData.forceHttp1 = true;
+    Session http1Session(sessionData);
+    responseData = http1Session.GET(requestData);
+    ASSERT_EQ(responseData.statusCode, 200);
+    ASSERT_EQ(responseData.usedProtocol, "HTTP/1.1");
+    ASSERT_EQ(responseData.body, std::string(100000, 'x'));
+}
+#endif
+
+#if defined(TLS_CLIENT_HAS_OPENSSL) && !defined(_WIN32)
+// Test the connection pool of the library
+TEST_F(TlsClientTest, TestTransportOptions) {
+    LoopbackServer server;
+    requestData.url = server.url("/anything");
+
+    sessionData.forceHttp1 = true;
+    sessionData.sessionId = "transport-options-test";
+    sessionData.transportOptions = TransportOptions();
+    sessionData.transportOptions->maxIdleConnsPerHost = 4;
+    sessionData.transportOptions->idleConnTimeout = std::chrono::seconds(30);
+    sessionData.transportOptions->disableCompression = true;
+
+    Session pooled(sessionData);
+    for (int i = 0; i < 3; ++i) {
+        responseData = pooled.GET(requestData);
+        ASSERT_EQ(responseData.statusCode, 200);
+    }
+    ASSERT_EQ(responseData.body.find("Accept-Encoding"), std::string::npos);
+    ASSERT_EQ(server.connectionsAccepted(), 1u);
+
+    sessionData.sessionId = "transport-options-test-no-keep-alive";
+    sessionData.transportOptions->disableKeepAlives = true;
+    Session unpooled(sessionData);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(unpooled.GET(requestData).statusCode, 200);
+    }
+    ASSERT_EQ(server.connectionsAccepted(), 4u);
+}
+
+// Test releasing the library client of a session id
+TEST_F(TlsClientTest, TestDestroySession) {
+    LoopbackServer server;
+    requestData.url = server.url("/anything");
+    sessionData.forceHttp1 = true;
+    sessionData.sessionId = "destroy-session-test";
+    {
+        Session first(sessionData);
+        ASSERT_EQ(first.GET(requestData).statusCode, 200);
+        ASSERT_EQ(server.connectionsAccepted(), 1u);
+    }
+
+    // The client was released with the session, so the id picks up new transport options
+    sessionData.transportOptions = TransportOptions();
+    sessionData.transportOptions->disableKeepAlives = true;
+    Session second(sessionData);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_EQ(second.GET(requestData).statusCode, 200);
+    }
+    ASSERT_EQ(server.connectionsAccepted(), 4u);
+}
+
+// Test that the client of a session id lives as long as a session holds the id
+TEST_F(TlsClientTest, TestSharedSessionId) {
+    LoopbackServer server;
+    requestData.url = server.url("/anything");
+    sessionData.forceHttp1 = true;
+    sessionData.sessionId = "shared-session-test";
+
+    Session first(sessionData);
+    ASSERT_EQ(first.GET(requestData).statusCode, 200);
+    {
+        Session second(sessionData);
+        Session copy = second;
+        ASSERT_EQ(copy.GET(requestData).statusCode, 200);
+    }
+
+    // Destroying the other holders kept the client and its connection
+    ASSERT_EQ(first.GET(requestData).statusCode, 200);
+    ASSERT_EQ(server.connectionsAccepted(), 1u);
+
+    // Switching to another id releases the client of the previous one
+    SessionData other = sessionData;
+    other.sessionId = "shared-session-test-other";
+    first.setSessionData(other);
+    ASSERT_EQ(first.GET(requestData).statusCode, 200);
+    ASSERT_EQ(server.connectionsAccepted(), 2u);
+
+    sessionData.transportOptions = TransportOptions();
+    sessionData.transportOptions->disableKeepAlives = true;
+    Session reused(sessionData);
+    ASSERT_EQ(reused.GET(requestData).statusCode, 200);
+    ASSERT_EQ(reused.GET(requestData).statusCode, 200);
+    ASSERT_EQ(server.connectionsAccepted(), 4u);
+}
+#endif
+
+// Test sharing a session between threads
+TEST_F(TlsClientTest, TestConcurrentRequests) {
+    requestData.url = "https://127.0.0.1:1"; // Nothing listens there, so every request fails fast
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([this]() {
+            for (int j = 0; j < 10; ++j) {
+                ASSERT_FALSE(session->tryGET(requestData).hasValue());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    SessionStats stats = session->getStats();
+    ASSERT_EQ(stats.requests, 80u);
+    ASSERT_EQ(stats.failures, 80u);
+}
+
+// Test sending a batch, with the responses parsed on their own executor
+TEST_F(TlsClientTest, TestBatch) {
+    struct ThreadSink : ResponseSink {
+        std::mutex mutex;
+        std::set<std::thread::id> threads;
+
+        void consume(const RequestData&, const std::string&, ResponseData&) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        }
+    };
+    auto sink = std::make_shared<ThreadSink>();
+    sessionData.sinks.push_back(sink);
+    Session batchSession(sessionData);
+
+    std::vector<RequestData> requests;
+    for (int i = 0; i < 12; ++i) {
+        RequestData request = requestData;
+        request.url += i == 5 ? "/status/404" : "/bytes/" + std::to_string(5000 * (i + 1));
+        requests.push_back(request);
+    }
+    RequestData failing = requestData;
+    failing.url = "https://127.0.0.1:1"; // Nothing listens there
+    requests.push_back(failing);
+
+    ThreadPool requestExecutor(4);
+    ThreadPool decodeExecutor(1);
+    std::thread::id decodeThread = decodeExecutor.submit([]() { return std::this_thread::get_id(); }).get();
+
+    std::vector<Expected<ResponseData>> responses = batchSession.tryBatch(requests, "GET", requestExecutor,
+        decodeExecutor);
+    ASSERT_EQ(responses.size(), 13u);
+    for (int i = 0; i < 12; ++i) {
+        ASSERT_TRUE(responses[i]) << responses[i].error().message;
+        if (i == 5) {
+            ASSERT_EQ(responses[i]->statusCode, 404);
+        } else {
+            ASSERT_EQ(responses[i]->statusCode, 200);
+            ASSERT_EQ(responses[i]->body.size(), 5000u * (i + 1));
+        }
+    }
+    ASSERT_FALSE(responses[12]);
+    ASSERT_EQ(responses[12].error().code, ErrorCode::Connection);
+
+    ASSERT_EQ(sink->threads, std::set<std::thread::id>{decodeThread});
+    ASSERT_EQ(batchSession.getStats().requests, 13u);
+    ASSERT_EQ(batchSession.getStats().failures, 1u);
+}
+
+#if defined(TLS_CLIENT_EXCEPTIONS)
+// Test that a throwing sink fails its own request of a batch, not the process
+TEST_F(TlsClientTest, TestBatchThrowingSink) {
+    struct ThrowingSink : ResponseSink {
+        void consume(const RequestData&, const std::string&, ResponseData& responseData) override {
+            if (responseData.statusCode == 404) {
+                throw std::runtime_error("sink failed");
+            }
+        }
+    };
+    sessionData.sinks.push_back(std::make_shared<ThrowingSink>());
+    Session batchSession(sessionData);
+
+    std::vector<RequestData> requests(3, requestData);
+    requests[0].url += "/get";
+    requests[1].url += "/status/404";
+    requests[2].url += "/get";
+
+    ThreadPool executor(2);
+    std::vector<Expected<ResponseData>> responses = batchSession.tryBatch(requests, "GET", executor, executor);
+    ASSERT_TRUE(responses[0]);
+    ASSERT_FALSE(responses[1]);
+    ASSERT_EQ(responses[1].error().code, ErrorCode::Request);
+    ASSERT_EQ(responses[1].error().message, "sink failed");
+    ASSERT_TRUE(responses[2]);
+}
+#endif
+
+// Test sending requests from a template, which only escapes the URL suffix and the body for each request
+TEST_F(TlsClientTest, TestRequestTemplate) {
+    requestData.url += "/anything?q=";
+    requestData.headers = R"({"X-Template": "yes"})";
+    RequestTemplate requestTemplate = session->prepare(requestData, "POST");
+    ASSERT_EQ(requestTemplate.getMethod(), "POST");
+
+    for (std::string value : {"1", "2"}) {
+        requestTemplate.setUrlSuffix(value);
+        requestTemplate.setBody("say \"" + value + "\" <now>");
+        Expected<ResponseData> response = session->tryPerform(requestTemplate);
+        ASSERT_TRUE(response) << response.error().message;
+        ASSERT_EQ(response->statusCode, 200);
+        ASSERT_NE(response->body.find(R"(\"q\": \")" + value + R"(\")"), std::string::npos);
+        ASSERT_NE(response->body.find(R"(\"data\": \"say \\\")" + value + R"(\\\" \\u003cnow\\u003e\")"),
+            std::string::npos);
+        ASSERT_NE(response->body.find(R"(\"X-Template\": \"yes\")"), std::string::npos);
+        ASSERT_NE(response->body.find(R"(\"method\": \"POST\")"), std::string::npos);
+    }
+
+    RequestData sent = requestTemplate.toRequestData();
+    ASSERT_EQ(sent.url, requestData.url + "2");
+    ASSERT_EQ(sent.data, "say \"2\" <now>");
+    ASSERT_EQ(sent.headers, requestData.headers);
+
+    // Once the session data changes, the request is built from scratch
+    session->setSessionData(sessionData);
+    requestTemplate.clearBody();
+    Expected<ResponseData> response = session->tryPerform(requestTemplate);
+    ASSERT_TRUE(response) << response.error().message;
+    ASSERT_NE(response->body.find(R"(\"q\": \"2\")"), std::string::npos);
+    ASSERT_NE(response->body.find(R"(\"data\": \"\")"), std::string::npos);
+    ASSERT_EQ(session->getStats().requests, 3u);
+}
+
+// Test sharing a response kept in the library buffer between consumers
+TEST_F(TlsClientTest, TestSharedResponse) {
+    requestData.url += "/get?q=shared";
+    Expected<std::shared_ptr<const SharedResponse>> shared = session->tryShare(requestData, "GET");
+    ASSERT_TRUE(shared) << shared.error().message;
+    ASSERT_EQ((*shared)->statusCode(), 200);
+    ASSERT_NE((*shared)->body().find(R"(\"q\": \"shared\")"), std::string_view::npos);
+    ASSERT_EQ((*shared)->header("content-type"), "application/json");
+    ASSERT_GT((*shared)->size(), (*shared)->body().size());
+
+    // Every consumer reads the same buffer
+    std::vector<std::thread> consumers;
+    std::atomic<size_t> bytes{0};
+    for (int i = 0; i < 4; ++i) {
+        consumers.emplace_back([response = *shared, &bytes] { bytes += response->body().size(); });
+    }
+    for (std::thread& consumer : consumers) {
+        consumer.join();
+    }
+    ASSERT_EQ(bytes, 4 * (*shared)->body().size());
+
+    ResponseData copied = (*shared)->toResponseData();
+    ASSERT_EQ(copied.statusCode, 200);
+    ASSERT_EQ(copied.body, (*shared)->body());
+    std::shared_ptr<const SharedResponse> again = SharedResponse::copy(copied);
+    ASSERT_EQ(again->body(), copied.body);
+    ASSERT_EQ(again->headers(), (*shared)->headers());
+    ASSERT_EQ(again->target(), (*shared)->target());
+    ASSERT_EQ(again->usedProtocol(), (*shared)->usedProtocol());
+
+    requestData.maxResponseSize = 16;
+    shared = session->tryShare(requestData, "GET");
+    ASSERT_FALSE(shared);
+    ASSERT_EQ(shared.error().code, ErrorCode::ResponseTooLarge);
+    ASSERT_EQ(session->getStats().requests, 2u);
+    ASSERT_EQ(session->getStats().failures, 1u);
+}
+
+TEST_F(TlsClientTest, TestSharedResponseSpilled) {
+    // Spilled bodies are built as a ResponseData, and the mapping is shared
+    sessionData.spillThreshold = 64;
+    Session spillingSession(sessionData);
+    requestData.url += "/get";
+
+    Expected<std::shared_ptr<const SharedResponse>> shared = spillingSession.tryShare(requestData, "GET");
+    ASSERT_TRUE(shared) << shared.error().message;
+    ASSERT_EQ((*shared)->statusCode(), 200);
+    ASSERT_GT((*shared)->body().size(), 64u);
+    ASSERT_TRUE((*shared)->toResponseData().mappedBody);
+}
+
 // We don't have to test url attribute, since we have already
 // used it in every test
 
@@ -0,0 +1,216 @@
+/**
+ * This file is a part of tls-client implementation for
+ * modern C++ (17+ standard)
+ *
+ * Thanks for bogdanfinn for creating the original tls-client
+ * library in GO https://github.com/bogdanfinn/tls-client
+ */
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../include/tls_client_warc.hpp"
+
+class WarcWriterTest : public ::testing::Test {
+protected:
+    std::string directory;
+
+    void SetUp() override {
+        const ::testing::TestInfo* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        directory = (std::filesystem::temp_directory_path() / ("tls-client-warc-" + std::string(info->name()))).string();
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream stream(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+
+    static std::vector<std::string> readLines(const std::string& path) {
+        std::ifstream stream(path);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(stream, line);) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    static void archive(WarcWriter& writer, int index) {
+        RequestData requestData;
+        requestData.url = "https://www.example.com/page/" + std::to_string(index) + "?q=1";
+        requestData.headers = R"({"accept":"text/html"})";
+
+        // A library response, whose body is escaped as Go's encoding/json does
+        ResponseData responseData = JsonHelper::parseResponse(R"({"id":"","body":"\u003chtml\u003epage )" +
+            std::to_string(index) + R"(\u003c/html\u003e","cookies":{},)"
+            R"("headers":{"Content-Type":["text/html; charset=utf-8"],"Content-Encoding":["gzip"]},)"
+            R"("sessionId":"","status":200,"target":"","usedProtocol":"HTTP/2.0"})");
+
+        writer.consume(requestData, "GET", responseData);
+    }
+
+    // Returns the CDX fields of a line: key, timestamp, url, mime, status, digest, redirect, flags, length, offset, file
+    static std::vector<std::string> fields(const std::string& line) {
+        std::istringstream stream(line);
+        std::vector<std::string> result;
+        for (std::string field; stream >> field;) {
+            result.push_back(field);
+        }
+        return result;
+    }
+};
+
+TEST_F(WarcWriterTest, TestSurt) {
+    ASSERT_EQ(WarcWriter::surt("https://www.Example.com/Path?Q=1#frag"), "com,example)/path?q=1");
+    ASSERT_EQ(WarcWriter::surt("http://example.com:80"), "com,example)/");
+    ASSERT_EQ(WarcWriter::surt("https://sub.example.com:8443/"), "com,example,sub:8443)/");
+}
+
+TEST_F(WarcWriterTest, TestUncompressedRecords) {
+    WarcOptions options;
+    options.directory = directory;
+    options.compression = WarcCompression::None;
+
+    Expected<std::shared_ptr<WarcWriter>> writer = WarcWriter::open(options);
+    ASSERT_TRUE(writer) << writer.error().message;
+    archive(**writer, 1);
+    ASSERT_FALSE((*writer)->flush());
+
+    std::vector<std::string> files = (*writer)->files();
+    writer = Unexpected<Error>{{ErrorCode::Io, "closed"}};
+
+    ASSERT_EQ(files.size(), 1u);
+    std::string warc = readFile(files[0]);
+    ASSERT_EQ(warc.rfind("WARC/1.1\r\nWARC-Type: warcinfo\r\n", 0), 0u);
+    ASSERT_NE(warc.find("WARC-Type: request\r\n"), std::string::npos);
+    ASSERT_NE(warc.find("GET /page/1?q=1 HTTP/1.1\r\nHost: www.example.com\r\naccept: text/html\r\n"),
+        std::string::npos);
+    ASSERT_NE(warc.find("HTTP/1.1 200 OK\r\nContent-Type: text/html; charset=utf-8\r\n"
+        "X-Archive-Orig-Content-Encoding: gzip\r\nContent-Length: 19\r\n\r\n<html>page 1</html>"), std::string::npos);
+
+    std::vector<std::string> cdx = readLines(files[0].substr(0, files[0].size() - 5) + ".cdx");
+    ASSERT_EQ(cdx.size(), 2u);
+    ASSERT_EQ(cdx[0], " CDX N b a m s k r M S V g");
+
+    std::vector<std::string> entry = fields(cdx[1]);
+    ASSERT_EQ(entry.size(), 11u);
+    ASSERT_EQ(entry[0], "com,example)/page/1?q=1");
+    ASSERT_EQ(entry[3], "text/html");
+    ASSERT_EQ(entry[4], "200");
+
+    std::string record = warc.substr(std::stoull(entry[9]), std::stoull(entry[8]));
+    ASSERT_EQ(record.rfind("WARC/1.1\r\nWARC-Type: response\r\n", 0), 0u);
+    ASSERT_EQ(record.substr(record.size() - 4), "\r\n\r\n");
+}
+
+TEST_F(WarcWriterTest, TestFlushAndClose) {
+    WarcOptions options;
+    options.directory = directory;
+    options.compression = WarcCompression::None;
+
+    Expected<std::shared_ptr<WarcWriter>> writer = WarcWriter::open(options);
+    ASSERT_TRUE(writer) << writer.error().message;
+    std::string file = (*writer)->files()[0];
+    std::string cdxPath = file.substr(0, file.size() - 5) + ".cdx";
+
+    // The index is readable while the writer is still open
+    archive(**writer, 1);
+    archive(**writer, 2);
+    ASSERT_FALSE((*writer)->flush());
+    ASSERT_EQ(readLines(cdxPath).size(), 3u);
+
+    archive(**writer, 3);
+    ASSERT_FALSE((*writer)->close());
+    ASSERT_EQ(readLines(cdxPath).size(), 4u);
+    size_t size = readFile(file).size();
+
+    // Responses after close are not archived
+    archive(**writer, 4);
+    ASSERT_FALSE((*writer)->flush());
+    ASSERT_FALSE((*writer)->close());
+    ASSERT_EQ(readFile(file).size(), size);
+    ASSERT_EQ(readLines(cdxPath).size(), 4u);
+}
+
+#if defined(TLS_CLIENT_HAS_ZLIB)
+TEST_F(WarcWriterTest, TestGzipRecordsAndRotation) {
+    WarcOptions options;
+    options.directory = directory;
+    options.compression = WarcCompression::Gzip;
+    options.maxFileSize = 4096;
+    options.compressionThreads = 4;
+
+    std::vector<std::string> files;
+    {
+        Expected<std::shared_ptr<WarcWriter>> writer = WarcWriter::open(options);
+        ASSERT_TRUE(writer) << writer.error().message;
+        for (int i = 0; i < 200; ++i) {
+            archive(**writer, i);
+        }
+        ASSERT_FALSE((*writer)->flush());
+        files = (*writer)->files();
+    }
+    ASSERT_GT(files.size(), 1u);
+
+    // Every CDX entry points at one gzip member holding a whole response record
+    size_t responses = 0;
+    for (const std::string& file : files) {
+        std::string warc = readFile(file);
+        for (const std::string& line : readLines(file.substr(0, file.size() - 8) + ".cdx")) {
+            std::vector<std::string> entry = fields(line);
+            if (entry[0] == "CDX") {
+                continue;
+            }
+
+            std::string member = warc.substr(std::stoull(entry[9]), std::stoull(entry[8]));
+            z_stream stream{};
+            ASSERT_EQ(inflateInit2(&stream, 15 + 16), Z_OK);
+            std::string record(1 << 16, '\0');
+            stream.next_in = reinterpret_cast<Bytef*>(member.data());
+            stream.avail_in = static_cast<uInt>(member.size());
+            stream.next_out = reinterpret_cast<Bytef*>(record.data());
+            stream.avail_out = static_cast<uInt>(record.size());
+            ASSERT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+            ASSERT_EQ(stream.avail_in, 0u);
+            record.resize(stream.total_out);
+            inflateEnd(&stream);
+
+            ASSERT_EQ(record.rfind("WARC/1.1\r\nWARC-Type: response\r\n", 0), 0u);
+            ASSERT_NE(record.find("WARC-Target-URI: " + entry[2]), std::string::npos);
+            ++responses;
+        }
+    }
+    ASSERT_EQ(responses, 200u);
+}
+#endif
+
+#if defined(TLS_CLIENT_HAS_ZSTD)
+TEST_F(WarcWriterTest, TestZstdRecords) {
+    WarcOptions options;
+    options.directory = directory;
+    options.compression = WarcCompression::Zstd;
+
+    std::vector<std::string> files;
+    {
+        Expected<std::shared_ptr<WarcWriter>> writer = WarcWriter::open(options);
+        ASSERT_TRUE(writer) << writer.error().message;
+        archive(**writer, 7);
+        files = (*writer)->files();
+    }
+
+    std::string warc = readFile(files[0]);
+    std::vector<std::string> entry = fields(readLines(files[0].substr(0, files[0].size() - 9) + ".cdx")[1]);
+    std::string frame = warc.substr(std::stoull(entry[9]), std::stoull(entry[8]));
+
+    std::string record(ZSTD_getFrameContentSize(frame.data(), frame.size()), '\0');
+    ASSERT_EQ(ZSTD_decompress(record.data(), record.size(), frame.data(), frame.size()), record.size());
+    ASSERT_NE(record.find("<html>page 7</html>"), std::string::npos);
+}
+#endif